@@ -22,6 +22,13 @@ pub fn build(b: *std.Build) void {
         "src/preprocess.c",
         "src/parser.c",
         "src/sema.c",
+        "src/inline.c",
+        "src/fold.c",
+        "src/licm.c",
+        "src/cse.c",
+        "src/range.c",
+        "src/dse.c",
+        "src/ir.c",
         "src/codegen.c",
         "src/main.c",
     };
@@ -9,15 +9,15 @@ class Memory {
   constructor(size) {
     this.size = size;
     this.buffer = new ArrayBuffer(size);
-    this.view = new DataView(this.buffer);
-    this.u8 = new Uint8Array(this.buffer);
+    this._viewListeners = [];
+    this.refreshViews();
 
     // Stack starts at top, grows downward.  Reserve top 1 MB for stack.
     this.stackTop = size;
     this.sp = this.stackTop;
 
     // Heap starts at byte 4 (address 0 is reserved NULL).
-    this.heapStart = 4;
+    this.heapStart = 8;
 
     // Free-list: array of {addr, size} ordered by addr.  Initially one big
     // block covering the whole heap region (up to stackBottom).
@@ -28,12 +28,44 @@ class Memory {
     this.allocated = new Map();
   }
 
+  // (Re)create the DataView and typed-array heap views over this.buffer and
+  // notify subscribers.  Generated code indexes the HEAPxx views directly,
+  // so this must run whenever the buffer is replaced.
+  refreshViews() {
+    const b = this.buffer;
+    this.view = new DataView(b);
+    this.u8 = new Uint8Array(b);
+    this.HEAP8 = new Int8Array(b);
+    this.HEAPU8 = this.u8;
+    this.HEAP16 = new Int16Array(b);
+    this.HEAPU16 = new Uint16Array(b);
+    this.HEAP32 = new Int32Array(b);
+    this.HEAPU32 = new Uint32Array(b);
+    this.HEAPF32 = new Float32Array(b);
+    this.HEAPF64 = new Float64Array(b);
+    for (const fn of this._viewListeners) fn(this);
+  }
+
+  // Call fn(mem) now and after every refreshViews()
+  onViewsChanged(fn) {
+    this._viewListeners.push(fn);
+    fn(this);
+  }
+
   // Reserve memory for global variables so heap doesn't overlap
   reserveGlobals(endAddr) {
+    endAddr = align(endAddr, 8); // keep heap blocks 8-byte aligned
     this.heapStart = endAddr;
     this.freeList = [{ addr: endAddr, size: this.heapEnd - endAddr }];
   }
 
+  // Install the program's initial static data, base64-encoded, at addr
+  loadImage(addr, b64) {
+    const bytes = (typeof Buffer !== 'undefined') ? Buffer.from(b64, 'base64')
+      : Uint8Array.from(atob(b64), (c) => c.charCodeAt(0));
+    this.u8.set(bytes, addr);
+  }
+
   // -- typed read helpers (little-endian) --
   readInt8(addr)    { return this.view.getInt8(addr); }
   readUint8(addr)   { return this.view.getUint8(addr); }
@@ -195,9 +227,8 @@ class Runtime {
     // setjmp/longjmp state
     this._setjmpCounter = 0;
 
-    // Function pointer table: integer ID → JS function
+    // Function pointer table: integer ID → JS function (set by the module)
     this._funcTable = [null]; // index 0 = NULL function pointer
-    this._funcMap = new Map(); // fn → id (for deduplication)
 
     // File descriptor table.  0=stdin 1=stdout 2=stderr, fd>=3 user files
     this._nextFd = 3;
@@ -227,8 +258,8 @@ class Runtime {
     this._errnoAddr = this.mem.malloc(4);
     this.mem.writeInt32(this._errnoAddr, 0);
 
-    // va_list table: index → { args: [...], pos: 0 }
-    this._vaLists = [null]; // index 0 reserved
+    // High word of the last 64-bit integer result (see int64 helpers)
+    this.H = 0;
   }
 
   // ======================== float64 <-> BigInt (NaN-safe) ===================
@@ -244,50 +275,133 @@ class Runtime {
     return this._tmpView.getBigUint64(0, true);
   }
 
-  // ======================== function pointer table ==========================
-  registerFunction(fn) {
-    const existing = this._funcMap.get(fn);
-    if (existing !== undefined) return existing;
-    const id = this._funcTable.length;
-    this._funcTable.push(fn);
-    this._funcMap.set(fn, id);
-    return id;
+  // ======================== 64-bit integers ================================
+  // long long values are (lo, hi) pairs of int32 words.  Helpers take both
+  // operands as pairs, return the low word of the result and leave the high
+  // word in this.H.  Values that fit in 52 bits take a plain Number path.
+  _split(n) {
+    this.H = Math.floor(n / 4294967296) | 0;
+    return n | 0;
   }
 
-  callFunction(id, ...args) {
-    const fn = this._funcTable[id];
-    if (!fn) throw new Error('NULL function pointer call (id=' + id + ')');
-    return fn(...args);
+  mul64(al, ah, bl, bh) {
+    if (ah === (al >> 31) && bh === (bl >> 31)) {
+      const p = al * bl;
+      if (p > -4503599627370496 && p < 4503599627370496) return this._split(p);
+    }
+    // Low words multiplied in 16-bit halves, cross terms only affect hi
+    const a0 = al & 0xFFFF, a1 = al >>> 16, b0 = bl & 0xFFFF, b1 = bl >>> 16;
+    const p00 = a0 * b0;
+    const mid = a1 * b0 + a0 * b1 + (p00 >>> 16);
+    this.H = (a1 * b1 + Math.floor(mid / 65536) + Math.imul(al, bh) + Math.imul(ah, bl)) | 0;
+    return (mid << 16) | (p00 & 0xFFFF);
+  }
+
+  _divmod64(al, ah, bl, bh, uns, mod) {
+    const a = (uns ? ah >>> 0 : ah) * 4294967296 + (al >>> 0);
+    const b = (uns ? bh >>> 0 : bh) * 4294967296 + (bl >>> 0);
+    if (b !== 0 && a > -4503599627370496 && a < 4503599627370496 &&
+        b > -4503599627370496 && b < 4503599627370496)
+      return this._split(mod ? a % b : Math.trunc(a / b));
+    const x = uns ? this.bigu64(al, ah) : this.big64(al, ah);
+    const y = uns ? this.bigu64(bl, bh) : this.big64(bl, bh);
+    return this.split64(mod ? x % y : x / y);
+  }
+
+  div64(al, ah, bl, bh)  { return this._divmod64(al, ah, bl, bh, false, false); }
+  divu64(al, ah, bl, bh) { return this._divmod64(al, ah, bl, bh, true, false); }
+  mod64(al, ah, bl, bh)  { return this._divmod64(al, ah, bl, bh, false, true); }
+  modu64(al, ah, bl, bh) { return this._divmod64(al, ah, bl, bh, true, true); }
+
+  shl64(lo, hi, n) {
+    n &= 63;
+    if (n === 0) { this.H = hi; return lo; }
+    if (n < 32) { this.H = (hi << n) | (lo >>> (32 - n)); return lo << n; }
+    this.H = lo << (n - 32);
+    return 0;
   }
 
-  // ======================== va_list support =================================
-  vaStart(jsArgs) {
-    const id = this._vaLists.length;
-    this._vaLists.push({ args: [...jsArgs], pos: 0 });
-    return id;
+  shr64(lo, hi, n) {
+    n &= 63;
+    if (n === 0) { this.H = hi; return lo; }
+    if (n < 32) { this.H = hi >> n; return (lo >>> n) | (hi << (32 - n)); }
+    this.H = hi >> 31;
+    return hi >> (n - 32);
   }
 
-  vaEnd(id) {
-    if (id > 0 && id < this._vaLists.length) this._vaLists[id] = null;
+  shru64(lo, hi, n) {
+    n &= 63;
+    if (n === 0) { this.H = hi; return lo; }
+    if (n < 32) { this.H = hi >>> n; return (lo >>> n) | (hi << (32 - n)); }
+    this.H = 0;
+    return (hi >>> (n - 32)) | 0;
   }
 
-  vaCopy(srcId) {
-    const src = this._vaLists[srcId];
-    const id = this._vaLists.length;
-    this._vaLists.push({ args: [...src.args], pos: src.pos });
-    return id;
+  // double → long long / unsigned long long (truncating)
+  d2i64(d) {
+    d = Math.trunc(d);
+    if (d > -4503599627370496 && d < 4503599627370496) return this._split(d);
+    return this.split64(BigInt.asIntN(64, BigInt(isFinite(d) ? d : 0)));
+  }
+
+  d2u64(d) {
+    d = Math.trunc(d);
+    if (d > -4503599627370496 && d < 4503599627370496) return this._split(d);
+    return this.split64(BigInt.asUintN(64, BigInt(isFinite(d) ? d : 0)));
   }
 
-  vaArg(id) {
-    const entry = this._vaLists[id];
-    return entry.args[entry.pos++];
+  // Conversions at the BigInt boundary (variadic arguments, stdlib results)
+  big64(lo, hi)  { return (BigInt(hi) << 32n) | BigInt(lo >>> 0); }
+  bigu64(lo, hi) { return (BigInt(hi >>> 0) << 32n) | BigInt(lo >>> 0); }
+
+  split64(v) {
+    if (typeof v !== 'bigint') return this._split(Math.trunc(Number(v)));
+    this.H = Number(BigInt.asIntN(32, v >> 32n));
+    return Number(BigInt.asIntN(32, v));
+  }
+
+  // ======================== function pointer table ==========================
+  // The generated module owns the table (__ft) and indexes it directly;
+  // the runtime only needs it to call back into C (qsort, bsearch).
+  setFunctionTable(table) {
+    this._funcTable = table;
+  }
+
+  _fn(id) {
+    const fn = this._funcTable[id];
+    if (typeof fn !== 'function') throw new Error('NULL function pointer call (id=' + id + ')');
+    return fn;
+  }
+
+  // ======================== va_list support =================================
+  // A va_list is the address of the next 8-byte argument slot written by
+  // the caller (see codegen).  Read one slot for a printf conversion.
+  _vaRead(ap, kind) {
+    const m = this.mem;
+    switch (kind) {
+      case 'f':  return m.HEAPF64[ap >> 3];
+      case 'p':  return m.HEAPU32[ap >> 2];
+      case 'll': return this.big64(m.HEAP32[ap >> 2], m.HEAP32[(ap + 4) >> 2]);
+      default:   return m.HEAP32[ap >> 2];
+    }
   }
 
   // ======================== v-printf functions =============================
-  vsnprintf(bufAddr, maxLen, fmtAddr, vaId) {
+  vprintf(fmtAddr, ap) {
+    const s = this._formatString(this.mem.readString(fmtAddr), null, ap);
+    this._writeStdout(s);
+    return s.length;
+  }
+
+  vsprintf(bufAddr, fmtAddr, ap) {
+    const s = this._formatString(this.mem.readString(fmtAddr), null, ap);
+    this.mem.writeString(bufAddr, s);
+    return s.length;
+  }
+
+  vsnprintf(bufAddr, maxLen, fmtAddr, ap) {
     const fmt = this.mem.readString(fmtAddr);
-    const args = this._vaLists[vaId].args.slice(this._vaLists[vaId].pos);
-    const s = this._formatString(fmt, args);
+    const s = this._formatString(fmt, null, ap);
     if (bufAddr !== 0 && maxLen > 0) {
       const truncated = s.substring(0, maxLen - 1);
       this.mem.writeString(bufAddr, truncated);
@@ -295,10 +409,9 @@ class Runtime {
     return s.length;
   }
 
-  vfprintf(filePtr, fmtAddr, vaId) {
+  vfprintf(filePtr, fmtAddr, ap) {
     const fmt = this.mem.readString(fmtAddr);
-    const args = this._vaLists[vaId].args.slice(this._vaLists[vaId].pos);
-    const s = this._formatString(fmt, args);
+    const s = this._formatString(fmt, null, ap);
     if (filePtr === this.STDOUT_PTR) {
       this._writeStdout(s);
     } else if (filePtr === this.STDERR_PTR) {
@@ -321,7 +434,9 @@ class Runtime {
     return this._formatString(fmt, args);
   }
 
-  _formatString(fmt, args) {
+  // Arguments come from the JS array args, or from va_list slots at ap
+  // when args is null.
+  _formatString(fmt, args, ap) {
     let out = '';
     let ai = 0; // argument index
     let i = 0;
@@ -347,7 +462,7 @@ class Runtime {
 
       // Width
       let width = 0;
-      if (fmt[i] === '*') { width = args[ai++]; i++; }
+      if (fmt[i] === '*') { width = args ? args[ai++] : this._vaRead(ap, 'i'); ap += 8; i++; }
       else { while (i < fmt.length && fmt[i] >= '0' && fmt[i] <= '9') { width = width * 10 + (fmt[i] - '0'); i++; } }
 
       // Precision
@@ -355,7 +470,7 @@ class Runtime {
       if (fmt[i] === '.') {
         i++;
         prec = 0;
-        if (fmt[i] === '*') { prec = args[ai++]; i++; }
+        if (fmt[i] === '*') { prec = args ? args[ai++] : this._vaRead(ap, 'i'); ap += 8; i++; }
         else { while (i < fmt.length && fmt[i] >= '0' && fmt[i] <= '9') { prec = prec * 10 + (fmt[i] - '0'); i++; } }
       }
 
@@ -367,7 +482,14 @@ class Runtime {
 
       // Conversion specifier
       const spec = fmt[i++];
-      let val = args[ai++];
+      let val;
+      if (args) {
+        val = args[ai++];
+      } else {
+        const kind = 'feEgGaA'.includes(spec) ? 'f' : 'spn'.includes(spec) ? 'p' : length;
+        val = this._vaRead(ap, kind);
+        ap += 8;
+      }
       let s = '';
 
       switch (spec) {
@@ -402,7 +524,7 @@ class Runtime {
           let abs = n.toString(16);
           if (spec === 'X') abs = abs.toUpperCase();
           if (prec >= 0) { while (abs.length < prec) abs = '0' + abs; flags.zero = false; }
-          let prefix = (flags.hash && n !== 0) ? (spec === 'X' ? '0X' : '0x') : '';
+          let prefix = (flags.hash && Number(n) !== 0) ? (spec === 'X' ? '0X' : '0x') : '';
           s = prefix + abs;
           s = this._pad(s, width, flags);
           break;
@@ -447,13 +569,12 @@ class Runtime {
         }
         case 'n': {
           // %n stores current output length at the pointer
-          ai--; // we consumed val as a ptr
           this.mem.writeInt32(val, out.length);
           continue;
         }
         default:
           s = '%' + spec;
-          ai--; // no arg consumed for unknown
+          ai--; ap -= 8; // no arg consumed for unknown
       }
       out += s;
     }
@@ -461,6 +582,7 @@ class Runtime {
   }
 
   _toInt(val, len) {
+    if (len === 'll') return BigInt.asIntN(64, BigInt(val || 0));
     let n = Number(val) | 0;
     if (len === 'hh') n = (n << 24) >> 24;
     else if (len === 'h') n = (n << 16) >> 16;
@@ -468,6 +590,7 @@ class Runtime {
   }
 
   _toUint(val, len) {
+    if (len === 'll') return BigInt.asUintN(64, BigInt(val || 0));
     let n = Number(val);
     if (len === 'hh') n = n & 0xFF;
     else if (len === 'h') n = n & 0xFFFF;
@@ -867,7 +990,9 @@ class Runtime {
     return parseFloat(this.mem.readString(addr)) || 0;
   }
 
-  strtol(addr, endPtrAddr, base) {
+  // Scan the integer prefix of a string as strtol does; the value is
+  // accumulated as a BigInt when big is set
+  _strtoScan(addr, endPtrAddr, base, big) {
     const s = this.mem.readString(addr);
     let i = 0;
     while (i < s.length && /\s/.test(s[i])) i++;
@@ -880,17 +1005,19 @@ class Runtime {
     } else if (base === 16 && s[i] === '0' && (s[i + 1] === 'x' || s[i + 1] === 'X')) {
       i += 2;
     }
-    let val = 0;
-    let start = i;
+    let val = big ? 0n : 0;
     while (i < s.length) {
       let d = digitVal(s[i], base);
       if (d < 0) break;
-      val = val * base + d;
+      val = big ? val * BigInt(base) + BigInt(d) : val * base + d;
       i++;
     }
     if (endPtrAddr) this.mem.writeInt32(endPtrAddr, addr + i);
-    val = neg ? -val : val;
-    return val | 0;
+    return neg ? -val : val;
+  }
+
+  strtol(addr, endPtrAddr, base) {
+    return this._strtoScan(addr, endPtrAddr, base, false) | 0;
   }
 
   strtoul(addr, endPtrAddr, base) {
@@ -899,11 +1026,11 @@ class Runtime {
   }
 
   strtoll(addr, endPtrAddr, base) {
-    return this.strtol(addr, endPtrAddr, base);
+    return BigInt.asIntN(64, this._strtoScan(addr, endPtrAddr, base, true));
   }
 
   strtoull(addr, endPtrAddr, base) {
-    return this.strtoul(addr, endPtrAddr, base);
+    return BigInt.asUintN(64, this._strtoScan(addr, endPtrAddr, base, true));
   }
 
   strdup(addr) {
@@ -974,6 +1101,7 @@ class Runtime {
   }
 
   qsort(baseAddr, numItems, itemSize, compareFn) {
+    compareFn = this._fn(compareFn);
     // Read items into a JS array, sort, write back
     const items = [];
     for (let i = 0; i < numItems; i++) {
@@ -997,6 +1125,7 @@ class Runtime {
   }
 
   bsearch(keyAddr, baseAddr, numItems, itemSize, compareFn) {
+    compareFn = this._fn(compareFn);
     let lo = 0, hi = numItems - 1;
     while (lo <= hi) {
       const mid = (lo + hi) >>> 1;
@@ -9,5 +9,12 @@
 #include "src/preprocess.c"
 #include "src/parser.c"
 #include "src/sema.c"
+#include "src/inline.c"
+#include "src/fold.c"
+#include "src/licm.c"
+#include "src/cse.c"
+#include "src/range.c"
+#include "src/dse.c"
+#include "src/ir.c"
 #include "src/codegen.c"
 #include "src/main.c"
@@ -48,3 +48,150 @@ Node *node_ident(Arena *a, const char *name, SrcLoc loc) {
     n->name = name;
     return n;
 }
+
+static void visit_child_list(Node *list, void (*fn)(Node *child, void *ctx), void *ctx) {
+    for (Node *c = list; c; c = c->next)
+        fn(c, ctx);
+}
+
+void node_visit_children(Node *n, void (*fn)(Node *child, void *ctx), void *ctx) {
+    if (!n) return;
+    switch (n->kind) {
+    case ND_CALL:
+        fn(n->callee, ctx);
+        visit_child_list(n->args, fn, ctx);
+        break;
+    case ND_FUNC_DEF:
+        visit_child_list(n->func_params, fn, ctx);
+        if (n->func_body) fn(n->func_body, ctx);
+        break;
+    case ND_VAR_DECL:
+        if (n->var_init) fn(n->var_init, ctx);
+        break;
+    case ND_FOR:
+        visit_child_list(n->for_init, fn, ctx);
+        if (n->for_cond) fn(n->for_cond, ctx);
+        if (n->for_inc) fn(n->for_inc, ctx);
+        if (n->for_body) fn(n->for_body, ctx);
+        break;
+    case ND_SWITCH:
+        fn(n->switch_expr, ctx);
+        if (n->switch_body) fn(n->switch_body, ctx);
+        break;
+    case ND_CASE:
+        if (n->case_expr) fn(n->case_expr, ctx);
+        if (n->case_body) fn(n->case_body, ctx);
+        break;
+    case ND_BLOCK: case ND_PROGRAM: case ND_INIT_LIST:
+        visit_child_list(n->body, fn, ctx);
+        break;
+    case ND_SIZEOF_TYPE:
+        break;
+    case ND_CAST: case ND_COMPOUND_LIT:
+        if (n->cast_expr) fn(n->cast_expr, ctx);
+        break;
+    case ND_DESIGNATOR:
+        if (n->desig_index) fn(n->desig_index, ctx);
+        if (n->desig_init) fn(n->desig_init, ctx);
+        break;
+    default:
+        if (n->lhs) fn(n->lhs, ctx);
+        if (n->rhs) fn(n->rhs, ctx);
+        if (n->third) fn(n->third, ctx);
+        break;
+    }
+}
+
+Node *node_lvalue_root(Node *n) {
+    while (n->kind == ND_MEMBER ||
+           (n->kind == ND_SUBSCRIPT && n->lhs->type && n->lhs->type->kind == TY_ARRAY))
+        n = n->lhs;
+    return n->kind == ND_IDENT ? n : NULL;
+}
+
+Node *node_clone(Arena *a, Node *n, Node *(*map)(Node *n, void *ctx), void *ctx) {
+    if (!n) return NULL;
+    if (map) {
+        Node *r = map(n, ctx);
+        if (r) return r;
+    }
+    Node *c = arena_alloc(a, sizeof(Node));
+    *c = *n;
+    c->next = NULL;
+    switch (n->kind) {
+    case ND_CALL: {
+        Node head;
+        Node *tail = &head;
+        head.next = NULL;
+        c->callee = node_clone(a, n->callee, map, ctx);
+        for (Node *arg = n->args; arg; arg = arg->next) {
+            tail->next = node_clone(a, arg, map, ctx);
+            tail = tail->next;
+        }
+        c->args = head.next;
+        break;
+    }
+    case ND_CAST: case ND_SIZEOF_TYPE: case ND_COMPOUND_LIT: case ND_VA_ARG:
+        c->cast_expr = node_clone(a, n->cast_expr, map, ctx);
+        break;
+    default:
+        break;
+    }
+    c->lhs = node_clone(a, n->lhs, map, ctx);
+    c->rhs = node_clone(a, n->rhs, map, ctx);
+    c->third = node_clone(a, n->third, map, ctx);
+    return c;
+}
+
+static void find_setjmp(Node *n, void *ctx) {
+    bool *found = ctx;
+    if (*found) return;
+    if (n->kind == ND_CALL && n->callee->kind == ND_IDENT &&
+        strcmp(n->callee->name, "setjmp") == 0) {
+        *found = true;
+        return;
+    }
+    node_visit_children(n, find_setjmp, found);
+}
+
+bool node_contains_setjmp(Node *n) {
+    bool found = false;
+    if (n) find_setjmp(n, &found);
+    return found;
+}
+
+typedef struct {
+    const char *name;
+    bool        hit;
+} NameWrites;
+
+static void find_name_writes(Node *n, void *ctx) {
+    NameWrites *w = ctx;
+    if (!n || w->hit) return;
+    switch (n->kind) {
+    case ND_ASSIGN:
+    case ND_ADD_ASSIGN: case ND_SUB_ASSIGN: case ND_MUL_ASSIGN:
+    case ND_DIV_ASSIGN: case ND_MOD_ASSIGN:
+    case ND_LSHIFT_ASSIGN: case ND_RSHIFT_ASSIGN:
+    case ND_AND_ASSIGN: case ND_OR_ASSIGN: case ND_XOR_ASSIGN:
+    case ND_PRE_INC: case ND_PRE_DEC: case ND_POST_INC: case ND_POST_DEC:
+    case ND_ADDR:
+        if (n->lhs && n->lhs->kind == ND_IDENT && strcmp(n->lhs->name, w->name) == 0)
+            w->hit = true;
+        break;
+    case ND_VAR_DECL:
+        if (n->var_name && strcmp(n->var_name, w->name) == 0) w->hit = true;
+        break;
+    default:
+        break;
+    }
+    node_visit_children(n, find_name_writes, ctx);
+}
+
+bool node_writes_name(Node *n, const char *name) {
+    NameWrites w;
+    w.name = name;
+    w.hit = false;
+    if (n) find_name_writes(n, &w);
+    return w.hit;
+}
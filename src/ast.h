@@ -50,6 +50,8 @@ typedef enum {
     ND_SUBSCRIPT,     /* a[b] */
     ND_CAST,          /* (type)x */
     ND_COMPOUND_LIT,  /* (type){...} */
+    ND_VA_ARG,        /* va_arg(ap, type): lhs = ap, cast_type = type */
+    ND_LABEL_ADDR,    /* &&label (GNU labels as values) */
 
     /* Statements */
     ND_BLOCK,         /* { ... } */
@@ -64,7 +66,7 @@ typedef enum {
     ND_BREAK,
     ND_CONTINUE,
     ND_RETURN,
-    ND_GOTO,
+    ND_GOTO,          /* goto label; or goto *lhs (computed) */
     ND_LABEL,
     ND_NULL_STMT,     /* empty statement */
 
@@ -105,7 +107,7 @@ struct Node {
         struct { const char *sval; int slen; };
         /* ND_CHAR_LIT */
         int cval;
-        /* ND_IDENT, ND_VAR_DECL, ND_LABEL, ND_GOTO, ND_MEMBER, ND_MEMBER_PTR */
+        /* ND_IDENT, ND_VAR_DECL, ND_LABEL, ND_GOTO, ND_LABEL_ADDR, ND_MEMBER, ND_MEMBER_PTR */
         const char *name;
         /* ND_CALL */
         struct { Node *callee; Node *args; };
@@ -124,7 +126,7 @@ struct Node {
                  Node *case_next; };
         /* ND_BLOCK, ND_PROGRAM, ND_INIT_LIST */
         struct { Node *body; };
-        /* ND_SIZEOF_TYPE, ND_CAST, ND_COMPOUND_LIT */
+        /* ND_SIZEOF_TYPE, ND_CAST, ND_COMPOUND_LIT, ND_VA_ARG */
         struct { Type *cast_type; Node *cast_expr; };
         /* ND_DESIGNATOR */
         struct { const char *desig_name; Node *desig_index; Node *desig_init; };
@@ -140,4 +142,23 @@ Node *node_float_lit(Arena *a, double val, Type *type, SrcLoc loc);
 Node *node_string_lit(Arena *a, const char *s, int len, SrcLoc loc);
 Node *node_ident(Arena *a, const char *name, SrcLoc loc);
 
+/* Invoke fn on every direct child of n in source order.  Sibling lists
+ * (block bodies, call arguments, initializer items) are walked in full;
+ * n->next itself is not followed. */
+void node_visit_children(Node *n, void (*fn)(Node *child, void *ctx), void *ctx);
+
+/* Variable an lvalue designates as a whole (x, s.a, m[i] of an array
+ * variable), or NULL if it is reached through a pointer */
+Node *node_lvalue_root(Node *n);
+
+/* Deep copy of expression n.  map, when given, sees each node first; a
+ * non-NULL result is used in place of that node's copy. */
+Node *node_clone(Arena *a, Node *n, Node *(*map)(Node *n, void *ctx), void *ctx);
+
+/* Does n contain a call to setjmp()? */
+bool node_contains_setjmp(Node *n);
+
+/* Does n assign, redeclare or take the address of variable name? */
+bool node_writes_name(Node *n, const char *name);
+
 #endif /* C99JS_AST_H */
@@ -40,16 +40,18 @@ static void var_clear_locals(CodeGen *cg) {
     memset(cg->locals, 0, sizeof(cg->locals));
 }
 
-static void var_set_local(CodeGen *cg, const char *name, int addr, Type *type, bool is_param) {
+static CGVar *var_set_local(CodeGen *cg, const char *name, int addr, Type *type, bool is_param) {
     unsigned int h = var_hash(name);
     CGVar *v = arena_calloc(cg->arena, sizeof(CGVar));
     v->name = name;
     v->addr = addr;
     v->is_local = true;
     v->is_param = is_param;
+    v->storage = CGV_MEMORY;
     v->type = type;
     v->next = cg->locals[h];
     cg->locals[h] = v;
+    return v;
 }
 
 static CGVar *var_find_local(CodeGen *cg, const char *name) {
@@ -87,28 +89,40 @@ static CGVar *var_find(CodeGen *cg, const char *name) {
 
 /* ---- Type helpers ---- */
 
-/* True if type is long long (signed or unsigned) -- needs BigInt in JS */
-static bool type_is_u64(Type *t) {
+/* True if type is long long (signed or unsigned) -- a pair of int32 words
+ * in JS, see "64-bit integers" below */
+static bool type_is_i64(Type *t) {
     return t && t->kind == TY_LLONG;
 }
 
-/* True if an expression's result type is uint64_t (BigInt in JS) */
-static bool expr_is_u64(Node *n) {
-    return n && type_is_u64(n->type);
+/* True if an expression's result type is long long */
+static bool expr_is_i64(Node *n) {
+    return n && type_is_i64(n->type);
 }
 
-/* True if type is double or long double -- stored as BigInt raw bits in JS */
+/* True if type is double or long double -- a JS number, or BigInt raw bits
+ * under --nan-boxing */
 static bool type_is_double(Type *t) {
     return t && (t->kind == TY_DOUBLE || t->kind == TY_LDOUBLE);
 }
 
-/* True if an expression produces a double (BigInt raw bits in JS) */
+/* True if an expression produces a double */
 static bool expr_is_double(Node *n) {
     return n && type_is_double(n->type);
 }
 
+/* True if values of type t are BigInts in the generated JS */
+static bool type_is_bigint(CodeGen *cg, Type *t) {
+    return cg->nan_boxing && type_is_double(t);
+}
+
+/* Wrappers converting between a JS number and the double representation.
+ * Both are plain parentheses unless --nan-boxing is on. */
+static const char *f64_box(CodeGen *cg)   { return cg->nan_boxing ? "rt.f64bits(" : "("; }
+static const char *f64_unbox(CodeGen *cg) { return cg->nan_boxing ? "rt.f64(" : "("; }
+
 /* Memory class uses readXxx/writeXxx (always little-endian) */
-static const char *js_getter(Type *t) {
+static const char *js_getter(CodeGen *cg, Type *t) {
     if (!t) return "readInt32";
     switch (t->kind) {
     case TY_BOOL:  return "readUint8";
@@ -117,15 +131,15 @@ static const char *js_getter(Type *t) {
     case TY_INT: case TY_ENUM:
         return t->is_unsigned ? "readUint32" : "readInt32";
     case TY_LONG:  return t->is_unsigned ? "readUint32" : "readInt32";
-    case TY_LLONG: return t->is_unsigned ? "readBigUint64" : "readBigInt64";
     case TY_FLOAT: return "readFloat32";
-    case TY_DOUBLE: case TY_LDOUBLE: return "readBigUint64";
+    case TY_DOUBLE: case TY_LDOUBLE:
+        return cg->nan_boxing ? "readBigUint64" : "readFloat64";
     case TY_PTR:   return "readUint32";
     default:       return "readInt32";
     }
 }
 
-static const char *js_setter(Type *t) {
+static const char *js_setter(CodeGen *cg, Type *t) {
     if (!t) return "writeInt32";
     switch (t->kind) {
     case TY_BOOL:  return "writeUint8";
@@ -134,14 +148,126 @@ static const char *js_setter(Type *t) {
     case TY_INT: case TY_ENUM:
         return t->is_unsigned ? "writeUint32" : "writeInt32";
     case TY_LONG:  return t->is_unsigned ? "writeUint32" : "writeInt32";
-    case TY_LLONG: return t->is_unsigned ? "writeBigUint64" : "writeBigInt64";
     case TY_FLOAT: return "writeFloat32";
-    case TY_DOUBLE: case TY_LDOUBLE: return "writeBigUint64";
+    case TY_DOUBLE: case TY_LDOUBLE:
+        return cg->nan_boxing ? "writeBigUint64" : "writeFloat64";
     case TY_PTR:   return "writeUint32";
     default:       return "writeInt32";
     }
 }
 
+/* Typed-array heap view for naturally aligned accesses of type t, or NULL
+ * when the access must go through the DataView helpers (raw-bits doubles,
+ * under-aligned types).  64-bit integers are accessed as two int32 words. */
+static const char *heap_view(CodeGen *cg, Type *t) {
+    if (!t || t->size <= 0 || t->align < t->size) return NULL;
+    switch (t->kind) {
+    case TY_BOOL:  return "HEAPU8";
+    case TY_CHAR:  return t->is_unsigned ? "HEAPU8" : "HEAP8";
+    case TY_SHORT: return t->is_unsigned ? "HEAPU16" : "HEAP16";
+    case TY_INT: case TY_ENUM: case TY_LONG:
+        return t->is_unsigned ? "HEAPU32" : "HEAP32";
+    case TY_PTR:   return "HEAPU32";
+    case TY_FLOAT: return "HEAPF32";
+    case TY_DOUBLE: case TY_LDOUBLE:
+        return cg->nan_boxing ? NULL : "HEAPF64";
+    default:       return NULL;
+    }
+}
+
+/* log2 of the element size of a heap view */
+static int heap_shift(Type *t) {
+    switch (t->size) {
+    case 2: return 1;
+    case 4: return 2;
+    case 8: return 3;
+    default: return 0;
+    }
+}
+
+/* Loads and stores.  An access of type t at a naturally aligned address is
+ * emitted as HEAPxx[addr >> k]; anything else calls rt.mem.readXxx/writeXxx.
+ *   load:  emit_load_begin  <addr> emit_load_end
+ *   store: emit_store_begin <addr> emit_store_mid <value> emit_store_end */
+static void emit_load_begin(CodeGen *cg, Type *t, bool aligned) {
+    const char *view = aligned ? heap_view(cg, t) : NULL;
+    if (!view) emit(cg, "rt.mem.%s(", js_getter(cg, t));
+    else if (heap_shift(t)) emit(cg, "%s[(", view);
+    else emit(cg, "%s[", view);
+}
+
+static void emit_load_end(CodeGen *cg, Type *t, bool aligned) {
+    const char *view = aligned ? heap_view(cg, t) : NULL;
+    if (!view) emit(cg, ")");
+    else if (heap_shift(t)) emit(cg, ") >> %d]", heap_shift(t));
+    else emit(cg, "]");
+}
+
+static void emit_store_begin(CodeGen *cg, Type *t, bool aligned) {
+    const char *view = aligned ? heap_view(cg, t) : NULL;
+    if (!view) emit(cg, "rt.mem.%s(", js_setter(cg, t));
+    else if (heap_shift(t)) emit(cg, "%s[(", view);
+    else emit(cg, "%s[", view);
+}
+
+static void emit_store_mid(CodeGen *cg, Type *t, bool aligned) {
+    const char *view = aligned ? heap_view(cg, t) : NULL;
+    if (!view) emit(cg, ", ");
+    else if (heap_shift(t)) emit(cg, ") >> %d] = ", heap_shift(t));
+    else emit(cg, "] = ");
+}
+
+static void emit_store_end(CodeGen *cg, Type *t, bool aligned) {
+    if (!(aligned && heap_view(cg, t))) emit(cg, ")");
+}
+
+/* Load text for an address already rendered as a JS expression */
+static const char *mem_load_str(CodeGen *cg, Type *t, bool aligned, const char *addr) {
+    Buf b;
+    buf_init(&b);
+    const char *view = aligned ? heap_view(cg, t) : NULL;
+    if (!view)
+        buf_printf(&b, "rt.mem.%s(%s)", js_getter(cg, t), addr);
+    else if (heap_shift(t))
+        buf_printf(&b, "%s[%s >> %d]", view, addr, heap_shift(t));
+    else
+        buf_printf(&b, "%s[%s]", view, addr);
+    char *str = buf_detach(&b);
+    const char *res = arena_strdup(cg->arena, str);
+    free(str);
+    return res;
+}
+
+/* Emit the JS conversion that a store to memory of type t (followed by a
+ * reload) applies, so values held in JS locals match memory semantics. */
+static void emit_coerce_begin(CodeGen *cg, Type *t) {
+    switch (t ? t->kind : TY_INT) {
+    case TY_FLOAT:
+        emit(cg, "Math.fround(");
+        break;
+    case TY_DOUBLE: case TY_LDOUBLE:
+        emit(cg, cg->nan_boxing ? "BigInt.asUintN(64, BigInt(" : "Number((");
+        break;
+    default:
+        emit(cg, "((");
+        break;
+    }
+}
+
+static void emit_coerce_end(CodeGen *cg, Type *t) {
+    switch (t ? t->kind : TY_INT) {
+    case TY_BOOL:  emit(cg, ") & 255)"); break;
+    case TY_CHAR:  emit(cg, t->is_unsigned ? ") & 255)" : ") << 24 >> 24)"); break;
+    case TY_SHORT: emit(cg, t->is_unsigned ? ") & 65535)" : ") << 16 >> 16)"); break;
+    case TY_FLOAT: emit(cg, ")"); break;
+    case TY_DOUBLE: case TY_LDOUBLE: emit(cg, "))"); break;
+    case TY_PTR:   emit(cg, ") >>> 0)"); break;
+    default:
+        emit(cg, (t && t->is_unsigned) ? ") >>> 0)" : ") | 0)");
+        break;
+    }
+}
+
 static int type_sz(Type *t) {
     if (!t) return 4;
     return t->size > 0 ? t->size : 4;
@@ -151,13 +277,447 @@ static bool is_aggregate(Type *t) {
     return t && (t->kind == TY_STRUCT || t->kind == TY_UNION);
 }
 
+static bool var_in_js(CGVar *v) {
+    return v && v->storage == CGV_JSLOCAL;
+}
+
+/* ---- Escape analysis ----
+ * A scalar local lives in a JS variable instead of the linear-memory frame
+ * when its address is never taken and no setjmp region can observe it.
+ * The analysis is name-based (like the variable table), so a name whose
+ * address is taken anywhere in the function stays in memory everywhere. */
+
+/* Name sets (per function, keyed like the variable table) */
+static void name_set_add(CodeGen *cg, CGVar **set, const char *name) {
+    unsigned int h = var_hash(name);
+    for (CGVar *v = set[h]; v; v = v->next)
+        if (strcmp(v->name, name) == 0) return;
+    CGVar *v = arena_calloc(cg->arena, sizeof(CGVar));
+    v->name = name;
+    v->next = set[h];
+    set[h] = v;
+}
+
+static bool name_set_has(CGVar **set, const char *name) {
+    unsigned int h = var_hash(name);
+    for (CGVar *v = set[h]; v; v = v->next)
+        if (strcmp(v->name, name) == 0) return true;
+    return false;
+}
+
+static void addr_taken_add(CodeGen *cg, const char *name) {
+    name_set_add(cg, cg->addr_taken, name);
+}
+
+static bool addr_taken_has(CodeGen *cg, const char *name) {
+    return name_set_has(cg->addr_taken, name);
+}
+
+/* Variable whose storage an lvalue designates (x, x.a, x[i] for array x) */
+static Node *lvalue_base_ident(Node *n) {
+    while (n) {
+        if (n->kind == ND_MEMBER) {
+            n = n->lhs;
+        } else if (n->kind == ND_SUBSCRIPT && n->lhs->type &&
+                   type_is_array(n->lhs->type)) {
+            n = n->lhs;
+        } else {
+            break;
+        }
+    }
+    return (n && n->kind == ND_IDENT) ? n : NULL;
+}
+
+static bool is_call_to(Node *n, const char *name) {
+    return n->kind == ND_CALL && n->callee && n->callee->kind == ND_IDENT &&
+           strcmp(n->callee->name, name) == 0;
+}
+
+static void scan_escapes(Node *n, void *ctx) {
+    CodeGen *cg = ctx;
+    if (!n) return;
+    if (n->kind == ND_ADDR) {
+        Node *base = lvalue_base_ident(n->lhs);
+        if (base) addr_taken_add(cg, base->name);
+    } else if (is_call_to(n, "setjmp")) {
+        cg->func_promote = false;
+    }
+    node_visit_children(n, scan_escapes, ctx);
+}
+
+static bool var_can_promote(CodeGen *cg, const char *name, Type *ty) {
+    if (!cg->func_promote || !ty) return false;
+    if (!type_is_scalar(ty) || ty->kind == TY_COMPLEX) return false;
+    if (ty->qual & QUAL_VOLATILE) return false;
+    return !addr_taken_has(cg, name);
+}
+
+/* ---- Scalar replacement of aggregates ----
+ * A local struct whose address is never taken, and which is only used
+ * through scalar member accesses and whole-struct copies (assignment,
+ * initialization, return), lives in one JS local per scalar leaf field
+ * instead of the frame.  Copies become field-by-field assignments.  Like
+ * escape analysis this is name-based. */
+
+#define SROA_MAX_FIELDS 16
+
+/* Number of scalar leaves of a splittable struct, or -1 */
+static int sroa_leaf_count(Type *t) {
+    if (t->kind != TY_STRUCT || t->is_packed || t->is_flexible) return -1;
+    int n = 0;
+    for (Member *m = t->members; m; m = m->next) {
+        Type *mt = m->type;
+        if (!m->name || m->bit_width >= 0 || (mt->qual & QUAL_VOLATILE)) return -1;
+        if (mt->kind == TY_STRUCT) {
+            int k = sroa_leaf_count(mt);
+            if (k < 0) return -1;
+            n += k;
+        } else if (type_is_scalar(mt) && mt->kind != TY_COMPLEX) {
+            n++;
+        } else {
+            return -1;
+        }
+    }
+    return n;
+}
+
+/* ---- Register structs ----
+ * A struct of at most 16 bytes whose leaves are all scalars is passed to
+ * compiled functions as one JS argument per leaf field (long longs as two
+ * words) and returned in the module-level slots __r0, __r1, ..., one per
+ * argument word, which the caller reads right after the call. */
+
+#define REG_STRUCT_SIZE 16
+
+typedef struct {
+    int   off;
+    Type *type;
+} RegLeaf;
+
+static bool struct_in_regs(Type *t) {
+    return t && t->kind == TY_STRUCT && type_sz(t) <= REG_STRUCT_SIZE &&
+           sroa_leaf_count(t) > 0;
+}
+
+/* Append the scalar leaves of register struct t at offset base to out */
+static int reg_leaves(Type *t, int base, RegLeaf *out, int n) {
+    for (Member *m = t->members; m; m = m->next) {
+        if (m->type->kind == TY_STRUCT) {
+            n = reg_leaves(m->type, base + m->offset, out, n);
+            continue;
+        }
+        out[n].off = base + m->offset;
+        out[n].type = m->type;
+        n++;
+    }
+    return n;
+}
+
+static void agg_escape(CodeGen *cg, const char *name) {
+    name_set_add(cg, cg->agg_escapes, name);
+}
+
+static bool agg_escaped(CodeGen *cg, const char *name) {
+    return name_set_has(cg->agg_escapes, name);
+}
+
+/* Record names used as whole objects anywhere but in a copy.  `discard`
+ * mirrors gen_discard: an aggregate assignment whose value is unused. */
+static void scan_agg_uses(CodeGen *cg, Node *n, bool discard);
+
+static void scan_agg_child(Node *n, void *ctx) {
+    scan_agg_uses(ctx, n, false);
+}
+
+static void scan_agg_uses(CodeGen *cg, Node *n, bool discard) {
+    if (!n) return;
+    switch (n->kind) {
+    case ND_IDENT:
+        agg_escape(cg, n->name);
+        return;
+    case ND_MEMBER: {
+        Node *root = node_lvalue_root(n);
+        if (!root) break;
+        /* Only s.a.b chains are split: an array element escapes its root */
+        bool whole = !type_is_scalar(n->type);
+        for (Node *p = n; p != root; p = p->lhs)
+            if (p->kind == ND_SUBSCRIPT) {
+                whole = true;
+                scan_agg_uses(cg, p->rhs, false);
+            }
+        if (whole) agg_escape(cg, root->name);
+        return;
+    }
+    case ND_SIZEOF:
+        return;
+    case ND_ASSIGN:
+        if (!is_aggregate(n->type)) break;
+        if (!discard || n->lhs->kind != ND_IDENT) scan_agg_uses(cg, n->lhs, false);
+        if (n->rhs->kind != ND_IDENT) scan_agg_uses(cg, n->rhs, false);
+        return;
+    case ND_EXPR_STMT:
+        scan_agg_uses(cg, n->lhs, true);
+        return;
+    case ND_COMMA:
+        scan_agg_uses(cg, n->lhs, true);
+        scan_agg_uses(cg, n->rhs, discard);
+        return;
+    case ND_CAST:
+        scan_agg_uses(cg, n->cast_expr, n->cast_type && n->cast_type->kind == TY_VOID);
+        return;
+    case ND_FOR:
+        for (Node *i = n->for_init; i; i = i->next) scan_agg_uses(cg, i, true);
+        scan_agg_uses(cg, n->for_cond, false);
+        scan_agg_uses(cg, n->for_inc, true);
+        scan_agg_uses(cg, n->for_body, false);
+        return;
+    case ND_VAR_DECL:
+        if (n->var_init && n->var_init->kind != ND_IDENT)
+            scan_agg_uses(cg, n->var_init, false);
+        return;
+    case ND_RETURN:
+        if (n->lhs && n->lhs->kind == ND_IDENT && is_aggregate(n->lhs->type)) return;
+        break;
+    case ND_CALL: {
+        /* Register struct arguments are passed field by field */
+        Type *ft = n->callee->type;
+        if (ft && ft->kind == TY_PTR) ft = ft->base;
+        Param *p = ft && ft->kind == TY_FUNC ? ft->params : NULL;
+        scan_agg_uses(cg, n->callee, false);
+        for (Node *a = n->args; a; a = a->next) {
+            if (!(p && a->kind == ND_IDENT && struct_in_regs(p->type)))
+                scan_agg_uses(cg, a, false);
+            if (p) p = p->next;
+        }
+        return;
+    }
+    default:
+        break;
+    }
+    node_visit_children(n, scan_agg_child, cg);
+}
+
+/* Can local struct `name` of type ty be split into field locals? */
+static bool agg_can_split(CodeGen *cg, const char *name, Type *ty) {
+    if (!cg->func_promote || !ty || (ty->qual & QUAL_VOLATILE)) return false;
+    int n = sroa_leaf_count(ty);
+    if (n <= 0 || n > SROA_MAX_FIELDS) return false;
+    return !addr_taken_has(cg, name) && !agg_escaped(cg, name);
+}
+
+/* Field local that member chain n (s.a, s.a.b) of a split struct names */
+static CGVar *sroa_field(CodeGen *cg, Node *n) {
+    if (n->kind != ND_MEMBER || !type_is_scalar(n->type)) return NULL;
+    int off = 0;
+    Node *r = n;
+    while (r->kind == ND_MEMBER) {
+        Member *m = r->lhs->type ? type_find_member(r->lhs->type, r->name) : NULL;
+        if (!m) return NULL;
+        off += m->offset;
+        r = r->lhs;
+    }
+    if (r->kind != ND_IDENT) return NULL;
+    CGVar *v = var_find(cg, r->name);
+    if (!v || v->storage != CGV_FIELDS) return NULL;
+    for (CGVar *f = v->fields; f; f = f->next)
+        if (f->addr == off) return f;
+    return NULL;
+}
+
+/* The split struct an identifier names, or NULL */
+static CGVar *split_var(CodeGen *cg, Node *n) {
+    if (!n || n->kind != ND_IDENT) return NULL;
+    CGVar *v = var_find(cg, n->name);
+    return v && v->storage == CGV_FIELDS ? v : NULL;
+}
+
+/* Does a block-scope declaration occupy a frame slot? */
+static bool decl_in_frame(CodeGen *cg, Node *decl) {
+    if (decl->var_sc == SC_STATIC || decl->var_sc == SC_EXTERN) return false;
+    return !var_can_promote(cg, decl->var_name, decl->type) &&
+           !agg_can_split(cg, decl->var_name, decl->type);
+}
+
+static bool call_passes_va_area(CodeGen *cg, Node *n);
+
+static void scan_frame_needs(Node *n, void *ctx);
+
+/* Scan the callee and arguments of call n */
+static void scan_frame_call(CodeGen *cg, Node *n);
+
+/* Scan e; a register struct call there is consumed from the return slots
+ * and needs no temporary */
+static void scan_frame_value(CodeGen *cg, Node *e) {
+    if (e && e->kind == ND_CALL && struct_in_regs(e->type) && !call_passes_va_area(cg, e))
+        scan_frame_call(cg, e);
+    else
+        scan_frame_needs(e, cg);
+}
+
+static void scan_frame_call(CodeGen *cg, Node *n) {
+    Type *ft = n->callee->type;
+    if (ft && ft->kind == TY_PTR) ft = ft->base;
+    Param *p = ft && ft->kind == TY_FUNC ? ft->params : NULL;
+    scan_frame_needs(n->callee, cg);
+    for (Node *a = n->args; a; a = a->next) {
+        if (p && struct_in_regs(p->type)) scan_frame_value(cg, a);
+        else scan_frame_needs(a, cg);
+        if (p) p = p->next;
+    }
+}
+
+static void scan_frame_needs(Node *n, void *ctx) {
+    CodeGen *cg = ctx;
+    if (!n || cg->func_has_frame) return;
+    switch (n->kind) {
+    case ND_VAR_DECL:
+        if (decl_in_frame(cg, n)) {
+            cg->func_has_frame = true;
+            return;
+        }
+        scan_frame_value(cg, n->var_init);
+        return;
+    case ND_CALL:
+        if (is_aggregate(n->type) || call_passes_va_area(cg, n)) {
+            cg->func_has_frame = true; /* struct-return temporary or va area */
+            return;
+        }
+        scan_frame_call(cg, n);
+        return;
+    case ND_ASSIGN:
+        if (!is_aggregate(n->type)) break;
+        scan_frame_needs(n->lhs, cg);
+        scan_frame_value(cg, n->rhs);
+        return;
+    case ND_EXPR_STMT: case ND_RETURN:
+        scan_frame_value(cg, n->lhs);
+        return;
+    default:
+        break;
+    }
+    node_visit_children(n, scan_frame_needs, ctx);
+}
+
+/* Run escape analysis over a function definition and decide whether it
+ * needs a linear-memory frame at all. */
+static void analyze_func_storage(CodeGen *cg, Node *fn) {
+    memset(cg->addr_taken, 0, sizeof(cg->addr_taken));
+    memset(cg->agg_escapes, 0, sizeof(cg->agg_escapes));
+    cg->func_promote = true;
+    scan_escapes(fn->func_body, cg);
+    scan_agg_uses(cg, fn->func_body, false);
+
+    cg->func_has_frame = !cg->func_promote;
+    for (Param *p = fn->type->params; p; p = p->next) {
+        if (p->name && !var_can_promote(cg, p->name, p->type) &&
+            !(struct_in_regs(p->type) && agg_can_split(cg, p->name, p->type)))
+            cg->func_has_frame = true;
+    }
+    scan_frame_needs(fn->func_body, cg);
+}
+
+/* Make v a JS local named js_name, declared at function top */
+static void jslocal_declare(CodeGen *cg, CGVar *v, const char *js_name) {
+    char buf[256];
+    v->storage = CGV_JSLOCAL;
+    v->js_name = js_name;
+    buf_printf(&cg->jslocal_decls, "%s%s = %s",
+               cg->jslocal_decls.len ? ", " : "", js_name,
+               type_is_bigint(cg, v->type) ? "0n" : "0");
+    if (type_is_i64(v->type)) {
+        snprintf(buf, sizeof(buf), "%s$h", js_name);
+        v->js_hi = arena_strdup(cg->arena, buf);
+        buf_printf(&cg->jslocal_decls, ", %s = 0", v->js_hi);
+    }
+}
+
+/* Bind a promoted local to a fresh JS identifier (declared at function top) */
+static CGVar *var_set_jslocal(CodeGen *cg, const char *name, Type *type) {
+    const char *js_name;
+    char buf[256];
+    if (var_find_local(cg, name)) {
+        snprintf(buf, sizeof(buf), "l_%s_%d", name, cg->tmp_count++);
+    } else {
+        snprintf(buf, sizeof(buf), "l_%s", name);
+    }
+    js_name = arena_strdup(cg->arena, buf);
+    CGVar *v = var_set_local(cg, name, 0, type, false);
+    jslocal_declare(cg, v, js_name);
+    return v;
+}
+
+/* Add the scalar leaves of struct t at offset base to the field list.
+ * Parameter fields are JS arguments and need no declaration. */
+static CGVar **var_add_fields(CodeGen *cg, CGVar **tail, Type *t, int base, const char *prefix,
+                              bool is_param) {
+    for (Member *m = t->members; m; m = m->next) {
+        char buf[256];
+        snprintf(buf, sizeof(buf), "%s$%s", prefix, m->name);
+        if (m->type->kind == TY_STRUCT) {
+            tail = var_add_fields(cg, tail, m->type, base + m->offset,
+                                  arena_strdup(cg->arena, buf), is_param);
+            continue;
+        }
+        CGVar *f = arena_calloc(cg->arena, sizeof(CGVar));
+        f->name = m->name;
+        f->addr = base + m->offset;
+        f->is_local = true;
+        f->is_param = is_param;
+        f->type = m->type;
+        if (is_param) {
+            f->storage = CGV_JSLOCAL;
+            f->js_name = arena_strdup(cg->arena, buf);
+            if (type_is_i64(f->type)) {
+                snprintf(buf, sizeof(buf), "%s$%s$h", prefix, m->name);
+                f->js_hi = arena_strdup(cg->arena, buf);
+            }
+        } else {
+            jslocal_declare(cg, f, arena_strdup(cg->arena, buf));
+        }
+        *tail = f;
+        tail = &f->next;
+    }
+    return tail;
+}
+
+/* Bind a split struct local: one JS local per scalar leaf field */
+static CGVar *var_set_fields(CodeGen *cg, const char *name, Type *type) {
+    char buf[256];
+    if (var_find_local(cg, name)) {
+        snprintf(buf, sizeof(buf), "l_%s_%d", name, cg->tmp_count++);
+    } else {
+        snprintf(buf, sizeof(buf), "l_%s", name);
+    }
+    CGVar *v = var_set_local(cg, name, 0, type, false);
+    v->storage = CGV_FIELDS;
+    var_add_fields(cg, &v->fields, type, 0, arena_strdup(cg->arena, buf), false);
+    return v;
+}
+
 /* Forward declarations */
 static void gen_expr(CodeGen *cg, Node *n);
 static void gen_addr(CodeGen *cg, Node *n);
+static void gen_cond(CodeGen *cg, Node *n);
+static void gen_i64(CodeGen *cg, Node *n);
+static void gen_update_i64(CodeGen *cg, Node *n, bool want_value);
+static void gen_va_arg(CodeGen *cg, Node *n);
 static void gen_stmt(CodeGen *cg, Node *n);
 static void gen_block_stmts(CodeGen *cg, Node *stmts);
+static void gen_breakable(CodeGen *cg, Node *body, const char *break_label);
 static int alloc_local(CodeGen *cg, Type *ty);
+static int func_id(CodeGen *cg, const char *name);
+static CGStr *str_lit(CodeGen *cg, const char *s, int len);
+static bool image_init(CodeGen *cg, int addr, Type *ty, Node *init);
+static bool gen_local_template(CodeGen *cg, int off, Type *ty, Node *init);
+static void gen_init_zero(CodeGen *cg, int off, Type *ty, Node *init);
 static void gen_global_init(CodeGen *cg, int addr, Type *ty, Node *init);
+static void gen_fields_init_at(CodeGen *cg, CGVar *v, int base, Type *ty, Node *init,
+                               unsigned *set, int *n);
+static void gen_fields_store(CodeGen *cg, CGVar *v, const char *base, int off, int *n);
+static bool call_in_slots(Node *n);
+static bool sret_into(CodeGen *cg, Node *call, CGVar *v, bool declared);
+static void gen_reg_store_slots(CodeGen *cg, Type *t, const char *base, int off);
+static void gen_reg_args(CodeGen *cg, Node *a);
 
 static int global_offset = 4096;
 
@@ -166,28 +726,115 @@ void codegen_init(CodeGen *cg, Arena *a, SymTab *st) {
     buf_init(&cg->out);
     buf_init(&cg->data_section);
     buf_init(&cg->decl_section);
-    buf_init(&cg->goto_labels);
+    buf_init(&cg->jslocal_decls);
+    buf_init(&cg->func_table);
+    buf_init(&cg->switch_tables);
+    buf_init(&cg->image);
+    buf_init(&cg->str_pool);
+    memset(cg->strs, 0, sizeof(cg->strs));
+    cg->relocs = NULL;
     cg->indent = 0;
     cg->label_count = 0;
     cg->str_count = 0;
     cg->tmp_count = 0;
+    cg->ret_slots = 0;
+    cg->rret_bare = false;
+    cg->sret_dest = NULL;
     cg->stack_offset = 0;
     cg->in_func = false;
+    cse_init(&cg->cse, a);
+    range_init(&cg->ranges, a);
     cg->has_goto = false;
+    cg->goto_labels = NULL;
+    cg->goto_lists = NULL;
+    cg->gotos = NULL;
     cg->goto_state = 0;
+    cg->continue_label = NULL;
     cg->symtab = st;
     cg->setjmp_counter = 0;
     cg->current_setjmp_id = -1;
+    cg->nan_boxing = false;
+    cg->switch_mode = SWITCH_AUTO;
+    cg->break_label = NULL;
     memset(cg->locals, 0, sizeof(cg->locals));
     memset(cg->globals, 0, sizeof(cg->globals));
+    memset(cg->funcs, 0, sizeof(cg->funcs));
+    memset(cg->func_ids, 0, sizeof(cg->func_ids));
+    memset(cg->fp_locals, 0, sizeof(cg->fp_locals));
+    memset(cg->fp_globals, 0, sizeof(cg->fp_globals));
+    cg->func_count = 0;
 }
 
 /* ---- Address generation ---- */
+
+/* Emit an index scaled by the element size for address arithmetic.
+ * Constant indices are scaled at compile time; a long long index
+ * contributes its low word. */
+static void gen_scaled_index(CodeGen *cg, Node *idx, int esz) {
+    if (idx->kind == ND_INT_LIT) {
+        emit(cg, "%d", (int)idx->ival * esz);
+        return;
+    }
+    gen_expr(cg, idx);
+    if (esz > 1) emit(cg, " * %d", esz);
+}
+
+/* Member and constant-index element chains rooted at a named object have
+ * an address known up to bp: fold it into a single offset.  Sets *local
+ * when the offset is frame-relative. */
+static bool const_addr(CodeGen *cg, Node *n, bool *local, int *off) {
+    switch (n->kind) {
+    case ND_IDENT: {
+        CGVar *v = var_find(cg, n->name);
+        if (!v || v->storage != CGV_MEMORY) return false;
+        *local = v->is_local;
+        *off = v->addr;
+        return true;
+    }
+    case ND_MEMBER: {
+        Member *m = n->lhs->type ? type_find_member(n->lhs->type, n->name) : NULL;
+        if (!m || !const_addr(cg, n->lhs, local, off)) return false;
+        *off += m->offset;
+        return true;
+    }
+    case ND_SUBSCRIPT: {
+        /* Only arrays stored in the object itself; a pointer must be loaded */
+        Node *base = n->lhs;
+        Type *bt = NULL;
+        if (n->rhs->kind != ND_INT_LIT) return false;
+        if (base->kind == ND_IDENT) {
+            CGVar *v = var_find(cg, base->name);
+            bt = v ? v->type : NULL;
+        } else if (base->kind == ND_MEMBER && base->lhs->type) {
+            Member *m = type_find_member(base->lhs->type, base->name);
+            bt = m ? m->type : NULL;
+        }
+        if (!bt || bt->kind != TY_ARRAY || !const_addr(cg, base, local, off)) return false;
+        *off += (int)n->rhs->ival * type_sz(n->type);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
 static void gen_addr(CodeGen *cg, Node *n) {
+    if (n->kind == ND_MEMBER || n->kind == ND_SUBSCRIPT) {
+        bool local;
+        int off;
+        if (const_addr(cg, n, &local, &off)) {
+            if (local) emit(cg, "(bp + (%d))", off);
+            else emit(cg, "%d", off);
+            return;
+        }
+    }
     switch (n->kind) {
     case ND_IDENT: {
         CGVar *v = var_find(cg, n->name);
-        if (v && v->is_local) {
+        if (v && v->storage != CGV_MEMORY) {
+            error_at(n->loc, "internal error: address of register variable '%s'", n->name);
+            emit(cg, "0");
+        } else if (v && v->is_local) {
             emit(cg, "(bp + (%d))", v->addr);
         } else if (v) {
             emit(cg, "%d", v->addr);
@@ -195,7 +842,7 @@ static void gen_addr(CodeGen *cg, Node *n) {
             /* Could be &func → function pointer ID */
             Symbol *sym = symtab_lookup(cg->symtab, n->name);
             if (sym && sym->kind == SYM_FUNC) {
-                emit(cg, "__fp_%s", n->name);
+                emit(cg, "%d", func_id(cg, n->name));
             } else {
                 emit(cg, "0 /* unknown: %s */", n->name);
             }
@@ -225,22 +872,134 @@ static void gen_addr(CodeGen *cg, Node *n) {
         emit(cg, "(");
         gen_expr(cg, n->lhs);
         emit(cg, " + ");
-        /* When index is BigInt (long long), convert to Number for address arithmetic */
-        bool idx_bigint = expr_is_u64(n->rhs);
-        if (idx_bigint) emit(cg, "Number(");
-        gen_expr(cg, n->rhs);
-        if (idx_bigint) emit(cg, ")");
-        if (n->type && type_sz(n->type) > 1)
-            emit(cg, " * %d", type_sz(n->type));
+        gen_scaled_index(cg, n->rhs, n->type ? type_sz(n->type) : 1);
         emit(cg, ")");
         break;
     }
+    case ND_CALL: case ND_CAST: case ND_TERNARY: case ND_COMMA:
+        /* Struct-valued expressions evaluate to the address of their value */
+        if (is_aggregate(n->type)) {
+            gen_expr(cg, n);
+            break;
+        }
+        emit(cg, "0 /* cannot take addr */");
+        break;
     default:
         emit(cg, "0 /* cannot take addr */");
         break;
     }
 }
 
+/* ---- Alignment ----
+ * Frame slots, globals and heap blocks are naturally aligned, so typed
+ * accesses may use the HEAPxx views.  The exceptions are members of packed
+ * structs and pointers produced by casting from a less-aligned pointer
+ * (e.g. (uint32_t *)(buf + 1)), from void * or from an integer.  A pointer
+ * local assigned such a value anywhere in the function is misaligned at
+ * every use; so is one assigned from another such local. */
+static bool lvalue_aligned(CodeGen *cg, Node *n);
+static bool ptr_maybe_misaligned(CodeGen *cg, Node *p);
+
+/* May converting pointer expression e to pointer type `to` misalign it?
+ * Fresh blocks from the allocator are aligned for any type. */
+static bool ptr_conv_misaligned(CodeGen *cg, Type *to, Node *e) {
+    Type *from = e ? e->type : NULL;
+    if (!to || to->kind != TY_PTR || !to->base || to->base->align <= 1)
+        return false;
+    if (!from || !(from->kind == TY_PTR || from->kind == TY_ARRAY) || !from->base)
+        return true;
+    if (from->base->kind != TY_VOID && from->base->align >= to->base->align)
+        return ptr_maybe_misaligned(cg, e);
+    return !(is_call_to(e, "malloc") || is_call_to(e, "calloc") ||
+             is_call_to(e, "realloc"));
+}
+
+static bool ptr_maybe_misaligned(CodeGen *cg, Node *p) {
+    if (!p) return false;
+    switch (p->kind) {
+    case ND_CAST:
+        return ptr_conv_misaligned(cg, p->cast_type, p->cast_expr);
+    case ND_IDENT:
+        return name_set_has(cg->misaligned, p->name);
+    case ND_ADD: case ND_SUB:
+        if (p->lhs && p->lhs->type && (type_is_ptr(p->lhs->type) || type_is_array(p->lhs->type)))
+            return ptr_maybe_misaligned(cg, p->lhs);
+        if (p->rhs && p->rhs->type && (type_is_ptr(p->rhs->type) || type_is_array(p->rhs->type)))
+            return ptr_maybe_misaligned(cg, p->rhs);
+        return false;
+    case ND_ADDR:
+        return !lvalue_aligned(cg, p->lhs);
+    case ND_MEMBER: case ND_MEMBER_PTR: case ND_SUBSCRIPT: case ND_DEREF:
+        /* array-typed lvalue decaying to a pointer */
+        return p->type && p->type->kind == TY_ARRAY ? !lvalue_aligned(cg, p) : false;
+    case ND_ASSIGN: case ND_COMMA:
+        return ptr_maybe_misaligned(cg, p->rhs);
+    case ND_TERNARY:
+        return ptr_maybe_misaligned(cg, p->rhs) || ptr_maybe_misaligned(cg, p->third);
+    default:
+        return false;
+    }
+}
+
+/* True if the address of lvalue n is a multiple of its type's alignment */
+static bool lvalue_aligned(CodeGen *cg, Node *n) {
+    if (!n) return true;
+    switch (n->kind) {
+    case ND_DEREF:
+        return !ptr_maybe_misaligned(cg, n->lhs);
+    case ND_SUBSCRIPT:
+        return !ptr_maybe_misaligned(cg, n->lhs);
+    case ND_MEMBER:
+        if (n->lhs && n->lhs->type && n->lhs->type->is_packed) return false;
+        return lvalue_aligned(cg, n->lhs);
+    case ND_MEMBER_PTR: {
+        Type *pt = n->lhs ? n->lhs->type : NULL;
+        if (pt && pt->base && pt->base->is_packed) return false;
+        return !ptr_maybe_misaligned(cg, n->lhs);
+    }
+    default:
+        return true;
+    }
+}
+
+typedef struct {
+    CodeGen *cg;
+    bool     added;
+} MisalignScan;
+
+static void scan_misaligned(Node *n, void *ctx) {
+    MisalignScan *ms = ctx;
+    if (!n) return;
+    const char *name = NULL;
+    Type *ty = NULL;
+    Node *val = NULL;
+    if (n->kind == ND_VAR_DECL && n->var_init && n->var_init->kind != ND_INIT_LIST) {
+        name = n->var_name;
+        ty = n->type;
+        val = n->var_init;
+    } else if (n->kind == ND_ASSIGN && n->lhs->kind == ND_IDENT) {
+        name = n->lhs->name;
+        ty = n->lhs->type;
+        val = n->rhs;
+    }
+    if (name && ty && ty->kind == TY_PTR && !name_set_has(ms->cg->misaligned, name) &&
+        ptr_conv_misaligned(ms->cg, ty, val)) {
+        name_set_add(ms->cg, ms->cg->misaligned, name);
+        ms->added = true;
+    }
+    node_visit_children(n, scan_misaligned, ctx);
+}
+
+static void analyze_func_alignment(CodeGen *cg, Node *fn) {
+    memset(cg->misaligned, 0, sizeof(cg->misaligned));
+    MisalignScan ms;
+    ms.cg = cg;
+    do {
+        ms.added = false;
+        scan_misaligned(fn->func_body, &ms);
+    } while (ms.added);
+}
+
 /* Check if a function call is a known C library function */
 static bool is_stdlib_func(const char *name) {
     static const char *names[] = {
@@ -257,6 +1016,7 @@ static bool is_stdlib_func(const char *name) {
         "puts","putchar","getchar","getc","putc","gets","assert","perror",
         "clock","time","difftime","localtime","strftime",
         "strdup","strtoll","strtoul","strtoull","vsnprintf","vfprintf",
+        "vprintf","vsprintf",
         "__errno_ptr","freopen","signal",
         "open","read","close",
         NULL
@@ -297,117 +1057,1471 @@ static bool is_math_func(const char *name) {
     return math_func_js_name(name) != NULL;
 }
 
-/* ---- setjmp detection helpers ---- */
+/* ---- Reachability ----
+ * Only functions reachable from main are emitted: the closure of the
+ * functions named, as callees or as values, by main and by the global
+ * initializers (data may hold function pointers).  Names are matched
+ * without regard to scope, so a local shadowing a function merely keeps
+ * it alive.  A program without main keeps everything. */
 
-/* Recursively check if an expression tree contains a setjmp() call */
-static bool contains_setjmp_expr(Node *n) {
-    if (!n) return false;
-    if (n->kind == ND_CALL && n->callee && n->callee->kind == ND_IDENT &&
-        strcmp(n->callee->name, "setjmp") == 0)
-        return true;
-    /* Check standard children (lhs/rhs/third are separate from union) */
-    if (contains_setjmp_expr(n->lhs)) return true;
-    if (contains_setjmp_expr(n->rhs)) return true;
-    if (contains_setjmp_expr(n->third)) return true;
-    /* Check union-specific children */
-    switch (n->kind) {
-    case ND_CALL:
-        if (contains_setjmp_expr(n->callee)) return true;
-        for (Node *a = n->args; a; a = a->next)
-            if (contains_setjmp_expr(a)) return true;
-        break;
-    case ND_CAST: case ND_COMPOUND_LIT:
-        if (contains_setjmp_expr(n->cast_expr)) return true;
-        break;
-    default: break;
-    }
-    return false;
+static CGFunc *func_def_find(CodeGen *cg, const char *name) {
+    unsigned int h = var_hash(name);
+    for (CGFunc *f = cg->funcs[h]; f; f = f->next)
+        if (strcmp(f->name, name) == 0) return f;
+    return NULL;
 }
 
-/* Check if a statement's immediate expressions contain setjmp() */
-static bool stmt_contains_setjmp(Node *n) {
-    if (!n) return false;
-    switch (n->kind) {
-    case ND_EXPR_STMT:
-        return contains_setjmp_expr(n->lhs);
-    case ND_IF:
-    case ND_WHILE:
-    case ND_DO_WHILE:
-        return contains_setjmp_expr(n->lhs);
-    case ND_FOR:
-        return contains_setjmp_expr(n->for_cond) ||
-               contains_setjmp_expr(n->for_init) ||
-               contains_setjmp_expr(n->for_inc);
-    case ND_SWITCH:
-        return contains_setjmp_expr(n->switch_expr);
-    case ND_VAR_DECL:
-        return n->var_init && contains_setjmp_expr(n->var_init);
-    case ND_RETURN:
-        return contains_setjmp_expr(n->lhs);
-    default:
-        return false;
-    }
-}
+typedef struct {
+    CodeGen *cg;
+    Node   **work;    /* reachable functions whose bodies are unscanned */
+    int      nwork;
+} ReachScan;
 
-/* ---- Expression generation ---- */
-static void gen_expr(CodeGen *cg, Node *n);
+static void reach_func(ReachScan *s, CGFunc *f) {
+    if (f->reachable) return;
+    f->reachable = true;
+    s->work[s->nwork++] = f->def;
+}
 
-/* Emit expression as a JS float64 number (not BigInt).
- * Doubles (BigInt raw bits) are converted via rt.f64(),
- * uint64_t (BigInt integer) via Number().
- * Other types (int, float) are already JS numbers. */
-static void gen_f64_val(CodeGen *cg, Node *n) {
-    if (expr_is_double(n)) {
-        emit(cg, "rt.f64("); gen_expr(cg, n); emit(cg, ")");
-    } else if (expr_is_u64(n)) {
-        emit(cg, "Number("); gen_expr(cg, n); emit(cg, ")");
-    } else {
-        gen_expr(cg, n);
+static void scan_reach(Node *n, void *ctx) {
+    if (!n) return;
+    ReachScan *s = ctx;
+    if (n->kind == ND_IDENT) {
+        CGFunc *f = func_def_find(s->cg, n->name);
+        if (f) reach_func(s, f);
     }
+    node_visit_children(n, scan_reach, ctx);
 }
 
-static void gen_expr(CodeGen *cg, Node *n) {
-    if (!n) { emit(cg, "0"); return; }
+static void analyze_reachability(CodeGen *cg, Node *program) {
+    int nfuncs = 0;
+    for (Node *n = program->body; n; n = n->next) {
+        if (n->kind != ND_FUNC_DEF || func_def_find(cg, n->func_name)) continue;
+        unsigned int h = var_hash(n->func_name);
+        CGFunc *f = arena_calloc(cg->arena, sizeof(CGFunc));
+        f->name = n->func_name;
+        f->def = n;
+        f->next = cg->funcs[h];
+        cg->funcs[h] = f;
+        nfuncs++;
+    }
 
-    switch (n->kind) {
+    CGFunc *entry = func_def_find(cg, "main");
+    if (!entry) {
+        for (int h = 0; h < CG_VAR_TABLE_SIZE; h++)
+            for (CGFunc *f = cg->funcs[h]; f; f = f->next) f->reachable = true;
+        return;
+    }
+
+    ReachScan s;
+    s.cg = cg;
+    s.work = arena_alloc(cg->arena, (nfuncs + 1) * sizeof(Node *));
+    s.nwork = 0;
+    reach_func(&s, entry);
+    for (Node *n = program->body; n; n = n->next) {
+        if (n->kind == ND_VAR_DECL && n->var_sc != SC_TYPEDEF)
+            scan_reach(n, &s);
+    }
+    while (s.nwork > 0) {
+        Node *fn = s.work[--s.nwork];
+        scan_reach(fn->func_body, &s);
+    }
+}
+
+static bool func_is_defined(CodeGen *cg, const char *name) {
+    return func_def_find(cg, name) != NULL;
+}
+
+static bool func_is_emitted(CodeGen *cg, Node *fn) {
+    CGFunc *f = func_def_find(cg, fn->func_name);
+    return f && f->reachable && f->def == fn;
+}
+
+/* ---- Function table ----
+ * A function used as a value is its index into the module-level __ft
+ * array.  IDs are compile-time constants handed out on first use, so
+ * only functions whose address is taken get a table entry.  ID 0 is
+ * the null pointer. */
+
+static CGVar *func_id_find(CodeGen *cg, const char *name) {
+    unsigned int h = var_hash(name);
+    for (CGVar *v = cg->func_ids[h]; v; v = v->next)
+        if (strcmp(v->name, name) == 0) return v;
+    return NULL;
+}
+
+/* ID of function `name` */
+static int func_id(CodeGen *cg, const char *name) {
+    CGVar *v = func_id_find(cg, name);
+    if (v) return v->addr;
+    unsigned int h = var_hash(name);
+    v = arena_calloc(cg->arena, sizeof(CGVar));
+    v->name = name;
+    v->addr = ++cg->func_count;
+    v->next = cg->func_ids[h];
+    cg->func_ids[h] = v;
+
+    /* Library functions are reached through the runtime */
+    if (func_is_defined(cg, name))
+        buf_printf(&cg->func_table, "  _%s,\n", name);
+    else if (is_math_func(name) && !cg->nan_boxing)
+        buf_printf(&cg->func_table, "  Math.%s,\n", math_func_js_name(name));
+    else if (is_stdlib_func(name))
+        buf_printf(&cg->func_table, "  rt.%s.bind(rt),\n", name);
+    else
+        buf_printf(&cg->func_table, "  null, /* %s */\n", name);
+    return v->addr;
+}
+
+/* ---- Devirtualization ----
+ * A function-pointer variable that is initialized from a function defined
+ * here and never written or address-taken afterwards always holds that
+ * function, so calls through it can call the function directly.  Like
+ * escape analysis this is name-based: a name declared twice in its scope
+ * (or, for globals, anywhere in a function) is left alone. */
+
+static CGVar *fp_bind_find(CGVar **tab, const char *name) {
+    unsigned int h = var_hash(name);
+    for (CGVar *v = tab[h]; v; v = v->next)
+        if (strcmp(v->name, name) == 0) return v;
+    return NULL;
+}
+
+/* Record a declaration of `name`; a second declaration clears the binding */
+static void fp_bind_decl(CodeGen *cg, CGVar **tab, const char *name, const char *target) {
+    CGVar *v = fp_bind_find(tab, name);
+    if (v) {
+        v->fn_target = NULL;
+        return;
+    }
+    unsigned int h = var_hash(name);
+    v = arena_calloc(cg->arena, sizeof(CGVar));
+    v->name = name;
+    v->fn_target = target;
+    v->next = tab[h];
+    tab[h] = v;
+}
+
+static bool type_is_func_ptr(Type *t) {
+    return t && t->kind == TY_PTR && t->base && t->base->kind == TY_FUNC;
+}
+
+/* Function defined in this program that expression n designates
+ * (f, &f, *f, casts thereof), or NULL.  `scope` holds names declared as
+ * variables, which shadow functions. */
+static const char *fp_static_target(CodeGen *cg, CGVar **scope, Node *n) {
+    while (n && (n->kind == ND_CAST || n->kind == ND_ADDR || n->kind == ND_DEREF)) {
+        if (n->kind == ND_CAST) {
+            Type *t = n->cast_type;
+            if (!t || !(type_is_func_ptr(t) || t->kind == TY_FUNC)) return NULL;
+            n = n->cast_expr;
+        } else {
+            n = n->lhs;
+        }
+    }
+    if (!n || n->kind != ND_IDENT || !func_is_defined(cg, n->name)) return NULL;
+    if (fp_bind_find(scope, n->name) || var_find_global(cg, n->name)) return NULL;
+    return n->name;
+}
+
+typedef struct {
+    CodeGen *cg;
+    CGVar  **tab;
+    bool     decls;   /* record declarations (else only writes) */
+} FpScan;
+
+static void scan_fp_bindings(Node *n, void *ctx) {
+    FpScan *s = ctx;
+    if (!n) return;
+    switch (n->kind) {
+    case ND_VAR_DECL:
+        if (n->var_name && n->var_sc != SC_TYPEDEF) {
+            const char *target = NULL;
+            if (s->decls && type_is_func_ptr(n->type) && n->var_sc != SC_EXTERN)
+                target = fp_static_target(s->cg, s->tab, n->var_init);
+            fp_bind_decl(s->cg, s->tab, n->var_name, target);
+        }
+        break;
+    case ND_ADDR: {
+        Node *base = lvalue_base_ident(n->lhs);
+        if (base) fp_bind_decl(s->cg, s->tab, base->name, NULL);
+        break;
+    }
+    case ND_ASSIGN:
+    case ND_ADD_ASSIGN: case ND_SUB_ASSIGN: case ND_MUL_ASSIGN:
+    case ND_DIV_ASSIGN: case ND_MOD_ASSIGN:
+    case ND_LSHIFT_ASSIGN: case ND_RSHIFT_ASSIGN:
+    case ND_AND_ASSIGN: case ND_OR_ASSIGN: case ND_XOR_ASSIGN:
+    case ND_PRE_INC: case ND_PRE_DEC: case ND_POST_INC: case ND_POST_DEC: {
+        Node *base = lvalue_base_ident(n->lhs);
+        if (base) fp_bind_decl(s->cg, s->tab, base->name, NULL);
+        break;
+    }
+    default:
+        break;
+    }
+    node_visit_children(n, scan_fp_bindings, ctx);
+}
+
+/* File-scope bindings.  Any local or parameter sharing a global's name
+ * clears it, since call sites resolve names through the variable table. */
+static void analyze_global_fp_bindings(CodeGen *cg, Node *program) {
+    FpScan s;
+    s.cg = cg;
+    s.tab = cg->fp_globals;
+    s.decls = true;
+    for (Node *n = program->body; n; n = n->next) {
+        if (n->kind == ND_VAR_DECL) scan_fp_bindings(n, &s);
+    }
+    for (Node *n = program->body; n; n = n->next) {
+        if (n->kind != ND_FUNC_DEF || !func_is_emitted(cg, n)) continue;
+        for (Param *p = n->type->params; p; p = p->next)
+            if (p->name) fp_bind_decl(cg, cg->fp_globals, p->name, NULL);
+        s.decls = false;
+        scan_fp_bindings(n->func_body, &s);
+        s.decls = true;
+    }
+}
+
+static void analyze_local_fp_bindings(CodeGen *cg, Node *fn) {
+    memset(cg->fp_locals, 0, sizeof(cg->fp_locals));
+    FpScan s;
+    s.cg = cg;
+    s.tab = cg->fp_locals;
+    s.decls = true;
+    for (Param *p = fn->type->params; p; p = p->next)
+        if (p->name) fp_bind_decl(cg, cg->fp_locals, p->name, NULL);
+    scan_fp_bindings(fn->func_body, &s);
+}
+
+/* Function a call through callee always reaches, or NULL */
+static const char *call_target(CodeGen *cg, Node *callee) {
+    Node *n = callee;
+    while (n && (n->kind == ND_CAST || n->kind == ND_ADDR || n->kind == ND_DEREF)) {
+        if (n->kind == ND_CAST) {
+            Type *t = n->cast_type;
+            if (!t || !(type_is_func_ptr(t) || t->kind == TY_FUNC)) return NULL;
+            n = n->cast_expr;
+        } else {
+            n = n->lhs;
+        }
+    }
+    if (!n || n->kind != ND_IDENT) return NULL;
+    CGVar *v = var_find(cg, n->name);
+    if (!v) return func_is_defined(cg, n->name) ? n->name : NULL;
+    if (!type_is_func_ptr(v->type)) return NULL;
+    /* Static locals live in the global table but are not file-scope names */
+    CGVar *b = fp_bind_find(v->is_local ? cg->fp_locals : cg->fp_globals, n->name);
+    return b ? b->fn_target : NULL;
+}
+
+/* ---- setjmp detection helpers ---- */
+
+/* Check if a statement's immediate expressions contain setjmp() */
+static bool stmt_contains_setjmp(Node *n) {
+    if (!n) return false;
+    switch (n->kind) {
+    case ND_EXPR_STMT:
+        return node_contains_setjmp(n->lhs);
+    case ND_IF:
+    case ND_WHILE:
+    case ND_DO_WHILE:
+        return node_contains_setjmp(n->lhs);
+    case ND_FOR:
+        return node_contains_setjmp(n->for_cond) ||
+               node_contains_setjmp(n->for_init) ||
+               node_contains_setjmp(n->for_inc);
+    case ND_SWITCH:
+        return node_contains_setjmp(n->switch_expr);
+    case ND_VAR_DECL:
+        return n->var_init && node_contains_setjmp(n->var_init);
+    case ND_RETURN:
+        return node_contains_setjmp(n->lhs);
+    default:
+        return false;
+    }
+}
+
+/* ---- Expression generation ---- */
+static void gen_expr(CodeGen *cg, Node *n);
+static CGLabel *goto_label_find(CodeGen *cg, const char *name);
+
+/* Emit expression as a JS float64 number (not BigInt).
+ * Doubles are unboxed via rt.f64() under --nan-boxing,
+ * long long pairs are combined as hi * 2^32 + lo.
+ * Other types (int, float) are already JS numbers. */
+static void gen_f64_val(CodeGen *cg, Node *n) {
+    if (n->kind == ND_FLOAT_LIT) {
+        emit(cg, "%.17g", n->fval);
+    } else if (expr_is_double(n)) {
+        if (cg->nan_boxing) { emit(cg, "rt.f64("); gen_expr(cg, n); emit(cg, ")"); }
+        else gen_expr(cg, n);
+    } else if (expr_is_i64(n)) {
+        /* lo is evaluated first, so rt.H holds its high word */
+        emit(cg, "(("); gen_expr(cg, n);
+        emit(cg, n->type->is_unsigned ? " >>> 0) + (rt.H >>> 0) * 4294967296)"
+                                      : " >>> 0) + rt.H * 4294967296)");
+    } else {
+        gen_expr(cg, n);
+    }
+}
+
+/* Long long n, known to lie in [lo, hi] within 2^53, as a JS number: its
+ * low word when that is the value, else the words combined */
+static void gen_i64_number(CodeGen *cg, Node *n, long long lo, long long hi) {
+    if (lo >= 0 && hi <= 2147483647LL) {
+        gen_expr(cg, n);
+    } else if (lo >= -2147483647LL - 1 && hi <= 2147483647LL) {
+        emit(cg, "("); gen_expr(cg, n); emit(cg, " | 0)");
+    } else if (lo >= 0 && hi <= 4294967295LL) {
+        emit(cg, "("); gen_expr(cg, n); emit(cg, " >>> 0)");
+    } else {
+        gen_f64_val(cg, n);
+    }
+}
+
+/* JS local bound to an lvalue expression, or NULL if it lives in memory */
+static CGVar *js_lvalue(CodeGen *cg, Node *n) {
+    if (n && n->kind == ND_MEMBER) return sroa_field(cg, n);
+    if (!n || n->kind != ND_IDENT) return NULL;
+    CGVar *v = var_find(cg, n->name);
+    return var_in_js(v) ? v : NULL;
+}
+
+/* ---- Assignment lowering ----
+ * Assignment, compound assignment and ++/-- become JS assignment
+ * expressions.  An lvalue address with side effects is evaluated once into
+ * a function-scoped temporary ($tN); no closure is created.  When the value
+ * is unused (expression statements, for-loop clauses, comma operands) the
+ * bare store is emitted and the store itself performs the narrowing. */
+
+/* Declare a fresh function-scoped temporary and return its name */
+static const char *new_tmp_var(CodeGen *cg) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "$t%d", new_tmp(cg));
+    buf_printf(&cg->jslocal_decls, "%s%s", cg->jslocal_decls.len ? ", " : "", buf);
+    return arena_strdup(cg->arena, buf);
+}
+
+/* True if evaluating n twice is equivalent to evaluating it once */
+static bool expr_is_pure(Node *n) {
+    if (!n) return true;
+    switch (n->kind) {
+    case ND_INT_LIT: case ND_CHAR_LIT: case ND_FLOAT_LIT:
+    case ND_IDENT: case ND_SIZEOF: case ND_SIZEOF_TYPE:
+        return true;
+    case ND_DEREF: case ND_ADDR: case ND_MEMBER: case ND_MEMBER_PTR:
+    case ND_NEG: case ND_POS: case ND_NOT: case ND_BITNOT:
+        return expr_is_pure(n->lhs);
+    case ND_ADD: case ND_SUB: case ND_MUL: case ND_SUBSCRIPT:
+    case ND_LSHIFT: case ND_RSHIFT: case ND_BITAND: case ND_BITOR: case ND_BITXOR:
+        return expr_is_pure(n->lhs) && expr_is_pure(n->rhs);
+    case ND_CAST:
+        return expr_is_pure(n->cast_expr);
+    default:
+        return false;
+    }
+}
+
+/* Render the address of lvalue n as a parenthesized JS expression */
+static const char *gen_addr_str(CodeGen *cg, Node *n) {
+    Buf saved = cg->out;
+    buf_init(&cg->out);
+    cg->cse.aside++;
+    emit(cg, "(");
+    gen_addr(cg, n);
+    emit(cg, ")");
+    cg->cse.aside--;
+    char *str = buf_detach(&cg->out);
+    cg->out = saved;
+    const char *res = arena_strdup(cg->arena, str);
+    free(str);
+    return res;
+}
+
+/* ---- Load reuse ----
+ * Within a basic block, a scalar loaded from memory (p->next, *pp, a[i])
+ * is kept in a temporary where it is first evaluated,
+ * ($t3 = HEAP32[(l_p + 4) >> 2]), and later loads with the same JS text
+ * use $t3.  The cache itself is cse.c; the emitter reports the stores,
+ * calls, conditional paths and joins that end its entries. */
+
+/* Invalidate after a store to lvalue lv */
+static void cse_stored(CodeGen *cg, Node *lv) {
+    if (!cg->cse.count) return;
+    CGVar *jv = js_lvalue(cg, lv);
+    CGVar *sv = jv ? NULL : split_var(cg, lv);
+    if (jv) {
+        cse_kill(&cg->cse, jv->js_name);
+    } else if (sv) {
+        for (CGVar *f = sv->fields; f; f = f->next) cse_kill(&cg->cse, f->js_name);
+    } else {
+        cse_store(&cg->cse, lv);
+    }
+}
+
+/* Emit the scalar load of lvalue n (of type ty), reusing an earlier
+ * evaluation of the same load */
+static void gen_load(CodeGen *cg, Node *n, Type *ty, bool aligned) {
+    if (!expr_is_pure(n) || !cse_candidate(&cg->cse, n, ty)) {
+        emit_load_begin(cg, ty, aligned);
+        gen_addr(cg, n);
+        emit_load_end(cg, ty, aligned);
+        return;
+    }
+    int mark = cse_mark(&cg->cse);
+    Buf saved = cg->out;
+    buf_init(&cg->out);
+    emit_load_begin(cg, ty, aligned);
+    gen_addr(cg, n);
+    emit_load_end(cg, ty, aligned);
+    char *text = buf_detach(&cg->out);
+    cg->out = saved;
+    const char *hit = cse_find(&cg->cse, text);
+    if (hit || cg->cse.aside) {
+        emit(cg, "%s", hit ? hit : text);
+        free(text);
+        return;
+    }
+    const char *t = new_tmp_var(cg);
+    emit(cg, "(%s = %s)", t, text);
+    if (cse_mark(&cg->cse) != mark) {
+        /* Key the entry by the text a later load renders, with the loads
+         * it contains already in temporaries */
+        free(text);
+        saved = cg->out;
+        buf_init(&cg->out);
+        cg->cse.aside++;
+        emit_load_begin(cg, ty, aligned);
+        gen_addr(cg, n);
+        emit_load_end(cg, ty, aligned);
+        cg->cse.aside--;
+        text = buf_detach(&cg->out);
+        cg->out = saved;
+    }
+    cse_add(&cg->cse, n, text, t);
+    free(text);
+}
+
+/* JS operator for a compound assignment or ++/-- */
+static const char *update_op(Node *n) {
+    switch (n->kind) {
+    case ND_PRE_INC: case ND_POST_INC: case ND_ADD_ASSIGN: return "+";
+    case ND_PRE_DEC: case ND_POST_DEC: case ND_SUB_ASSIGN: return "-";
+    case ND_MUL_ASSIGN: return "*";
+    case ND_DIV_ASSIGN: return "/";
+    case ND_MOD_ASSIGN: return "%";
+    case ND_LSHIFT_ASSIGN: return "<<";
+    case ND_RSHIFT_ASSIGN:
+        return (n->lhs->type && n->lhs->type->is_unsigned) ? ">>>" : ">>";
+    case ND_AND_ASSIGN: return "&";
+    case ND_OR_ASSIGN: return "|";
+    case ND_XOR_ASSIGN: return "^";
+    default: return "+";
+    }
+}
+
+/* Emit the value update n stores, given the lvalue's current value old.
+ * Not yet narrowed to the lvalue type. */
+static void gen_update_value(CodeGen *cg, Node *n, Type *lt, const char *old) {
+    const char *op = update_op(n);
+    bool is_step = n->kind == ND_PRE_INC || n->kind == ND_PRE_DEC ||
+                   n->kind == ND_POST_INC || n->kind == ND_POST_DEC;
+    int esz = lt && lt->kind == TY_PTR && lt->base ? type_sz(lt->base) : 1;
+
+    if (n->kind == ND_ASSIGN) {
+        gen_expr(cg, n->rhs);
+    } else if (type_is_double(lt)) {
+        emit(cg, "%s%s%s) %s ", f64_box(cg), f64_unbox(cg), old, op);
+        if (is_step) emit(cg, "1");
+        else gen_f64_val(cg, n->rhs);
+        emit(cg, ")");
+    } else if (is_step) {
+        emit(cg, "%s %s %d", old, op, esz);
+    } else if (n->kind == ND_MUL_ASSIGN && type_is_integer(lt) &&
+               n->rhs->type && type_is_integer(n->rhs->type) && !expr_is_i64(n->rhs)) {
+        emit(cg, "Math.imul(%s, ", old);
+        gen_expr(cg, n->rhs);
+        emit(cg, ")");
+    } else {
+        emit(cg, "%s %s (", old, op);
+        gen_expr(cg, n->rhs);
+        emit(cg, ")");
+        /* pointer += n advances by n elements */
+        if (esz > 1 && (n->kind == ND_ADD_ASSIGN || n->kind == ND_SUB_ASSIGN))
+            emit(cg, " * %d", esz);
+    }
+}
+
+/* Update value narrowed to the lvalue type, as a reload would see it */
+static void gen_update_coerced(CodeGen *cg, Node *n, Type *lt, const char *old) {
+    long long lo, hi;
+    bool exact = type_is_double(lt) ? n->kind != ND_ASSIGN || expr_is_double(n->rhs)
+                                    : range_update(&cg->ranges, n, lt, &lo, &hi) && range_fits(lt, lo, hi);
+    if (!exact) emit_coerce_begin(cg, lt);
+    gen_update_value(cg, n, lt, old);
+    if (!exact) emit_coerce_end(cg, lt);
+}
+
+/* True if evaluating the pure expression n may read memory; lvalue n:
+ * computing its address may */
+static bool expr_reads_memory(CodeGen *cg, Node *n, bool lvalue) {
+    if (!n) return false;
+    switch (n->kind) {
+    case ND_INT_LIT: case ND_CHAR_LIT: case ND_FLOAT_LIT:
+    case ND_SIZEOF: case ND_SIZEOF_TYPE:
+        return false;
+    case ND_IDENT:
+        return !lvalue && !js_lvalue(cg, n);
+    case ND_ADDR:
+        return expr_reads_memory(cg, n->lhs, true);
+    case ND_MEMBER:
+        if (!lvalue && js_lvalue(cg, n)) return false;
+        return !lvalue || expr_reads_memory(cg, n->lhs, true);
+    case ND_DEREF: case ND_MEMBER_PTR:
+        return !lvalue || expr_reads_memory(cg, n->lhs, false);
+    case ND_SUBSCRIPT:
+        if (!lvalue) return true;
+        return expr_reads_memory(cg, n->lhs, n->lhs->type && type_is_array(n->lhs->type)) ||
+               expr_reads_memory(cg, n->rhs, false);
+    case ND_CAST:
+        return expr_reads_memory(cg, n->cast_expr, false);
+    default:
+        return expr_reads_memory(cg, n->lhs, false) || expr_reads_memory(cg, n->rhs, false);
+    }
+}
+
+static void gen_update_store(CodeGen *cg, Node *n, bool want_value);
+
+static void gen_update(CodeGen *cg, Node *n, bool want_value) {
+    gen_update_store(cg, n, want_value);
+    cse_stored(cg, n->lhs);
+}
+
+static void gen_update_store(CodeGen *cg, Node *n, bool want_value) {
+    Node *lv = n->lhs;
+    Type *lt = lv->type;
+    bool is_post = want_value && (n->kind == ND_POST_INC || n->kind == ND_POST_DEC);
+    CGVar *jv = js_lvalue(cg, lv);
+
+    if (type_is_i64(lt)) {
+        gen_update_i64(cg, n, want_value);
+        return;
+    }
+
+    CGVar *sv = is_aggregate(lt) ? split_var(cg, lv) : NULL;
+    if (sv) {
+        /* Copy into a split struct (only ever in a discarded context) */
+        int k = 0;
+        emit(cg, "(");
+        gen_fields_init_at(cg, sv, 0, lt, n->rhs, NULL, &k);
+        emit(cg, ")");
+        return;
+    }
+
+    if (jv) {
+        const char *l = jv->js_name;
+        if (is_post) {
+            const char *t = new_tmp_var(cg);
+            emit(cg, "(%s = %s, %s = ", t, l, l);
+            gen_update_coerced(cg, n, lt, t);
+            emit(cg, ", %s)", t);
+        } else {
+            if (want_value) emit(cg, "(");
+            emit(cg, "%s = ", l);
+            gen_update_coerced(cg, n, lt, l);
+            if (want_value) emit(cg, ")");
+        }
+        return;
+    }
+
+    sv = is_aggregate(lt) ? split_var(cg, n->rhs) : NULL;
+    bool rcall = call_in_slots(n->rhs);
+    if (want_value || sv || rcall) emit(cg, "(");
+
+    /* Address: reuse the expression text if pure and either used once or
+     * computed without loads, else evaluate it once */
+    bool reused = is_aggregate(lt) ? (want_value || sv || rcall) : n->kind != ND_ASSIGN;
+    const char *a;
+    if (expr_is_pure(lv) && !(reused && expr_reads_memory(cg, lv, true))) {
+        a = gen_addr_str(cg, lv);
+    } else {
+        a = new_tmp_var(cg);
+        emit(cg, "%s = ", a);
+        gen_addr(cg, lv);
+        emit(cg, ", ");
+    }
+
+    if (sv) {
+        int k = 0;
+        gen_fields_store(cg, sv, a, 0, &k);
+        emit(cg, want_value ? ", %s)" : ")", a);
+        return;
+    }
+    if (rcall) {
+        cg->rret_bare = true;
+        gen_expr(cg, n->rhs);
+        emit(cg, ", ");
+        gen_reg_store_slots(cg, lt, a, 0);
+        emit(cg, want_value ? ", %s)" : ")", a);
+        return;
+    }
+
+    if (!want_value && lv->kind == ND_IDENT &&
+        sret_into(cg, n->rhs, var_find(cg, lv->name), false)) {
+        /* The callee stores its result into the local itself */
+        cg->sret_dest = a;
+        gen_expr(cg, n->rhs);
+        return;
+    }
+    if (is_aggregate(lt)) {
+        /* Struct copy via memcpy; gen_expr returns address for structs */
+        emit(cg, "rt.memcpy(%s, ", a);
+        gen_expr(cg, n->rhs);
+        emit(cg, ", %d)", type_sz(lt));
+        if (want_value) emit(cg, ", %s)", a);
+        return;
+    }
+
+    bool al = lvalue_aligned(cg, lv);
+    bool via_view = al && heap_view(cg, lt);
+    const char *old = n->kind == ND_ASSIGN ? NULL : mem_load_str(cg, lt, al, a);
+
+    if (is_post) {
+        /* (t = load, store(new(t)), t) */
+        const char *t = new_tmp_var(cg);
+        emit(cg, "%s = %s, ", t, old);
+        emit_store_begin(cg, lt, al);
+        emit(cg, "%s", a);
+        emit_store_mid(cg, lt, al);
+        gen_update_value(cg, n, lt, t);
+        emit_store_end(cg, lt, al);
+        emit(cg, ", %s)", t);
+    } else if (want_value && !via_view) {
+        /* DataView setters return undefined: (t = new, store(t), t) */
+        const char *t = new_tmp_var(cg);
+        emit(cg, "%s = ", t);
+        gen_update_coerced(cg, n, lt, old);
+        emit(cg, ", ");
+        emit_store_begin(cg, lt, al);
+        emit(cg, "%s", a);
+        emit_store_mid(cg, lt, al);
+        emit(cg, "%s", t);
+        emit_store_end(cg, lt, al);
+        emit(cg, ", %s)", t);
+    } else {
+        /* HEAPxx[a] = v yields v, so a narrowed v is the C result */
+        emit_store_begin(cg, lt, al);
+        emit(cg, "%s", a);
+        emit_store_mid(cg, lt, al);
+        if (want_value) gen_update_coerced(cg, n, lt, old);
+        else gen_update_value(cg, n, lt, old);
+        emit_store_end(cg, lt, al);
+        if (want_value) emit(cg, ")");
+    }
+}
+
+/* Emit n for its side effects only; its value is discarded */
+static void gen_discard(CodeGen *cg, Node *n) {
+    if (!n) return;
+    switch (n->kind) {
+    case ND_ASSIGN:
+    case ND_ADD_ASSIGN: case ND_SUB_ASSIGN: case ND_MUL_ASSIGN:
+    case ND_DIV_ASSIGN: case ND_MOD_ASSIGN:
+    case ND_LSHIFT_ASSIGN: case ND_RSHIFT_ASSIGN:
+    case ND_AND_ASSIGN: case ND_OR_ASSIGN: case ND_XOR_ASSIGN:
+    case ND_PRE_INC: case ND_PRE_DEC: case ND_POST_INC: case ND_POST_DEC:
+        gen_update(cg, n, false);
+        break;
+    case ND_COMMA:
+        gen_discard(cg, n->lhs);
+        emit(cg, ", ");
+        gen_discard(cg, n->rhs);
+        break;
+    case ND_CALL:
+        /* A register struct result can stay in the return slots */
+        cg->rret_bare = struct_in_regs(n->type);
+        gen_expr(cg, n);
+        break;
+    case ND_CAST:
+        if (n->cast_type && n->cast_type->kind == TY_VOID) {
+            gen_discard(cg, n->cast_expr);
+            break;
+        }
+        gen_expr(cg, n);
+        break;
+    default:
+        gen_expr(cg, n);
+        break;
+    }
+}
+
+/* ---- 32-bit integer arithmetic ----
+ * int and unsigned results are kept as JS int32 / uint32 values: every
+ * operation is re-coerced with |0 or >>>0 so V8 can keep it in an integer
+ * register, and products use Math.imul so bits past 2^53 are not lost. */
+
+/* k if n is 2^k, else -1 */
+static int log2_exact(unsigned long long n) {
+    if (n == 0 || (n & (n - 1)) != 0) return -1;
+    int k = 0;
+    while (n > 1) { n >>= 1; k++; }
+    return k;
+}
+
+/* k if e is the integer constant 2^k (k < 32), else -1 */
+static int const_log2(Node *e) {
+    if (!e || e->kind != ND_INT_LIT || type_is_i64(e->type)) return -1;
+    if ((long long)e->ival < 0 || e->ival > 0x80000000ULL) return -1;
+    return log2_exact(e->ival);
+}
+
+static bool type_is_signed_int(Type *t) {
+    return t && type_is_integer(t) && t->kind != TY_BOOL && !t->is_unsigned;
+}
+
+/* Emit an operand of a uint32 operation: signed values are reinterpreted
+ * as unsigned, as the usual arithmetic conversions require */
+static void gen_u32_operand(CodeGen *cg, Node *e) {
+    long long lo, hi;
+    bool neg_ok = e->kind == ND_INT_LIT ? (long long)e->ival < 0
+                                        : type_is_signed_int(e->type) &&
+                                          !(range_of(&cg->ranges, e, &lo, &hi) && lo >= 0);
+    if (!neg_ok) { gen_expr(cg, e); return; }
+    emit(cg, "("); gen_expr(cg, e); emit(cg, " >>> 0)");
+}
+
+/* True if comparison n compares 32-bit integers as unsigned */
+static bool int_cmp_unsigned(CodeGen *cg, Node *n) {
+    Type *lt = n->lhs->type, *rt = n->rhs->type;
+    if (!lt || !rt || !type_is_integer(lt) || !type_is_integer(rt)) return false;
+    Type *common = type_usual_arith(cg->arena, lt, rt);
+    return common->is_unsigned && !type_is_i64(common);
+}
+
+static void gen_int_binop(CodeGen *cg, Node *n, const char *op) {
+    bool uns = n->type->is_unsigned;
+    const char *wrap = uns ? ">>> 0" : "| 0";
+    int k;
+
+    /* No wrap when the exact result is known to fit */
+    bool fits = range_binop_exact(&cg->ranges, n);
+
+    switch (n->kind) {
+    case ND_MUL:
+        uns = uns && !fits;
+        emit(cg, uns ? "(Math.imul(" : "Math.imul(");
+        gen_expr(cg, n->lhs); emit(cg, ", "); gen_expr(cg, n->rhs);
+        emit(cg, uns ? ") >>> 0)" : ")");
+        return;
+
+    case ND_DIV: case ND_MOD:
+        k = const_log2(n->rhs);
+        if (uns && k >= 0) {
+            /* x / 2^k == x >>> k, x % 2^k == x & (2^k - 1) */
+            emit(cg, "("); gen_u32_operand(cg, n->lhs);
+            if (n->kind == ND_DIV) emit(cg, " >>> %d)", k);
+            else emit(cg, " & %u)", (unsigned)((1ULL << k) - 1));
+            return;
+        }
+        if (!uns && k > 0 && k < 31 && n->kind == ND_DIV) {
+            /* Signed division rounds toward zero: bias negative dividends
+             * by 2^k - 1 before the arithmetic shift */
+            CGVar *jv = js_lvalue(cg, n->lhs);
+            const char *x = jv ? jv->js_name : new_tmp_var(cg);
+            if (!jv) { emit(cg, "(%s = ", x); gen_expr(cg, n->lhs); emit(cg, ", "); }
+            emit(cg, "((%s + ((%s >> 31) >>> %d)) >> %d)", x, x, 32 - k, k);
+            if (!jv) emit(cg, ")");
+            return;
+        }
+        emit(cg, fits ? "(" : "((");
+        if (uns) gen_u32_operand(cg, n->lhs); else gen_expr(cg, n->lhs);
+        emit(cg, " %s ", op);
+        if (uns) gen_u32_operand(cg, n->rhs); else gen_expr(cg, n->rhs);
+        if (fits) emit(cg, ")");
+        else emit(cg, ") %s)", wrap);
+        return;
+
+    case ND_ADD: case ND_SUB:
+        break;
+
+    default:
+        /* Shifts and bitwise operators already yield int32; >> and >>>
+         * are chosen by signedness */
+        if (!uns || n->kind == ND_RSHIFT || fits) {
+            emit(cg, "("); gen_expr(cg, n->lhs); emit(cg, " %s ", op);
+            gen_expr(cg, n->rhs); emit(cg, ")");
+            return;
+        }
+        break;
+    }
+    if (fits) {
+        emit(cg, "("); gen_expr(cg, n->lhs); emit(cg, " %s ", op);
+        gen_expr(cg, n->rhs); emit(cg, ")");
+        return;
+    }
+    emit(cg, "(("); gen_expr(cg, n->lhs); emit(cg, " %s ", op);
+    gen_expr(cg, n->rhs); emit(cg, ") %s)", wrap);
+}
+
+/* ---- 64-bit integers ----
+ * long long values are pairs of int32 words.  A 64-bit expression evaluates
+ * to its low word and leaves the high word in rt.H, which the consumer reads
+ * right after it (f(lo, rt.H), HEAP32[a >> 2] = lo, HEAP32[(a + 4) >> 2] = rt.H).
+ * Operators split their operands into words first; add, sub, bitwise ops,
+ * constant shifts and comparisons are inlined as int32 arithmetic, while
+ * mul/div/mod and variable shifts call the rt.*64 helpers. */
+
+/* Words of a 64-bit value as side-effect-free JS expressions */
+typedef struct {
+    const char *lo, *hi;
+    bool is_const;
+    unsigned long long val;  /* when is_const */
+} I64Parts;
+
+/* Addresses of the two words of a 64-bit object in memory */
+typedef struct {
+    const char *lo, *hi;
+    bool aligned;            /* HEAP32 accesses; else rt.mem.readInt32 */
+} I64Mem;
+
+static const char *fmt_str(CodeGen *cg, const char *fmt, ...) {
+    Buf b;
+    buf_init(&b);
+    va_list ap;
+    va_start(ap, fmt);
+    buf_vprintf(&b, fmt, ap);
+    va_end(ap);
+    char *str = buf_detach(&b);
+    const char *res = arena_strdup(cg->arena, str);
+    free(str);
+    return res;
+}
+
+static void scan_sets_h(Node *n, void *ctx) {
+    bool *found = ctx;
+    if (!n || *found) return;
+    if (expr_is_i64(n) || n->kind == ND_CALL) {
+        *found = true;
+        return;
+    }
+    node_visit_children(n, scan_sets_h, ctx);
+}
+
+/* True if evaluating any operand of n may overwrite rt.H */
+static bool operands_set_h(Node *n) {
+    bool found = false;
+    node_visit_children(n, scan_sets_h, &found);
+    return found;
+}
+
+static void i64_const_parts(CodeGen *cg, unsigned long long v, I64Parts *p) {
+    p->lo = fmt_str(cg, "%d", (int)(unsigned)v);
+    p->hi = fmt_str(cg, "%d", (int)(unsigned)(v >> 32));
+    p->is_const = true;
+    p->val = v;
+}
+
+/* A word read as uint32 */
+static const char *i64_u32(CodeGen *cg, I64Parts *p, bool hi) {
+    if (p->is_const)
+        return fmt_str(cg, "%u", hi ? (unsigned)(p->val >> 32) : (unsigned)p->val);
+    return fmt_str(cg, "(%s >>> 0)", hi ? p->hi : p->lo);
+}
+
+/* Word addresses of the 64-bit object at base + off ("0" for globals) */
+static void i64_mem_at(CodeGen *cg, const char *base, int off, bool aligned, I64Mem *m) {
+    bool abs = strcmp(base, "0") == 0;
+    m->lo = abs ? fmt_str(cg, "%d", off) : fmt_str(cg, "(%s + (%d))", base, off);
+    m->hi = abs ? fmt_str(cg, "%d", off + 4) : fmt_str(cg, "(%s + (%d))", base, off + 4);
+    m->aligned = aligned;
+}
+
+/* Word addresses of the 64-bit lvalue lv.  An address that cannot be
+ * repeated, or that loads a pointer, is evaluated once into a temporary,
+ * emitting "t = ..., ". */
+static void gen_i64_mem(CodeGen *cg, Node *lv, I64Mem *m) {
+    bool local;
+    int off;
+    m->aligned = lvalue_aligned(cg, lv) && lv->type->align >= 4;
+    if ((lv->kind == ND_IDENT || lv->kind == ND_MEMBER || lv->kind == ND_SUBSCRIPT) &&
+        const_addr(cg, lv, &local, &off)) {
+        i64_mem_at(cg, local ? "bp" : "0", off, m->aligned, m);
+        return;
+    }
+    const char *a;
+    if (expr_is_pure(lv) && !operands_set_h(lv) && !expr_reads_memory(cg, lv, true)) {
+        a = gen_addr_str(cg, lv);
+    } else {
+        a = new_tmp_var(cg);
+        emit(cg, "%s = ", a);
+        gen_addr(cg, lv);
+        emit(cg, ", ");
+    }
+    m->lo = a;
+    m->hi = fmt_str(cg, "(%s + 4)", a);
+}
+
+static const char *i64_mem_word(CodeGen *cg, I64Mem *m, bool hi) {
+    const char *a = hi ? m->hi : m->lo;
+    return m->aligned ? fmt_str(cg, "HEAP32[%s >> 2]", a)
+                      : fmt_str(cg, "rt.mem.readInt32(%s)", a);
+}
+
+/* Store a 64-bit expression: store_begin <lo-valued expr> store_end */
+static void emit_i64_store_begin(CodeGen *cg, I64Mem *m) {
+    if (m->aligned) emit(cg, "HEAP32[%s >> 2] = ", m->lo);
+    else emit(cg, "rt.mem.writeInt32(%s, ", m->lo);
+}
+
+static void emit_i64_store_end(CodeGen *cg, I64Mem *m) {
+    if (m->aligned) emit(cg, ", HEAP32[%s >> 2] = rt.H", m->hi);
+    else emit(cg, "), rt.mem.writeInt32(%s, rt.H)", m->hi);
+}
+
+static void gen_i64_conv(CodeGen *cg, Node *e, Type *to);
+static void gen_i64_parts(CodeGen *cg, Node *e, Type *to, I64Parts *p);
+
+/* Store e, converted to the 64-bit type ty, at base + off */
+static void gen_i64_init(CodeGen *cg, const char *base, int off, bool aligned, Type *ty, Node *e) {
+    I64Mem m;
+    I64Parts v;
+    i64_mem_at(cg, base, off, aligned, &m);
+    gen_i64_parts(cg, e, ty, &v);
+    if (aligned)
+        emit(cg, "HEAP32[%s >> 2] = %s, HEAP32[%s >> 2] = %s", m.lo, v.lo, m.hi, v.hi);
+    else
+        emit(cg, "rt.mem.writeInt32(%s, %s), rt.mem.writeInt32(%s, %s)", m.lo, v.lo, m.hi, v.hi);
+}
+
+/* Split e, converted to a 64-bit integer of type to, into words.  Values
+ * that are not already side-effect free are evaluated into temporaries,
+ * emitting "t = ..., " as part of an enclosing comma expression. */
+static void gen_i64_parts(CodeGen *cg, Node *e, Type *to, I64Parts *p) {
+    /* Integer conversions to 64 bits only change how the words are formed */
+    while (e->kind == ND_CAST && type_is_i64(e->cast_type) && e->cast_expr->type &&
+           (type_is_integer(e->cast_expr->type) || type_is_ptr(e->cast_expr->type)))
+        e = e->cast_expr;
+
+    p->is_const = false;
+    if (e->kind == ND_INT_LIT) {
+        i64_const_parts(cg, e->ival, p);
+        return;
+    }
+    if (e->kind == ND_CHAR_LIT) {
+        i64_const_parts(cg, (unsigned long long)(long long)e->cval, p);
+        return;
+    }
+
+    CGVar *jv = js_lvalue(cg, e);
+    if (expr_is_i64(e)) {
+        if (jv) {
+            p->lo = jv->js_name;
+            p->hi = jv->js_hi;
+            return;
+        }
+        if (e->kind == ND_IDENT || e->kind == ND_DEREF || e->kind == ND_MEMBER ||
+            e->kind == ND_MEMBER_PTR || e->kind == ND_SUBSCRIPT) {
+            I64Mem m;
+            gen_i64_mem(cg, e, &m);
+            p->lo = i64_mem_word(cg, &m, false);
+            p->hi = i64_mem_word(cg, &m, true);
+            return;
+        }
+    } else if (e->type && (type_is_integer(e->type) || type_is_ptr(e->type))) {
+        /* 32-bit value: signed types sign-extend, the rest zero-extend */
+        bool sext = type_is_signed_int(e->type);
+        if (jv) {
+            p->lo = sext ? jv->js_name : fmt_str(cg, "(%s | 0)", jv->js_name);
+        } else {
+            p->lo = new_tmp_var(cg);
+            emit(cg, "%s = ", p->lo);
+            gen_expr(cg, e);
+            emit(cg, sext ? ", " : " | 0, ");
+        }
+        p->hi = sext ? fmt_str(cg, "(%s >> 31)", p->lo) : "0";
+        return;
+    }
+
+    p->lo = new_tmp_var(cg);
+    p->hi = new_tmp_var(cg);
+    emit(cg, "%s = ", p->lo);
+    gen_i64_conv(cg, e, to);
+    emit(cg, ", %s = rt.H, ", p->hi);
+}
+
+/* Emit e converted to a 64-bit integer of type to */
+static void gen_i64_conv(CodeGen *cg, Node *e, Type *to) {
+    if (expr_is_i64(e)) {
+        gen_expr(cg, e);
+    } else if (expr_is_double(e) || (e->type && e->type->kind == TY_FLOAT)) {
+        emit(cg, to && to->is_unsigned ? "rt.d2u64(" : "rt.d2i64(");
+        gen_f64_val(cg, e);
+        emit(cg, ")");
+    } else {
+        I64Parts p;
+        emit(cg, "(");
+        gen_i64_parts(cg, e, to, &p);
+        emit(cg, "rt.H = %s, %s)", p.hi, p.lo);
+    }
+}
+
+/* a op b on split operands, as the tail of a comma expression */
+static void gen_i64_arith(CodeGen *cg, NodeKind kind, bool uns, I64Parts *a, I64Parts *b) {
+    const char *l, *op;
+    switch (kind) {
+    case ND_ADD:
+        /* carry out of the low word: the wrapped sum is below an addend */
+        l = new_tmp_var(cg);
+        emit(cg, "%s = (%s + %s) | 0, rt.H = (%s + ", l, a->lo, b->lo, a->hi);
+        if (!b->is_const || (b->val >> 32)) emit(cg, "%s + ", b->hi);
+        emit(cg, "((%s >>> 0) < %s ? 1 : 0)) | 0, %s", l, i64_u32(cg, b, false), l);
+        return;
+    case ND_SUB:
+        l = new_tmp_var(cg);
+        emit(cg, "%s = (%s - %s) | 0, rt.H = (%s - ", l, a->lo, b->lo, a->hi);
+        if (!b->is_const || (b->val >> 32)) emit(cg, "%s - ", b->hi);
+        emit(cg, "(%s < %s ? 1 : 0)) | 0, %s", i64_u32(cg, a, false), i64_u32(cg, b, false), l);
+        return;
+    case ND_MUL: op = "mul64"; break;
+    case ND_DIV: op = uns ? "divu64" : "div64"; break;
+    case ND_MOD: op = uns ? "modu64" : "mod64"; break;
+    default:
+        op = kind == ND_BITAND ? "&" : kind == ND_BITOR ? "|" : "^";
+        emit(cg, "rt.H = %s %s %s, %s %s %s", a->hi, op, b->hi, a->lo, op, b->lo);
+        return;
+    }
+    emit(cg, "rt.%s(%s, %s, %s, %s)", op, a->lo, a->hi, b->lo, b->hi);
+}
+
+/* a << count or a >> count; constant counts are inlined */
+static void gen_i64_shift(CodeGen *cg, NodeKind kind, bool uns, I64Parts *a, Node *count) {
+    if (count->kind != ND_INT_LIT) {
+        emit(cg, "rt.%s(%s, %s, ", kind == ND_LSHIFT ? "shl64" : uns ? "shru64" : "shr64",
+             a->lo, a->hi);
+        gen_expr(cg, count);
+        emit(cg, ")");
+        return;
+    }
+    int k = (int)(count->ival & 63);
+    if (k == 0) {
+        emit(cg, "rt.H = %s, %s", a->hi, a->lo);
+    } else if (kind == ND_LSHIFT) {
+        if (k < 32)
+            emit(cg, "rt.H = (%s << %d) | (%s >>> %d), %s << %d",
+                 a->hi, k, a->lo, 32 - k, a->lo, k);
+        else
+            emit(cg, "rt.H = %s << %d, 0", a->lo, k - 32);
+    } else if (k < 32) {
+        emit(cg, "rt.H = %s %s %d, (%s >>> %d) | (%s << %d)",
+             a->hi, uns ? ">>>" : ">>", k, a->lo, k, a->hi, 32 - k);
+    } else if (uns) {
+        emit(cg, "rt.H = 0, %s >>> %d | 0", a->hi, k - 32);
+    } else {
+        emit(cg, "rt.H = %s >> 31, %s >> %d", a->hi, a->hi, k - 32);
+    }
+}
+
+/* a op b where b is the right operand of a binary or compound operator */
+static void gen_i64_binop(CodeGen *cg, NodeKind kind, bool uns, I64Parts *a, Node *b, Type *ty) {
+    if (kind == ND_LSHIFT || kind == ND_RSHIFT) {
+        gen_i64_shift(cg, kind, uns, a, b);
+        return;
+    }
+    I64Parts bp;
+    gen_i64_parts(cg, b, ty, &bp);
+    gen_i64_arith(cg, kind, uns, a, &bp);
+}
+
+/* a < b (or <=) as a JS boolean */
+static void gen_i64_less(CodeGen *cg, bool uns, bool or_equal, I64Parts *a, I64Parts *b) {
+    if (uns) emit(cg, "(%s < %s", i64_u32(cg, a, true), i64_u32(cg, b, true));
+    else emit(cg, "(%s < %s", a->hi, b->hi);
+    emit(cg, " || %s === %s && %s %s %s)", a->hi, b->hi,
+         i64_u32(cg, a, false), or_equal ? "<=" : "<", i64_u32(cg, b, false));
+}
+
+static void gen_i64_compare(CodeGen *cg, Node *n) {
+    bool uns = (expr_is_i64(n->lhs) && n->lhs->type->is_unsigned) ||
+               (expr_is_i64(n->rhs) && n->rhs->type->is_unsigned);
+    Type *ty = uns ? ty_ullong : ty_llong;
+    I64Parts a, b;
+    emit(cg, "(");
+    gen_i64_parts(cg, n->lhs, ty, &a);
+    gen_i64_parts(cg, n->rhs, ty, &b);
+    switch (n->kind) {
+    case ND_EQ: emit(cg, "%s === %s && %s === %s", a.lo, b.lo, a.hi, b.hi); break;
+    case ND_NE: emit(cg, "(%s !== %s || %s !== %s)", a.lo, b.lo, a.hi, b.hi); break;
+    case ND_LT: gen_i64_less(cg, uns, false, &a, &b); break;
+    case ND_LE: gen_i64_less(cg, uns, true, &a, &b); break;
+    case ND_GT: gen_i64_less(cg, uns, false, &b, &a); break;
+    default:    gen_i64_less(cg, uns, true, &b, &a); break;
+    }
+    emit(cg, ")");
+}
+
+/* Binary operator of a compound assignment or ++/-- */
+static NodeKind update_binop(Node *n) {
+    switch (n->kind) {
+    case ND_PRE_DEC: case ND_POST_DEC: case ND_SUB_ASSIGN: return ND_SUB;
+    case ND_MUL_ASSIGN: return ND_MUL;
+    case ND_DIV_ASSIGN: return ND_DIV;
+    case ND_MOD_ASSIGN: return ND_MOD;
+    case ND_LSHIFT_ASSIGN: return ND_LSHIFT;
+    case ND_RSHIFT_ASSIGN: return ND_RSHIFT;
+    case ND_AND_ASSIGN: return ND_BITAND;
+    case ND_OR_ASSIGN: return ND_BITOR;
+    case ND_XOR_ASSIGN: return ND_BITXOR;
+    default: return ND_ADD;
+    }
+}
+
+/* Assignment, compound assignment or ++/-- of a 64-bit lvalue */
+static void gen_update_i64(CodeGen *cg, Node *n, bool want_value) {
+    Node *lv = n->lhs;
+    Type *lt = lv->type;
+    bool is_post = want_value && (n->kind == ND_POST_INC || n->kind == ND_POST_DEC);
+    bool is_step = n->kind == ND_PRE_INC || n->kind == ND_PRE_DEC ||
+                   n->kind == ND_POST_INC || n->kind == ND_POST_DEC;
+    CGVar *jv = js_lvalue(cg, lv);
+    I64Mem m;
+    I64Parts old;
+
+    emit(cg, "(");
+    if (jv) {
+        old.lo = jv->js_name;
+        old.hi = jv->js_hi;
+    } else {
+        gen_i64_mem(cg, lv, &m);
+        old.lo = i64_mem_word(cg, &m, false);
+        old.hi = i64_mem_word(cg, &m, true);
+    }
+    old.is_const = false;
+
+    const char *t = NULL, *th = NULL;
+    if (is_post) {
+        t = new_tmp_var(cg);
+        th = new_tmp_var(cg);
+        emit(cg, "%s = %s, %s = %s, ", t, old.lo, th, old.hi);
+    }
+
+    if (jv) emit(cg, "%s = ", jv->js_name);
+    else emit_i64_store_begin(cg, &m);
+    if (n->kind == ND_ASSIGN) {
+        gen_i64_conv(cg, n->rhs, lt);
+    } else {
+        emit(cg, "(");
+        if (is_step) {
+            I64Parts one;
+            i64_const_parts(cg, 1, &one);
+            gen_i64_arith(cg, update_binop(n), lt->is_unsigned, &old, &one);
+        } else {
+            gen_i64_binop(cg, update_binop(n), lt->is_unsigned, &old, n->rhs, lt);
+        }
+        emit(cg, ")");
+    }
+    if (jv) emit(cg, ", %s = rt.H", jv->js_hi);
+    else emit_i64_store_end(cg, &m);
+
+    /* rt.H still holds the stored high word */
+    if (is_post) emit(cg, ", rt.H = %s, %s)", th, t);
+    else if (want_value) emit(cg, ", %s)", old.lo);
+    else emit(cg, ")");
+}
+
+/* Emit the 64-bit expression n */
+static void gen_i64(CodeGen *cg, Node *n) {
+    I64Parts a;
+    switch (n->kind) {
     case ND_INT_LIT:
-        emit(cg, "%lld", (long long)n->ival);
+        i64_const_parts(cg, n->ival, &a);
+        emit(cg, "(rt.H = %s, %s)", a.hi, a.lo);
+        break;
+    case ND_IDENT: case ND_DEREF: case ND_MEMBER: case ND_MEMBER_PTR: case ND_SUBSCRIPT:
+        emit(cg, "(");
+        gen_i64_parts(cg, n, n->type, &a);
+        emit(cg, "rt.H = %s, %s)", a.hi, a.lo);
+        break;
+    case ND_CAST:
+        gen_i64_conv(cg, n->cast_expr, n->type);
+        break;
+    case ND_POS:
+        gen_i64_conv(cg, n->lhs, n->type);
+        break;
+    case ND_NEG:
+        /* -x == ~x + 1: the high word takes the carry when lo is 0 */
+        emit(cg, "(");
+        gen_i64_parts(cg, n->lhs, n->type, &a);
+        emit(cg, "rt.H = (~%s + (%s === 0 ? 1 : 0)) | 0, -(%s) | 0)", a.hi, a.lo, a.lo);
+        break;
+    case ND_BITNOT:
+        emit(cg, "(");
+        gen_i64_parts(cg, n->lhs, n->type, &a);
+        emit(cg, "rt.H = ~%s, ~%s)", a.hi, a.lo);
+        break;
+    case ND_ADD: case ND_SUB: case ND_MUL: case ND_DIV: case ND_MOD:
+    case ND_LSHIFT: case ND_RSHIFT:
+    case ND_BITAND: case ND_BITOR: case ND_BITXOR:
+        emit(cg, "(");
+        gen_i64_parts(cg, n->lhs, n->type, &a);
+        gen_i64_binop(cg, n->kind, n->type->is_unsigned, &a, n->rhs, n->type);
+        emit(cg, ")");
+        break;
+    case ND_TERNARY: {
+        emit(cg, "("); gen_cond(cg, n->lhs); emit(cg, " ? ");
+        int mark = cse_mark(&cg->cse);
+        gen_i64_conv(cg, n->rhs, n->type); emit(cg, " : ");
+        cse_drop(&cg->cse, mark);
+        gen_i64_conv(cg, n->third, n->type); emit(cg, ")");
+        cse_drop(&cg->cse, mark);
+        break;
+    }
+    case ND_COMMA:
+        emit(cg, "("); gen_discard(cg, n->lhs); emit(cg, ", ");
+        gen_i64_conv(cg, n->rhs, n->type); emit(cg, ")");
+        break;
+    case ND_ASSIGN:
+    case ND_ADD_ASSIGN: case ND_SUB_ASSIGN: case ND_MUL_ASSIGN:
+    case ND_DIV_ASSIGN: case ND_MOD_ASSIGN:
+    case ND_LSHIFT_ASSIGN: case ND_RSHIFT_ASSIGN:
+    case ND_AND_ASSIGN: case ND_OR_ASSIGN: case ND_XOR_ASSIGN:
+    case ND_PRE_INC: case ND_PRE_DEC: case ND_POST_INC: case ND_POST_DEC:
+        gen_update(cg, n, true);
+        break;
+    case ND_VA_ARG:
+        gen_va_arg(cg, n);
+        cse_clear(&cg->cse);
+        break;
+    default:
+        emit(cg, "(rt.H = 0, 0 /* expr_%d */)", n->kind);
+        break;
+    }
+}
+
+/* ---- Variadic arguments ----
+ * Compiled variadic functions receive their variable arguments in linear
+ * memory.  The caller writes each one into an 8-byte slot (aggregates take
+ * their size rounded up to 8) of a scratch area in its own frame and passes
+ * the area's address as the last JS argument, p___va.  A va_list is just a
+ * pointer into that area: va_start/va_copy assign it and va_arg reads a
+ * slot and steps past it.  Integers narrower than 64 bits use the slot's
+ * low word; doubles and long longs fill it.  Library functions keep taking
+ * plain JS arguments. */
+
+static int va_slot_size(Type *t) {
+    int sz = is_aggregate(t) ? type_sz(t) : 8;
+    return (sz + 7) & ~7;
+}
+
+/* True if call n passes variable arguments through a memory area */
+static bool call_passes_va_area(CodeGen *cg, Node *n) {
+    Type *ft = n->callee ? n->callee->type : NULL;
+    if (ft && ft->kind == TY_PTR) ft = ft->base;
+    if (!ft || ft->kind != TY_FUNC || !ft->is_variadic) return false;
+    if (n->callee->kind == ND_IDENT) {
+        /* Library functions and builtins (va_start, ...) are not compiled */
+        const char *name = n->callee->name;
+        Symbol *sym = symtab_lookup(cg->symtab, name);
+        if (sym && sym->kind == SYM_FUNC &&
+            (!func_is_defined(cg, name) || is_stdlib_func(name) || is_math_func(name)))
+            return false;
+    }
+    Param *p = ft->params;
+    Node *a = n->args;
+    for (; p && a; p = p->next) a = a->next;
+    return a != NULL;
+}
+
+/* Write the arguments from `first` on into slots of a fresh area in the
+ * frame, each store followed by ", "; returns the area's offset. */
+static int gen_va_area(CodeGen *cg, Node *first) {
+    int size = 0;
+    for (Node *a = first; a; a = a->next)
+        size += va_slot_size(a->type);
+    int off = alloc_local(cg, type_array(cg->arena, ty_double, size / 8));
+    int slot = off;
+    for (Node *a = first; a; a = a->next) {
+        if (is_aggregate(a->type)) {
+            emit(cg, "rt.memcpy(bp + (%d), ", slot);
+            gen_expr(cg, a);
+            emit(cg, ", %d)", type_sz(a->type));
+        } else if (expr_is_i64(a)) {
+            gen_i64_init(cg, "bp", slot, true, a->type, a);
+        } else {
+            /* float is promoted to double, narrower integers to int */
+            bool dbl = a->type && (type_is_double(a->type) || a->type->kind == TY_FLOAT);
+            Type *st = dbl ? ty_double : ty_int;
+            emit_store_begin(cg, st, true);
+            emit(cg, "bp + (%d)", slot);
+            emit_store_mid(cg, st, true);
+            if (dbl && !expr_is_double(a)) {
+                emit(cg, "%s", f64_box(cg));
+                gen_f64_val(cg, a);
+                emit(cg, ")");
+            } else {
+                gen_expr(cg, a);
+            }
+            emit_store_end(cg, st, true);
+        }
+        emit(cg, ", ");
+        slot += va_slot_size(a->type);
+    }
+    return off;
+}
+
+/* Assign to a va_list lvalue: gen_va_set_begin <value> gen_va_set_end */
+static void gen_va_set_begin(CodeGen *cg, Node *ap) {
+    CGVar *v = ap->kind == ND_IDENT ? var_find(cg, ap->name) : NULL;
+    if (var_in_js(v)) {
+        emit(cg, "(%s = ", v->js_name);
+        return;
+    }
+    emit_store_begin(cg, ap->type, lvalue_aligned(cg, ap));
+    gen_addr(cg, ap);
+    emit_store_mid(cg, ap->type, lvalue_aligned(cg, ap));
+}
+
+static void gen_va_set_end(CodeGen *cg, Node *ap) {
+    CGVar *v = ap->kind == ND_IDENT ? var_find(cg, ap->name) : NULL;
+    if (var_in_js(v)) emit(cg, ")");
+    else emit_store_end(cg, ap->type, lvalue_aligned(cg, ap));
+}
+
+/* va_arg(ap, T): (slot = ap, ap = slot + size, <T at slot>) */
+static void gen_va_arg(CodeGen *cg, Node *n) {
+    Type *t = n->type;
+    Node *ap = n->lhs;
+    const char *slot = new_tmp_var(cg);
+    int step = va_slot_size(t);
+    CGVar *v = ap->kind == ND_IDENT ? var_find(cg, ap->name) : NULL;
+    emit(cg, "(");
+    if (var_in_js(v)) {
+        emit(cg, "%s = %s, %s = %s + %d, ", slot, v->js_name, v->js_name, slot, step);
+    } else {
+        const char *a;
+        if (expr_is_pure(ap)) {
+            a = gen_addr_str(cg, ap);
+        } else {
+            a = new_tmp_var(cg);
+            emit(cg, "%s = ", a);
+            gen_addr(cg, ap);
+            emit(cg, ", ");
+        }
+        if (lvalue_aligned(cg, ap))
+            emit(cg, "%s = HEAPU32[%s >> 2], HEAPU32[%s >> 2] = %s + %d, ",
+                 slot, a, a, slot, step);
+        else
+            emit(cg, "%s = rt.mem.readUint32(%s), rt.mem.writeUint32(%s, %s + %d), ",
+                 slot, a, a, slot, step);
+    }
+    if (is_aggregate(t)) {
+        emit(cg, "%s", slot);
+    } else if (type_is_i64(t)) {
+        emit(cg, "rt.H = HEAP32[(%s + 4) >> 2], HEAP32[%s >> 2]", slot, slot);
+    } else if (t->kind == TY_FLOAT) {
+        emit(cg, "Math.fround(%s%s))", f64_unbox(cg), mem_load_str(cg, ty_double, true, slot));
+    } else {
+        emit(cg, "%s", mem_load_str(cg, t, true, slot));
+    }
+    emit(cg, ")");
+}
+
+/* ---- Conditions ----
+ * Control flow (if/while/for/?:/!/&&/||) consumes conditions as raw JS
+ * booleans; gen_expr only turns them into 0/1 when used as a value. */
+
+/* Emit a comparison as a JS boolean */
+static void gen_compare(CodeGen *cg, Node *n) {
+    const char *op;
+    switch (n->kind) {
+    case ND_LT: op = "<"; break;   case ND_LE: op = "<="; break;
+    case ND_GT: op = ">"; break;   case ND_GE: op = ">="; break;
+    case ND_EQ: op = "==="; break; default: op = "!=="; break;
+    }
+
+    if (expr_is_double(n->lhs) || expr_is_double(n->rhs)) {
+        emit(cg, "(");
+        gen_f64_val(cg, n->lhs);
+        emit(cg, " %s ", op);
+        gen_f64_val(cg, n->rhs);
+        emit(cg, ")");
+    } else if (expr_is_i64(n->lhs) || expr_is_i64(n->rhs)) {
+        gen_i64_compare(cg, n);
+    } else if (int_cmp_unsigned(cg, n)) {
+        emit(cg, "("); gen_u32_operand(cg, n->lhs); emit(cg, " %s ", op);
+        gen_u32_operand(cg, n->rhs); emit(cg, ")");
+    } else {
+        emit(cg, "("); gen_expr(cg, n->lhs); emit(cg, " %s ", op);
+        gen_expr(cg, n->rhs); emit(cg, ")");
+    }
+}
+
+/* Emit n as a JS boolean-valued condition */
+static void gen_cond(CodeGen *cg, Node *n) {
+    switch (n->kind) {
+    case ND_LT: case ND_LE: case ND_GT: case ND_GE:
+    case ND_EQ: case ND_NE:
+        gen_compare(cg, n);
+        break;
+    case ND_AND: case ND_OR:
+    {
+        emit(cg, "("); gen_cond(cg, n->lhs);
+        emit(cg, n->kind == ND_AND ? " && " : " || ");
+        int mark = cse_mark(&cg->cse);
+        gen_cond(cg, n->rhs); emit(cg, ")");
+        cse_drop(&cg->cse, mark);
+        break;
+    }
+    case ND_NOT:
+        emit(cg, "!"); gen_cond(cg, n->lhs);
+        break;
+    default:
+        if (expr_is_double(n)) {
+            /* NaN is true in C but falsy in JS */
+            emit(cg, "("); gen_f64_val(cg, n); emit(cg, " !== 0)");
+        } else if (expr_is_i64(n)) {
+            emit(cg, "(("); gen_expr(cg, n); emit(cg, " | rt.H) !== 0)");
+        } else {
+            gen_expr(cg, n);
+        }
+        break;
+    }
+}
+
+static void gen_expr(CodeGen *cg, Node *n) {
+    if (!n) { emit(cg, "0"); return; }
+    if (expr_is_i64(n) && n->kind != ND_CALL) {
+        gen_i64(cg, n);
+        return;
+    }
+
+    switch (n->kind) {
+    case ND_INT_LIT:
+        if (n->type && n->type->is_unsigned)
+            emit(cg, "%u", (unsigned)n->ival);
+        else
+            emit(cg, "%d", (int)n->ival);
         break;
     case ND_FLOAT_LIT:
         if (n->type && n->type->kind == TY_FLOAT)
             emit(cg, "%.17g", n->fval);
-        else
+        else if (cg->nan_boxing)
             emit(cg, "rt.f64bits(%.17g)", n->fval);
+        else
+            emit(cg, "%.17g", n->fval);
         break;
     case ND_CHAR_LIT:
         emit(cg, "%d", n->cval);
         break;
 
-    case ND_STRING_LIT: {
-        int idx = cg->str_count++;
-        buf_printf(&cg->data_section, "const __str%d = rt.mem.allocString(\"", idx);
-        for (int i = 0; i < n->slen; i++) {
-            char c = n->sval[i];
-            switch (c) {
-            case '\\': buf_append(&cg->data_section, "\\\\", 2); break;
-            case '"':  buf_append(&cg->data_section, "\\\"", 2); break;
-            case '\n': buf_append(&cg->data_section, "\\n", 2); break;
-            case '\r': buf_append(&cg->data_section, "\\r", 2); break;
-            case '\t': buf_append(&cg->data_section, "\\t", 2); break;
-            case '\0': buf_append(&cg->data_section, "\\0", 2); break;
-            default:
-                if ((unsigned char)c > 0x7e || (unsigned char)c < 0x20) {
-                    char hex[5];
-                    snprintf(hex, sizeof(hex), "\\x%02x", (unsigned char)c);
-                    buf_append(&cg->data_section, hex, 4);
-                } else {
-                    buf_push(&cg->data_section, c);
-                }
-                break;
-            }
-        }
-        buf_append(&cg->data_section, "\");\n", 3);
-        emit(cg, "__str%d", idx);
+    case ND_STRING_LIT:
+        emit(cg, "__str%d", str_lit(cg, n->sval, n->slen)->id);
+        break;
+
+    case ND_LABEL_ADDR: {
+        /* Case number of the label in the function's dispatch loop */
+        CGLabel *l = goto_label_find(cg, n->name);
+        emit(cg, "%d", l ? l->state : 0);
         break;
     }
 
@@ -418,7 +2532,7 @@ static void gen_expr(CodeGen *cg, Node *n) {
             Symbol *sym = symtab_lookup(cg->symtab, n->name);
             if (sym && sym->kind == SYM_FUNC) {
                 /* Function used as a value → function pointer ID */
-                emit(cg, "__fp_%s", n->name);
+                emit(cg, "%d", func_id(cg, n->name));
             } else if (sym && sym->kind == SYM_ENUM_CONST) {
                 emit(cg, "%lld", sym->enum_val);
             } else if (sym && sym->kind == SYM_VAR && sym->sc == SC_EXTERN) {
@@ -436,6 +2550,10 @@ static void gen_expr(CodeGen *cg, Node *n) {
             }
             break;
         }
+        if (var_in_js(v)) {
+            emit(cg, "%s", v->js_name);
+            break;
+        }
         /* Array, struct/union types evaluate to their address */
         if (v->type && (v->type->kind == TY_ARRAY || v->type->kind == TY_VLA ||
                         v->type->kind == TY_STRUCT || v->type->kind == TY_UNION)) {
@@ -447,15 +2565,18 @@ static void gen_expr(CodeGen *cg, Node *n) {
             break;
         }
         /* Load value from memory */
-        emit(cg, "rt.mem.%s(", js_getter(v->type));
-        gen_addr(cg, n);
-        emit(cg, ")");
+        gen_load(cg, n, v->type, true);
         break;
     }
 
     case ND_NEG:
         if (expr_is_double(n)) {
-            emit(cg, "rt.f64bits(-rt.f64("); gen_expr(cg, n->lhs); emit(cg, "))");
+            emit(cg, "%s-%s", f64_box(cg), f64_unbox(cg));
+            gen_expr(cg, n->lhs);
+            emit(cg, "))");
+        } else if (n->type && type_is_integer(n->type)) {
+            emit(cg, "(-("); gen_expr(cg, n->lhs);
+            emit(cg, n->type->is_unsigned ? ") >>> 0)" : ") | 0)");
         } else {
             emit(cg, "(-("); gen_expr(cg, n->lhs); emit(cg, "))");
         }
@@ -464,74 +2585,29 @@ static void gen_expr(CodeGen *cg, Node *n) {
         emit(cg, "(+("); gen_expr(cg, n->lhs); emit(cg, "))");
         break;
     case ND_NOT:
-        emit(cg, "(("); gen_expr(cg, n->lhs); emit(cg, ") ? 0 : 1)");
+        emit(cg, "("); gen_cond(cg, n->lhs); emit(cg, " ? 0 : 1)");
         break;
     case ND_BITNOT:
-        emit(cg, "(~("); gen_expr(cg, n->lhs); emit(cg, "))");
+        emit(cg, "(~("); gen_expr(cg, n->lhs);
+        emit(cg, n->type && n->type->is_unsigned ? ") >>> 0)" : "))");
         break;
     case ND_DEREF:
         if (n->type && (n->type->kind == TY_STRUCT || n->type->kind == TY_UNION ||
-                        n->type->kind == TY_ARRAY)) {
-            /* Aggregate deref: just return the address (pointer value) */
+                        n->type->kind == TY_ARRAY || n->type->kind == TY_FUNC)) {
+            /* Aggregate or function deref: just return the address (pointer value) */
             gen_expr(cg, n->lhs);
         } else {
-            emit(cg, "rt.mem.%s(", js_getter(n->type));
-            gen_expr(cg, n->lhs);
-            emit(cg, ")");
+            gen_load(cg, n, n->type, !ptr_maybe_misaligned(cg, n->lhs));
         }
         break;
     case ND_ADDR:
         gen_addr(cg, n->lhs);
         break;
 
-    case ND_PRE_INC: case ND_PRE_DEC: {
-        const char *op = (n->kind == ND_PRE_INC) ? "+" : "-";
-        int step = 1;
-        if (n->lhs->type && n->lhs->type->kind == TY_PTR)
-            step = type_sz(n->lhs->type->base);
-        Type *lt = n->lhs->type;
-        if (type_is_double(lt)) {
-            emit(cg, "((function(){ var a = ");
-            gen_addr(cg, n->lhs);
-            emit(cg, "; var v = rt.f64bits(rt.f64(rt.mem.readBigUint64(a)) %s %d); rt.mem.writeBigUint64(a, v); return v; })())",
-                   op, step);
-        } else if (type_is_u64(lt)) {
-            emit(cg, "((function(){ var a = ");
-            gen_addr(cg, n->lhs);
-            emit(cg, "; var v = rt.mem.%s(a) %s BigInt(%d); rt.mem.%s(a, v); return v; })())",
-                   js_getter(lt), op, step, js_setter(lt));
-        } else {
-            emit(cg, "((function(){ var a = ");
-            gen_addr(cg, n->lhs);
-            emit(cg, "; var v = rt.mem.%s(a) %s %d; rt.mem.%s(a, v); return v; })())",
-                   js_getter(lt), op, step, js_setter(lt));
-        }
-        break;
-    }
-    case ND_POST_INC: case ND_POST_DEC: {
-        const char *op = (n->kind == ND_POST_INC) ? "+" : "-";
-        int step = 1;
-        if (n->lhs->type && n->lhs->type->kind == TY_PTR)
-            step = type_sz(n->lhs->type->base);
-        Type *lt = n->lhs->type;
-        if (type_is_double(lt)) {
-            emit(cg, "((function(){ var a = ");
-            gen_addr(cg, n->lhs);
-            emit(cg, "; var old = rt.mem.readBigUint64(a); rt.mem.writeBigUint64(a, rt.f64bits(rt.f64(old) %s %d)); return old; })())",
-                   op, step);
-        } else if (type_is_u64(lt)) {
-            emit(cg, "((function(){ var a = ");
-            gen_addr(cg, n->lhs);
-            emit(cg, "; var old = rt.mem.%s(a); rt.mem.%s(a, old %s BigInt(%d)); return old; })())",
-                   js_getter(lt), js_setter(lt), op, step);
-        } else {
-            emit(cg, "((function(){ var a = ");
-            gen_addr(cg, n->lhs);
-            emit(cg, "; var old = rt.mem.%s(a); rt.mem.%s(a, old %s %d); return old; })())",
-                   js_getter(lt), js_setter(lt), op, step);
-        }
+    case ND_PRE_INC: case ND_PRE_DEC:
+    case ND_POST_INC: case ND_POST_DEC:
+        gen_update(cg, n, true);
         break;
-    }
 
     case ND_SIZEOF:
         emit(cg, "%d", n->lhs && n->lhs->type ? type_sz(n->lhs->type) : 4);
@@ -540,10 +2616,17 @@ static void gen_expr(CodeGen *cg, Node *n) {
         emit(cg, "%d", n->cast_type ? type_sz(n->cast_type) : 4);
         break;
 
-    case ND_ADD: case ND_SUB: case ND_MUL: case ND_DIV: case ND_MOD:
-    case ND_LSHIFT: case ND_RSHIFT:
     case ND_LT: case ND_LE: case ND_GT: case ND_GE:
     case ND_EQ: case ND_NE:
+    case ND_AND: case ND_OR:
+        /* Conditions used as values materialize 0/1 */
+        emit(cg, "(");
+        gen_cond(cg, n);
+        emit(cg, " ? 1 : 0)");
+        break;
+
+    case ND_ADD: case ND_SUB: case ND_MUL: case ND_DIV: case ND_MOD:
+    case ND_LSHIFT: case ND_RSHIFT:
     case ND_BITAND: case ND_BITOR: case ND_BITXOR: {
         const char *op;
         switch (n->kind) {
@@ -553,269 +2636,129 @@ static void gen_expr(CodeGen *cg, Node *n) {
         case ND_LSHIFT: op = "<<"; break;
         case ND_RSHIFT:
             /* Unsigned types need logical right shift (>>>) in JavaScript;
-             * signed types need arithmetic right shift (>>).
-             * BigInt (u64) does not support >>>, but >> on BigInt is always
-             * arithmetic; for unsigned BigInt values this is fine since they
-             * are non-negative. */
-            op = (n->lhs->type && n->lhs->type->is_unsigned &&
-                  !type_is_u64(n->lhs->type)) ? ">>>" : ">>";
+             * signed types need arithmetic right shift (>>). */
+            op = (n->lhs->type && n->lhs->type->is_unsigned) ? ">>>" : ">>";
             break;
-        case ND_LT: op = "<"; break;   case ND_LE: op = "<="; break;
-        case ND_GT: op = ">"; break;   case ND_GE: op = ">="; break;
-        case ND_EQ: op = "==="; break; case ND_NE: op = "!=="; break;
         case ND_BITAND: op = "&"; break; case ND_BITOR: op = "|"; break;
         case ND_BITXOR: op = "^"; break;
         default: op = "+"; break;
         }
 
         /* Float64 mode: when result or either operand is double, convert
-         * operands to JS numbers via gen_f64_val and wrap result in rt.f64bits.
-         * Must be checked BEFORE u64mode since double + uint64_t → double. */
+         * operands to JS numbers via gen_f64_val and box the result. */
         bool f64mode = expr_is_double(n->lhs) || expr_is_double(n->rhs) || type_is_double(n->type);
         if (f64mode) {
-            bool is_cmp = (n->kind >= ND_LT && n->kind <= ND_NE);
-            if (is_cmp) {
-                emit(cg, "((");
-                gen_f64_val(cg, n->lhs);
-                emit(cg, " %s ", op);
-                gen_f64_val(cg, n->rhs);
-                emit(cg, ") ? 1 : 0)");
-            } else {
-                emit(cg, "rt.f64bits(");
-                gen_f64_val(cg, n->lhs);
-                emit(cg, " %s ", op);
-                gen_f64_val(cg, n->rhs);
-                emit(cg, ")");
-            }
+            emit(cg, "%s", f64_box(cg));
+            gen_f64_val(cg, n->lhs);
+            emit(cg, " %s ", op);
+            gen_f64_val(cg, n->rhs);
+            emit(cg, ")");
             break;
         }
 
-        /* Pointer arithmetic must be checked before BigInt mode, because
-         * ptr + BigInt needs Number conversion, not BigInt wrapping. */
         bool lp = n->lhs->type && (type_is_ptr(n->lhs->type) || type_is_array(n->lhs->type));
         bool rp = n->rhs->type && (type_is_ptr(n->rhs->type) || type_is_array(n->rhs->type));
 
         if ((n->kind == ND_ADD || n->kind == ND_SUB) && lp && !rp) {
             int esz = n->lhs->type->base ? type_sz(n->lhs->type->base) : 1;
             emit(cg, "("); gen_expr(cg, n->lhs); emit(cg, " %s ", op);
-            if (expr_is_u64(n->rhs)) emit(cg, "Number(");
-            gen_expr(cg, n->rhs);
-            if (expr_is_u64(n->rhs)) emit(cg, ")");
-            if (esz > 1) emit(cg, " * %d", esz);
+            gen_scaled_index(cg, n->rhs, esz);
             emit(cg, ")");
             break;
         } else if (n->kind == ND_ADD && rp && !lp) {
             int esz = n->rhs->type->base ? type_sz(n->rhs->type->base) : 1;
             emit(cg, "(");
-            if (expr_is_u64(n->lhs)) emit(cg, "Number(");
-            gen_expr(cg, n->lhs);
-            if (expr_is_u64(n->lhs)) emit(cg, ")");
-            if (esz > 1) emit(cg, " * %d", esz);
+            gen_scaled_index(cg, n->lhs, esz);
             emit(cg, " + "); gen_expr(cg, n->rhs); emit(cg, ")");
             break;
         } else if (n->kind == ND_SUB && lp && rp) {
+            /* The byte difference is an exact multiple of the element size */
             int esz = n->lhs->type->base ? type_sz(n->lhs->type->base) : 1;
+            int k = log2_exact(esz);
             emit(cg, "(("); gen_expr(cg, n->lhs); emit(cg, " - "); gen_expr(cg, n->rhs);
             emit(cg, ")");
-            if (esz > 1) emit(cg, " / %d", esz);
-            emit(cg, " | 0)");
+            if (k > 0) emit(cg, " >> %d)", k);
+            else if (esz > 1) emit(cg, " / %d | 0)", esz);
+            else emit(cg, " | 0)");
             break;
         }
 
-        /* BigInt mode: when either operand is uint64_t, all arithmetic
-         * must use BigInt. Non-BigInt operands are wrapped with BigInt(). */
-        bool u64mode = expr_is_u64(n->lhs) || expr_is_u64(n->rhs) || type_is_u64(n->type);
-        if (u64mode) {
-            bool is_cmp = (n->kind >= ND_LT && n->kind <= ND_NE);
-            if (is_cmp) {
-                emit(cg, "((");
-                if (!expr_is_u64(n->lhs)) emit(cg, "BigInt(");
-                gen_expr(cg, n->lhs);
-                if (!expr_is_u64(n->lhs)) emit(cg, ")");
-                emit(cg, " %s ", op);
-                if (!expr_is_u64(n->rhs)) emit(cg, "BigInt(");
-                gen_expr(cg, n->rhs);
-                if (!expr_is_u64(n->rhs)) emit(cg, ")");
-                emit(cg, ") ? 1 : 0)");
-            } else {
-                emit(cg, "(");
-                if (!expr_is_u64(n->lhs)) emit(cg, "BigInt(");
-                gen_expr(cg, n->lhs);
-                if (!expr_is_u64(n->lhs)) emit(cg, ")");
-                emit(cg, " %s ", op);
-                if (!expr_is_u64(n->rhs)) emit(cg, "BigInt(");
-                gen_expr(cg, n->rhs);
-                if (!expr_is_u64(n->rhs)) emit(cg, ")");
-                emit(cg, ")");
-            }
-        } else if (n->kind == ND_DIV && n->type && type_is_integer(n->type)) {
-            emit(cg, "(("); gen_expr(cg, n->lhs); emit(cg, " / ");
-            gen_expr(cg, n->rhs); emit(cg, ") | 0)");
-        } else if (n->kind >= ND_LT && n->kind <= ND_NE) {
-            emit(cg, "(("); gen_expr(cg, n->lhs); emit(cg, " %s ", op);
-            gen_expr(cg, n->rhs); emit(cg, ") ? 1 : 0)");
+        if (n->type && type_is_integer(n->type)) {
+            gen_int_binop(cg, n, op);
         } else {
-            /* For unsigned 32-bit arithmetic (+, -, *), wrap with >>> 0
-             * to keep values in uint32 range.  JavaScript bitwise operators
-             * already coerce to 32-bit, so only arithmetic ops need this. */
-            bool need_u32_wrap = false;
-            if (n->type && n->type->is_unsigned && !type_is_u64(n->type) &&
-                (n->kind == ND_ADD || n->kind == ND_SUB || n->kind == ND_MUL)) {
-                need_u32_wrap = true;
-            }
-            if (need_u32_wrap) {
-                emit(cg, "(("); gen_expr(cg, n->lhs); emit(cg, " %s ", op);
-                gen_expr(cg, n->rhs); emit(cg, ") >>> 0)");
-            } else {
-                emit(cg, "("); gen_expr(cg, n->lhs); emit(cg, " %s ", op);
-                gen_expr(cg, n->rhs); emit(cg, ")");
-            }
+            emit(cg, "("); gen_expr(cg, n->lhs); emit(cg, " %s ", op);
+            gen_expr(cg, n->rhs); emit(cg, ")");
         }
         break;
     }
 
-    case ND_AND:
-        emit(cg, "(("); gen_expr(cg, n->lhs); emit(cg, " && ");
-        gen_expr(cg, n->rhs); emit(cg, ") ? 1 : 0)");
-        break;
-    case ND_OR:
-        emit(cg, "(("); gen_expr(cg, n->lhs); emit(cg, " || ");
-        gen_expr(cg, n->rhs); emit(cg, ") ? 1 : 0)");
-        break;
-
     case ND_TERNARY: {
-        /* When ternary result is double but a branch is i64, wrap with f64bits(Number())
-         * When ternary result is double but a branch is int, wrap with f64bits() */
+        /* When the result is double, box a non-double branch's value */
         bool res_double = type_is_double(n->type);
-        bool rhs_u64 = expr_is_u64(n->rhs);
-        bool third_u64 = expr_is_u64(n->third);
-        bool rhs_double = expr_is_double(n->rhs);
-        bool third_double = expr_is_double(n->third);
 
-        emit(cg, "("); gen_expr(cg, n->lhs); emit(cg, " ? ");
+        emit(cg, "("); gen_cond(cg, n->lhs); emit(cg, " ? ");
 
-        if (res_double && rhs_u64 && !rhs_double)
-            { emit(cg, "rt.f64bits(Number("); gen_expr(cg, n->rhs); emit(cg, "))"); }
-        else if (res_double && !rhs_double && !rhs_u64)
-            { emit(cg, "rt.f64bits("); gen_expr(cg, n->rhs); emit(cg, ")"); }
+        /* Loads kept on one arm are not evaluated on the other */
+        int mark = cse_mark(&cg->cse);
+        if (res_double && !expr_is_double(n->rhs))
+            { emit(cg, "%s", f64_box(cg)); gen_f64_val(cg, n->rhs); emit(cg, ")"); }
         else
             gen_expr(cg, n->rhs);
 
         emit(cg, " : ");
+        cse_drop(&cg->cse, mark);
 
-        if (res_double && third_u64 && !third_double)
-            { emit(cg, "rt.f64bits(Number("); gen_expr(cg, n->third); emit(cg, "))"); }
-        else if (res_double && !third_double && !third_u64)
-            { emit(cg, "rt.f64bits("); gen_expr(cg, n->third); emit(cg, ")"); }
+        if (res_double && !expr_is_double(n->third))
+            { emit(cg, "%s", f64_box(cg)); gen_f64_val(cg, n->third); emit(cg, ")"); }
         else
             gen_expr(cg, n->third);
 
         emit(cg, ")");
+        cse_drop(&cg->cse, mark);
         break;
     }
 
     case ND_COMMA:
-        emit(cg, "("); gen_expr(cg, n->lhs); emit(cg, ", ");
+        emit(cg, "("); gen_discard(cg, n->lhs); emit(cg, ", ");
         gen_expr(cg, n->rhs); emit(cg, ")");
         break;
 
-    case ND_ASSIGN: {
-        Type *lt = n->lhs->type;
-        if (lt && (lt->kind == TY_STRUCT || lt->kind == TY_UNION)) {
-            /* Struct copy via memcpy; gen_expr returns address for structs */
-            emit(cg, "(rt.memcpy(");
-            gen_addr(cg, n->lhs);
-            emit(cg, ", ");
-            gen_expr(cg, n->rhs);
-            emit(cg, ", %d), ", type_sz(lt));
-            gen_addr(cg, n->lhs);
-            emit(cg, ")");
-        } else {
-            emit(cg, "((function(){ var v = ");
-            gen_expr(cg, n->rhs);
-            emit(cg, "; rt.mem.%s(", js_setter(lt));
-            gen_addr(cg, n->lhs);
-            emit(cg, ", v); return v; })())");
-        }
+    case ND_VA_ARG:
+        gen_va_arg(cg, n);
         break;
-    }
 
+    case ND_ASSIGN:
     case ND_ADD_ASSIGN: case ND_SUB_ASSIGN: case ND_MUL_ASSIGN:
     case ND_DIV_ASSIGN: case ND_MOD_ASSIGN:
     case ND_LSHIFT_ASSIGN: case ND_RSHIFT_ASSIGN:
-    case ND_AND_ASSIGN: case ND_OR_ASSIGN: case ND_XOR_ASSIGN: {
-        const char *op;
-        switch (n->kind) {
-        case ND_ADD_ASSIGN: op = "+"; break; case ND_SUB_ASSIGN: op = "-"; break;
-        case ND_MUL_ASSIGN: op = "*"; break; case ND_DIV_ASSIGN: op = "/"; break;
-        case ND_MOD_ASSIGN: op = "%"; break;
-        case ND_LSHIFT_ASSIGN: op = "<<"; break;
-        case ND_RSHIFT_ASSIGN:
-            op = (n->lhs->type && n->lhs->type->is_unsigned &&
-                  !type_is_u64(n->lhs->type)) ? ">>>" : ">>";
-            break;
-        case ND_AND_ASSIGN: op = "&"; break; case ND_OR_ASSIGN: op = "|"; break;
-        case ND_XOR_ASSIGN: op = "^"; break;
-        default: op = "+"; break;
-        }
-        Type *lt = n->lhs->type;
-        if (type_is_double(lt)) {
-            emit(cg, "((function(){ var a = ");
-            gen_addr(cg, n->lhs);
-            emit(cg, "; var v = rt.f64bits(rt.f64(rt.mem.readBigUint64(a)) %s ", op);
-            gen_f64_val(cg, n->rhs);
-            emit(cg, "); rt.mem.writeBigUint64(a, v); return v; })())");
-        } else {
-            /* For unsigned 32-bit compound arithmetic (+=, -=, *=),
-             * mask the result with >>> 0 to stay in uint32 range. */
-            bool need_u32_wrap = false;
-            if (lt && lt->is_unsigned && !type_is_u64(lt) &&
-                (n->kind == ND_ADD_ASSIGN || n->kind == ND_SUB_ASSIGN ||
-                 n->kind == ND_MUL_ASSIGN)) {
-                need_u32_wrap = true;
-            }
-            emit(cg, "((function(){ var a = ");
-            gen_addr(cg, n->lhs);
-            if (need_u32_wrap) {
-                emit(cg, "; var v = (rt.mem.%s(a) %s (", js_getter(lt), op);
-                gen_expr(cg, n->rhs);
-                emit(cg, ")) >>> 0; rt.mem.%s(a, v); return v; })())", js_setter(lt));
-            } else {
-                emit(cg, "; var v = rt.mem.%s(a) %s (", js_getter(lt), op);
-                gen_expr(cg, n->rhs);
-                emit(cg, "); rt.mem.%s(a, v); return v; })())", js_setter(lt));
-            }
-        }
+    case ND_AND_ASSIGN: case ND_OR_ASSIGN: case ND_XOR_ASSIGN:
+        gen_update(cg, n, true);
         break;
-    }
 
     case ND_CALL: {
+        bool bare = cg->rret_bare;
+        const char *dest = cg->sret_dest;
+        cg->rret_bare = false;
+        cg->sret_dest = NULL;
         const char *fname = NULL;
         if (n->callee->kind == ND_IDENT)
             fname = n->callee->name;
 
-        /* Special handling for va_start/va_end/va_copy */
+        /* va_start/va_copy assign the va_list pointer; va_end is a no-op */
         if (fname && strcmp(fname, "va_start") == 0) {
-            /* va_start(ap, last) → write va_list ID to ap's address */
-            emit(cg, "rt.mem.writeUint32(");
-            gen_addr(cg, n->args);
-            emit(cg, ", rt.vaStart(p___va))");
+            gen_va_set_begin(cg, n->args);
+            emit(cg, "p___va");
+            gen_va_set_end(cg, n->args);
             break;
         }
         if (fname && strcmp(fname, "va_end") == 0) {
-            /* va_end(ap) → free va_list entry */
-            emit(cg, "rt.vaEnd(rt.mem.readUint32(");
-            gen_addr(cg, n->args);
-            emit(cg, "))");
+            emit(cg, "0 /* va_end */");
             break;
         }
         if (fname && strcmp(fname, "va_copy") == 0) {
-            /* va_copy(dest, src) → copy va_list entry */
-            emit(cg, "rt.mem.writeUint32(");
-            gen_addr(cg, n->args);
-            emit(cg, ", rt.vaCopy(rt.mem.readUint32(");
-            gen_addr(cg, n->args->next);
-            emit(cg, ")))");
+            gen_va_set_begin(cg, n->args);
+            gen_expr(cg, n->args->next);
+            gen_va_set_end(cg, n->args);
             break;
         }
 
@@ -843,7 +2786,8 @@ static void gen_expr(CodeGen *cg, Node *n) {
         }
 
         bool is_direct = false;
-        bool sret = is_aggregate(n->type);
+        bool rret = struct_in_regs(n->type);
+        bool sret = is_aggregate(n->type) && !rret;
         if (fname) {
             /* Check if it's a known function (not a local/global variable) */
             CGVar *v = var_find(cg, fname);
@@ -852,11 +2796,34 @@ static void gen_expr(CodeGen *cg, Node *n) {
                 if (sym && sym->kind == SYM_FUNC) is_direct = true;
             }
         }
+        if (!is_direct) {
+            /* Pointer provably bound to one function: call it directly */
+            const char *target = call_target(cg, n->callee);
+            if (target) {
+                fname = target;
+                is_direct = true;
+            }
+        }
+
+        /* Variable arguments of compiled functions go to a memory area:
+         * (stores..., call(args..., area)) */
+        Node *va_first = NULL;
+        int va_off = 0;
+        if (call_passes_va_area(cg, n)) {
+            Type *ft = n->callee->type->kind == TY_PTR ? n->callee->type->base : n->callee->type;
+            va_first = n->args;
+            for (Param *p = ft->params; p; p = p->next) va_first = va_first->next;
+            emit(cg, "(");
+            va_off = gen_va_area(cg, va_first);
+        }
 
         /* For struct-returning functions, allocate temp space and use
-         * comma expression: (call(retptr, args...), retptr) */
+         * comma expression: (call(retptr, args...), retptr).  A call whose
+         * destination is known returns straight into it. */
         int sret_off = 0;
-        if (sret) {
+        if (sret && dest) {
+            /* no temporary */
+        } else if (sret || (rret && !bare)) {
             sret_off = alloc_local(cg, n->type);
             emit(cg, "(");
         }
@@ -864,12 +2831,15 @@ static void gen_expr(CodeGen *cg, Node *n) {
         bool is_math = is_direct && is_math_func(fname);
         bool is_stdlib = is_direct && is_stdlib_func(fname);
         bool ret_f64 = !sret && type_is_double(n->type);
-        /* Math/stdlib functions return JS numbers; wrap result in f64bits */
-        bool wrap_ret = (is_math || is_stdlib) && ret_f64;
-        /* Math/stdlib functions expect JS numbers; unwrap double args */
-        bool unwrap_args = is_math || is_stdlib;
+        /* Math/stdlib functions return JS numbers; box the result */
+        bool wrap_ret = (is_math || is_stdlib) && ret_f64 && cg->nan_boxing;
+        /* Math/stdlib functions expect JS numbers; unbox double args */
+        bool unwrap_args = (is_math || is_stdlib) && cg->nan_boxing;
+        /* stdlib functions return long long as a BigInt */
+        bool split_ret = is_stdlib && expr_is_i64(n);
 
         if (wrap_ret) emit(cg, "rt.f64bits(");
+        if (split_ret) emit(cg, "rt.split64(");
 
         if (is_math) {
             emit(cg, "Math.%s(", math_func_js_name(fname));
@@ -878,19 +2848,20 @@ static void gen_expr(CodeGen *cg, Node *n) {
         } else if (is_direct) {
             emit(cg, "_%s(", fname);
         } else {
-            /* Indirect call through function pointer */
-            emit(cg, "rt.callFunction(");
+            /* Indirect call through the function table */
+            emit(cg, "__ft[");
             gen_expr(cg, n->callee);
-            emit(cg, ", ");
+            emit(cg, "](");
         }
 
         /* Hidden return pointer as first argument */
         if (sret) {
-            emit(cg, "(bp + (%d))", sret_off);
+            if (dest) emit(cg, "%s", dest);
+            else emit(cg, "(bp + (%d))", sret_off);
             if (n->args) emit(cg, ", ");
         }
 
-        /* Get parameter types for BigInt→Number coercion at call boundary */
+        /* Parameter types decide how each argument is passed */
         Type *call_fn_type = NULL;
         if (n->callee && n->callee->type) {
             call_fn_type = n->callee->type;
@@ -899,37 +2870,72 @@ static void gen_expr(CodeGen *cg, Node *n) {
             if (call_fn_type->kind != TY_FUNC) call_fn_type = NULL;
         }
         Param *cparam = call_fn_type ? call_fn_type->params : NULL;
-
-        for (Node *a = n->args; a; a = a->next) {
-            bool coerce_bigint = false;
-            if (cparam && expr_is_u64(a) && !type_is_u64(cparam->type) && !type_is_double(cparam->type))
-                coerce_bigint = true;
-            if (unwrap_args && expr_is_double(a)) {
+        long long vlo, vhi;
+
+        for (Node *a = n->args; a != va_first; a = a->next) {
+            /* long long parameters of compiled functions take two words;
+             * the runtime gets variadic and stdlib long longs as BigInts */
+            bool i64_param = cparam && type_is_i64(cparam->type);
+            bool pass_words = i64_param && !is_math && !is_stdlib;
+            bool pass_bigint = !pass_words && expr_is_i64(a) && (!cparam || i64_param);
+            /* Non-double argument for a double parameter: box its numeric value */
+            bool box_arg = !unwrap_args && cparam && type_is_double(cparam->type) &&
+                           !expr_is_double(a) && (cg->nan_boxing || expr_is_i64(a));
+            /* Double argument for a non-double parameter: unbox it */
+            bool unbox_arg = cg->nan_boxing && expr_is_double(a) &&
+                             (unwrap_args || (cparam && !type_is_double(cparam->type)));
+            bool reg_arg = cparam && struct_in_regs(cparam->type) && !is_math && !is_stdlib;
+            if (reg_arg) {
+                gen_reg_args(cg, a);
+            } else if (unbox_arg) {
                 emit(cg, "rt.f64(");
                 gen_expr(cg, a);
                 emit(cg, ")");
-            } else if (coerce_bigint) {
-                emit(cg, "Number(");
+            } else if (box_arg) {
+                emit(cg, "%s", f64_box(cg));
+                gen_f64_val(cg, a);
+                emit(cg, ")");
+            } else if (pass_words) {
+                gen_i64_conv(cg, a, cparam->type);
+                emit(cg, ", rt.H");
+            } else if (pass_bigint && !cparam && is_stdlib && range_of(&cg->ranges, a, &vlo, &vhi)) {
+                /* printf-style varargs take an exact Number as well */
+                gen_i64_number(cg, a, vlo, vhi);
+            } else if (pass_bigint) {
+                emit(cg, a->type->is_unsigned ? "rt.bigu64(" : "rt.big64(");
                 gen_expr(cg, a);
-                emit(cg, " & 0xFFFFFFFFn)");
+                emit(cg, ", rt.H)");
             } else {
                 gen_expr(cg, a);
             }
-            if (a->next) emit(cg, ", ");
+            if (a->next != va_first) emit(cg, ", ");
             if (cparam) cparam = cparam->next;
         }
+        if (va_first) emit(cg, "%sbp + (%d)", n->args != va_first ? ", " : "", va_off);
         emit(cg, ")");
 
+        if (split_ret) emit(cg, ")");
         if (wrap_ret) emit(cg, ")");
 
-        if (sret) {
+        if (sret && !dest) {
+            emit(cg, ", (bp + (%d)))", sret_off);
+        } else if (rret && !bare) {
+            /* (call, stores of __r0..., temp) */
+            emit(cg, ", ");
+            gen_reg_store_slots(cg, n->type, "bp", sret_off);
             emit(cg, ", (bp + (%d)))", sret_off);
         }
+        if (va_first) emit(cg, ")");
         break;
     }
 
     case ND_MEMBER:
     case ND_MEMBER_PTR: {
+        CGVar *f = sroa_field(cg, n);
+        if (f) {
+            emit(cg, "%s", f->js_name);
+            break;
+        }
         /* Check if the original member type (before decay) is an array.
          * sema's decay_array() mutates n->type from TY_ARRAY to TY_PTR,
          * so we look up the member in the struct definition. */
@@ -953,9 +2959,7 @@ static void gen_expr(CodeGen *cg, Node *n) {
             /* Aggregate or array member → return address */
             gen_addr(cg, n);
         } else {
-            emit(cg, "rt.mem.%s(", js_getter(n->type));
-            gen_addr(cg, n);
-            emit(cg, ")");
+            gen_load(cg, n, n->type, lvalue_aligned(cg, n));
         }
         break;
     }
@@ -965,52 +2969,43 @@ static void gen_expr(CodeGen *cg, Node *n) {
                         n->type->kind == TY_STRUCT || n->type->kind == TY_UNION)) {
             gen_addr(cg, n);
         } else {
-            emit(cg, "rt.mem.%s(", js_getter(n->type));
-            gen_addr(cg, n);
-            emit(cg, ")");
+            gen_load(cg, n, n->type, lvalue_aligned(cg, n));
         }
         break;
 
     case ND_CAST: {
         bool to_double = n->cast_type && type_is_double(n->cast_type);
         bool from_double = expr_is_double(n->cast_expr);
-        bool to_u64 = n->cast_type && type_is_u64(n->cast_type);
-        bool from_u64 = expr_is_u64(n->cast_expr);
+        bool from_i64 = expr_is_i64(n->cast_expr);
         bool to_float32 = n->cast_type && n->cast_type->kind == TY_FLOAT;
         bool to_int = n->cast_type && type_is_integer(n->cast_type) && n->cast_type->size <= 4;
 
         if (to_double) {
-            /* Cast TO double: result must be BigInt raw bits */
+            /* Cast TO double: box the numeric value */
             if (from_double) {
                 gen_expr(cg, n->cast_expr);
-            } else if (from_u64) {
-                /* uint64_t→double: numeric conversion (BigInt int → float → bits) */
-                emit(cg, "rt.f64bits(Number("); gen_expr(cg, n->cast_expr); emit(cg, "))");
-            } else {
+            } else if (from_i64) {
+                emit(cg, "%s", f64_box(cg)); gen_f64_val(cg, n->cast_expr); emit(cg, ")");
+            } else if (cg->nan_boxing) {
                 /* int/float→double: JS number → BigInt raw float64 bits */
                 emit(cg, "rt.f64bits("); gen_expr(cg, n->cast_expr); emit(cg, ")");
-            }
-        } else if (to_u64) {
-            if (from_double) {
-                /* double→uint64_t: numeric conversion (bits → float → truncate → BigInt) */
-                emit(cg, "BigInt(Math.trunc(rt.f64("); gen_expr(cg, n->cast_expr); emit(cg, ")))");
             } else {
-                /* int/float→uint64_t: wrap in BigInt() */
-                emit(cg, "BigInt("); gen_expr(cg, n->cast_expr); emit(cg, ")");
+                gen_expr(cg, n->cast_expr);
             }
         } else if (to_float32 && from_double) {
-            /* double→float32: BigInt raw bits → JS number (narrowed to float32) */
-            emit(cg, "Math.fround(rt.f64("); gen_expr(cg, n->cast_expr); emit(cg, "))");
-        } else if (to_float32 && from_u64) {
-            /* uint64_t→float32: BigInt integer → JS number */
-            emit(cg, "Number("); gen_expr(cg, n->cast_expr); emit(cg, ")");
+            /* double→float32: narrow the JS number to float32 */
+            emit(cg, "Math.fround(%s", f64_unbox(cg)); gen_expr(cg, n->cast_expr); emit(cg, "))");
+        } else if (to_float32 && from_i64) {
+            emit(cg, "Math.fround("); gen_f64_val(cg, n->cast_expr); emit(cg, ")");
+        } else if (to_int && from_i64 && n->cast_type->kind == TY_BOOL) {
+            emit(cg, "("); gen_cond(cg, n->cast_expr); emit(cg, " ? 1 : 0)");
+        } else if (to_int && range_cast_exact(&cg->ranges, n)) {
+            gen_expr(cg, n->cast_expr);
         } else if (to_int) {
-            /* Cast to int/short/char: may need to unwrap BigInt/double first.
-             * For from_u64: mask BigInt to 32 bits BEFORE Number() to avoid
-             * precision loss for values > 2^53. */
+            /* Cast to int/short/char: may need to unwrap a double first.
+             * A long long contributes its low word. */
             const char *pre = "", *suf = "";
-            if (from_double)   { pre = "rt.f64("; suf = ")"; }
-            else if (from_u64) { pre = "Number("; suf = " & 0xFFFFFFFFn)"; }
+            if (from_double) { pre = f64_unbox(cg); suf = ")"; }
 
             if (n->cast_type->kind == TY_CHAR && !n->cast_type->is_unsigned) {
                 emit(cg, "((%s", pre); gen_expr(cg, n->cast_expr); emit(cg, "%s) << 24 >> 24)", suf);
@@ -1025,12 +3020,9 @@ static void gen_expr(CodeGen *cg, Node *n) {
             } else {
                 emit(cg, "((%s", pre); gen_expr(cg, n->cast_expr); emit(cg, "%s) | 0)", suf);
             }
-        } else if (type_is_ptr(n->cast_type) && from_u64) {
-            /* BigInt→pointer: convert to Number (32-bit address) */
-            emit(cg, "Number("); gen_expr(cg, n->cast_expr); emit(cg, " & 0xFFFFFFFFn)");
-        } else if (from_u64 && !to_u64) {
-            /* BigInt→other non-pointer: convert to Number */
-            emit(cg, "Number("); gen_expr(cg, n->cast_expr); emit(cg, ")");
+        } else if (type_is_ptr(n->cast_type) && from_i64) {
+            /* long long→pointer: the low word is the address */
+            emit(cg, "("); gen_expr(cg, n->cast_expr); emit(cg, " >>> 0)");
         } else {
             gen_expr(cg, n->cast_expr);
         }
@@ -1045,9 +3037,60 @@ static void gen_expr(CodeGen *cg, Node *n) {
         emit(cg, "0 /* expr_%d */", n->kind);
         break;
     }
+    /* The callee may store anywhere */
+    if (n->kind == ND_CALL || n->kind == ND_VA_ARG) cse_clear(&cg->cse);
 }
 
 /* ---- Statement generation ---- */
+
+/* Emit e converted to the JS representation of scalar type ty.
+ * Initializer items carry no implicit cast to the element type. */
+static void gen_expr_to(CodeGen *cg, Type *ty, Node *e) {
+    if (type_is_i64(ty)) {
+        gen_i64_conv(cg, e, ty);
+    } else if (type_is_double(ty) && !expr_is_double(e) && (cg->nan_boxing || expr_is_i64(e))) {
+        emit(cg, "%s", f64_box(cg));
+        gen_f64_val(cg, e);
+        emit(cg, ")");
+    } else if (!type_is_double(ty) && expr_is_double(e) && cg->nan_boxing) {
+        emit(cg, "rt.f64(");
+        gen_expr(cg, e);
+        emit(cg, ")");
+    } else if (ty && ty->kind == TY_FLOAT && expr_is_i64(e)) {
+        gen_f64_val(cg, e);
+    } else {
+        gen_expr(cg, e);
+    }
+}
+
+/* True if integer initializer init already holds a value of type ty */
+static bool init_in_range(CodeGen *cg, Type *ty, Node *init) {
+    long long lo, hi;
+    return init->type && type_is_integer(init->type) && !expr_is_i64(init) &&
+           range_of(&cg->ranges, init, &lo, &hi) && range_fits(ty, lo, hi);
+}
+
+/* Assign the initial value of promoted local v, converted to its type */
+static void gen_jslocal_init(CodeGen *cg, CGVar *v, Node *init) {
+    Type *ty = v->type;
+    if (init && init->kind == ND_INIT_LIST)
+        init = init->body; /* scalar in braces: int x = { 1 }; */
+    emit(cg, "%s = ", v->js_name);
+    if (type_is_i64(ty)) {
+        if (init) gen_i64_conv(cg, init, ty);
+        else emit(cg, "0, rt.H = 0");
+        emit(cg, ", %s = rt.H", v->js_hi);
+    } else if (!init) {
+        emit(cg, type_is_bigint(cg, ty) ? "0n" : "0");
+    } else if (type_is_double(ty) || init_in_range(cg, ty, init)) {
+        gen_expr_to(cg, ty, init);
+    } else {
+        emit_coerce_begin(cg, ty);
+        gen_expr_to(cg, ty, init);
+        emit_coerce_end(cg, ty);
+    }
+}
+
 static int alloc_local(CodeGen *cg, Type *ty) {
     int size = type_sz(ty);
     int align = ty->align > 0 ? ty->align : 1;
@@ -1056,6 +3099,266 @@ static int alloc_local(CodeGen *cg, Type *ty) {
     return -(cg->stack_offset);
 }
 
+/* ---- Register struct values ----
+ * Moves of register structs between memory, split locals, call arguments
+ * and the return slots.  Each emits a comma-separated list. */
+
+static const char *ret_slot(CodeGen *cg, int k) {
+    if (k >= cg->ret_slots) cg->ret_slots = k + 1;
+    return fmt_str(cg, "__r%d", k);
+}
+
+/* Word `w` (1 = high word of a long long) of leaf l of the struct at addr */
+static const char *reg_leaf_load(CodeGen *cg, RegLeaf *l, const char *addr, bool aligned, int w) {
+    const char *a = fmt_str(cg, "(%s + (%d))", addr, l->off + 4 * w);
+    if (!type_is_i64(l->type)) return mem_load_str(cg, l->type, aligned, a);
+    return aligned ? fmt_str(cg, "HEAP32[%s >> 2]", a) : fmt_str(cg, "rt.mem.readInt32(%s)", a);
+}
+
+/* Return slots = the register struct of type t at addr */
+static void gen_reg_load_slots(CodeGen *cg, Type *t, const char *addr, bool aligned) {
+    RegLeaf lv[REG_STRUCT_SIZE];
+    int n = reg_leaves(t, 0, lv, 0), k = 0;
+    for (int i = 0; i < n; i++) {
+        int words = type_is_i64(lv[i].type) ? 2 : 1;
+        for (int w = 0; w < words; w++) {
+            if (k) emit(cg, ", ");
+            emit(cg, "%s = %s", ret_slot(cg, k), reg_leaf_load(cg, &lv[i], addr, aligned, w));
+            k++;
+        }
+    }
+}
+
+/* Store the return slots to the register struct of type t at base + off */
+static void gen_reg_store_slots(CodeGen *cg, Type *t, const char *base, int off) {
+    RegLeaf lv[REG_STRUCT_SIZE];
+    int n = reg_leaves(t, 0, lv, 0), k = 0;
+    for (int i = 0; i < n; i++) {
+        if (i) emit(cg, ", ");
+        if (type_is_i64(lv[i].type)) {
+            I64Mem m;
+            i64_mem_at(cg, base, off + lv[i].off, true, &m);
+            emit(cg, "HEAP32[%s >> 2] = %s, ", m.lo, ret_slot(cg, k));
+            emit(cg, "HEAP32[%s >> 2] = %s", m.hi, ret_slot(cg, k + 1));
+            k += 2;
+            continue;
+        }
+        emit_store_begin(cg, lv[i].type, true);
+        emit(cg, "(%s + (%d))", base, off + lv[i].off);
+        emit_store_mid(cg, lv[i].type, true);
+        emit(cg, "%s", ret_slot(cg, k++));
+        emit_store_end(cg, lv[i].type, true);
+    }
+}
+
+/* Return slots = the fields of split struct v */
+static void gen_fields_to_slots(CodeGen *cg, CGVar *v) {
+    int k = 0;
+    for (CGVar *f = v->fields; f; f = f->next) {
+        if (k) emit(cg, ", ");
+        emit(cg, "%s = %s", ret_slot(cg, k++), f->js_name);
+        if (f->js_hi) emit(cg, ", %s = %s", ret_slot(cg, k++), f->js_hi);
+    }
+}
+
+/* Is n a call whose register struct result arrives in the return slots? */
+static bool call_in_slots(Node *n) {
+    return n && n->kind == ND_CALL && struct_in_regs(n->type);
+}
+
+/* Is n a call whose struct result goes through a hidden return pointer? */
+static bool call_in_memory(Node *n) {
+    return n && n->kind == ND_CALL && is_aggregate(n->type) && !struct_in_regs(n->type);
+}
+
+/* Can memory struct call `call` return straight into the frame local v
+ * instead of a temporary that is copied afterwards?  v escapes when its
+ * address is taken, or, for an object just being declared (which nothing
+ * can point to yet), when a backward goto may re-enter its scope. */
+static bool sret_into(CodeGen *cg, Node *call, CGVar *v, bool declared) {
+    if (!call_in_memory(call) || !v || v->storage != CGV_MEMORY || !v->is_local || v->is_param)
+        return false;
+    bool escapes = declared ? cg->has_goto
+                            : !cg->func_promote || addr_taken_has(cg, v->name) ||
+                              agg_escaped(cg, v->name);
+    return dse_sret_into(call, v->name, v->type, escapes);
+}
+
+/* The leaf words of register struct argument a, as JS arguments */
+static void gen_reg_args(CodeGen *cg, Node *a) {
+    CGVar *sv = split_var(cg, a);
+    if (sv) {
+        for (CGVar *f = sv->fields; f; f = f->next) {
+            emit(cg, "%s%s", f == sv->fields ? "" : ", ", f->js_name);
+            if (f->js_hi) emit(cg, ", %s", f->js_hi);
+        }
+        return;
+    }
+    RegLeaf lv[REG_STRUCT_SIZE];
+    int n = reg_leaves(a->type, 0, lv, 0), k = 0;
+    const char *addr = NULL;
+    bool al = true, wrap = true;
+    if (call_in_slots(a)) {
+        /* (call, __r0), __r1, ... */
+        emit(cg, "(");
+        cg->rret_bare = true;
+        gen_expr(cg, a);
+        emit(cg, ", ");
+    } else if (expr_is_pure(a)) {
+        addr = gen_addr_str(cg, a);
+        al = lvalue_aligned(cg, a);
+        wrap = false;
+    } else {
+        /* ($t = address, first word), other words ... */
+        addr = new_tmp_var(cg);
+        emit(cg, "(%s = ", addr);
+        gen_expr(cg, a);
+        emit(cg, ", ");
+    }
+    for (int i = 0; i < n; i++) {
+        int words = type_is_i64(lv[i].type) ? 2 : 1;
+        for (int w = 0; w < words; w++) {
+            if (k) emit(cg, ", ");
+            if (call_in_slots(a)) emit(cg, "%s", ret_slot(cg, k));
+            else emit(cg, "%s", reg_leaf_load(cg, &lv[i], addr, al, w));
+            if (k == 0 && wrap) emit(cg, ")");
+            k++;
+        }
+    }
+}
+
+/* ---- Split struct copies ----
+ * Initialization and whole-struct copies of a CGV_FIELDS variable are comma
+ * expressions of per-field assignments; *n counts the assignments emitted
+ * so far.  A `set` mask records which fields (by position) were written. */
+
+static void fields_sep(CodeGen *cg, int *n) {
+    if ((*n)++) emit(cg, ", ");
+}
+
+/* Fields of v in [base, base + size) = the same fields of split struct src */
+static void gen_fields_from_var(CodeGen *cg, CGVar *v, int base, int size, CGVar *src,
+                                unsigned *set, int *n) {
+    int i = 0;
+    for (CGVar *f = v->fields; f; f = f->next, i++) {
+        if (f->addr < base || f->addr >= base + size) continue;
+        CGVar *s = src->fields;
+        while (s && s->addr != f->addr - base) s = s->next;
+        if (!s) continue;
+        fields_sep(cg, n);
+        emit(cg, "%s = %s", f->js_name, s->js_name);
+        if (f->js_hi) emit(cg, ", %s = %s", f->js_hi, s->js_hi);
+        if (set) *set |= 1u << i;
+    }
+}
+
+/* Fields of v in [base, base + size) = the struct at address addr */
+static void gen_fields_from_addr(CodeGen *cg, CGVar *v, int base, int size, const char *addr,
+                                 unsigned *set, int *n) {
+    int i = 0;
+    for (CGVar *f = v->fields; f; f = f->next, i++) {
+        if (f->addr < base || f->addr >= base + size) continue;
+        fields_sep(cg, n);
+        if (f->js_hi) {
+            I64Mem m;
+            i64_mem_at(cg, addr, f->addr - base, true, &m);
+            emit(cg, "%s = HEAP32[%s >> 2], %s = HEAP32[%s >> 2]",
+                 f->js_name, m.lo, f->js_hi, m.hi);
+        } else {
+            emit(cg, "%s = %s", f->js_name,
+                 mem_load_str(cg, f->type, true, fmt_str(cg, "(%s + (%d))", addr, f->addr - base)));
+        }
+        if (set) *set |= 1u << i;
+    }
+}
+
+/* Store the fields of v to the struct at base + off */
+static void gen_fields_store(CodeGen *cg, CGVar *v, const char *base, int off, int *n) {
+    for (CGVar *f = v->fields; f; f = f->next) {
+        fields_sep(cg, n);
+        if (f->js_hi) {
+            I64Mem m;
+            i64_mem_at(cg, base, off + f->addr, true, &m);
+            emit(cg, "HEAP32[%s >> 2] = %s, HEAP32[%s >> 2] = %s", m.lo, f->js_name, m.hi, f->js_hi);
+            continue;
+        }
+        emit_store_begin(cg, f->type, true);
+        emit(cg, "(%s + (%d))", base, off + f->addr);
+        emit_store_mid(cg, f->type, true);
+        emit(cg, "%s", f->js_name);
+        emit_store_end(cg, f->type, true);
+    }
+}
+
+/* Assign init to the part of split struct v of type ty at offset base */
+static void gen_fields_init_at(CodeGen *cg, CGVar *v, int base, Type *ty, Node *init,
+                               unsigned *set, int *n) {
+    if (!init) return;
+    if (init->kind == ND_INIT_LIST) {
+        if (ty->kind != TY_STRUCT) {
+            gen_fields_init_at(cg, v, base, ty, init->body, set, n);
+            return;
+        }
+        Member *m = ty->members;
+        for (Node *item = init->body; item; item = item->next) {
+            if (item->kind == ND_DESIGNATOR && item->desig_name) {
+                m = type_find_member(ty, item->desig_name);
+                if (m) gen_fields_init_at(cg, v, base + m->offset, m->type, item->desig_init, set, n);
+                if (m) m = m->next;
+            } else if (m) {
+                gen_fields_init_at(cg, v, base + m->offset, m->type, item, set, n);
+                m = m->next;
+            }
+        }
+    } else if (ty->kind == TY_STRUCT) {
+        CGVar *src = split_var(cg, init);
+        if (src) {
+            gen_fields_from_var(cg, v, base, type_sz(ty), src, set, n);
+        } else if (call_in_slots(init)) {
+            /* call, fields = __r0, __r1, ... */
+            int i = 0, k = 0;
+            fields_sep(cg, n);
+            cg->rret_bare = true;
+            gen_expr(cg, init);
+            for (CGVar *f = v->fields; f; f = f->next, i++) {
+                if (f->addr < base || f->addr >= base + type_sz(ty)) continue;
+                emit(cg, ", %s = %s", f->js_name, ret_slot(cg, k++));
+                if (f->js_hi) emit(cg, ", %s = %s", f->js_hi, ret_slot(cg, k++));
+                if (set) *set |= 1u << i;
+            }
+        } else {
+            const char *t = new_tmp_var(cg);
+            fields_sep(cg, n);
+            emit(cg, "%s = ", t);
+            gen_expr(cg, init);
+            gen_fields_from_addr(cg, v, base, type_sz(ty), t, set, n);
+        }
+    } else {
+        int i = 0;
+        for (CGVar *f = v->fields; f; f = f->next, i++) {
+            if (f->addr != base) continue;
+            fields_sep(cg, n);
+            gen_jslocal_init(cg, f, init);
+            if (set) *set |= 1u << i;
+            break;
+        }
+    }
+}
+
+/* Initialize split struct v from init; fields it does not name are zeroed */
+static void gen_fields_init(CodeGen *cg, CGVar *v, Node *init) {
+    unsigned set = 0;
+    int n = 0, i = 0;
+    gen_fields_init_at(cg, v, 0, v->type, init, &set, &n);
+    for (CGVar *f = v->fields; f; f = f->next, i++) {
+        if (set & (1u << i)) continue;
+        fields_sep(cg, &n);
+        gen_jslocal_init(cg, f, NULL);
+    }
+}
+
+/* Store initializer init of type ty at bp_expr + base_offset.  A NULL
+ * bp_expr means static storage at absolute address base_offset. */
 static void gen_init(CodeGen *cg, const char *bp_expr, int base_offset, Type *ty, Node *init) {
     if (!init) return;
 
@@ -1089,25 +3392,597 @@ static void gen_init(CodeGen *cg, const char *bp_expr, int base_offset, Type *ty
         } else {
             if (init->body) gen_init(cg, bp_expr, base_offset, ty, init->body);
         }
-    } else if (is_aggregate(ty)) {
-        /* Aggregate leaf: memcpy from source address */
-        emit_indent(cg);
-        emit(cg, "rt.memcpy(%s + (%d), ", bp_expr, base_offset);
-        gen_expr(cg, init);
-        emit(cg, ", %d);\n", type_sz(ty));
-    } else {
-        emit_indent(cg);
-        emit(cg, "rt.mem.%s(%s + (%d), ", js_setter(ty), bp_expr, base_offset);
-        gen_expr(cg, init);
-        emit(cg, ");\n");
+        return;
+    }
+
+    /* Static storage: constant leaves go into the data image */
+    if (!bp_expr) {
+        if (image_init(cg, base_offset, ty, init)) return;
+        bp_expr = "0";
+    }
+    if (ty->kind == TY_ARRAY && ty->base && ty->base->kind == TY_CHAR &&
+        init->kind == ND_STRING_LIT) {
+        /* char array member or row from a string: copy, zero the rest */
+        int sz = type_sz(ty), n = init->slen + 1 < sz ? init->slen + 1 : sz;
+        int id = str_lit(cg, init->sval, init->slen)->id;
+        emitln(cg, "HEAPU8.copyWithin(%s + (%d), __str%d, __str%d + %d);",
+               bp_expr, base_offset, id, id, n);
+        if (n < sz) emitln(cg, "rt.memset(%s + (%d), 0, %d);", bp_expr, base_offset + n, sz - n);
+    } else if (is_aggregate(ty)) {
+        /* Aggregate leaf: memcpy from source address */
+        emit_indent(cg);
+        emit(cg, "rt.memcpy(%s + (%d), ", bp_expr, base_offset);
+        gen_expr(cg, init);
+        emit(cg, ", %d);\n", type_sz(ty));
+    } else if (type_is_i64(ty)) {
+        emit_indent(cg);
+        gen_i64_init(cg, bp_expr, base_offset, base_offset % 4 == 0, ty, init);
+        emit(cg, ";\n");
+    } else {
+        bool al = ty->align > 0 && base_offset % ty->align == 0;
+        emit_indent(cg);
+        emit_store_begin(cg, ty, al);
+        emit(cg, "%s + (%d)", bp_expr, base_offset);
+        emit_store_mid(cg, ty, al);
+        gen_expr_to(cg, ty, init);
+        emit_store_end(cg, ty, al);
+        emit(cg, ";\n");
+    }
+}
+
+/* Epilogue prefix for a return: pops the frame if the function has one */
+static const char *restore_sp(CodeGen *cg) {
+    return cg->func_has_frame ? "rt.mem.sp = saved_sp; " : "";
+}
+
+/* ---- goto lowering ----
+ * Each label belongs to a statement list: the block whose statement it
+ * labels, or, for a labeled statement outside any block, a list of its
+ * own.  A goto must sit inside that list (possibly deep in one of its
+ * statements); one that jumps into a nested statement first has the
+ * statements around its label flattened into labels and gotos.  A
+ * forward goto from statement j to label statement i leaves a labeled
+ * block around j..i-1; a backward one continues a labeled loop around
+ * i..j.  When the blocks and loops of a list do not nest, the whole list
+ * becomes a dispatch loop: for (;;) { switch (state) { case 0: ... } break; }
+ * and a goto sets the state and continues it.  C loops and switches in
+ * such functions get JS labels, so that their break and continue skip the
+ * loops added here. */
+
+#define GOTO_MAX_DEPTH 256
+
+static CGLabel *goto_label_find(CodeGen *cg, const char *name) {
+    for (CGLabel *l = cg->goto_labels; l; l = l->next)
+        if (strcmp(l->name, name) == 0) return l;
+    return NULL;
+}
+
+static CGGotoList *goto_list_find(CodeGen *cg, Node *head, bool lone) {
+    for (CGGotoList *gl = cg->goto_lists; gl; gl = gl->next)
+        if (gl->head == head && gl->lone == lone) return gl;
+    return NULL;
+}
+
+static void goto_label_add(CodeGen *cg, Node *label, Node *head, int index, bool lone) {
+    CGGotoList *gl = goto_list_find(cg, head, lone);
+    if (!gl) {
+        gl = arena_calloc(cg->arena, sizeof(CGGotoList));
+        gl->head = head;
+        gl->lone = lone;
+        gl->next = cg->goto_lists;
+        cg->goto_lists = gl;
+    }
+    CGLabel *l = arena_calloc(cg->arena, sizeof(CGLabel));
+    l->name = label->name;
+    l->node = label;
+    l->list = gl;
+    l->index = index;
+    l->next = cg->goto_labels;
+    cg->goto_labels = l;
+}
+
+/* Labels and case labels in front of statement s */
+static bool is_stmt_label(Node *s) {
+    return s && (s->kind == ND_LABEL || s->kind == ND_CASE || s->kind == ND_DEFAULT);
+}
+
+static Node *label_target(Node *s) {
+    return s->kind == ND_CASE ? s->case_body : s->lhs;
+}
+
+static void scan_labels(Node *n, void *ctx) {
+    if (!n) return;
+    CodeGen *cg = ctx;
+    if (n->kind == ND_BLOCK) {
+        int k = 0;
+        for (Node *s = n->body; s; s = s->next, k++)
+            for (Node *l = s; is_stmt_label(l); l = label_target(l))
+                if (l->kind == ND_LABEL) goto_label_add(cg, l, n->body, k, false);
+    } else if (n->kind == ND_LABEL && !goto_label_find(cg, n->name)) {
+        goto_label_add(cg, n, n, 0, true);
+    }
+    node_visit_children(n, scan_labels, ctx);
+}
+
+typedef struct {
+    CodeGen *cg;
+    Node    *heads[GOTO_MAX_DEPTH];  /* enclosing lists, innermost last */
+    int      index[GOTO_MAX_DEPTH];  /* ... and the statement we are in */
+    int      depth;
+    Node    *into;                   /* first goto into a nested statement */
+    Node    *computed;               /* first goto *ptr */
+    bool     label_values;           /* &&label is used */
+} GotoScan;
+
+static CGGotoRegion *goto_region(CodeGen *cg, CGGotoList *gl, int lo, int hi, bool loop) {
+    CGGotoRegion *r = arena_calloc(cg->arena, sizeof(CGGotoRegion));
+    r->lo = lo;
+    r->hi = hi;
+    r->loop = loop;
+    r->js_label = fmt_str(cg, "__g%d", cg->label_count++);
+    r->next = gl->regions;
+    gl->regions = r;
+    return r;
+}
+
+static void goto_add(GotoScan *s, Node *n) {
+    CodeGen *cg = s->cg;
+    CGLabel *l = goto_label_find(cg, n->name);
+    if (!l) {
+        error_at(n->loc, "label '%s' used but not defined", n->name);
+        return;
+    }
+    int d = s->depth - 1;
+    while (d >= 0 && !(s->heads[d] == l->list->head)) d--;
+    if (d < 0) {
+        if (!s->into) s->into = n;
+        return;
+    }
+    int j = s->index[d];
+    CGGoto *g = arena_calloc(cg->arena, sizeof(CGGoto));
+    g->node = n;
+    g->label = l;
+    g->back = j >= l->index;
+    g->next = cg->gotos;
+    cg->gotos = g;
+    if (g->back) {
+        if (!l->back) l->back = goto_region(cg, l->list, l->index, j, true);
+        else if (j > l->back->hi) l->back->hi = j;
+    } else {
+        if (!l->fwd) l->fwd = goto_region(cg, l->list, j, l->index - 1, false);
+        else if (j < l->fwd->lo) l->fwd->lo = j;
+    }
+}
+
+static void goto_push(GotoScan *s, Node *head, int index, Node *at) {
+    if (s->depth == GOTO_MAX_DEPTH) {
+        error_at(at->loc, "statements nested too deeply for goto lowering");
+        return;
+    }
+    s->heads[s->depth] = head;
+    s->index[s->depth] = index;
+    s->depth++;
+}
+
+static void scan_gotos(Node *n, void *ctx) {
+    if (!n) return;
+    GotoScan *s = ctx;
+    if (n->kind == ND_GOTO && n->lhs) {
+        if (!s->computed) s->computed = n;
+        return;
+    }
+    if (n->kind == ND_GOTO) {
+        goto_add(s, n);
+        return;
+    }
+    if (n->kind == ND_LABEL_ADDR) {
+        CGLabel *l = goto_label_find(s->cg, n->name);
+        if (l) l->addr_taken = true;
+        else error_at(n->loc, "label '%s' used but not defined", n->name);
+        s->label_values = true;
+        return;
+    }
+    if (n->kind == ND_BLOCK) {
+        int k = 0, depth = s->depth;
+        for (Node *e = n->body; e; e = e->next, k++) {
+            goto_push(s, n->body, k, e);
+            scan_gotos(e, s);
+            s->depth = depth;
+        }
+        return;
+    }
+    int depth = s->depth;
+    if (n->kind == ND_LABEL && goto_list_find(s->cg, n, true))
+        goto_push(s, n, 0, n);
+    node_visit_children(n, scan_gotos, ctx);
+    s->depth = depth;
+}
+
+/* A goto into a nested statement: the statement holding the label, in
+ * the innermost block that also holds the goto, is rewritten into an
+ * equivalent run of statements, labels and gotos in that block (if and
+ * loop conditions become conditional gotos, break and continue of a
+ * flattened loop become gotos).  This repeats, one level at a time, until
+ * every goto sits in the list of its label.  Switch bodies stay nested. */
+typedef struct {
+    Node *target;
+    Node *blocks[GOTO_MAX_DEPTH];   /* enclosing blocks, outermost first */
+    int   index[GOTO_MAX_DEPTH];    /* ... and the statement we are in */
+    int   depth;
+    bool  found;
+} GotoPath;
+
+static void goto_path(Node *n, void *ctx) {
+    GotoPath *p = ctx;
+    if (!n || p->found) return;
+    if (n == p->target) {
+        p->found = true;
+        return;
+    }
+    if (n->kind == ND_BLOCK && p->depth < GOTO_MAX_DEPTH) {
+        int k = 0;
+        for (Node *e = n->body; e && !p->found; e = e->next, k++) {
+            p->blocks[p->depth] = n;
+            p->index[p->depth] = k;
+            p->depth++;
+            goto_path(e, p);
+            if (!p->found) p->depth--;
+        }
+        return;
+    }
+    node_visit_children(n, goto_path, ctx);
+}
+
+typedef struct {
+    const char *brk, *cont;         /* labels for break and continue */
+} GotoJumps;
+
+static void goto_retarget(Node *n, void *ctx) {
+    if (!n) return;
+    GotoJumps *j = ctx;
+    if ((n->kind == ND_BREAK && j->brk) || (n->kind == ND_CONTINUE && j->cont)) {
+        n->name = n->kind == ND_BREAK ? j->brk : j->cont;
+        n->kind = ND_GOTO;
+        return;
+    }
+    if (n->kind == ND_WHILE || n->kind == ND_DO_WHILE || n->kind == ND_FOR) return;
+    if (n->kind == ND_SWITCH) {
+        GotoJumps inner = { NULL, j->cont };
+        node_visit_children(n, goto_retarget, &inner);
+        return;
+    }
+    node_visit_children(n, goto_retarget, ctx);
+}
+
+typedef struct {
+    Node *first, *last;
+} GotoSeq;
+
+/* Appends statement s, or the whole list starting at s */
+static void goto_seq_add(GotoSeq *q, Node *s, bool list) {
+    if (!s) return;
+    if (!list) s->next = NULL;
+    if (q->last) q->last->next = s;
+    else q->first = s;
+    q->last = s;
+    while (q->last->next) q->last = q->last->next;
+}
+
+static Node *goto_stmt(CodeGen *cg, NodeKind kind, const char *name, Node *lhs, SrcLoc loc) {
+    Node *n = node_new(cg->arena, kind, loc);
+    n->name = name;
+    if (kind == ND_LABEL) n->lhs = lhs ? lhs : node_new(cg->arena, ND_NULL_STMT, loc);
+    return n;
+}
+
+/* if (cond) goto label;  (if (!cond) ... when negate) */
+static Node *goto_cond(CodeGen *cg, Node *cond, bool negate, const char *label) {
+    Node *n = node_new(cg->arena, ND_IF, cond->loc);
+    n->lhs = cond;
+    if (negate) {
+        n->lhs = node_unary(cg->arena, ND_NOT, cond, cond->loc);
+        n->lhs->type = ty_int;
+    }
+    n->rhs = goto_stmt(cg, ND_GOTO, label, NULL, cond->loc);
+    return n;
+}
+
+static bool goto_unnest(CodeGen *cg, Node *s, GotoSeq *q) {
+    SrcLoc loc = s->loc;
+    const char *a = fmt_str(cg, "__gl%d", cg->label_count++);
+    const char *b = fmt_str(cg, "__gl%d", cg->label_count++);
+    const char *c = fmt_str(cg, "__gl%d", cg->label_count++);
+    GotoJumps jumps = { c, b };
+    switch (s->kind) {
+    case ND_BLOCK:
+        goto_seq_add(q, s->body, true);
+        return q->first != NULL;
+    case ND_IF:
+        /* if (!cond) goto a; then; goto c; a: else; c: ; */
+        goto_seq_add(q, goto_cond(cg, s->lhs, true, s->third ? a : c), false);
+        goto_seq_add(q, s->rhs, false);
+        if (s->third) {
+            goto_seq_add(q, goto_stmt(cg, ND_GOTO, c, NULL, loc), false);
+            goto_seq_add(q, goto_stmt(cg, ND_LABEL, a, s->third, loc), false);
+        }
+        break;
+    case ND_WHILE:
+        /* b: if (!cond) goto c; body; goto b; c: ; */
+        goto_retarget(s->rhs, &jumps);
+        goto_seq_add(q, goto_stmt(cg, ND_LABEL, b, goto_cond(cg, s->lhs, true, c), loc), false);
+        goto_seq_add(q, s->rhs, false);
+        goto_seq_add(q, goto_stmt(cg, ND_GOTO, b, NULL, loc), false);
+        break;
+    case ND_DO_WHILE:
+        /* a: body; b: if (cond) goto a; c: ; */
+        goto_retarget(s->rhs, &jumps);
+        goto_seq_add(q, goto_stmt(cg, ND_LABEL, a, s->rhs, loc), false);
+        goto_seq_add(q, goto_stmt(cg, ND_LABEL, b, goto_cond(cg, s->lhs, false, a), loc), false);
+        break;
+    case ND_FOR: {
+        /* init; a: if (!cond) goto c; body; b: inc; goto a; c: ; */
+        if (s->for_init && s->for_init->kind == ND_VAR_DECL) {
+            goto_seq_add(q, s->for_init, true);
+        } else if (s->for_init) {
+            Node *init = node_new(cg->arena, ND_EXPR_STMT, loc);
+            init->lhs = s->for_init;
+            goto_seq_add(q, init, false);
+        }
+        goto_retarget(s->for_body, &jumps);
+        Node *test = s->for_cond ? goto_cond(cg, s->for_cond, true, c) : NULL;
+        goto_seq_add(q, goto_stmt(cg, ND_LABEL, a, test, loc), false);
+        goto_seq_add(q, s->for_body, false);
+        Node *inc = NULL;
+        if (s->for_inc) {
+            inc = node_new(cg->arena, ND_EXPR_STMT, loc);
+            inc->lhs = s->for_inc;
+        }
+        goto_seq_add(q, goto_stmt(cg, ND_LABEL, b, inc, loc), false);
+        goto_seq_add(q, goto_stmt(cg, ND_GOTO, a, NULL, loc), false);
+        break;
+    }
+    default:
+        return false;
+    }
+    goto_seq_add(q, goto_stmt(cg, ND_LABEL, c, NULL, loc), false);
+    return true;
+}
+
+/* Flattens one level around label l, as seen from statement or goto g */
+static bool goto_flatten(CodeGen *cg, Node *body, Node *g, CGLabel *l) {
+    GotoPath *from = arena_calloc(cg->arena, sizeof(GotoPath));
+    GotoPath *to = arena_calloc(cg->arena, sizeof(GotoPath));
+    from->target = g;
+    to->target = l->node;
+    goto_path(body, from);
+    goto_path(body, to);
+    if (!from->found || !to->found || to->depth == 0) return false;
+    /* Innermost block holding both; its statement around the label */
+    int c = 0;
+    while (c < from->depth && c < to->depth && from->blocks[c] == to->blocks[c] &&
+           from->index[c] == to->index[c])
+        c++;
+    if (c == from->depth || c == to->depth || from->blocks[c] != to->blocks[c]) c--;
+    if (c < 0) return false;
+    Node *block = to->blocks[c], *prev = NULL, *e = block->body;
+    for (int k = 0; k < to->index[c]; k++) {
+        prev = e;
+        e = e->next;
+    }
+    Node *lab = NULL, *s = e;
+    for (; is_stmt_label(s); s = label_target(s)) lab = s;
+    GotoSeq q = { NULL, NULL };
+    Node *rest = e->next;
+    if (!goto_unnest(cg, s, &q)) return false;
+    q.last->next = rest;
+    if (lab) {
+        /* Labels stay in front of an empty statement */
+        Node *empty = node_new(cg->arena, ND_NULL_STMT, s->loc);
+        if (lab->kind == ND_CASE) lab->case_body = empty;
+        else lab->lhs = empty;
+        e->next = q.first;
+    } else if (prev) {
+        prev->next = q.first;
+    } else {
+        block->body = q.first;
+    }
+    return true;
+}
+
+/* Regions in nesting order: by start, longest first */
+static int goto_regions_sorted(CGGotoList *gl, CGGotoRegion **out) {
+    int n = 0;
+    for (CGGotoRegion *r = gl->regions; r && n < GOTO_MAX_DEPTH; r = r->next) {
+        int i = n++;
+        while (i > 0 && (out[i - 1]->lo > r->lo ||
+                         (out[i - 1]->lo == r->lo && out[i - 1]->hi < r->hi))) {
+            out[i] = out[i - 1];
+            i--;
+        }
+        out[i] = r;
+    }
+    return n;
+}
+
+static void analyze_gotos(CodeGen *cg, Node *fn) {
+    cg->goto_labels = NULL;
+    cg->goto_lists = NULL;
+    cg->gotos = NULL;
+    cg->goto_state = 0;
+    cg->goto_table = NULL;
+    scan_labels(fn->func_body, cg);
+
+    GotoScan s;
+    s.cg = cg;
+    s.depth = 0;
+    s.into = NULL;
+    s.computed = NULL;
+    s.label_values = false;
+    scan_gotos(fn->func_body, &s);
+    if (s.into) {
+        CGLabel *l = goto_label_find(cg, s.into->name);
+        if (goto_flatten(cg, fn->func_body, s.into, l)) {
+            analyze_gotos(cg, fn);
+            return;
+        }
+        error_at(s.into->loc, "goto '%s' jumps into a nested statement (not supported)",
+                 s.into->name);
+    }
+    /* Labels as values: every label whose address is taken is brought up
+     * to the function body, which becomes one dispatch loop; &&label is
+     * the label's case number and goto *p continues the loop with it */
+    if (s.computed || s.label_values) {
+        Node *top = fn->func_body->body;
+        for (CGLabel *l = cg->goto_labels; l; l = l->next) {
+            if (!l->addr_taken || (l->list->head == top && !l->list->lone)) continue;
+            if (goto_flatten(cg, fn->func_body, top, l)) {
+                analyze_gotos(cg, fn);
+                return;
+            }
+            error_at(l->node->loc, "address of label '%s' taken inside a switch body (not supported)",
+                     l->name);
+        }
+        CGGotoList *gl = goto_list_find(cg, top, false);
+        bool any = false;
+        for (CGLabel *l = cg->goto_labels; l; l = l->next) any |= l->addr_taken;
+        if (!gl || !any) {
+            /* Otherwise already reported above */
+            if (!s.label_values)
+                error_at(s.computed->loc, "computed goto in a function that takes no label address");
+        } else {
+            gl->dispatch = fmt_str(cg, "__gd%d", cg->label_count++);
+            gl->state = new_tmp_var(cg);
+            cg->goto_table = gl;
+            int k = 0;
+            for (Node *e = top; e; e = e->next, k++)
+                for (CGLabel *l = cg->goto_labels; l; l = l->next)
+                    if (l->list == gl && l->index == k && (l->fwd || l->back || l->addr_taken))
+                        l->state = ++cg->goto_state;
+        }
+    }
+    cg->has_goto = cg->gotos != NULL || cg->goto_table != NULL;
+
+    for (CGGotoList *gl = cg->goto_lists; gl; gl = gl->next) {
+        if (!gl->regions) continue;
+        /* A block may start early and a loop may end late: widen crossing
+         * regions until they nest */
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (CGGotoRegion *a = gl->regions; a; a = a->next) {
+                for (CGGotoRegion *b = gl->regions; b; b = b->next) {
+                    if (!(a->lo < b->lo && b->lo <= a->hi && a->hi < b->hi)) continue;
+                    if (!b->loop) b->lo = a->lo;
+                    else if (a->loop) a->hi = b->hi;
+                    else continue;
+                    changed = true;
+                }
+            }
+        }
+        /* Blocks and loops that still cross need dispatch */
+        CGGotoRegion *sorted[GOTO_MAX_DEPTH], *stack[GOTO_MAX_DEPTH];
+        int n = goto_regions_sorted(gl, sorted), top = 0;
+        for (int i = 0; i < n && !gl->dispatch; i++) {
+            while (top > 0 && stack[top - 1]->hi < sorted[i]->lo) top--;
+            if (top > 0 && sorted[i]->hi > stack[top - 1]->hi) {
+                gl->dispatch = fmt_str(cg, "__gd%d", cg->label_count++);
+                gl->state = new_tmp_var(cg);
+            }
+            stack[top++] = sorted[i];
+        }
+        if (gl->dispatch) {
+            for (CGLabel *l = cg->goto_labels; l; l = l->next)
+                if (l->list == gl && (l->fwd || l->back) && !l->state) l->state = ++cg->goto_state;
+        }
+        /* JS case labels cannot move into the blocks and loops added here */
+        int k = 0;
+        for (Node *e = gl->head; e; e = gl->lone ? NULL : e->next, k++) {
+            bool wrapped = gl->dispatch != NULL;
+            for (CGGotoRegion *r = gl->regions; r; r = r->next)
+                if (r->lo <= k && k <= r->hi) wrapped = true;
+            for (Node *l = e; wrapped && is_stmt_label(l); l = label_target(l)) {
+                if (l->kind != ND_LABEL) {
+                    error_at(l->loc, "goto across case labels is not supported");
+                    wrapped = false;
+                }
+            }
+        }
+    }
+}
+
+static CGGoto *goto_find(CodeGen *cg, Node *n) {
+    for (CGGoto *g = cg->gotos; g; g = g->next)
+        if (g->node == n) return g;
+    return NULL;
+}
+
+static void gen_goto_list(CodeGen *cg, CGGotoList *gl) {
+    int k = 0;
+    if (gl->dispatch) {
+        emitln(cg, "%s = 0;", gl->state);
+        emitln(cg, "%s: for (;;) {", gl->dispatch);
+        cg->indent++;
+        emitln(cg, "switch (%s) {", gl->state);
+        emitln(cg, "case 0:");
+        cg->indent++;
+        for (Node *e = gl->head; e; e = gl->lone ? NULL : e->next, k++) {
+            cg->indent--;
+            for (CGLabel *l = cg->goto_labels; l; l = l->next)
+                if (l->list == gl && l->index == k && l->state) emitln(cg, "case %d:", l->state);
+            cg->indent++;
+            gen_stmt(cg, gl->lone ? e->lhs : e);
+        }
+        cg->indent--;
+        emitln(cg, "}");
+        emitln(cg, "break;");
+        cg->indent--;
+        emitln(cg, "}");
+        return;
+    }
+
+    CGGotoRegion *sorted[GOTO_MAX_DEPTH], *open[GOTO_MAX_DEPTH];
+    int n = goto_regions_sorted(gl, sorted), next = 0, nopen = 0;
+    for (Node *e = gl->head; e; e = gl->lone ? NULL : e->next, k++) {
+        if (stmt_contains_setjmp(e))
+            error_at(e->loc, "setjmp in a statement list with goto targets is not supported");
+        for (; next < n && sorted[next]->lo == k; next++) {
+            CGGotoRegion *r = sorted[next];
+            emitln(cg, r->loop ? "%s: for (;;) {" : "%s: {", r->js_label);
+            cg->indent++;
+            open[nopen++] = r;
+        }
+        gen_stmt(cg, gl->lone ? e->lhs : e);
+        while (nopen > 0 && open[nopen - 1]->hi == k) {
+            if (open[--nopen]->loop) emitln(cg, "break;");
+            cg->indent--;
+            emitln(cg, "}");
+        }
     }
 }
 
+/* JS label for a C loop or switch when goto lowering may wrap its
+ * statements in JS loops of its own */
+static const char *jump_label(CodeGen *cg) {
+    return cg->has_goto ? fmt_str(cg, "__l%d", cg->label_count++) : NULL;
+}
+
+static void gen_loop_body(CodeGen *cg, Node *body, const char *label) {
+    const char *saved = cg->continue_label;
+    cg->continue_label = label;
+    gen_breakable(cg, body, label);
+    cg->continue_label = saved;
+}
+
 /* Generate a list of statements, detecting setjmp and wrapping in try/catch.
  * When a statement contains setjmp(), it and ALL remaining statements in the
  * list are wrapped in: while(true) { try { ... break; } catch { ... } }
  * Nested setjmps are handled by recursive calls. */
 static void gen_block_stmts(CodeGen *cg, Node *stmts) {
+    CGGotoList *gl = cg->has_goto ? goto_list_find(cg, stmts, false) : NULL;
+    if (gl && (gl->regions || gl->dispatch)) {
+        gen_goto_list(cg, gl);
+        return;
+    }
     for (Node *s = stmts; s; s = s->next) {
         if (stmt_contains_setjmp(s)) {
             int sj = cg->setjmp_counter++;
@@ -1142,6 +4017,225 @@ static void gen_block_stmts(CodeGen *cg, Node *stmts) {
     }
 }
 
+/* ---- Switch lowering ----
+ * A switch whose cases are constants and whose labels all sit directly in
+ * its body becomes a nest of labeled blocks, one per label group:
+ *
+ *   __sw0: { __sw0_1: { __sw0_0: { <dispatch> } <group 0> } <group 1> }
+ *
+ * The dispatch leaves block k ("break __sw0_k") to land on group k, and
+ * falling out of one group runs into the next, as in C.  Sparse case sets
+ * dispatch through a balanced compare tree.  --switch=table instead looks
+ * the value up in a table of group numbers and switches on that directly,
+ * with the groups as its cases:
+ *
+ *   __sw0: switch (t < 40 ? __swt0[t] : 3) { case 0: <group 0> case 1: ... }
+ */
+
+#define SWITCH_MIN_CASES 4     /* smaller switches stay JS switches */
+#define SWITCH_MAX_TABLE 4096  /* largest dispatch table */
+
+typedef struct {
+    long long lo, hi;   /* case values lo..hi (promoted switch type) */
+    int       group;    /* label block they jump to */
+} SwitchRange;
+
+/* Run body with C break meaning break_label (NULL: the innermost JS
+ * loop or switch) */
+static void gen_breakable(CodeGen *cg, Node *body, const char *break_label) {
+    const char *saved = cg->break_label;
+    cg->break_label = break_label;
+    gen_stmt(cg, body);
+    cg->break_label = saved;
+}
+
+static void emit_case_val(CodeGen *cg, long long v, bool uns) {
+    if (uns) emit(cg, "%u", (unsigned)v);
+    else emit(cg, "%d", (int)v);
+}
+
+static void gen_switch_tree(CodeGen *cg, const char *t, SwitchRange *r, int lo, int hi,
+                            int id, bool uns) {
+    if (hi - lo <= 3) {
+        for (int i = lo; i < hi; i++) {
+            emit_indent(cg);
+            emit(cg, "if (");
+            if (r[i].lo == r[i].hi) {
+                emit(cg, "%s === ", t);
+                emit_case_val(cg, r[i].lo, uns);
+            } else {
+                emit(cg, "%s >= ", t);
+                emit_case_val(cg, r[i].lo, uns);
+                emit(cg, " && %s <= ", t);
+                emit_case_val(cg, r[i].hi, uns);
+            }
+            emit(cg, ") break __sw%d_%d;\n", id, r[i].group);
+        }
+        return;
+    }
+    int mid = (lo + hi) / 2;
+    emit_indent(cg);
+    emit(cg, "if (%s < ", t);
+    emit_case_val(cg, r[mid].lo, uns);
+    emit(cg, ") {\n");
+    cg->indent++;
+    gen_switch_tree(cg, t, r, lo, mid, id, uns);
+    cg->indent--;
+    emitln(cg, "} else {");
+    cg->indent++;
+    gen_switch_tree(cg, t, r, mid, hi, id, uns);
+    cg->indent--;
+    emitln(cg, "}");
+}
+
+/* Lower switch n as described above; false leaves it to a JS switch */
+static bool gen_switch_lowered(CodeGen *cg, Node *n) {
+    Type *st = n->switch_expr->type;
+    if (cg->switch_mode == SWITCH_JS || !st || !type_is_integer(st) || type_is_i64(st))
+        return false;
+    int ncases = 0;
+    for (Node *c = n->switch_cases; c; c = c->case_next) {
+        if (!c->case_expr || (c->case_expr->kind != ND_INT_LIT &&
+                              c->case_expr->kind != ND_CHAR_LIT))
+            return false;
+        ncases++;
+    }
+    if (ncases == 0 || (cg->switch_mode == SWITCH_AUTO && ncases < SWITCH_MIN_CASES))
+        return false;
+
+    /* Label groups: statements of the body that carry labels */
+    Node *list = n->switch_body->kind == ND_BLOCK ? n->switch_body->body : n->switch_body;
+    CGGotoList *gl = cg->has_goto ? goto_list_find(cg, list, false) : NULL;
+    if (gl && (gl->regions || gl->dispatch)) return false;
+    Node **entry = arena_alloc(cg->arena, sizeof(Node *) * (ncases + 1));
+    SwitchRange *r = arena_alloc(cg->arena, sizeof(SwitchRange) * ncases);
+    int ngroups = 0, nfound = 0, def_group = -1;
+    bool uns = st->is_unsigned && st->size >= 4;  /* unpromoted: values are uint32 */
+    for (Node *s = list; s; s = s->next) {
+        if (stmt_contains_setjmp(s)) return false;
+        if (s->kind != ND_CASE && s->kind != ND_DEFAULT) continue;
+        for (Node *l = s; l->kind == ND_CASE || l->kind == ND_DEFAULT;
+             l = l->kind == ND_CASE ? l->case_body : l->lhs) {
+            if (l->kind == ND_DEFAULT) {
+                if (l != n->switch_default) return false;
+                def_group = ngroups;
+                continue;
+            }
+            long long v = uns ? (long long)(unsigned)l->case_val : (long long)(int)l->case_val;
+            /* insert sorted */
+            if (nfound == ncases) return false;
+            int i = nfound++;
+            while (i > 0 && r[i - 1].lo > v) { r[i] = r[i - 1]; i--; }
+            if (i > 0 && r[i - 1].lo == v) return false;
+            r[i].lo = r[i].hi = v;
+            r[i].group = ngroups;
+        }
+        entry[ngroups++] = s;
+    }
+    /* Labels nested in inner statements (Duff's device) need a JS switch */
+    if (nfound != ncases || (n->switch_default && def_group < 0)) return false;
+
+    long long min = r[0].lo, range = r[ncases - 1].lo - min + 1;
+    bool dense = range * 2 <= (long long)ncases * 5;
+    /* V8 already compiles a JS switch over dense integer literals to a
+     * jump table; a table lookup in front of it would only add a load */
+    if (cg->switch_mode != SWITCH_TREE && dense) return false;
+    bool table = cg->switch_mode == SWITCH_TABLE && range <= SWITCH_MAX_TABLE;
+    int id = cg->label_count++;
+    char sw_label[32];
+    snprintf(sw_label, sizeof(sw_label), "__sw%d", id);
+
+    const char *t = new_tmp_var(cg);
+    emit_indent(cg);
+    if (table) {
+        /* Index into the table; out-of-range values wrap to large ones */
+        emit(cg, "%s = (", t);
+        gen_expr(cg, n->switch_expr);
+        if (min != 0) {
+            emit(cg, " - ");
+            emit_case_val(cg, min, uns);
+        }
+        emit(cg, ") >>> 0;\n");
+
+        /* Group number per value, ngroups for the holes */
+        buf_printf(&cg->switch_tables, "const __swt%d = new %s([", id,
+                   ngroups < 255 ? "Uint8Array" : "Uint16Array");
+        int i = 0;
+        for (long long v = 0; v < range; v++) {
+            while (i < ncases && r[i].lo - min < v) i++;
+            buf_printf(&cg->switch_tables, "%s%d", v ? "," : "",
+                       i < ncases && r[i].lo - min == v ? r[i].group : ngroups);
+        }
+        buf_printf(&cg->switch_tables, "]);\n");
+        emitln(cg, "%s: switch (%s < %d ? __swt%d[%s] : %d) {", sw_label, t, (int)range,
+               id, t, ngroups);
+        cg->indent++;
+        /* Statements before the first label are unreachable but may declare
+         * variables the cases use: they sit under a group no value maps to */
+        cse_clear(&cg->cse);
+        if (list != entry[0]) {
+            emitln(cg, "case %d:", ngroups + 1);
+            for (Node *s = list; s != entry[0]; s = s->next)
+                gen_breakable(cg, s, sw_label);
+        }
+        for (int g = 0; g < ngroups; g++) {
+            if (g == def_group) emitln(cg, "default:");
+            else emitln(cg, "case %d:", g);
+            cse_clear(&cg->cse);
+            Node *l = entry[g];
+            while (l->kind == ND_CASE || l->kind == ND_DEFAULT)
+                l = l->kind == ND_CASE ? l->case_body : l->lhs;
+            gen_breakable(cg, l, sw_label);
+            for (Node *s = entry[g]->next; s && (g + 1 == ngroups || s != entry[g + 1]); s = s->next)
+                gen_breakable(cg, s, sw_label);
+        }
+        cg->indent--;
+        emitln(cg, "}");
+        return true;
+    }
+
+    emit(cg, "%s = ", t);
+    gen_expr(cg, n->switch_expr);
+    emit(cg, ";\n");
+    char def_label[32];
+    if (def_group >= 0) snprintf(def_label, sizeof(def_label), "__sw%d_%d", id, def_group);
+    else snprintf(def_label, sizeof(def_label), "__sw%d", id);
+    emitln(cg, "__sw%d: {", id);
+    for (int g = ngroups - 1; g >= 0; g--)
+        emitln(cg, "__sw%d_%d: {", id, g);
+    cg->indent++;
+    /* Merge runs of consecutive values that share a group */
+    int nr = 0;
+    for (int i = 0; i < ncases; i++) {
+        if (nr > 0 && r[nr - 1].group == r[i].group && r[nr - 1].hi + 1 == r[i].lo)
+            r[nr - 1].hi = r[i].lo;
+        else
+            r[nr++] = r[i];
+    }
+    gen_switch_tree(cg, t, r, 0, nr, id, uns);
+    emitln(cg, "break %s;", def_label);
+    /* Statements before the first label are unreachable but may declare
+     * variables the cases use */
+    cse_clear(&cg->cse);
+    for (Node *s = list; s && s != entry[0]; s = s->next)
+        gen_breakable(cg, s, sw_label);
+    for (int g = 0; g < ngroups; g++) {
+        cg->indent--;
+        emitln(cg, "}");
+        cg->indent++;
+        cse_clear(&cg->cse);
+        Node *l = entry[g];
+        while (l->kind == ND_CASE || l->kind == ND_DEFAULT)
+            l = l->kind == ND_CASE ? l->case_body : l->lhs;
+        gen_breakable(cg, l, sw_label);
+        for (Node *s = entry[g]->next; s && (g + 1 == ngroups || s != entry[g + 1]); s = s->next)
+            gen_breakable(cg, s, sw_label);
+    }
+    cg->indent--;
+    emitln(cg, "}");
+    return true;
+}
+
 static void gen_stmt(CodeGen *cg, Node *n) {
     if (!n) return;
 
@@ -1151,6 +4245,7 @@ static void gen_stmt(CodeGen *cg, Node *n) {
         break;
 
     case ND_VAR_DECL: {
+        if (n->var_sc == SC_EXTERN) break; /* refers to the global */
         if (n->var_sc == SC_STATIC) {
             /* Static local → allocate in global memory, init in data section */
             int size = type_sz(n->type);
@@ -1164,8 +4259,28 @@ static void gen_stmt(CodeGen *cg, Node *n) {
             break;
         }
 
+        if (var_can_promote(cg, n->var_name, n->type)) {
+            CGVar *v = var_set_jslocal(cg, n->var_name, n->type);
+            if (n->var_init) {
+                emit_indent(cg);
+                gen_jslocal_init(cg, v, n->var_init);
+                emit(cg, ";\n");
+            }
+            break;
+        }
+
+        if (agg_can_split(cg, n->var_name, n->type)) {
+            CGVar *v = var_set_fields(cg, n->var_name, n->type);
+            if (n->var_init) {
+                emit_indent(cg);
+                gen_fields_init(cg, v, n->var_init);
+                emit(cg, ";\n");
+            }
+            break;
+        }
+
         int off = alloc_local(cg, n->type);
-        var_set_local(cg, n->var_name, off, n->type, false);
+        CGVar *lv = var_set_local(cg, n->var_name, off, n->type, false);
 
         if (n->var_init) {
             /* Check if init is a string literal (possibly wrapped in ND_CAST) */
@@ -1176,133 +4291,287 @@ static void gen_stmt(CodeGen *cg, Node *n) {
                 (n->type->kind == TY_ARRAY || n->type->kind == TY_VLA) &&
                 n->type->base && n->type->base->kind == TY_CHAR;
 
-            if (n->var_init->kind == ND_INIT_LIST) {
-                emitln(cg, "rt.memset(bp + (%d), 0, %d);", off, type_sz(n->type));
+            if ((n->var_init->kind == ND_INIT_LIST ||
+                 (real_init->kind == ND_STRING_LIT && is_char_array)) &&
+                gen_local_template(cg, off, n->type, real_init)) {
+                /* copied from a constant template */
+            } else if (n->var_init->kind == ND_INIT_LIST) {
+                gen_init_zero(cg, off, n->type, n->var_init);
                 gen_init(cg, "bp", off, n->type, n->var_init);
             } else if (real_init->kind == ND_STRING_LIT && is_char_array) {
-                /* char arr[] = "string" → memset + strcpy */
-                emitln(cg, "rt.memset(bp + (%d), 0, %d);", off, type_sz(n->type));
+                /* char arr[] = "string" → strcpy, zeroing only the tail */
+                gen_init_zero(cg, off, n->type, real_init);
                 emit_indent(cg);
                 emit(cg, "rt.strcpy(bp + (%d), ", off);
                 gen_expr(cg, real_init);
                 emit(cg, ");\n");
+            } else if (call_in_slots(n->var_init)) {
+                /* The slot stores write every leaf: no zeroing needed */
+                emit_indent(cg);
+                cg->rret_bare = true;
+                gen_expr(cg, n->var_init);
+                emit(cg, ", ");
+                gen_reg_store_slots(cg, n->type, "bp", off);
+                emit(cg, ";\n");
+            } else if (split_var(cg, n->var_init)) {
+                int k = 0;
+                emit_indent(cg);
+                gen_fields_store(cg, split_var(cg, n->var_init), "bp", off, &k);
+                emit(cg, ";\n");
+            } else if (sret_into(cg, n->var_init, lv, true)) {
+                /* The callee stores its result into the local itself */
+                char dest[32];
+                snprintf(dest, sizeof(dest), "(bp + (%d))", off);
+                emit_indent(cg);
+                cg->sret_dest = dest;
+                gen_expr(cg, n->var_init);
+                emit(cg, ";\n");
             } else if (is_aggregate(n->type)) {
-                /* Struct/union init from expression: memcpy */
-                emitln(cg, "rt.memset(bp + (%d), 0, %d);", off, type_sz(n->type));
+                /* Struct/union init from expression: one memcpy of the whole object */
                 emit_indent(cg);
                 emit(cg, "rt.memcpy(bp + (%d), ", off);
                 gen_expr(cg, n->var_init);
                 emit(cg, ", %d);\n", type_sz(n->type));
+            } else if (type_is_i64(n->type)) {
+                emit_indent(cg);
+                gen_i64_init(cg, "bp", off, true, n->type, n->var_init);
+                emit(cg, ";\n");
             } else {
                 emit_indent(cg);
-                emit(cg, "rt.mem.%s(bp + (%d), ", js_setter(n->type), off);
-                gen_expr(cg, n->var_init);
-                emit(cg, ");\n");
+                emit_store_begin(cg, n->type, true);
+                emit(cg, "bp + (%d)", off);
+                emit_store_mid(cg, n->type, true);
+                gen_expr_to(cg, n->type, n->var_init);
+                emit_store_end(cg, n->type, true);
+                emit(cg, ";\n");
             }
+            cse_clear(&cg->cse);
         }
         break;
     }
 
     case ND_EXPR_STMT:
         emit_indent(cg);
-        gen_expr(cg, n->lhs);
+        gen_discard(cg, n->lhs);
         emit(cg, ";\n");
         break;
 
-    case ND_IF:
-        emit_indent(cg); emit(cg, "if ("); gen_expr(cg, n->lhs); emit(cg, ") {\n");
+    case ND_IF: {
+        emit_indent(cg); emit(cg, "if ("); gen_cond(cg, n->lhs); emit(cg, ") {\n");
+        /* Loads of the condition stay available; those of an arm do not */
+        int mark = cse_mark(&cg->cse);
         cg->indent++;
         gen_stmt(cg, n->rhs);
         cg->indent--;
+        cse_drop(&cg->cse, mark);
         if (n->third) {
             emitln(cg, "} else {");
             cg->indent++;
             gen_stmt(cg, n->third);
             cg->indent--;
+            cse_drop(&cg->cse, mark);
         }
         emitln(cg, "}");
         break;
+    }
 
-    case ND_WHILE:
-        emit_indent(cg); emit(cg, "while ("); gen_expr(cg, n->lhs); emit(cg, ") {\n");
+    case ND_WHILE: {
+        const char *label = jump_label(cg);
+        emit_indent(cg);
+        if (label) emit(cg, "%s: ", label);
+        cse_clear(&cg->cse);
+        emit(cg, "while ("); gen_cond(cg, n->lhs); emit(cg, ") {\n");
         cg->indent++;
-        gen_stmt(cg, n->rhs);
+        gen_loop_body(cg, n->rhs, label);
         cg->indent--;
         emitln(cg, "}");
+        cse_clear(&cg->cse);
         break;
+    }
 
-    case ND_DO_WHILE:
-        emitln(cg, "do {");
+    case ND_DO_WHILE: {
+        const char *label = jump_label(cg);
+        if (label) emitln(cg, "%s: do {", label);
+        else emitln(cg, "do {");
+        cse_clear(&cg->cse);
         cg->indent++;
-        gen_stmt(cg, n->rhs);
+        gen_loop_body(cg, n->rhs, label);
         cg->indent--;
-        emit_indent(cg); emit(cg, "} while ("); gen_expr(cg, n->lhs); emit(cg, ");\n");
+        cse_clear(&cg->cse);
+        emit_indent(cg); emit(cg, "} while ("); gen_cond(cg, n->lhs); emit(cg, ");\n");
+        cse_clear(&cg->cse);
         break;
+    }
 
     case ND_FOR: {
-        emit_indent(cg); emit(cg, "for (");
+        const char *label = jump_label(cg);
+        emit_indent(cg);
+        if (label) emit(cg, "%s: ", label);
+        emit(cg, "for (");
         if (n->for_init) {
             if (n->for_init->kind == ND_VAR_DECL) {
-                int off = alloc_local(cg, n->for_init->type);
-                var_set_local(cg, n->for_init->var_name, off, n->for_init->type, false);
-                if (n->for_init->var_init) {
-                    emit(cg, "rt.mem.%s(bp + (%d), ", js_setter(n->for_init->type), off);
-                    gen_expr(cg, n->for_init->var_init);
-                    emit(cg, ")");
+                bool first = true;
+                for (Node *d = n->for_init; d; d = d->next) {
+                    if (!first && d->var_init) emit(cg, ", ");
+                    if (var_can_promote(cg, d->var_name, d->type)) {
+                        CGVar *v = var_set_jslocal(cg, d->var_name, d->type);
+                        if (d->var_init) {
+                            gen_jslocal_init(cg, v, d->var_init);
+                            first = false;
+                        }
+                        continue;
+                    }
+                    if (agg_can_split(cg, d->var_name, d->type)) {
+                        CGVar *v = var_set_fields(cg, d->var_name, d->type);
+                        if (d->var_init) {
+                            gen_fields_init(cg, v, d->var_init);
+                            first = false;
+                        }
+                        continue;
+                    }
+                    int off = alloc_local(cg, d->type);
+                    var_set_local(cg, d->var_name, off, d->type, false);
+                    if (d->var_init && type_is_i64(d->type)) {
+                        gen_i64_init(cg, "bp", off, true, d->type, d->var_init);
+                        first = false;
+                    } else if (d->var_init) {
+                        emit_store_begin(cg, d->type, true);
+                        emit(cg, "bp + (%d)", off);
+                        emit_store_mid(cg, d->type, true);
+                        gen_expr_to(cg, d->type, d->var_init);
+                        emit_store_end(cg, d->type, true);
+                        first = false;
+                    }
                 }
             } else {
-                gen_expr(cg, n->for_init);
+                gen_discard(cg, n->for_init);
             }
         }
         emit(cg, "; ");
-        if (n->for_cond) gen_expr(cg, n->for_cond);
+        cse_clear(&cg->cse);
+        if (n->for_cond) gen_cond(cg, n->for_cond);
         emit(cg, "; ");
-        if (n->for_inc) gen_expr(cg, n->for_inc);
+        /* The increment runs after the body */
+        cse_clear(&cg->cse);
+        RangeBound *outer = range_mark(&cg->ranges);
+        /* Bound an integer counter; a goto may enter the body past the
+         * condition */
+        const char *ctr = cg->has_goto ? NULL : range_counter(n);
+        CGVar *cv = ctr ? var_find(cg, ctr) : NULL;
+        if (var_in_js(cv)) range_loop(&cg->ranges, n, cv->type);
+        if (n->for_inc) gen_discard(cg, n->for_inc);
+        cse_clear(&cg->cse);
         emit(cg, ") {\n");
         cg->indent++;
-        gen_stmt(cg, n->for_body);
+        gen_loop_body(cg, n->for_body, label);
         cg->indent--;
         emitln(cg, "}");
+        range_drop(&cg->ranges, outer);
+        cse_clear(&cg->cse);
         break;
     }
 
-    case ND_SWITCH:
+    case ND_SWITCH: {
+        if (gen_switch_lowered(cg, n)) {
+            cse_clear(&cg->cse);
+            break;
+        }
+        const char *label = jump_label(cg);
         emit_indent(cg);
-        if (expr_is_u64(n->switch_expr))
-            { emit(cg, "switch (Number("); gen_expr(cg, n->switch_expr); emit(cg, ")) {\n"); }
+        if (label) emit(cg, "%s: ", label);
+        if (expr_is_i64(n->switch_expr))
+            { emit(cg, "switch ("); gen_f64_val(cg, n->switch_expr); emit(cg, ") {\n"); }
         else
             { emit(cg, "switch ("); gen_expr(cg, n->switch_expr); emit(cg, ") {\n"); }
         cg->indent++;
-        gen_stmt(cg, n->switch_body);
+        gen_breakable(cg, n->switch_body, label);
         cg->indent--;
         emitln(cg, "}");
+        cse_clear(&cg->cse);
         break;
+    }
 
     case ND_CASE:
+        cse_clear(&cg->cse);
         cg->indent--;
-        emit_indent(cg); emit(cg, "case "); gen_expr(cg, n->case_expr); emit(cg, ":\n");
+        emit_indent(cg); emit(cg, "case ");
+        if (expr_is_i64(n->case_expr) && n->case_expr->kind == ND_INT_LIT)
+            emit(cg, "%.17g", n->case_expr->type->is_unsigned ? (double)n->case_expr->ival
+                                                              : (double)(long long)n->case_expr->ival);
+        else if (expr_is_i64(n->case_expr))
+            gen_f64_val(cg, n->case_expr);
+        else
+            gen_expr(cg, n->case_expr);
+        emit(cg, ":\n");
         cg->indent++;
         gen_stmt(cg, n->case_body);
         break;
 
     case ND_DEFAULT:
+        cse_clear(&cg->cse);
         cg->indent--;
         emitln(cg, "default:");
         cg->indent++;
         gen_stmt(cg, n->lhs);
         break;
 
-    case ND_BREAK:    emitln(cg, "break;"); break;
-    case ND_CONTINUE: emitln(cg, "continue;"); break;
+    case ND_BREAK:
+        if (cg->break_label) emitln(cg, "break %s;", cg->break_label);
+        else emitln(cg, "break;");
+        break;
+    case ND_CONTINUE:
+        if (cg->continue_label) emitln(cg, "continue %s;", cg->continue_label);
+        else emitln(cg, "continue;");
+        break;
 
     case ND_RETURN:
-        if (is_aggregate(cg->current_func_ret_type) && n->lhs) {
+        if (struct_in_regs(cg->current_func_ret_type) && n->lhs) {
+            /* Register struct return: fill __r0... */
+            Type *ty = cg->current_func_ret_type;
+            CGVar *sv = split_var(cg, n->lhs);
+            emit_indent(cg);
+            if (sv) {
+                gen_fields_to_slots(cg, sv);
+            } else if (call_in_slots(n->lhs)) {
+                cg->rret_bare = true;
+                gen_expr(cg, n->lhs);
+            } else if (expr_is_pure(n->lhs)) {
+                gen_reg_load_slots(cg, ty, gen_addr_str(cg, n->lhs), lvalue_aligned(cg, n->lhs));
+            } else {
+                const char *t = new_tmp_var(cg);
+                emit(cg, "%s = ", t);
+                gen_expr(cg, n->lhs);
+                emit(cg, ", ");
+                gen_reg_load_slots(cg, ty, t, true);
+            }
+            emit(cg, ";\n");
+            emitln(cg, "%sreturn;", restore_sp(cg));
+        } else if (is_aggregate(cg->current_func_ret_type) && split_var(cg, n->lhs)) {
+            int k = 0;
+            emit_indent(cg);
+            gen_fields_store(cg, split_var(cg, n->lhs), "p___retptr", 0, &k);
+            emit(cg, ";\n");
+            emitln(cg, "%sreturn p___retptr;", restore_sp(cg));
+        } else if (is_aggregate(cg->current_func_ret_type) && call_in_memory(n->lhs)) {
+            /* Tail struct call: the callee fills our own return pointer,
+             * which nothing else in this function can reach */
+            emit_indent(cg);
+            cg->sret_dest = "p___retptr";
+            gen_expr(cg, n->lhs);
+            emit(cg, ";\n");
+            emitln(cg, "%sreturn p___retptr;", restore_sp(cg));
+        } else if (is_aggregate(cg->current_func_ret_type) && n->lhs) {
             /* Struct return: memcpy result to hidden __retptr, return the ptr */
             emit_indent(cg);
             emit(cg, "rt.memcpy(p___retptr, ");
             gen_expr(cg, n->lhs);
             emit(cg, ", %d);\n", type_sz(cg->current_func_ret_type));
-            emitln(cg, "rt.mem.sp = saved_sp; return p___retptr;");
+            emitln(cg, "%sreturn p___retptr;", restore_sp(cg));
+        } else if (n->lhs && !cg->func_has_frame) {
+            emit_indent(cg);
+            emit(cg, "return ");
+            gen_expr(cg, n->lhs);
+            emit(cg, ";\n");
         } else if (n->lhs) {
             /* Evaluate return expression BEFORE restoring sp, because the
              * expression may reference stack-frame addresses (e.g. passing
@@ -1313,17 +4582,38 @@ static void gen_stmt(CodeGen *cg, Node *n) {
             gen_expr(cg, n->lhs);
             emit(cg, "; rt.mem.sp = saved_sp; return __ret;\n");
         } else {
-            emitln(cg, "rt.mem.sp = saved_sp; return;");
+            emitln(cg, "%sreturn;", restore_sp(cg));
         }
         break;
 
-    case ND_GOTO:
-        emitln(cg, "/* goto %s */", n->name);
+    case ND_GOTO: {
+        if (n->lhs) {
+            CGGotoList *gl = cg->goto_table;
+            if (!gl) break;  /* reported by analyze_gotos */
+            emit_indent(cg);
+            emit(cg, "%s = ", gl->state);
+            gen_expr(cg, n->lhs);
+            emit(cg, "; continue %s;\n", gl->dispatch);
+            break;
+        }
+        CGGoto *g = goto_find(cg, n);
+        if (!g) break;  /* reported by analyze_gotos */
+        CGGotoList *gl = g->label->list;
+        if (gl->dispatch)
+            emitln(cg, "%s = %d; continue %s;", gl->state, g->label->state, gl->dispatch);
+        else if (g->back)
+            emitln(cg, "continue %s;", g->label->back->js_label);
+        else
+            emitln(cg, "break %s;", g->label->fwd->js_label);
         break;
-    case ND_LABEL:
-        emitln(cg, "/* label %s: */", n->name);
-        gen_stmt(cg, n->lhs);
+    }
+    case ND_LABEL: {
+        cse_clear(&cg->cse);
+        CGGotoList *gl = cg->has_goto ? goto_list_find(cg, n, true) : NULL;
+        if (gl && (gl->regions || gl->dispatch)) gen_goto_list(cg, gl);
+        else gen_stmt(cg, n->lhs);
         break;
+    }
 
     case ND_NULL_STMT:
     case ND_TYPEDEF:
@@ -1337,22 +4627,399 @@ static void gen_stmt(CodeGen *cg, Node *n) {
     }
 }
 
+/* ---- Data image ----
+ * Static storage starts at address 4096.  Its initial contents are laid
+ * out at compile time: constant initializers are written into an image of
+ * that memory, and string literals, deduplicated by content, go into a
+ * read-only pool placed after the last global.  Pointers to literals are
+ * recorded as relocations and patched once the pool's address is known.
+ * Startup installs each run of nonzero bytes with one Uint8Array.set;
+ * only initializers that are not compile-time constants run as code. */
+
+#define IMAGE_BASE 4096
+
+static CGStr *str_lit(CodeGen *cg, const char *s, int len) {
+    unsigned int h = 5381;
+    for (int i = 0; i < len; i++) h = h * 33 + (unsigned char)s[i];
+    h %= CG_VAR_TABLE_SIZE;
+    for (CGStr *e = cg->strs[h]; e; e = e->next)
+        if (e->len == len && memcmp(e->s, s, len) == 0) return e;
+    CGStr *e = arena_calloc(cg->arena, sizeof(CGStr));
+    e->s = s;
+    e->len = len;
+    e->id = cg->str_count++;
+    e->off = (int)cg->str_pool.len;
+    buf_append(&cg->str_pool, s, len);
+    buf_push(&cg->str_pool, '\0');
+    e->next = cg->strs[h];
+    cg->strs[h] = e;
+    return e;
+}
+
+/* Grow the image to cover static storage below end */
+static void image_reserve(CodeGen *cg, int end) {
+    while ((int)cg->image.len < end - IMAGE_BASE) buf_push(&cg->image, 0);
+}
+
+static void image_put(CodeGen *cg, int addr, const void *bytes, int n) {
+    image_reserve(cg, addr + n);
+    memcpy(cg->image.data + (addr - IMAGE_BASE), bytes, n);
+}
+
+/* Little-endian integer of n bytes */
+static void image_put_int(CodeGen *cg, int addr, unsigned long long v, int n) {
+    unsigned char b[8];
+    for (int i = 0; i < n; i++) b[i] = (unsigned char)(v >> (8 * i));
+    image_put(cg, addr, b, n);
+}
+
+/* A constant initializer value */
+enum { IV_INT, IV_FLOAT, IV_STR };
+typedef struct {
+    int         kind;       /* IV_* */
+    unsigned long long i;   /* IV_INT: value, or address of a global/function ID */
+    double      f;
+    CGStr      *str;        /* IV_STR: address of this literal */
+} ImageVal;
+
+/* Evaluate a static initializer expression at compile time */
+static bool image_eval(CodeGen *cg, Node *e, ImageVal *v) {
+    switch (e->kind) {
+    case ND_INT_LIT:
+        v->kind = IV_INT;
+        v->i = e->ival;
+        return true;
+    case ND_CHAR_LIT:
+        v->kind = IV_INT;
+        v->i = (unsigned long long)(long long)e->cval;
+        return true;
+    case ND_FLOAT_LIT:
+        v->kind = IV_FLOAT;
+        v->f = e->fval;
+        return true;
+    case ND_STRING_LIT:
+        v->kind = IV_STR;
+        v->str = str_lit(cg, e->sval, e->slen);
+        return true;
+    case ND_LABEL_ADDR: {
+        CGLabel *l = cg->in_func ? goto_label_find(cg, e->name) : NULL;
+        if (!l || !l->state) return false;
+        v->kind = IV_INT;
+        v->i = (unsigned)l->state;
+        return true;
+    }
+    case ND_NEG:
+        if (!image_eval(cg, e->lhs, v) || v->kind == IV_STR) return false;
+        if (v->kind == IV_INT) v->i = 0 - v->i;
+        else v->f = -v->f;
+        return true;
+    case ND_ADDR:
+    case ND_IDENT: {
+        /* Functions, and the addresses of objects in static storage */
+        Node *obj = e->kind == ND_ADDR ? e->lhs : e;
+        bool local;
+        int off;
+        if (obj->kind == ND_IDENT && !var_find(cg, obj->name)) {
+            Symbol *sym = symtab_lookup(cg->symtab, obj->name);
+            if (sym && sym->kind == SYM_FUNC) {
+                v->kind = IV_INT;
+                v->i = (unsigned)func_id(cg, obj->name);
+                return true;
+            }
+            if (sym && sym->kind == SYM_ENUM_CONST && e->kind == ND_IDENT) {
+                v->kind = IV_INT;
+                v->i = (unsigned long long)sym->enum_val;
+                return true;
+            }
+            return false;
+        }
+        /* A bare name is an address only when it is an array (sema has
+         * already retyped it as the decayed pointer) */
+        if (e->kind == ND_IDENT) {
+            CGVar *gv = var_find(cg, e->name);
+            if (!gv->type || gv->type->kind != TY_ARRAY) return false;
+        }
+        if (!const_addr(cg, obj, &local, &off) || local) return false;
+        v->kind = IV_INT;
+        v->i = (unsigned)off;
+        return true;
+    }
+    case ND_ADD:
+    case ND_SUB: {
+        /* Address plus a constant element offset */
+        ImageVal k;
+        if (!e->type || !type_is_ptr(e->type) || !e->lhs->type || !type_is_ptr(e->lhs->type))
+            return false;
+        if (!image_eval(cg, e->lhs, v) || v->kind != IV_INT) return false;
+        if (!image_eval(cg, e->rhs, &k) || k.kind != IV_INT) return false;
+        unsigned long long d = k.i * (unsigned long long)type_sz(e->type->base);
+        v->i = (unsigned)(e->kind == ND_ADD ? v->i + d : v->i - d);
+        return true;
+    }
+    case ND_CAST: {
+        Type *to = e->cast_type, *from = e->cast_expr->type;
+        if (!image_eval(cg, e->cast_expr, v) || !to || !from) return false;
+        if (to->kind == TY_VOID) return false;
+        if (v->kind == IV_STR)
+            return type_is_ptr(to) || to->kind == TY_ARRAY;
+        if (type_is_float(to)) {
+            if (v->kind == IV_INT)
+                v->f = from->is_unsigned ? (double)v->i : (double)(long long)v->i;
+            if (to->kind == TY_FLOAT) v->f = (float)v->f;
+            v->kind = IV_FLOAT;
+            return true;
+        }
+        if (!type_is_integer(to) && !type_is_ptr(to)) return false;
+        if (v->kind == IV_FLOAT) {
+            if (to->kind == TY_BOOL) v->i = v->f != 0;
+            else if (v->f >= 9.2233720368547758e18) v->i = (unsigned long long)v->f;
+            else v->i = (unsigned long long)(long long)v->f;
+            v->kind = IV_INT;
+        } else if (to->kind == TY_BOOL) {
+            v->i = v->i != 0;
+        }
+        /* Narrow to the target width, keeping sign */
+        int sz = type_sz(to);
+        if (sz < 8) {
+            unsigned long long mask = (1ULL << (8 * sz)) - 1;
+            v->i &= mask;
+            if (!to->is_unsigned && !type_is_ptr(to) && (v->i >> (8 * sz - 1)) & 1)
+                v->i |= ~mask;
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+/* Write the value of init, of type ty, into the image at addr.  False if
+ * it is not a compile-time constant. */
+static bool image_init(CodeGen *cg, int addr, Type *ty, Node *init) {
+    int sz = type_sz(ty);
+
+    /* char array from a string literal: copy the bytes, zero-padded */
+    if (ty->kind == TY_ARRAY && ty->base && ty->base->kind == TY_CHAR &&
+        init->kind == ND_STRING_LIT) {
+        int n = init->slen + 1 < sz ? init->slen : sz;
+        image_reserve(cg, addr + sz);
+        if (n > 0) image_put(cg, addr, init->sval, n);
+        return true;
+    }
+    if (is_aggregate(ty) || ty->kind == TY_ARRAY) return false;
+
+    ImageVal v;
+    if (!image_eval(cg, init, &v)) return false;
+    if (v.kind == IV_STR) {
+        if (!type_is_ptr(ty)) return false;
+        CGReloc *r = arena_calloc(cg->arena, sizeof(CGReloc));
+        r->addr = addr;
+        r->str = v.str;
+        r->next = cg->relocs;
+        cg->relocs = r;
+        image_reserve(cg, addr + 4);
+        return true;
+    }
+    if (type_is_float(ty)) {
+        double d = v.kind == IV_FLOAT ? v.f
+                 : (init->type && init->type->is_unsigned) ? (double)v.i : (double)(long long)v.i;
+        if (ty->kind == TY_FLOAT) {
+            float f = (float)d;
+            image_put(cg, addr, &f, 4);
+        } else {
+            image_put(cg, addr, &d, 8);
+        }
+        return true;
+    }
+    if (!type_is_integer(ty) && !type_is_ptr(ty)) return false;
+    if (v.kind == IV_FLOAT) {
+        if (ty->kind == TY_BOOL) v.i = v.f != 0;
+        else if (v.f >= 9.2233720368547758e18) v.i = (unsigned long long)v.f;
+        else v.i = (unsigned long long)(long long)v.f;
+    } else if (ty->kind == TY_BOOL) {
+        v.i = v.i != 0;
+    }
+    image_put_int(cg, addr, v.i, sz > 8 ? 8 : sz);
+    return true;
+}
+
+/* Local aggregates with constant initializers are copied from a template
+ * in static storage, so entering the function costs one bulk copy rather
+ * than a memset and a store per element.  A char array initialized from a
+ * string no longer than itself copies straight from the literal pool. */
+
+#define TEMPLATE_MIN_LEAVES 4   /* fewer constant stores stay inline */
+
+typedef struct {
+    int  leaves;
+    bool constant;
+} InitShape;
+
+static void init_shape(CodeGen *cg, Type *ty, Node *init, InitShape *s) {
+    if (!init) return;
+    if (init->kind == ND_INIT_LIST) {
+        if (ty->kind == TY_ARRAY) {
+            for (Node *item = init->body; item; item = item->next) {
+                if (item->kind == ND_DESIGNATOR && item->desig_index)
+                    init_shape(cg, ty->base, item->desig_init, s);
+                else
+                    init_shape(cg, ty->base, item, s);
+            }
+        } else if (ty->kind == TY_STRUCT || ty->kind == TY_UNION) {
+            Member *m = ty->members;
+            for (Node *item = init->body; item; item = item->next) {
+                if (item->kind == ND_DESIGNATOR && item->desig_name) {
+                    m = type_find_member(ty, item->desig_name);
+                    if (m) init_shape(cg, m->type, item->desig_init, s);
+                    if (m) m = m->next;
+                } else if (m) {
+                    init_shape(cg, m->type, item, s);
+                    m = m->next;
+                }
+            }
+        } else if (init->body) {
+            init_shape(cg, ty, init->body, s);
+        }
+        return;
+    }
+
+    s->leaves++;
+    if (ty->kind == TY_ARRAY && ty->base && ty->base->kind == TY_CHAR &&
+        init->kind == ND_STRING_LIT)
+        return;
+    ImageVal v;
+    if (is_aggregate(ty) || ty->kind == TY_ARRAY || !image_eval(cg, init, &v) ||
+        (v.kind == IV_STR && !type_is_ptr(ty)))
+        s->constant = false;
+}
+
+/* Zero the bytes of the frame object at off that init leaves unset, so
+ * nothing gen_init stores is zeroed first */
+static void gen_init_zero(CodeGen *cg, int off, Type *ty, Node *init) {
+    DseRun runs[DSE_RUNS_MAX];
+    int n = dse_zero_runs(ty, init, runs);
+    if (n < 0) {
+        emitln(cg, "rt.memset(bp + (%d), 0, %d);", off, type_sz(ty));
+        return;
+    }
+    for (int i = 0; i < n; i++)
+        emitln(cg, "rt.memset(bp + (%d), 0, %d);", off + runs[i].off, runs[i].len);
+}
+
+static bool gen_local_template(CodeGen *cg, int off, Type *ty, Node *init) {
+    if (ty->kind == TY_VLA) return false;
+    int size = type_sz(ty);
+
+    if (init->kind == ND_STRING_LIT && size <= init->slen + 1) {
+        int id = str_lit(cg, init->sval, init->slen)->id;
+        emitln(cg, "HEAPU8.copyWithin(bp + (%d), __str%d, __str%d + %d);", off, id, id, size);
+        return true;
+    }
+
+    InitShape shape;
+    shape.leaves = 0;
+    shape.constant = true;
+    init_shape(cg, ty, init, &shape);
+    if (!shape.constant) return false;
+    if (init->kind != ND_STRING_LIT && shape.leaves < TEMPLATE_MIN_LEAVES) return false;
+
+    int align = ty->align > 0 ? ty->align : 1;
+    global_offset = (global_offset + align - 1) & ~(align - 1);
+    int tmpl = global_offset;
+    global_offset += size;
+    image_reserve(cg, global_offset);
+    if (init->kind == ND_INIT_LIST) {
+        /* Every leaf is constant: nothing is emitted */
+        gen_init(cg, NULL, tmpl, ty, init);
+    } else {
+        image_init(cg, tmpl, ty, init);
+    }
+    emitln(cg, "HEAPU8.copyWithin(bp + (%d), %d, %d);", off, tmpl, tmpl + size);
+    return true;
+}
+
+#define IMAGE_GAP_MIN 64  /* zeros that end a run of the image */
+
+/* rt.mem.loadImage of image bytes [from, to) */
+static void emit_image_run(CodeGen *cg, const unsigned char *d, int from, int to) {
+    static const char b64[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    emit(cg, "rt.mem.loadImage(%d, \"", IMAGE_BASE + from);
+    for (int i = from; i < to; i += 3) {
+        unsigned w = (unsigned)d[i] << 16;
+        if (i + 1 < to) w |= (unsigned)d[i + 1] << 8;
+        if (i + 2 < to) w |= d[i + 2];
+        char q[4];
+        q[0] = b64[(w >> 18) & 63];
+        q[1] = b64[(w >> 12) & 63];
+        q[2] = i + 1 < to ? b64[(w >> 6) & 63] : '=';
+        q[3] = i + 2 < to ? b64[w & 63] : '=';
+        buf_append(&cg->out, q, 4);
+    }
+    emit(cg, "\");\n");
+}
+
+/* Lay out the literal pool after the globals, patch relocations and emit
+ * the image; returns the end of static storage */
+static int emit_image(CodeGen *cg) {
+    int pool = (global_offset + 7) & ~7;
+    image_reserve(cg, pool);
+    buf_append(&cg->image, cg->str_pool.data, cg->str_pool.len);
+    for (CGReloc *r = cg->relocs; r; r = r->next) {
+        unsigned p = (unsigned)(pool + r->str->off);
+        for (int i = 0; i < 4; i++)
+            cg->image.data[r->addr - IMAGE_BASE + i] = (char)(p >> (8 * i));
+    }
+
+    for (int h = 0; h < CG_VAR_TABLE_SIZE; h++)
+        for (CGStr *e = cg->strs[h]; e; e = e->next)
+            emit(cg, "const __str%d = %d;\n", e->id, pool + e->off);
+
+    /* Memory starts zeroed: only runs of nonzero bytes are stored, split
+     * wherever IMAGE_GAP_MIN zeros or more separate them */
+    const unsigned char *d = (const unsigned char *)cg->image.data;
+    int n = (int)cg->image.len;
+    int i = 0;
+    for (;;) {
+        while (i < n && d[i] == 0) i++;
+        if (i >= n) break;
+        int end = i, j = i;
+        while (j < n) {
+            if (d[j]) {
+                end = ++j;
+                continue;
+            }
+            int k = j;
+            while (k < n && d[k] == 0) k++;
+            if (k == n || k - j >= IMAGE_GAP_MIN) break;
+            j = k;
+        }
+        emit_image_run(cg, d, i, end);
+        i = end;
+    }
+    return pool + (int)cg->str_pool.len;
+}
+
 /* ---- Global variable ---- */
 
 static void gen_global_init(CodeGen *cg, int addr, Type *ty, Node *init) {
-    /* Write initialization code for a global variable.
-     * Use a temp buffer for init code so that string literal declarations
-     * (written to data_section by gen_expr) appear before the init code
-     * that references them. */
+    /* Constant parts go into the data image; the rest becomes
+     * initialization code in data_section, run after the image is
+     * installed. */
+    image_reserve(cg, addr + type_sz(ty));
+    if (init->kind != ND_INIT_LIST && image_init(cg, addr, ty, init)) return;
+
     Buf saved_out = cg->out;
     int saved_indent = cg->indent;
+    bool saved_cse = cg->cse.on;
     Buf tmp;
     buf_init(&tmp);
     cg->out = tmp;
     cg->indent = 0;
+    cg->cse.on = false;
 
     if (init->kind == ND_INIT_LIST) {
-        gen_init(cg, "0", addr, ty, init);
+        gen_init(cg, NULL, addr, ty, init);
     } else if (init->kind == ND_STRING_LIT &&
                ty->kind == TY_ARRAY && ty->base && ty->base->kind == TY_CHAR) {
         emit(cg, "rt.strcpy(%d, ", addr);
@@ -1362,17 +5029,24 @@ static void gen_global_init(CodeGen *cg, int addr, Type *ty, Node *init) {
         emit(cg, "rt.memcpy(%d, ", addr);
         gen_expr(cg, init);
         emit(cg, ", %d);\n", type_sz(ty));
+    } else if (type_is_i64(ty)) {
+        gen_i64_init(cg, "0", addr, addr % 4 == 0, ty, init);
+        emit(cg, ";\n");
     } else {
-        emit(cg, "rt.mem.%s(%d, ", js_setter(ty), addr);
-        gen_expr(cg, init);
-        emit(cg, ");\n");
+        bool al = ty->align > 0 && addr % ty->align == 0;
+        emit_store_begin(cg, ty, al);
+        emit(cg, "%d", addr);
+        emit_store_mid(cg, ty, al);
+        gen_expr_to(cg, ty, init);
+        emit_store_end(cg, ty, al);
+        emit(cg, ";\n");
     }
 
     tmp = cg->out;
     cg->out = saved_out;
     cg->indent = saved_indent;
+    cg->cse.on = saved_cse;
 
-    /* Append the init code to data_section (after any string decls) */
     if (tmp.len > 0)
         buf_append(&cg->data_section, tmp.data, tmp.len);
     buf_free(&tmp);
@@ -1399,8 +5073,18 @@ static void gen_func(CodeGen *cg, Node *n) {
     cg->tmp_count = 0;
     var_clear_locals(cg);
     cg->current_func_ret_type = n->type->return_type;
+    analyze_func_storage(cg, n);
+    analyze_func_alignment(cg, n);
+    analyze_local_fp_bindings(cg, n);
+    buf_free(&cg->jslocal_decls);
+    buf_init(&cg->jslocal_decls);
+    cg->has_goto = false;
+    analyze_gotos(cg, n);
+    /* Load reuse needs straight-line text between joins: not with goto
+     * regions or setjmp retries */
+    cse_begin(&cg->cse, n, cg->func_promote && !cg->has_goto);
 
-    bool sret = is_aggregate(n->type->return_type);
+    bool sret = is_aggregate(n->type->return_type) && !struct_in_regs(n->type->return_type);
     emit(cg, "function _%s(", n->func_name);
     if (sret) {
         emit(cg, "p___retptr");
@@ -1408,59 +5092,132 @@ static void gen_func(CodeGen *cg, Node *n) {
     }
     int pi = 0;
     for (Param *p = n->type->params; p; p = p->next) {
+        const char *pname = p->name ? p->name : "arg";
         if (pi > 0) emit(cg, ", ");
-        emit(cg, "p_%s", p->name ? p->name : "arg");
+        if (struct_in_regs(p->type)) {
+            /* one argument per leaf field word */
+            CGVar *list = NULL;
+            var_add_fields(cg, &list, p->type, 0, fmt_str(cg, "p_%s", pname), true);
+            for (CGVar *f = list; f; f = f->next) {
+                emit(cg, "%s%s", f == list ? "" : ", ", f->js_name);
+                if (f->js_hi) emit(cg, ", %s", f->js_hi);
+            }
+        } else {
+            emit(cg, "p_%s", pname);
+            if (type_is_i64(p->type)) emit(cg, ", p_%s$h", pname);
+        }
         pi++;
     }
     if (n->type->is_variadic) {
         if (pi > 0 || sret) emit(cg, ", ");
-        emit(cg, "...p___va");
+        emit(cg, "p___va");
     }
     emit(cg, ") {\n");
+
+    /* Generate the body first: the set of promoted locals and the frame
+     * size are only known afterwards. */
+    Buf saved_out = cg->out;
+    buf_init(&cg->out);
     cg->indent = 1;
 
-    emitln(cg, "const saved_sp = rt.mem.sp;");
-    emitln(cg, "const bp = rt.mem.sp;");
+    if (cg->func_has_frame) {
+        emitln(cg, "const saved_sp = rt.mem.sp;");
+        emitln(cg, "const bp = rt.mem.sp;");
+    }
 
-    /* Allocate and store parameters on stack */
+    /* Parameters: promoted ones stay in their JS argument (converted to the
+     * declared type), the rest are stored into the frame */
     for (Param *p = n->type->params; p; p = p->next) {
         if (!p->name) continue;
+        if (struct_in_regs(p->type)) {
+            /* Register struct: split in its arguments, or stored to the frame */
+            CGVar *v = var_set_local(cg, p->name, 0, p->type, true);
+            v->storage = CGV_FIELDS;
+            var_add_fields(cg, &v->fields, p->type, 0, fmt_str(cg, "p_%s", p->name), true);
+            if (agg_can_split(cg, p->name, p->type)) continue;
+            int k = 0;
+            v->addr = alloc_local(cg, p->type);
+            emit_indent(cg);
+            gen_fields_store(cg, v, "bp", v->addr, &k);
+            emit(cg, ";\n");
+            v->storage = CGV_MEMORY;
+            continue;
+        }
+        if (var_can_promote(cg, p->name, p->type)) {
+            CGVar *v = var_set_local(cg, p->name, 0, p->type, true);
+            v->storage = CGV_JSLOCAL;
+            char buf[256];
+            snprintf(buf, sizeof(buf), "p_%s", p->name);
+            v->js_name = arena_strdup(cg->arena, buf);
+            if (type_is_i64(p->type)) {
+                /* callers pass both words already in int32 form */
+                snprintf(buf, sizeof(buf), "p_%s$h", p->name);
+                v->js_hi = arena_strdup(cg->arena, buf);
+                continue;
+            }
+            emit_indent(cg);
+            emit(cg, "%s = ", v->js_name);
+            emit_coerce_begin(cg, p->type);
+            emit(cg, "%s", v->js_name);
+            emit_coerce_end(cg, p->type);
+            emit(cg, ";\n");
+            continue;
+        }
         int off = alloc_local(cg, p->type);
         var_set_local(cg, p->name, off, p->type, true);
         if (is_aggregate(p->type)) {
             /* Struct/union params: caller passes address, copy full data */
             emitln(cg, "rt.memcpy(bp + (%d), p_%s, %d);",
                    off, p->name, type_sz(p->type));
+        } else if (type_is_i64(p->type)) {
+            emitln(cg, "HEAP32[(bp + (%d)) >> 2] = p_%s;", off, p->name);
+            emitln(cg, "HEAP32[(bp + (%d)) >> 2] = p_%s$h;", off + 4, p->name);
         } else {
-            emitln(cg, "rt.mem.%s(bp + (%d), p_%s);",
-                   js_setter(p->type), off, p->name);
+            emit_indent(cg);
+            emit_store_begin(cg, p->type, true);
+            emit(cg, "bp + (%d)", off);
+            emit_store_mid(cg, p->type, true);
+            emit(cg, "p_%s", p->name);
+            emit_store_end(cg, p->type, true);
+            emit(cg, ";\n");
         }
     }
 
-    /* Placeholder for stack allocation */
-    size_t sp_pos = cg->out.len;
-    emitln(cg, "rt.mem.sp -= %-10d;  /* frame */", 0);
+    size_t frame_pos = cg->out.len;
 
     /* Body */
     if (n->func_body) gen_stmt(cg, n->func_body);
 
     /* Implicit return */
-    if (strcmp(n->func_name, "main") == 0)
-        emitln(cg, "rt.mem.sp = saved_sp; return 0;");
-    else
-        emitln(cg, "rt.mem.sp = saved_sp;");
+    bool is_main = strcmp(n->func_name, "main") == 0;
+    if (cg->func_has_frame)
+        emitln(cg, is_main ? "rt.mem.sp = saved_sp; return 0;" : "rt.mem.sp = saved_sp;");
+    else if (is_main)
+        emitln(cg, "return 0;");
+
+    Buf body = cg->out;
+    cg->out = saved_out;
+
+    if (cg->jslocal_decls.len > 0) {
+        buf_push(&cg->jslocal_decls, '\0');
+        emitln(cg, "let %s;", cg->jslocal_decls.data);
+    }
+    buf_append(&cg->out, body.data, frame_pos);
+    if (cg->func_has_frame) {
+        int frame = (cg->stack_offset + 15) & ~15;
+        emitln(cg, "rt.mem.sp -= %d;  /* frame */", frame);
+    } else if (cg->stack_offset > 0) {
+        error_noloc("internal error: frameless function '%s' allocates locals",
+                    n->func_name);
+    }
+    buf_append(&cg->out, body.data + frame_pos, body.len - frame_pos);
+    buf_free(&body);
 
     cg->indent = 0;
     emit(cg, "}\n\n");
 
-    /* Patch stack frame size */
-    int frame = (cg->stack_offset + 15) & ~15;
-    char patch[64];
-    snprintf(patch, sizeof(patch), "rt.mem.sp -= %-10d;  /* frame */", frame);
-    char *target = strstr(cg->out.data + sp_pos, "rt.mem.sp -= ");
-    if (target) memcpy(target, patch, strlen(patch));
-
     cg->in_func = false;
+    cg->cse.on = false;
 }
 
 /* ---- Top-level ---- */
@@ -1469,7 +5226,14 @@ void codegen_generate(CodeGen *cg, Node *program) {
 
     emit(cg, "\"use strict\";\n");
     emit(cg, "const { Runtime } = require(\"./runtime/runtime.js\");\n");
-    emit(cg, "const rt = new Runtime(16 * 1024 * 1024);\n\n");
+    emit(cg, "const rt = new Runtime(16 * 1024 * 1024);\n");
+    /* Heap views are owned by rt.mem; rebind whenever it refreshes them */
+    emit(cg, "let HEAP8, HEAPU8, HEAP16, HEAPU16, HEAP32, HEAPU32, HEAPF32, HEAPF64;\n");
+    emit(cg, "rt.mem.onViewsChanged((m) => { HEAP8 = m.HEAP8; HEAPU8 = m.HEAPU8; "
+             "HEAP16 = m.HEAP16; HEAPU16 = m.HEAPU16; HEAP32 = m.HEAP32; HEAPU32 = m.HEAPU32; "
+             "HEAPF32 = m.HEAPF32; HEAPF64 = m.HEAPF64; });\n\n");
+
+    analyze_reachability(cg, program);
 
     /* Collect globals */
     for (Node *n = program->body; n; n = n->next) {
@@ -1477,29 +5241,35 @@ void codegen_generate(CodeGen *cg, Node *program) {
             gen_global_var(cg, n);
     }
 
-    /* Generate functions (this populates data_section with string literals,
-     * and may add static locals which increase global_offset) */
+    analyze_global_fp_bindings(cg, program);
+
+    /* Generate functions (this interns string literals, and may add
+     * static locals which increase global_offset) */
     Buf func_buf;
     buf_init(&func_buf);
     Buf saved = cg->out;
     cg->out = func_buf;
 
     for (Node *n = program->body; n; n = n->next) {
-        if (n->kind == ND_FUNC_DEF)
+        if (n->kind == ND_FUNC_DEF && func_is_emitted(cg, n))
             gen_func(cg, n);
     }
 
     func_buf = cg->out;
     cg->out = saved;
 
-    /* Now emit data section. reserveGlobals must come first so that
-     * heap allocations (allocString etc.) don't overlap globals. */
+    /* Return slots of register structs */
+    for (int k = 0; k < cg->ret_slots; k++)
+        emit(cg, "%s__r%d = 0%s", k ? ", " : "let ", k, k + 1 == cg->ret_slots ? ";\n" : "");
+    /* Static data.  reserveGlobals keeps the heap clear of the image. */
     emit(cg, "// === Data ===\n");
-    emit(cg, "rt.mem.reserveGlobals(%d);\n", global_offset);
+    int data_end = emit_image(cg);
+    emit(cg, "rt.mem.reserveGlobals(%d);\n", data_end);
+    if (cg->switch_tables.len > 0) {
+        buf_push(&cg->switch_tables, '\0');
+        emit(cg, "%s", cg->switch_tables.data);
+    }
 
-    /* Emit functions first, then register function pointers BEFORE
-     * global data initializers, because global data may reference
-     * function pointer constants (__fp_xxx). */
     emit(cg, "\n// === Functions ===\n");
     if (func_buf.len > 0) {
         buf_push(&func_buf, '\0');
@@ -1507,21 +5277,16 @@ void codegen_generate(CodeGen *cg, Node *program) {
     }
     buf_free(&func_buf);
 
-    /* Register function pointers for user-defined functions */
-    bool has_fp = false;
-    for (Node *n = program->body; n; n = n->next) {
-        if (n->kind == ND_FUNC_DEF) {
-            if (!has_fp) {
-                emit(cg, "// === Function Pointers ===\n");
-                has_fp = true;
-            }
-            emit(cg, "const __fp_%s = rt.registerFunction(_%s);\n",
-                 n->func_name, n->func_name);
-        }
+    /* Function table, indexed by the IDs that code and data use as
+     * function pointer values */
+    if (cg->func_count > 0) {
+        buf_push(&cg->func_table, '\0');
+        emit(cg, "// === Function Pointers ===\n");
+        emit(cg, "const __ft = [\n  null,\n%s];\n", cg->func_table.data);
+        emit(cg, "rt.setFunctionTable(__ft);\n\n");
     }
-    if (has_fp) emit(cg, "\n");
 
-    /* Emit global data initializers (may reference __fp_xxx) */
+    /* Emit global data initializers */
     emit(cg, "// === Global Data ===\n");
     if (cg->data_section.len > 0) {
         buf_push(&cg->data_section, '\0');
@@ -3,6 +3,24 @@
 
 #include "ast.h"
 #include "symtab.h"
+#include "cse.h"
+#include "dse.h"
+#include "range.h"
+
+/* Where a variable's value lives at runtime */
+typedef enum {
+    CGV_MEMORY,     /* linear memory: bp-relative frame slot or global address */
+    CGV_JSLOCAL,    /* JS local (scalar whose address is never taken) */
+    CGV_FIELDS,     /* struct split into one JS local per scalar field */
+} CGVarStorage;
+
+/* How switch statements with constant cases are dispatched */
+typedef enum {
+    SWITCH_AUTO,    /* JS switch when dense, compare tree when sparse */
+    SWITCH_JS,      /* plain JS switch */
+    SWITCH_TABLE,   /* force array-indexed tables */
+    SWITCH_TREE,    /* force balanced compare trees */
+} SwitchMode;
 
 /* Local variable entry for codegen */
 #define CG_VAR_TABLE_SIZE 256
@@ -11,10 +29,79 @@ typedef struct CGVar {
     int         addr;       /* offset from bp (negative for locals) */
     bool        is_local;
     bool        is_param;   /* parameter passed by value */
+    CGVarStorage storage;
+    const char *js_name;    /* JS identifier when storage == CGV_JSLOCAL */
+    const char *js_hi;      /* ... and of the high word of a long long */
+    const char *fn_target;  /* function a never-reassigned pointer always holds */
+    struct CGVar *fields;   /* CGV_FIELDS: leaf fields (addr = offset), via next */
     Type       *type;
     struct CGVar *next;
 } CGVar;
 
+/* String literal in the read-only data pool (deduplicated by content) */
+typedef struct CGStr {
+    const char *s;
+    int         len;        /* bytes, excluding the terminating NUL */
+    int         id;         /* __strN */
+    int         off;        /* offset in the pool */
+    struct CGStr *next;
+} CGStr;
+
+/* Pointer in the data image to a pool literal, patched once the pool's
+ * address is known */
+typedef struct CGReloc {
+    int         addr;
+    CGStr      *str;
+    struct CGReloc *next;
+} CGReloc;
+
+/* goto lowering.  A statement list holding goto targets either keeps its
+ * shape, with runs of statements wrapped in labeled JS blocks (left by
+ * break: forward gotos) and loops (re-entered by continue: backward
+ * gotos), or, when those runs cross, becomes a switch over a state
+ * variable inside a dispatch loop. */
+typedef struct CGGotoRegion {
+    int         lo, hi;     /* statements of the list it wraps */
+    bool        loop;
+    const char *js_label;
+    struct CGGotoRegion *next;
+} CGGotoRegion;
+
+typedef struct CGGotoList {
+    Node       *head;       /* first statement of a block's list */
+    bool        lone;       /* head is a labeled statement outside any list */
+    CGGotoRegion *regions;
+    const char *dispatch;   /* JS label of the dispatch loop, if any */
+    const char *state;      /* ... and its state variable */
+    struct CGGotoList *next;
+} CGGotoList;
+
+typedef struct CGLabel {
+    const char *name;
+    Node       *node;
+    CGGotoList *list;
+    int         index;      /* statement of the list carrying the label */
+    CGGotoRegion *fwd, *back;
+    int         state;      /* dispatch case, and the value of &&label */
+    bool        addr_taken; /* used as a value (&&label) */
+    struct CGLabel *next;
+} CGLabel;
+
+typedef struct CGGoto {
+    Node       *node;
+    CGLabel    *label;
+    bool        back;       /* target is at or before the goto */
+    struct CGGoto *next;
+} CGGoto;
+
+/* Function defined in the program */
+typedef struct CGFunc {
+    const char *name;
+    Node       *def;        /* its ND_FUNC_DEF */
+    bool        reachable;  /* called or referenced from code that runs */
+    struct CGFunc *next;
+} CGFunc;
+
 typedef struct {
     Arena  *arena;
     Buf     out;          /* output JavaScript buffer */
@@ -22,29 +109,77 @@ typedef struct {
     int     label_count;  /* for generating unique labels */
     int     str_count;    /* string literal counter */
     int     tmp_count;    /* temporary variable counter */
-    Buf     data_section; /* string literals and global data */
+    Buf     data_section; /* global initializers that are not constant */
     Buf     decl_section; /* forward declarations */
     int     stack_offset; /* current stack frame offset */
     bool    in_func;      /* inside a function? */
     SymTab *symtab;
 
+    /* Data image: initial bytes of static storage from address 4096, and
+     * the literal pool that follows it */
+    Buf     image;
+    Buf     str_pool;
+    CGStr  *strs[CG_VAR_TABLE_SIZE];
+    CGReloc *relocs;
+
     /* Local variable map (per function) */
     CGVar  *locals[CG_VAR_TABLE_SIZE];
 
     /* Global variable map */
     CGVar  *globals[CG_VAR_TABLE_SIZE];
 
-    /* goto support */
+    /* Escape analysis (per function): names whose address is taken */
+    CGVar  *addr_taken[CG_VAR_TABLE_SIZE];
+    CGVar  *agg_escapes[CG_VAR_TABLE_SIZE]; /* structs used other than by member or copy */
+    /* Pointer locals that may hold a misaligned address (per function) */
+    CGVar  *misaligned[CG_VAR_TABLE_SIZE];
+    bool    func_promote;   /* scalar locals may live in JS locals */
+    bool    func_has_frame; /* function needs a linear-memory stack frame */
+    Buf     jslocal_decls;  /* "let" list for promoted locals */
+
+    /* Defined functions by name; only reachable ones are emitted */
+    CGFunc *funcs[CG_VAR_TABLE_SIZE];
+
+    /* Function table: name -> compile-time ID (addr) of functions used as values */
+    CGVar  *func_ids[CG_VAR_TABLE_SIZE];
+    int     func_count;
+    Buf     func_table;   /* entries of the emitted __ft array, in ID order */
+
+    /* Devirtualization: function-pointer variables bound once to a known
+     * function (per function for locals, per program for globals) */
+    CGVar  *fp_locals[CG_VAR_TABLE_SIZE];
+    CGVar  *fp_globals[CG_VAR_TABLE_SIZE];
+
+    /* goto support (per function) */
     bool    has_goto;     /* current function uses goto */
-    Buf     goto_labels;  /* label → state mapping */
-    int     goto_state;   /* state counter for goto */
+    CGLabel *goto_labels; /* labels targeted by a goto */
+    CGGotoList *goto_lists;
+    CGGoto *gotos;
+    int     goto_state;   /* dispatch states handed out */
+    CGGotoList *goto_table; /* dispatch of computed gotos (function body) */
+    const char *continue_label; /* target of C continue (NULL: innermost loop) */
+
+    Cse     cse;          /* load reuse (per function) */
+
+    Ranges  ranges;       /* value ranges, with the counters of enclosing loops */
+
+    /* switch lowering */
+    const char *break_label;  /* target of C break inside a lowered switch */
+    Buf     switch_tables;    /* dispatch tables of lowered switches */
 
     /* struct return support */
     Type   *current_func_ret_type; /* return type of current function */
+    int     ret_slots;    /* __rN return slots used by register structs */
+    bool    rret_bare;    /* next struct call leaves its value in the slots */
+    const char *sret_dest; /* next memory struct call returns into this address */
 
     /* setjmp/longjmp support */
     int     setjmp_counter;   /* unique setjmp variable counter */
     int     current_setjmp_id; /* active setjmp context (-1 if none) */
+
+    /* Options */
+    bool    nan_boxing;   /* doubles as BigInt raw bits (NaN payloads kept) */
+    SwitchMode switch_mode; /* dispatch of switches with constant cases */
 } CodeGen;
 
 void codegen_init(CodeGen *cg, Arena *a, SymTab *st);
@@ -0,0 +1,313 @@
+#include "cse.h"
+#include <string.h>
+
+/* A load shape of the function and how often it occurs */
+struct CseShape {
+    const char *key;
+    int         count;
+    CseShape   *next;
+};
+
+/* A parameter of the function */
+struct CseParam {
+    const char *name;
+    bool        array;       /* declared as an array: a pointer */
+    bool        is_restrict;   /* restrict pointer the body never reassigns */
+    CseParam   *next;
+};
+
+void cse_init(Cse *c, Arena *a) {
+    memset(c, 0, sizeof(*c));
+    c->arena = a;
+}
+
+static unsigned int cse_hash(const char *key) {
+    unsigned int h = 0;
+    for (const char *p = key; *p; p++)
+        h = h * 31 + (unsigned char)*p;
+    return h % CSE_TABLE_SIZE;
+}
+
+/* ---- Shapes ---- */
+
+/* Structural key of an expression; names are not resolved, so different
+ * variables may share a key */
+static void cse_shape(Buf *b, Node *n) {
+    if (!n) return;
+    buf_printf(b, "(%d", n->kind);
+    switch (n->kind) {
+    case ND_IDENT: case ND_MEMBER: case ND_MEMBER_PTR:
+        buf_printf(b, " %s", n->name);
+        break;
+    case ND_INT_LIT:
+        buf_printf(b, " %u", (unsigned)n->ival);
+        break;
+    case ND_CHAR_LIT:
+        buf_printf(b, " %d", n->cval);
+        break;
+    case ND_CAST:
+        cse_shape(b, n->cast_expr);
+        break;
+    default:
+        break;
+    }
+    if (n->kind != ND_CAST) {
+        cse_shape(b, n->lhs);
+        cse_shape(b, n->rhs);
+    }
+    buf_push(b, ')');
+}
+
+/* True if loads of type t may be kept: scalars held in one JS value */
+static bool cse_type(Type *t) {
+    return t && !(t->qual & QUAL_VOLATILE) && t->kind != TY_LLONG &&
+           (t->kind == TY_PTR || type_is_integer(t) || t->kind == TY_FLOAT ||
+            t->kind == TY_DOUBLE || t->kind == TY_LDOUBLE);
+}
+
+static bool cse_load_node(Node *n) {
+    switch (n->kind) {
+    case ND_IDENT: case ND_DEREF: case ND_MEMBER: case ND_MEMBER_PTR: case ND_SUBSCRIPT:
+        return cse_type(n->type);
+    default:
+        return false;
+    }
+}
+
+/* Count of loads shaped like n in the function (n added when add) */
+static int cse_shape_count(Cse *c, Node *n, bool add) {
+    Buf b;
+    buf_init(&b);
+    cse_shape(&b, n);
+    buf_push(&b, '\0');
+    unsigned int h = cse_hash(b.data);
+    CseShape *s;
+    for (s = c->shapes[h]; s; s = s->next)
+        if (strcmp(s->key, b.data) == 0) break;
+    if (!s && add) {
+        s = arena_calloc(c->arena, sizeof(CseShape));
+        s->key = arena_strdup(c->arena, b.data);
+        s->next = c->shapes[h];
+        c->shapes[h] = s;
+    }
+    buf_free(&b);
+    if (s && add) s->count++;
+    return s ? s->count : 0;
+}
+
+/* Loads with side effects are counted too: their shapes contain the
+ * side effect and never match a pure load's */
+static void cse_scan_shapes(Node *n, void *ctx) {
+    Cse *c = ctx;
+    if (!n) return;
+    if (cse_load_node(n)) cse_shape_count(c, n, true);
+    node_visit_children(n, cse_scan_shapes, ctx);
+}
+
+/* True if parameter p of function fn is a restrict pointer that the body
+ * never reassigns or shadows, so every pointer based on it is derived from
+ * its initial value */
+static bool cse_is_restrictparam(Node *fn, Param *p) {
+    if (!p->type || p->type->kind != TY_PTR || !(p->type->qual & QUAL_RESTRICT)) return false;
+    return !node_writes_name(fn->func_body, p->name);
+}
+
+void cse_begin(Cse *c, Node *fn, bool on) {
+    memset(c->shapes, 0, sizeof(c->shapes));
+    c->params = NULL;
+    c->count = 0;
+    c->aside = 0;
+    c->on = on;
+    if (!on) return;
+    cse_scan_shapes(fn->func_body, c);
+    for (Param *p = fn->type->params; p; p = p->next) {
+        if (!p->name) continue;
+        CseParam *cp = arena_calloc(c->arena, sizeof(CseParam));
+        cp->name = p->name;
+        cp->array = p->type && type_is_array(p->type);
+        cp->is_restrict = cse_is_restrictparam(fn, p);
+        cp->next = c->params;
+        c->params = cp;
+    }
+}
+
+bool cse_candidate(Cse *c, Node *n, Type *ty) {
+    return c->on && cse_type(ty) && cse_shape_count(c, n, false) >= 2;
+}
+
+/* ---- Aliasing ---- */
+
+/* Type-based alias class of an access to lvalue n (C99 6.5p7): accesses
+ * of different nonzero classes never overlap.  0 may alias anything:
+ * character types, _Bool, aggregates and members of unions, which
+ * programs use to reinterpret bytes. */
+static int cse_alias_class(Node *n) {
+    Type *t = n->type;
+    for (Node *m = n; m; m = m->lhs) {
+        if (m->kind == ND_MEMBER) {
+            if (m->lhs->type && m->lhs->type->kind == TY_UNION) return 0;
+        } else if (m->kind == ND_MEMBER_PTR) {
+            Type *b = m->lhs->type ? m->lhs->type->base : NULL;
+            if (b && b->kind == TY_UNION) return 0;
+            break;
+        } else if (m->kind != ND_SUBSCRIPT || !m->lhs->type || !type_is_array(m->lhs->type)) {
+            break;
+        }
+    }
+    switch (t ? t->kind : TY_VOID) {
+    case TY_SHORT: return 1;
+    case TY_INT: case TY_LONG: case TY_ENUM: return 2;
+    case TY_LLONG: return 3;
+    case TY_FLOAT: return 4;
+    case TY_DOUBLE: case TY_LDOUBLE: return 5;
+    case TY_PTR: return 6;
+    default: return 0;
+    }
+}
+
+static CseParam *cse_param(Cse *c, const char *name) {
+    for (CseParam *p = c->params; p; p = p->next)
+        if (strcmp(p->name, name) == 0) return p;
+    return NULL;
+}
+
+static Node *cse_lvalue_base(Cse *c, Node *n);
+
+/* Restrict parameter or named object pointer expression p is based on,
+ * as its identifier, or NULL */
+static Node *cse_pointer_base(Cse *c, Node *p) {
+    for (;;) {
+        switch (p->kind) {
+        case ND_CAST:
+            p = p->cast_expr;
+            continue;
+        case ND_ADD: case ND_SUB:
+            p = p->rhs->type && type_is_ptr(p->rhs->type) && p->kind == ND_ADD ? p->rhs : p->lhs;
+            continue;
+        case ND_ADDR:
+            return cse_lvalue_base(c, p->lhs);
+        case ND_IDENT: {
+            CseParam *cp = cse_param(c, p->name);
+            if (cp && cp->is_restrict) return p;
+            return p->type && type_is_array(p->type) ? cse_lvalue_base(c, p) : NULL;
+        }
+        default:
+            return NULL;
+        }
+    }
+}
+
+/* Named object, or restrict pointer parameter, that lvalue n lies in or
+ * is reached through, as its identifier; NULL if unknown.  Bases are
+ * compared by name: names are resolved in the function's scope, and two
+ * objects sharing a name only make the check conservative.  Distinct
+ * bases never overlap: objects are disjoint, and an object modified
+ * through a restrict pointer is accessed only through it. */
+static Node *cse_lvalue_base(Cse *c, Node *n) {
+    for (;;) {
+        switch (n->kind) {
+        case ND_IDENT: {
+            /* Array parameters are pointers */
+            CseParam *cp = cse_param(c, n->name);
+            return cp && cp->array ? NULL : n;
+        }
+        case ND_MEMBER:
+            n = n->lhs;
+            continue;
+        case ND_SUBSCRIPT:
+            if (n->lhs->type && type_is_array(n->lhs->type)) {
+                n = n->lhs;
+                continue;
+            }
+            return cse_pointer_base(c, n->lhs->type && type_is_ptr(n->lhs->type) ? n->lhs : n->rhs);
+        case ND_DEREF: case ND_MEMBER_PTR:
+            return cse_pointer_base(c, n->lhs);
+        default:
+            return NULL;
+        }
+    }
+}
+
+/* True if base identifier id names an object defined const: stores to it
+ * are undefined */
+static bool cse_readonly(Cse *c, Node *id) {
+    CseParam *cp = id ? cse_param(c, id->name) : NULL;
+    Type *t = id && !(cp && cp->is_restrict) ? id->type : NULL;
+    while (t && type_is_array(t)) t = t->base;
+    return t && (t->qual & QUAL_CONST);
+}
+
+/* True if a store of alias class alias to base may change entry e */
+static bool cse_may_alias(CseLoad *e, int alias, const char *base) {
+    if (e->readonly) return false;
+    if (base && e->base && strcmp(base, e->base) != 0) return false;
+    return !alias || !e->alias || alias == e->alias;
+}
+
+/* ---- Entries ---- */
+
+const char *cse_find(Cse *c, const char *text) {
+    for (int i = 0; i < c->count; i++)
+        if (strcmp(c->loads[i].text, text) == 0) return c->loads[i].tmp;
+    return NULL;
+}
+
+void cse_add(Cse *c, Node *n, const char *text, const char *tmp) {
+    if (c->count == CSE_CACHE_SIZE) return;
+    Node *base = cse_lvalue_base(c, n);
+    CseLoad *e = &c->loads[c->count++];
+    e->text = arena_strdup(c->arena, text);
+    e->tmp = tmp;
+    e->seq = c->seq++;
+    e->alias = cse_alias_class(n);
+    e->base = base ? base->name : NULL;
+    e->readonly = cse_readonly(c, base);
+}
+
+void cse_store(Cse *c, Node *lv) {
+    int alias = cse_alias_class(lv);
+    Node *base = cse_lvalue_base(c, lv);
+    int k = 0;
+    for (int i = 0; i < c->count; i++)
+        if (!cse_may_alias(&c->loads[i], alias, base ? base->name : NULL))
+            c->loads[k++] = c->loads[i];
+    c->count = k;
+}
+
+int cse_mark(Cse *c) {
+    return c->seq;
+}
+
+void cse_drop(Cse *c, int mark) {
+    int k = 0;
+    for (int i = 0; i < c->count; i++)
+        if (c->loads[i].seq < mark) c->loads[k++] = c->loads[i];
+    c->count = k;
+}
+
+void cse_clear(Cse *c) {
+    c->count = 0;
+}
+
+static bool cse_ident_char(char ch) {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') ||
+           ch == '_';
+}
+
+/* An entry mentions name when it appears as a whole identifier, or as the
+ * start of one derived from it (name$h, name$field) */
+void cse_kill(Cse *c, const char *name) {
+    size_t len = strlen(name);
+    int k = 0;
+    for (int i = 0; i < c->count; i++) {
+        const char *t = c->loads[i].text;
+        bool uses = false;
+        for (const char *p = strstr(t, name); p && !uses; p = strstr(p + 1, name)) {
+            char before = p > t ? p[-1] : ' ';
+            char after = p[len];
+            uses = !cse_ident_char(before) && before != '$' && !cse_ident_char(after);
+        }
+        if (!uses) c->loads[k++] = c->loads[i];
+    }
+    c->count = k;
+}
@@ -0,0 +1,60 @@
+#ifndef C99JS_CSE_H
+#define C99JS_CSE_H
+
+#include "ast.h"
+
+/* Reuse of loads within a basic block.  Codegen renders a candidate load
+ * to its JS text and asks the cache for a temporary already holding that
+ * value; on a miss it assigns a fresh temporary where the load is first
+ * evaluated and records it.  Codegen reports what ends an entry: a store
+ * to memory (cse_store, which keeps the entries it cannot overwrite), a
+ * call (cse_clear), an assignment to a JS local (cse_kill), the end of a
+ * conditionally evaluated path (cse_drop back to a cse_mark) and a
+ * control-flow join (cse_clear).  Only loads whose shape occurs at least
+ * twice in the function are candidates, so a single load costs no
+ * temporary. */
+
+#define CSE_CACHE_SIZE 32
+#define CSE_TABLE_SIZE 256
+
+typedef struct CseShape CseShape;
+typedef struct CseParam CseParam;
+
+typedef struct {
+    const char *text;       /* JS of the load */
+    const char *tmp;        /* temporary holding its value */
+    int         seq;        /* definition order */
+    int         alias;      /* alias class of the loaded type (0: any) */
+    const char *base;       /* object or restrict pointer the address derives from */
+    bool        readonly;   /* load from an object defined const */
+} CseLoad;
+
+typedef struct {
+    Arena    *arena;
+    bool      on;                        /* reuse enabled in this function */
+    int       aside;                     /* rendering text that may be repeated: no new entries */
+    CseLoad   loads[CSE_CACHE_SIZE];
+    int       count;
+    int       seq;
+    CseShape *shapes[CSE_TABLE_SIZE];    /* load shapes of the function, with counts */
+    CseParam *params;                    /* parameters of the function */
+} Cse;
+
+void cse_init(Cse *c, Arena *a);
+/* Start function fn with reuse on or off: count its load shapes */
+void cse_begin(Cse *c, Node *fn, bool on);
+/* True if the load of lvalue n as type ty is worth keeping in a
+ * temporary; n must be free of side effects */
+bool cse_candidate(Cse *c, Node *n, Type *ty);
+/* Temporary holding the load rendered as text, or NULL */
+const char *cse_find(Cse *c, const char *text);
+/* Record that tmp now holds the load of lvalue n rendered as text */
+void cse_add(Cse *c, Node *n, const char *text, const char *tmp);
+/* Forget entries a store to memory lvalue lv may overwrite */
+void cse_store(Cse *c, Node *lv);
+int  cse_mark(Cse *c);
+void cse_drop(Cse *c, int mark);      /* forget entries made since mark */
+void cse_clear(Cse *c);
+void cse_kill(Cse *c, const char *name);  /* forget entries mentioning JS name */
+
+#endif /* C99JS_CSE_H */
@@ -0,0 +1,139 @@
+#include "dse.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define DSE_MAP_MAX 65536   /* larger objects are zeroed whole */
+
+/* Size as codegen lays the object out */
+static int dse_size(Type *t) {
+    return t->size > 0 ? t->size : 4;
+}
+
+/* ---- Zeroing ---- */
+
+/* True if init explicitly sets every member and element of the object,
+ * so it need not be zeroed first.  Designated initializers are assumed
+ * not to. */
+static bool dse_covers(Type *ty, Node *init) {
+    if (init->kind != ND_INIT_LIST) {
+        if (ty->kind == TY_ARRAY && init->kind == ND_STRING_LIT)
+            return init->slen + 1 >= dse_size(ty);
+        return !(ty->kind == TY_ARRAY);
+    }
+    if (ty->kind == TY_ARRAY) {
+        int n = 0;
+        for (Node *item = init->body; item; item = item->next, n++)
+            if (item->kind == ND_DESIGNATOR || !dse_covers(ty->base, item)) return false;
+        return ty->array_len > 0 && n == ty->array_len;
+    }
+    if (ty->kind == TY_STRUCT || ty->kind == TY_UNION) {
+        Member *m = ty->members;
+        Node *item = init->body;
+        if (ty->kind == TY_UNION && m && dse_size(m->type) != dse_size(ty)) return false;
+        for (; m; m = ty->kind == TY_UNION ? NULL : m->next, item = item->next) {
+            if (!item || item->kind == ND_DESIGNATOR || m->bit_width >= 0 ||
+                !dse_covers(m->type, item))
+                return false;
+        }
+        return true;
+    }
+    return init->body != NULL;
+}
+
+/* Mark in map the bytes of an object of type ty at off that codegen
+ * stores for initializer list init (padding is never marked, so it is
+ * still zeroed) */
+static void dse_mark(Type *ty, Node *init, int off, char *map, int size) {
+    if (!init) return;
+    if (init->kind == ND_INIT_LIST) {
+        if (ty->kind == TY_ARRAY) {
+            int idx = 0;
+            for (Node *item = init->body; item; item = item->next, idx++) {
+                if (item->kind == ND_DESIGNATOR && item->desig_index) {
+                    if (item->desig_index->kind == ND_INT_LIT) idx = (int)item->desig_index->ival;
+                    dse_mark(ty->base, item->desig_init, off + idx * dse_size(ty->base), map, size);
+                } else {
+                    dse_mark(ty->base, item, off + idx * dse_size(ty->base), map, size);
+                }
+            }
+        } else if (ty->kind == TY_STRUCT || ty->kind == TY_UNION) {
+            Member *m = ty->members;
+            for (Node *item = init->body; item; item = item->next) {
+                if (item->kind == ND_DESIGNATOR && item->desig_name) {
+                    m = type_find_member(ty, item->desig_name);
+                    if (m) dse_mark(m->type, item->desig_init, off + m->offset, map, size);
+                    if (m) m = m->next;
+                } else if (m) {
+                    dse_mark(m->type, item, off + m->offset, map, size);
+                    m = m->next;
+                }
+            }
+        } else if (init->body) {
+            dse_mark(ty, init->body, off, map, size);
+        }
+        return;
+    }
+    /* A leaf is stored whole */
+    for (int i = off < 0 ? 0 : off; i < off + dse_size(ty) && i < size; i++) map[i] = 1;
+}
+
+int dse_zero_runs(Type *ty, Node *init, DseRun *runs) {
+    int size = dse_size(ty);
+    if (dse_covers(ty, init)) return 0;
+    if (init->kind == ND_STRING_LIT) {
+        /* strcpy stores the string and its terminator */
+        runs[0].off = init->slen + 1;
+        runs[0].len = size - runs[0].off;
+        return 1;
+    }
+    if (ty->kind == TY_VLA || size <= 0 || size > DSE_MAP_MAX) return -1;
+
+    char *map = xcalloc((size_t)size, 1);
+    int n = 0;
+    dse_mark(ty, init, 0, map, size);
+    for (int i = 0; i < size && n <= DSE_RUNS_MAX; i++) {
+        if (map[i]) continue;
+        int j = i;
+        while (j < size && !map[j]) j++;
+        if (n < DSE_RUNS_MAX) {
+            runs[n].off = i;
+            runs[n].len = j - i;
+        }
+        n++;
+        i = j;
+    }
+    free(map);
+    return n > DSE_RUNS_MAX ? -1 : n;
+}
+
+/* ---- Struct results ---- */
+
+typedef struct {
+    const char *name;
+    bool        hit;
+} DseRefs;
+
+/* Sets hit if n mentions name at all */
+static void dse_scan_refs(Node *n, void *ctx) {
+    DseRefs *r = ctx;
+    if (!n || r->hit) return;
+    if ((n->kind == ND_IDENT && strcmp(n->name, r->name) == 0) ||
+        (n->kind == ND_VAR_DECL && n->var_name && strcmp(n->var_name, r->name) == 0)) {
+        r->hit = true;
+        return;
+    }
+    node_visit_children(n, dse_scan_refs, ctx);
+}
+
+/* The callee stores into its return pointer before it returns, so nothing
+ * it can reach may alias the destination: the arguments must not mention
+ * it, and no pointer to it may exist elsewhere.  The copy from a temporary
+ * is then a dead store. */
+bool dse_sret_into(Node *call, const char *name, Type *ty, bool escapes) {
+    if (escapes || (ty && (ty->qual & QUAL_VOLATILE))) return false;
+    DseRefs r;
+    r.name = name;
+    r.hit = false;
+    dse_scan_refs(call, &r);
+    return !r.hit;
+}
@@ -0,0 +1,29 @@
+#ifndef C99JS_DSE_H
+#define C99JS_DSE_H
+
+#include "ast.h"
+
+/* Dead stores to frame objects.  Before codegen initializes or assigns a
+ * local in the linear-memory frame, it asks which stores are needed: only
+ * the bytes an initializer leaves unset are zeroed, and a call returning a
+ * struct through the hidden return pointer may store straight into its
+ * destination instead of a temporary that is then copied. */
+
+#define DSE_RUNS_MAX 4      /* more gaps than this: zero the whole object */
+
+typedef struct {
+    int off;
+    int len;
+} DseRun;
+
+/* Byte runs of an object of type ty that init (an initializer list, or a
+ * string literal copied with its terminator) leaves unset, into runs;
+ * returns their number, or -1 if the whole object should be zeroed */
+int dse_zero_runs(Type *ty, Node *init, DseRun *runs);
+
+/* True if struct call `call` may store its result straight into the local
+ * named name, of type ty; escapes: the local may be reached other than by
+ * its name */
+bool dse_sret_into(Node *call, const char *name, Type *ty, bool escapes);
+
+#endif /* C99JS_DSE_H */
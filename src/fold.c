@@ -0,0 +1,635 @@
+#include "fold.h"
+#include <string.h>
+
+/* A compile-time constant.  Integers are held as 64-bit two's complement,
+ * sign-extended for signed types and zero-extended for unsigned ones, so
+ * that equal C values always have equal bit patterns. */
+typedef struct {
+    bool               is_float;
+    unsigned long long i;
+    double             f;
+} FoldVal;
+
+#define FOLD_SIGN_BIT (1ULL << 63)
+
+static void fold_node(Node *n, void *ctx);
+
+void fold_init(Fold *f, Arena *a, SymTab *st) {
+    f->arena = a;
+    f->symtab = st;
+    f->func = NULL;
+}
+
+/* ---- Types ---- */
+
+static bool fold_is_int_type(Type *t) {
+    return t && (type_is_integer(t) || t->kind == TY_PTR);
+}
+
+static bool fold_is_float_type(Type *t) {
+    return t && (t->kind == TY_FLOAT || t->kind == TY_DOUBLE || t->kind == TY_LDOUBLE);
+}
+
+static bool fold_is_signed(Type *t) {
+    return type_is_integer(t) && t->kind != TY_BOOL && !t->is_unsigned;
+}
+
+static int fold_bits(Type *t) {
+    return t->size * 8;
+}
+
+/* Reduce v to the width of integer type t */
+static unsigned long long fold_wrap(unsigned long long v, Type *t) {
+    if (t->kind == TY_BOOL) return v != 0;
+    int bits = fold_bits(t);
+    if (bits <= 0 || bits >= 64) return v;
+    unsigned long long mask = (1ULL << bits) - 1;
+    v &= mask;
+    if (fold_is_signed(t) && ((v >> (bits - 1)) & 1))
+        v |= ~mask;
+    return v;
+}
+
+static bool fold_finite(double d) {
+    return d == d && d - d == 0;
+}
+
+/* ---- Values ---- */
+
+/* Read the constant held by a literal node */
+static bool fold_const(Node *n, FoldVal *v) {
+    v->is_float = false;
+    v->i = 0;
+    v->f = 0;
+    if (!n || !n->type) return false;
+    switch (n->kind) {
+    case ND_INT_LIT:
+        /* Literals too wide for their parsed type are left alone */
+        if (!fold_is_int_type(n->type) || fold_wrap(n->ival, n->type) != n->ival)
+            return false;
+        v->i = n->ival;
+        return true;
+    case ND_CHAR_LIT:
+        v->i = fold_wrap((unsigned long long)(long long)n->cval, ty_int);
+        return true;
+    case ND_FLOAT_LIT:
+        if (!fold_is_float_type(n->type)) return false;
+        v->is_float = true;
+        v->f = n->fval;
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool fold_truth(FoldVal *v) {
+    return v->is_float ? v->f != 0 : v->i != 0;
+}
+
+static double fold_to_double(FoldVal *v, Type *t) {
+    if (v->is_float) return v->f;
+    if (fold_is_signed(t) && (v->i & FOLD_SIGN_BIT)) {
+        unsigned long long mag = 0 - v->i;
+        return -(double)mag;
+    }
+    return (double)v->i;
+}
+
+/* Convert v from type `from` to type `to`.  Fails when the result is not
+ * a representable constant (non-scalar target, out-of-range float). */
+static bool fold_convert(FoldVal *v, Type *from, Type *to) {
+    if (fold_is_float_type(to)) {
+        double d = fold_to_double(v, from);
+        if (to->kind == TY_FLOAT) d = (float)d;
+        v->is_float = true;
+        v->f = d;
+        v->i = 0;
+        return true;
+    }
+    if (!fold_is_int_type(to)) return false;
+    if (!v->is_float) {
+        v->i = fold_wrap(v->i, to);
+        return true;
+    }
+
+    double d = v->f;
+    v->is_float = false;
+    if (to->kind == TY_BOOL) {
+        v->i = d != 0;
+        return true;
+    }
+    double lim = 1;
+    for (int i = 1; i < fold_bits(to); i++) lim *= 2;
+    if (fold_is_signed(to)) {
+        if (!(d > -lim - 1 && d < lim)) return false;
+        if (d < 0) {
+            unsigned long long mag = (unsigned long long)-d;
+            v->i = fold_wrap(0 - mag, to);
+        } else {
+            v->i = (unsigned long long)d;
+        }
+    } else {
+        if (!(d > -1 && d < lim * 2)) return false;
+        v->i = (unsigned long long)d;
+    }
+    return true;
+}
+
+/* Rewrite n in place into a literal holding v; n keeps its type */
+static void fold_set(Node *n, FoldVal *v) {
+    n->lhs = NULL;
+    n->rhs = NULL;
+    n->third = NULL;
+    if (v->is_float) {
+        n->kind = ND_FLOAT_LIT;
+        n->fval = v->f;
+    } else {
+        n->kind = ND_INT_LIT;
+        n->ival = v->i;
+    }
+}
+
+/* Fold the value v of type `from` into n, converted to n's type */
+static void fold_set_as(Node *n, FoldVal *v, Type *from) {
+    if (!fold_convert(v, from, n->type)) return;
+    if (v->is_float && !fold_finite(v->f)) return;
+    fold_set(n, v);
+}
+
+/* Replace n by `with`, keeping n's place in its sibling list */
+static void fold_replace(Node *n, Node *with) {
+    Node *next = n->next;
+    *n = *with;
+    n->next = next;
+}
+
+/* ---- Integer arithmetic ---- */
+
+/* Evaluate a op b in integer type t; false on division by zero or
+ * signed-division overflow. */
+static bool fold_int_binop(NodeKind op, unsigned long long a, unsigned long long b,
+                           Type *t, unsigned long long *r) {
+    unsigned long long v;
+    switch (op) {
+    case ND_ADD:    v = a + b; break;
+    case ND_SUB:    v = a - b; break;
+    case ND_MUL:    v = a * b; break;
+    case ND_BITAND: v = a & b; break;
+    case ND_BITOR:  v = a | b; break;
+    case ND_BITXOR: v = a ^ b; break;
+    case ND_LSHIFT: v = a << b; break;
+    case ND_RSHIFT:
+        if (fold_is_signed(t) && (a & FOLD_SIGN_BIT)) {
+            unsigned long long inv = ~a;
+            inv >>= b;
+            v = ~inv;
+        } else {
+            v = a >> b;
+        }
+        break;
+    case ND_DIV: case ND_MOD: {
+        if (b == 0) return false;
+        if (!fold_is_signed(t)) {
+            v = op == ND_DIV ? a / b : a % b;
+            break;
+        }
+        bool na = (a & FOLD_SIGN_BIT) != 0, nb = (b & FOLD_SIGN_BIT) != 0;
+        unsigned long long ma = a, mb = b;
+        if (na) ma = 0 - a;
+        if (nb) mb = 0 - b;
+        /* INT_MIN / -1 overflows */
+        if (na && nb && mb == 1 && ma == (1ULL << (fold_bits(t) - 1))) return false;
+        unsigned long long q = op == ND_DIV ? ma / mb : ma % mb;
+        bool neg = op == ND_DIV ? na != nb : na;
+        v = q;
+        if (neg) v = 0 - q;
+        break;
+    }
+    default:
+        return false;
+    }
+    *r = fold_wrap(v, t);
+    return true;
+}
+
+static bool fold_float_binop(NodeKind op, double a, double b, double *r) {
+    switch (op) {
+    case ND_ADD: *r = a + b; return true;
+    case ND_SUB: *r = a - b; return true;
+    case ND_MUL: *r = a * b; return true;
+    case ND_DIV:
+        if (b == 0) return false;
+        *r = a / b;
+        return true;
+    default:
+        return false;
+    }
+}
+
+/* Compare two constants already converted to common type t */
+static int fold_compare(NodeKind op, FoldVal *a, FoldVal *b, Type *t) {
+    int lt, eq;
+    if (a->is_float) {
+        if (a->f != a->f || b->f != b->f) return op == ND_NE;
+        lt = a->f < b->f;
+        eq = a->f == b->f;
+    } else {
+        unsigned long long x = a->i, y = b->i;
+        if (fold_is_signed(t)) {
+            x ^= FOLD_SIGN_BIT;
+            y ^= FOLD_SIGN_BIT;
+        }
+        lt = x < y;
+        eq = x == y;
+    }
+    switch (op) {
+    case ND_LT: return lt;
+    case ND_LE: return lt || eq;
+    case ND_GT: return !lt && !eq;
+    case ND_GE: return !lt;
+    case ND_EQ: return eq;
+    default:    return !eq;
+    }
+}
+
+/* ---- Expressions ---- */
+
+typedef struct {
+    const char *name;
+    bool        found;
+} FoldDeclSearch;
+
+static void fold_find_decl(Node *n, void *ctx) {
+    FoldDeclSearch *s = ctx;
+    if (!n || s->found) return;
+    if (n->kind == ND_VAR_DECL && n->var_name && strcmp(n->var_name, s->name) == 0) {
+        s->found = true;
+        return;
+    }
+    node_visit_children(n, fold_find_decl, s);
+}
+
+/* True if the current function declares a local or parameter `name`,
+ * which would shadow a file-scope enum constant of the same name. */
+static bool fold_shadowed(Fold *f, const char *name) {
+    if (!f->func) return false;
+    FoldDeclSearch s;
+    s.name = name;
+    s.found = false;
+    fold_find_decl(f->func, &s);
+    return s.found;
+}
+
+static void fold_unary(Node *n) {
+    FoldVal a;
+    if (!fold_const(n->lhs, &a)) return;
+    Type *t = n->type;
+    if (n->kind == ND_NOT) {
+        bool truth = fold_truth(&a);
+        a.is_float = false;
+        a.i = !truth;
+        fold_set_as(n, &a, ty_int);
+        return;
+    }
+    if (!type_is_arithmetic(t) || !fold_convert(&a, n->lhs->type, t)) return;
+    if (n->kind == ND_NEG) {
+        if (a.is_float) a.f = -a.f;
+        else a.i = fold_wrap(0 - a.i, t);
+    } else if (n->kind == ND_BITNOT) {
+        if (a.is_float) return;
+        a.i = fold_wrap(~a.i, t);
+    }
+    fold_set_as(n, &a, t);
+}
+
+static void fold_binary(Fold *f, Node *n) {
+    FoldVal a, b;
+    if (!fold_const(n->lhs, &a) || !fold_const(n->rhs, &b)) return;
+    Type *lt = n->lhs->type, *rt = n->rhs->type, *t = n->type;
+    if (!type_is_arithmetic(lt) || !type_is_arithmetic(rt)) return;
+
+    switch (n->kind) {
+    case ND_LT: case ND_LE: case ND_GT: case ND_GE: case ND_EQ: case ND_NE: {
+        Type *common = type_usual_arith(f->arena, lt, rt);
+        if (!fold_convert(&a, lt, common) || !fold_convert(&b, rt, common)) return;
+        FoldVal r;
+        r.is_float = false;
+        r.f = 0;
+        r.i = (unsigned long long)fold_compare(n->kind, &a, &b, common);
+        fold_set_as(n, &r, ty_int);
+        return;
+    }
+    case ND_LSHIFT: case ND_RSHIFT: {
+        if (!type_is_integer(t) || a.is_float || b.is_float) return;
+        if (!fold_convert(&a, lt, t)) return;
+        if (fold_is_signed(rt) && (b.i & FOLD_SIGN_BIT)) return;
+        if (b.i >= (unsigned long long)fold_bits(t)) return;
+        if (!fold_int_binop(n->kind, a.i, b.i, t, &a.i)) return;
+        fold_set_as(n, &a, t);
+        return;
+    }
+    default:
+        break;
+    }
+
+    if (!type_is_arithmetic(t)) return;
+    if (!fold_convert(&a, lt, t) || !fold_convert(&b, rt, t)) return;
+    if (a.is_float) {
+        double r;
+        if (!fold_float_binop(n->kind, a.f, b.f, &r)) return;
+        a.f = r;
+    } else {
+        if (!fold_int_binop(n->kind, a.i, b.i, t, &a.i)) return;
+    }
+    fold_set_as(n, &a, t);
+}
+
+/* a && b, a || b: a constant left operand either decides the result or
+ * reduces the expression to b != 0. */
+static void fold_logical(Fold *f, Node *n) {
+    FoldVal a, b;
+    if (!fold_const(n->lhs, &a)) return;
+    bool truth = fold_truth(&a);
+    bool decided = n->kind == ND_AND ? !truth : truth;
+    FoldVal r;
+    r.is_float = false;
+    r.f = 0;
+    if (decided) {
+        r.i = truth;
+        fold_set_as(n, &r, ty_int);
+    } else if (fold_const(n->rhs, &b)) {
+        r.i = fold_truth(&b);
+        fold_set_as(n, &r, ty_int);
+    } else {
+        n->kind = ND_NE;
+        n->lhs = n->rhs;
+        n->rhs = node_int_lit(f->arena, 0, ty_int, n->loc);
+    }
+}
+
+static void fold_expr(Fold *f, Node *n);
+
+static void fold_ternary(Fold *f, Node *n) {
+    FoldVal c;
+    if (!fold_const(n->lhs, &c)) return;
+    Node *pick = fold_truth(&c) ? n->rhs : n->third;
+    if (!pick) return;
+    Type *t = n->type;
+    if (t && pick->type && (type_is_arithmetic(t) || t->kind == TY_PTR) &&
+        !type_is_compatible(pick->type, t)) {
+        Node *cast = node_new(f->arena, ND_CAST, n->loc);
+        cast->cast_type = t;
+        cast->cast_expr = pick;
+        cast->type = t;
+        fold_replace(n, cast);
+        fold_expr(f, n);
+    } else {
+        fold_replace(n, pick);
+    }
+}
+
+static void fold_expr(Fold *f, Node *n) {
+    if (!n->type) return;
+    switch (n->kind) {
+    case ND_IDENT: {
+        Symbol *sym = symtab_lookup(f->symtab, n->name);
+        if (!sym || sym->kind != SYM_ENUM_CONST || !fold_is_int_type(n->type)) return;
+        if (fold_shadowed(f, n->name)) return;
+        FoldVal v;
+        v.is_float = false;
+        v.f = 0;
+        v.i = (unsigned long long)sym->enum_val;
+        fold_set_as(n, &v, ty_llong);
+        return;
+    }
+    case ND_SIZEOF: case ND_SIZEOF_TYPE: {
+        Type *t = n->kind == ND_SIZEOF ? (n->lhs ? n->lhs->type : NULL) : n->cast_type;
+        if (!t || t->kind == TY_VLA || t->size <= 0 || !fold_is_int_type(n->type)) return;
+        FoldVal v;
+        v.is_float = false;
+        v.f = 0;
+        v.i = (unsigned long long)t->size;
+        fold_set_as(n, &v, ty_uint);
+        return;
+    }
+    case ND_CAST: {
+        FoldVal v;
+        Type *to = n->cast_type;
+        if (!to || !fold_const(n->cast_expr, &v)) return;
+        /* Only the null pointer constant folds to a pointer */
+        if (to->kind == TY_PTR && (v.is_float || v.i != 0)) return;
+        if (!fold_convert(&v, n->cast_expr->type, to)) return;
+        if (v.is_float && !fold_finite(v.f)) return;
+        n->type = to;
+        fold_set(n, &v);
+        return;
+    }
+    case ND_NEG: case ND_POS: case ND_NOT: case ND_BITNOT:
+        fold_unary(n);
+        return;
+    case ND_ADD: case ND_SUB: case ND_MUL: case ND_DIV: case ND_MOD:
+    case ND_LSHIFT: case ND_RSHIFT:
+    case ND_LT: case ND_LE: case ND_GT: case ND_GE: case ND_EQ: case ND_NE:
+    case ND_BITAND: case ND_BITOR: case ND_BITXOR:
+        fold_binary(f, n);
+        return;
+    case ND_AND: case ND_OR:
+        fold_logical(f, n);
+        return;
+    case ND_TERNARY:
+        fold_ternary(f, n);
+        return;
+    default:
+        return;
+    }
+}
+
+/* ---- Statements ---- */
+
+/* True if n contains a jump target (label, case or default), which keeps
+ * otherwise dead code reachable. */
+static void fold_find_label(Node *n, void *ctx) {
+    bool *found = ctx;
+    if (!n || *found) return;
+    if (n->kind == ND_LABEL || n->kind == ND_CASE || n->kind == ND_DEFAULT) {
+        *found = true;
+        return;
+    }
+    node_visit_children(n, fold_find_label, found);
+}
+
+static bool fold_has_label(Node *n) {
+    bool found = false;
+    fold_find_label(n, &found);
+    return found;
+}
+
+static void fold_make_null(Node *n) {
+    n->kind = ND_NULL_STMT;
+    n->lhs = NULL;
+    n->rhs = NULL;
+    n->third = NULL;
+}
+
+static void fold_stmt(Node *n) {
+    FoldVal c;
+    switch (n->kind) {
+    case ND_IF: {
+        if (!fold_const(n->lhs, &c)) return;
+        bool truth = fold_truth(&c);
+        Node *taken = truth ? n->rhs : n->third;
+        Node *dead = truth ? n->third : n->rhs;
+        if (dead && fold_has_label(dead)) return;
+        if (taken) fold_replace(n, taken);
+        else fold_make_null(n);
+        return;
+    }
+    case ND_WHILE:
+        if (fold_const(n->lhs, &c) && !fold_truth(&c) && !fold_has_label(n->rhs))
+            fold_make_null(n);
+        return;
+    case ND_CASE:
+        if (fold_const(n->case_expr, &c) && !c.is_float)
+            n->case_val = (long long)c.i;
+        return;
+    default:
+        return;
+    }
+}
+
+/* ---- Traversal ---- */
+
+/* Post-order: children are folded before their parent */
+static void fold_node(Node *n, void *ctx) {
+    Fold *f = ctx;
+    if (!n) return;
+    if (n->kind == ND_FUNC_DEF) {
+        Node *saved = f->func;
+        f->func = n;
+        node_visit_children(n, fold_node, f);
+        f->func = saved;
+        return;
+    }
+    /* The operand of sizeof is not evaluated */
+    if (n->kind != ND_SIZEOF)
+        node_visit_children(n, fold_node, f);
+    fold_expr(f, n);
+    fold_stmt(n);
+}
+
+void fold_program(Fold *f, Node *program) {
+    fold_node(program, f);
+}
+
+/* ---- Constant expressions for the parser ---- */
+
+/* Evaluate n into v of type *t.  The parser needs enum values, array
+ * sizes, bit-field widths and case labels before sema has typed the
+ * operators, so types are derived here the way sema would derive them. */
+static bool fold_eval(Node *n, FoldVal *v, Type **t) {
+    FoldVal b;
+    Type *lt, *rt;
+    if (!n) return false;
+    switch (n->kind) {
+    case ND_INT_LIT:
+    case ND_FLOAT_LIT:
+        *t = n->type;
+        return fold_const(n, v);
+    case ND_CHAR_LIT:
+        *t = ty_int;
+        return fold_const(n, v);
+    case ND_CAST:
+        if (!fold_eval(n->cast_expr, v, &lt)) return false;
+        *t = n->cast_type;
+        return fold_convert(v, lt, *t);
+    case ND_NOT:
+        if (!fold_eval(n->lhs, v, &lt)) return false;
+        v->i = !fold_truth(v);
+        v->is_float = false;
+        v->f = 0;
+        *t = ty_int;
+        return true;
+    case ND_NEG:
+    case ND_BITNOT:
+        if (!fold_eval(n->lhs, v, &lt) || !type_is_arithmetic(lt)) return false;
+        *t = type_int_promote(NULL, lt);
+        if (!fold_convert(v, lt, *t)) return false;
+        if (n->kind == ND_NEG) {
+            if (v->is_float) v->f = -v->f;
+            else v->i = fold_wrap(0 - v->i, *t);
+        } else {
+            if (v->is_float) return false;
+            v->i = fold_wrap(~v->i, *t);
+        }
+        return true;
+    case ND_AND:
+    case ND_OR: {
+        if (!fold_eval(n->lhs, v, &lt)) return false;
+        bool truth = fold_truth(v);
+        if (truth == (n->kind == ND_AND)) {
+            if (!fold_eval(n->rhs, v, &rt)) return false;
+            truth = fold_truth(v);
+        }
+        v->i = truth;
+        v->is_float = false;
+        v->f = 0;
+        *t = ty_int;
+        return true;
+    }
+    case ND_TERNARY: {
+        FoldVal c;
+        Type *ct;
+        if (!fold_eval(n->lhs, &c, &ct)) return false;
+        if (!fold_eval(n->rhs, v, &lt) || !fold_eval(n->third, &b, &rt)) return false;
+        if (!type_is_arithmetic(lt) || !type_is_arithmetic(rt)) return false;
+        *t = type_usual_arith(NULL, lt, rt);
+        if (!fold_truth(&c)) {
+            *v = b;
+            lt = rt;
+        }
+        return fold_convert(v, lt, *t);
+    }
+    case ND_LT: case ND_LE: case ND_GT: case ND_GE: case ND_EQ: case ND_NE: {
+        if (!fold_eval(n->lhs, v, &lt) || !fold_eval(n->rhs, &b, &rt)) return false;
+        if (!type_is_arithmetic(lt) || !type_is_arithmetic(rt)) return false;
+        Type *common = type_usual_arith(NULL, lt, rt);
+        if (!fold_convert(v, lt, common) || !fold_convert(&b, rt, common)) return false;
+        v->i = (unsigned long long)fold_compare(n->kind, v, &b, common);
+        v->is_float = false;
+        v->f = 0;
+        *t = ty_int;
+        return true;
+    }
+    case ND_LSHIFT: case ND_RSHIFT:
+        if (!fold_eval(n->lhs, v, &lt) || !fold_eval(n->rhs, &b, &rt)) return false;
+        if (!type_is_integer(lt) || !type_is_integer(rt)) return false;
+        *t = type_int_promote(NULL, lt);
+        if (!fold_convert(v, lt, *t)) return false;
+        if (fold_is_signed(rt) && (b.i & FOLD_SIGN_BIT)) return false;
+        if (b.i >= (unsigned long long)fold_bits(*t)) return false;
+        return fold_int_binop(n->kind, v->i, b.i, *t, &v->i);
+    case ND_ADD: case ND_SUB: case ND_MUL: case ND_DIV: case ND_MOD:
+    case ND_BITAND: case ND_BITOR: case ND_BITXOR:
+        if (!fold_eval(n->lhs, v, &lt) || !fold_eval(n->rhs, &b, &rt)) return false;
+        if (!type_is_arithmetic(lt) || !type_is_arithmetic(rt)) return false;
+        *t = type_usual_arith(NULL, lt, rt);
+        if (!fold_convert(v, lt, *t) || !fold_convert(&b, rt, *t)) return false;
+        if (v->is_float) {
+            double r;
+            if (!fold_float_binop(n->kind, v->f, b.f, &r)) return false;
+            v->f = r;
+            return true;
+        }
+        return fold_int_binop(n->kind, v->i, b.i, *t, &v->i);
+    default:
+        return false;
+    }
+}
+
+bool fold_eval_int(Node *n, long long *result) {
+    FoldVal v;
+    Type *t;
+    if (!fold_eval(n, &v, &t) || !fold_is_int_type(t)) return false;
+    *result = (long long)v.i;
+    return true;
+}
@@ -0,0 +1,25 @@
+#ifndef C99JS_FOLD_H
+#define C99JS_FOLD_H
+
+#include "ast.h"
+#include "symtab.h"
+
+/* Constant folding and dead-branch elimination.  Runs on the typed AST
+ * between sema_check and codegen; constant subexpressions are rewritten in
+ * place into ND_INT_LIT / ND_FLOAT_LIT nodes of the original type, with C
+ * wraparound for the type's width and signedness. */
+typedef struct {
+    Arena  *arena;
+    SymTab *symtab;
+    Node   *func;    /* function being folded (for enum-constant shadowing) */
+} Fold;
+
+void fold_init(Fold *f, Arena *a, SymTab *st);
+void fold_program(Fold *f, Node *program);
+
+/* Value of an integer constant expression as the parser sees it (untyped
+ * operators), with the same conversions and wraparound as fold_program.
+ * False if n is not constant. */
+bool fold_eval_int(Node *n, long long *result);
+
+#endif /* C99JS_FOLD_H */
@@ -0,0 +1,469 @@
+#include "inline.h"
+#include <stdio.h>
+#include <string.h>
+
+#define INLINE_MAX_NODES    40  /* body size limit for static functions */
+#define INLINE_MAX_NODES_KW 80  /* ... and for functions declared inline */
+#define INLINE_MAX_DEPTH     3  /* calls inlined from inside inlined bodies */
+#define INLINE_MAX_NAMES    32  /* parameters plus locals */
+
+enum { INL_UNKNOWN, INL_YES, INL_NO };
+
+struct InlineFn {
+    const char *name;
+    Node       *def;
+    int         state;
+    InlineFn   *next;
+};
+
+/* Callee names (parameters, locals) mapped to what replaces them in the
+ * caller: a fresh local or the argument expression itself */
+typedef struct {
+    Inliner    *in;
+    const char *from[INLINE_MAX_NAMES];
+    Node       *to[INLINE_MAX_NAMES];
+    int         count;
+    Node       *temps;     /* declarations of fresh locals, in order */
+    Node      **temps_tail;
+    bool        conflict;  /* a free name of the body is declared by the caller */
+} InlineMap;
+
+void inline_init(Inliner *in, Arena *a) {
+    memset(in, 0, sizeof(*in));
+    in->arena = a;
+}
+
+static unsigned int inl_hash(const char *name) {
+    unsigned int h = 0;
+    for (const char *p = name; *p; p++)
+        h = h * 31 + (unsigned char)*p;
+    return h % INLINE_TABLE_SIZE;
+}
+
+static InlineFn *inl_find(Inliner *in, const char *name) {
+    for (InlineFn *f = in->funcs[inl_hash(name)]; f; f = f->next)
+        if (strcmp(f->name, name) == 0) return f;
+    return NULL;
+}
+
+/* ---- Candidate analysis ---- */
+
+typedef struct {
+    const char *self;   /* function being analyzed */
+    int         nodes;
+    bool        bad;
+} InlineScan;
+
+static bool inl_is_call_to(Node *n, const char *name) {
+    return n->kind == ND_CALL && n->callee->kind == ND_IDENT &&
+           strcmp(n->callee->name, name) == 0;
+}
+
+/* Count nodes and reject constructs that cannot be moved into a caller */
+static void inl_scan_expr(Node *n, void *ctx) {
+    InlineScan *s = ctx;
+    if (!n || s->bad) return;
+    s->nodes++;
+    switch (n->kind) {
+    case ND_COMPOUND_LIT: case ND_VA_ARG:
+        s->bad = true;
+        return;
+    case ND_CALL:
+        if (inl_is_call_to(n, s->self) || inl_is_call_to(n, "setjmp") ||
+            inl_is_call_to(n, "longjmp") || inl_is_call_to(n, "va_start") ||
+            inl_is_call_to(n, "va_end") || inl_is_call_to(n, "va_copy")) {
+            s->bad = true;
+            return;
+        }
+        break;
+    default:
+        break;
+    }
+    node_visit_children(n, inl_scan_expr, s);
+}
+
+static bool inl_type_ok(Type *t) {
+    return t && t->kind != TY_ARRAY && t->kind != TY_VLA && t->kind != TY_FUNC &&
+           !(t->qual & QUAL_VOLATILE);
+}
+
+/* The statements of an if branch */
+static Node *inl_branch(Node *s) {
+    return s->kind == ND_BLOCK ? s->body : s;
+}
+
+/* Can statement list s, followed by list rest, become an expression?
+ * A non-void body must return on every path; *names counts the locals
+ * it declares. */
+static bool inl_stmts_ok(InlineScan *sc, Node *s, Node *rest, bool is_void, int *names) {
+    for (; s || rest; s = s->next) {
+        if (!s) {
+            s = rest;
+            rest = NULL;
+        }
+        switch (s->kind) {
+        case ND_NULL_STMT:
+            break;
+        case ND_EXPR_STMT:
+            inl_scan_expr(s->lhs, sc);
+            break;
+        case ND_VAR_DECL:
+            if (s->var_sc != SC_NONE && s->var_sc != SC_AUTO && s->var_sc != SC_REGISTER)
+                return false;
+            if (!inl_type_ok(s->type) || !s->var_name) return false;
+            if (s->var_init && s->var_init->kind == ND_INIT_LIST) return false;
+            if (rest) return false; /* its scope would leak into rest */
+            inl_scan_expr(s->var_init, sc);
+            (*names)++;
+            break;
+        case ND_RETURN:
+            if (s->next || is_void != !s->lhs) return false;
+            inl_scan_expr(s->lhs, sc);
+            return !sc->bad;
+        case ND_IF:
+            if (is_void) return false;
+            inl_scan_expr(s->lhs, sc);
+            if (!inl_stmts_ok(sc, inl_branch(s->rhs), NULL, false, names)) return false;
+            if (s->third) {
+                /* the then-branch returns, so the else-branch runs on
+                 * into the statements after the if */
+                return inl_stmts_ok(sc, inl_branch(s->third), s->next ? s->next : rest,
+                                    false, names);
+            }
+            break;
+        default:
+            return false;
+        }
+        if (sc->bad) return false;
+    }
+    return is_void;
+}
+
+static bool inl_check(InlineFn *f) {
+    Node *def = f->def;
+    Type *ft = def->type;
+    if (!def->func_body || def->func_body->kind != ND_BLOCK) return false;
+    if (def->func_sc != SC_STATIC && !def->func_is_inline) return false;
+    if (ft->is_variadic || strcmp(def->func_name, "main") == 0) return false;
+    Type *rt = ft->return_type;
+    bool is_void = type_is_void(rt);
+    if (!is_void && (!type_is_scalar(rt) || rt->kind == TY_COMPLEX)) return false;
+
+    int names = 0;
+    for (Param *p = ft->params; p; p = p->next) {
+        if (!inl_type_ok(p->type)) return false;
+        names++;
+    }
+    InlineScan sc;
+    sc.self = def->func_name;
+    sc.nodes = 0;
+    sc.bad = false;
+    if (!inl_stmts_ok(&sc, def->func_body->body, NULL, is_void, &names)) return false;
+    if (names > INLINE_MAX_NAMES) return false;
+    return sc.nodes <= (def->func_is_inline ? INLINE_MAX_NODES_KW : INLINE_MAX_NODES);
+}
+
+static InlineFn *inl_candidate(Inliner *in, Node *call) {
+    if (call->callee->kind != ND_IDENT || !call->callee->type ||
+        call->callee->type->kind != TY_FUNC)
+        return NULL;
+    InlineFn *f = inl_find(in, call->callee->name);
+    if (!f || f->def == in->func) return NULL;
+    if (f->state == INL_UNKNOWN) f->state = inl_check(f) ? INL_YES : INL_NO;
+    return f->state == INL_YES ? f : NULL;
+}
+
+/* ---- Parameter use ---- */
+
+typedef struct {
+    const char *name;
+    int         uses;
+    bool        written;   /* assigned or address taken */
+    bool        impure;    /* calls, or writes to anything but a body local */
+    Node       *def;
+} InlineUse;
+
+/* Is name a parameter or local of function def? */
+static void inl_find_decl(Node *n, void *ctx);
+
+typedef struct {
+    const char *name;
+    bool        found;
+} InlineDeclSearch;
+
+static void inl_find_decl(Node *n, void *ctx) {
+    InlineDeclSearch *s = ctx;
+    if (!n || s->found) return;
+    if (n->kind == ND_VAR_DECL && n->var_name && strcmp(n->var_name, s->name) == 0) {
+        s->found = true;
+        return;
+    }
+    node_visit_children(n, inl_find_decl, s);
+}
+
+static bool inl_declares(Node *def, const char *name) {
+    InlineDeclSearch s;
+    s.name = name;
+    s.found = false;
+    for (Param *p = def->type->params; p; p = p->next)
+        if (p->name && strcmp(p->name, name) == 0) return true;
+    inl_find_decl(def->func_body, &s);
+    return s.found;
+}
+
+static void inl_scan_use(Node *n, void *ctx) {
+    InlineUse *u = ctx;
+    if (!n) return;
+    switch (n->kind) {
+    case ND_IDENT:
+        if (strcmp(n->name, u->name) == 0) u->uses++;
+        return;
+    case ND_CALL:
+        u->impure = true;
+        break;
+    case ND_ADDR:
+    case ND_ASSIGN: case ND_ADD_ASSIGN: case ND_SUB_ASSIGN: case ND_MUL_ASSIGN:
+    case ND_DIV_ASSIGN: case ND_MOD_ASSIGN: case ND_LSHIFT_ASSIGN: case ND_RSHIFT_ASSIGN:
+    case ND_AND_ASSIGN: case ND_OR_ASSIGN: case ND_XOR_ASSIGN:
+    case ND_PRE_INC: case ND_PRE_DEC: case ND_POST_INC: case ND_POST_DEC: {
+        Node *root = node_lvalue_root(n->lhs);
+        if (root && strcmp(root->name, u->name) == 0) u->written = true;
+        if (n->kind != ND_ADDR && (!root || !inl_declares(u->def, root->name)))
+            u->impure = true;
+        break;
+    }
+    default:
+        break;
+    }
+    node_visit_children(n, inl_scan_use, u);
+}
+
+/* Arguments whose value cannot change while the body runs and that are
+ * cheap to repeat: constants and addresses of variables */
+static bool inl_arg_constant(Node *a) {
+    switch (a->kind) {
+    case ND_INT_LIT: case ND_FLOAT_LIT: case ND_CHAR_LIT:
+        return true;
+    case ND_ADDR:
+        return a->lhs->kind == ND_IDENT;
+    case ND_NEG: case ND_POS: case ND_BITNOT:
+        return inl_arg_constant(a->lhs);
+    case ND_CAST:
+        return inl_arg_constant(a->cast_expr);
+    default:
+        return false;
+    }
+}
+
+/* ---- Expression construction ---- */
+
+/* node_clone map: callee names become their bound arguments or temps */
+static Node *inl_subst(Node *n, void *ctx) {
+    InlineMap *m = ctx;
+    if (n->kind != ND_IDENT) return NULL;
+    for (int i = m->count - 1; i >= 0; i--)
+        if (strcmp(m->from[i], n->name) == 0)
+            return node_clone(m->in->arena, m->to[i], NULL, NULL);
+    if (inl_declares(m->in->func, n->name)) m->conflict = true;
+    return NULL;
+}
+
+/* n converted to type t, as sema would for an assignment */
+static Node *inl_convert(Arena *a, Node *n, Type *t) {
+    if (type_is_compatible(n->type, t)) return n;
+    Node *c = node_new(a, ND_CAST, n->loc);
+    c->cast_type = t;
+    c->cast_expr = n;
+    c->type = t;
+    return c;
+}
+
+static Node *inl_seq(Arena *a, Node *first, Node *then) {
+    if (!first) return then;
+    if (!then) return first;
+    Node *n = node_binary(a, ND_COMMA, first, then, first->loc);
+    n->type = then->type;
+    return n;
+}
+
+/* Declare a fresh caller local for callee name `name` of type t and map
+ * the name to it */
+static Node *inl_temp(InlineMap *m, const char *name, Type *t, SrcLoc loc) {
+    Arena *a = m->in->arena;
+    char buf[256];
+    snprintf(buf, sizeof(buf), "__inl%d_%s", m->in->counter++, name);
+    Node *decl = node_new(a, ND_VAR_DECL, loc);
+    decl->var_name = arena_strdup(a, buf);
+    decl->type = t;
+    decl->var_sc = SC_NONE;
+    *m->temps_tail = decl;
+    m->temps_tail = &decl->next;
+    Node *id = node_ident(a, decl->var_name, loc);
+    id->type = t;
+    m->from[m->count] = name;
+    m->to[m->count] = id;
+    m->count++;
+    return id;
+}
+
+static Node *inl_assign(Arena *a, Node *lhs, Node *rhs) {
+    rhs = inl_convert(a, rhs, lhs->type);
+    Node *n = node_binary(a, ND_ASSIGN, node_clone(a, lhs, NULL, NULL), rhs, rhs->loc);
+    n->type = lhs->type;
+    return n;
+}
+
+/* Expression equivalent to statement list s followed by list rest
+ * (NULL if it has no value) */
+static Node *inl_build(InlineMap *m, Node *s, Node *rest, Type *ret) {
+    Arena *a = m->in->arena;
+    for (; s || rest; s = s->next) {
+        if (!s) {
+            s = rest;
+            rest = NULL;
+        }
+        switch (s->kind) {
+        case ND_EXPR_STMT:
+            return inl_seq(a, node_clone(a, s->lhs, inl_subst, m), inl_build(m, s->next, rest, ret));
+        case ND_VAR_DECL: {
+            Node *init = node_clone(a, s->var_init, inl_subst, m);
+            Node *id = inl_temp(m, s->var_name, s->type, s->loc);
+            return inl_seq(a, init ? inl_assign(a, id, init) : NULL,
+                           inl_build(m, s->next, rest, ret));
+        }
+        case ND_RETURN:
+            return node_clone(a, s->lhs, inl_subst, m);
+        case ND_IF: {
+            Node *cond = node_clone(a, s->lhs, inl_subst, m);
+            int saved = m->count;
+            Node *then = inl_build(m, inl_branch(s->rhs), NULL, ret);
+            m->count = saved;
+            Node *els = s->third ? inl_build(m, inl_branch(s->third), s->next ? s->next : rest, ret)
+                                 : inl_build(m, s->next, rest, ret);
+            m->count = saved;
+            Node *n = node_new(a, ND_TERNARY, s->loc);
+            n->lhs = cond;
+            n->rhs = then;
+            n->third = els;
+            n->type = ret;
+            return n;
+        }
+        default:
+            break;
+        }
+    }
+    return NULL;
+}
+
+/* Replace call n to function f by f's body */
+static bool inl_expand(Inliner *in, Node *n, InlineFn *f) {
+    Node *def = f->def;
+    Arena *a = in->arena;
+    InlineMap m;
+    m.in = in;
+    m.count = 0;
+    m.temps = NULL;
+    m.temps_tail = &m.temps;
+    m.conflict = false;
+
+    /* The argument count must match before any link is cut */
+    int nargs = 0;
+    Node *arg = n->args;
+    for (Param *p = def->type->params; p; p = p->next, arg = arg->next, nargs++)
+        if (!arg) return false;
+    if (arg) return false;
+    Node **argv = arena_alloc(a, (size_t)(nargs + 1) * sizeof(Node *));
+    nargs = 0;
+    for (arg = n->args; arg; arg = arg->next) argv[nargs++] = arg;
+
+    /* Bind the arguments */
+    Node *binds = NULL;
+    arg = n->args;
+    for (Param *p = def->type->params; p; p = p->next) {
+        Node *next = arg->next;
+        arg->next = NULL;
+        InlineUse u;
+        u.name = p->name;
+        u.uses = 0;
+        u.written = false;
+        u.impure = false;
+        u.def = def;
+        if (p->name) inl_scan_use(def->func_body, &u);
+        bool is_var = arg->kind == ND_IDENT && !(arg->type->qual & QUAL_VOLATILE);
+        bool stable = inl_arg_constant(arg) ||
+                      (is_var && !u.impure && !inl_declares(def, arg->name));
+        if (!p->name || u.uses == 0) {
+            /* unused: keep only the side effects */
+            if (!inl_arg_constant(arg) && !is_var) binds = inl_seq(a, binds, arg);
+        } else if (stable && !u.written) {
+            m.from[m.count] = p->name;
+            m.to[m.count] = inl_convert(a, arg, p->type);
+            m.count++;
+        } else {
+            Node *id = inl_temp(&m, p->name, p->type, arg->loc);
+            binds = inl_seq(a, binds, inl_assign(a, id, arg));
+        }
+        arg = next;
+    }
+
+    Node *body = inl_build(&m, def->func_body->body, NULL, def->type->return_type);
+    if (m.conflict) {
+        /* The call stays: relink its arguments */
+        for (int i = 0; i + 1 < nargs; i++) argv[i]->next = argv[i + 1];
+        return false;
+    }
+    Node *e = inl_seq(a, binds, body);
+    if (!e) e = node_int_lit(a, 0, ty_int, n->loc);
+
+    /* Commit: fresh locals go to the top of the caller */
+    if (m.temps) {
+        Node *block = in->func->func_body;
+        *m.temps_tail = block->body;
+        block->body = m.temps;
+    }
+    Node *next = n->next;
+    *n = *e;
+    n->next = next;
+    return true;
+}
+
+/* ---- Traversal ---- */
+
+static void inl_node(Node *n, void *ctx) {
+    Inliner *in = ctx;
+    if (!n) return;
+    /* The operand of sizeof is not evaluated */
+    if (n->kind != ND_SIZEOF)
+        node_visit_children(n, inl_node, in);
+    if (n->kind != ND_CALL || in->depth >= INLINE_MAX_DEPTH) return;
+    InlineFn *f = inl_candidate(in, n);
+    if (f && inl_expand(in, n, f)) {
+        /* Calls inside the inlined body */
+        in->depth++;
+        node_visit_children(n, inl_node, in);
+        in->depth--;
+    }
+}
+
+void inline_program(Inliner *in, Node *program) {
+    for (Node *n = program->body; n; n = n->next) {
+        if (n->kind != ND_FUNC_DEF || !n->func_body) continue;
+        InlineFn *f = inl_find(in, n->func_name);
+        if (!f) {
+            unsigned int h = inl_hash(n->func_name);
+            f = arena_calloc(in->arena, sizeof(InlineFn));
+            f->name = n->func_name;
+            f->next = in->funcs[h];
+            in->funcs[h] = f;
+        }
+        f->def = n;
+    }
+    for (Node *n = program->body; n; n = n->next) {
+        if (n->kind != ND_FUNC_DEF || !n->func_body) continue;
+        if (node_contains_setjmp(n->func_body)) continue;
+        in->func = n;
+        in->depth = 0;
+        inl_node(n->func_body, in);
+    }
+    in->func = NULL;
+}
@@ -0,0 +1,28 @@
+#ifndef C99JS_INLINE_H
+#define C99JS_INLINE_H
+
+#include "ast.h"
+
+/* Function inlining.  Runs on the typed AST between sema_check and fold:
+ * a call to a small static or inline function whose body reduces to an
+ * expression (expression statements, local declarations, if/return) is
+ * replaced by that expression.  Parameters and locals become fresh locals
+ * of the caller unless the argument can be substituted directly.
+ * Recursive, variadic and setjmp-using functions are never inlined. */
+
+#define INLINE_TABLE_SIZE 256
+
+typedef struct InlineFn InlineFn;
+
+typedef struct {
+    Arena    *arena;
+    InlineFn *funcs[INLINE_TABLE_SIZE]; /* function definitions by name */
+    Node     *func;     /* caller being rewritten */
+    int       counter;  /* suffix for fresh local names */
+    int       depth;    /* inlining depth inside an inlined body */
+} Inliner;
+
+void inline_init(Inliner *in, Arena *a);
+void inline_program(Inliner *in, Node *program);
+
+#endif /* C99JS_INLINE_H */
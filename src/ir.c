@@ -0,0 +1,1248 @@
+#include "ir.h"
+#include <stdio.h>
+#include <string.h>
+
+/* A C variable in scope while lowering */
+typedef struct IrVar {
+    const char *name;
+    Type       *type;        /* declared type (arrays not decayed) */
+    int         index;       /* SSA variable, or -1 */
+    int         slot;        /* frame offset when it lives in memory */
+    bool        global;      /* block-scope extern: the global of that name */
+    struct IrVar *next;
+} IrVar;
+
+typedef struct IrName {
+    const char *name;
+    struct IrName *next;
+} IrName;
+
+typedef struct {
+    Arena   *arena;
+    SymTab  *symtab;
+    IrFunc  *f;
+    IrBlock *cur;            /* block being filled; NULL after a terminator */
+    IrBlock *tail;           /* last block of f */
+    IrVar   *vars;           /* in scope, innermost first */
+    IrName  *addr_taken;     /* names whose address is taken */
+    int      nvars;          /* SSA variables handed out */
+    int      max_vars;       /* ... and the room in each block's defs */
+    int      stack;          /* frame bytes allocated */
+    IrBlock *brk, *cont;     /* targets of break and continue */
+} IrLower;
+
+/* Where an lvalue lives: an SSA variable or an address */
+typedef struct {
+    int     var;
+    IrInst *addr;
+    IrType  type;
+    Type   *ctype;
+} IrLval;
+
+static IrInst *ir_expr(IrLower *L, Node *n);
+static void ir_stmt(IrLower *L, Node *n);
+
+static IrType ir_type(Type *t) {
+    if (!t) return IRT_NONE;
+    switch (t->kind) {
+    case TY_VOID:  return IRT_VOID;
+    case TY_BOOL:  return IRT_BOOL;
+    case TY_CHAR:  return t->is_unsigned ? IRT_U8 : IRT_I8;
+    case TY_SHORT: return t->is_unsigned ? IRT_U16 : IRT_I16;
+    case TY_INT: case TY_LONG: case TY_ENUM:
+        return t->is_unsigned ? IRT_U32 : IRT_I32;
+    case TY_PTR: case TY_ARRAY: case TY_FUNC:
+        return IRT_PTR;
+    case TY_FLOAT: return IRT_F32;
+    case TY_DOUBLE: case TY_LDOUBLE:
+        return IRT_F64;
+    default:
+        return IRT_NONE;
+    }
+}
+
+static bool ir_is_float(IrType t) {
+    return t == IRT_F32 || t == IRT_F64;
+}
+
+static void ir_fail(IrLower *L, const char *why) {
+    if (!L->f->error) L->f->error = why;
+}
+
+/* v with removed phis forwarded */
+static IrInst *ir_value(IrInst *v) {
+    while (v && v->forward) v = v->forward;
+    return v;
+}
+
+/* ---- Construction ---- */
+
+static IrBlock *ir_block(IrLower *L) {
+    IrBlock *b = arena_calloc(L->arena, sizeof(IrBlock));
+    b->id = L->f->nblocks++;
+    b->defs = arena_calloc(L->arena, sizeof(IrInst *) * (L->max_vars > 0 ? L->max_vars : 1));
+    if (L->tail) L->tail->next = b;
+    else L->f->entry = b;
+    L->tail = b;
+    return b;
+}
+
+/* Block for code that follows a terminator: reachable only through a
+ * label, which the IR does not have, so it has no predecessors */
+static IrBlock *ir_cur(IrLower *L) {
+    if (!L->cur) {
+        L->cur = ir_block(L);
+        L->cur->sealed = true;
+    }
+    return L->cur;
+}
+
+static IrInst *ir_new(IrLower *L, IrOp op, IrType type, int nargs) {
+    IrInst *v = arena_calloc(L->arena, sizeof(IrInst));
+    v->op = op;
+    v->type = type;
+    v->id = L->f->nvalues++;
+    v->nargs = nargs;
+    if (nargs > 0) v->args = arena_calloc(L->arena, sizeof(IrInst *) * nargs);
+    return v;
+}
+
+/* Appends an instruction to the current block */
+static IrInst *ir_emit(IrLower *L, IrOp op, IrType type, int nargs) {
+    IrBlock *b = ir_cur(L);
+    IrInst *v = ir_new(L, op, type, nargs);
+    v->block = b;
+    if (b->last) b->last->next = v;
+    else b->first = v;
+    b->last = v;
+    return v;
+}
+
+/* Operands (constants, parameters, addresses) belong to no block */
+static IrInst *ir_const(IrLower *L, IrType t, int val) {
+    IrInst *v = ir_new(L, IR_CONST, t, 0);
+    switch (t) {
+    case IRT_BOOL: val = val != 0; break;
+    case IRT_I8:   val = (signed char)val; break;
+    case IRT_U8:   val = val & 255; break;
+    case IRT_I16:  val = (short)val; break;
+    case IRT_U16:  val = val & 65535; break;
+    default: break;
+    }
+    v->ival = val;
+    return v;
+}
+
+static IrInst *ir_fconst(IrLower *L, IrType t, double val) {
+    IrInst *v = ir_new(L, IR_FCONST, t, 0);
+    v->fval = t == IRT_F32 ? (double)(float)val : val;
+    return v;
+}
+
+static IrInst *ir_operand(IrLower *L, IrOp op, const char *name, int ival) {
+    IrInst *v = ir_new(L, op, IRT_PTR, 0);
+    v->name = name;
+    v->ival = ival;
+    return v;
+}
+
+static IrInst *ir_op1(IrLower *L, IrOp op, IrType t, IrInst *a) {
+    IrInst *v = ir_emit(L, op, t, 1);
+    v->args[0] = a;
+    return v;
+}
+
+static IrInst *ir_op2(IrLower *L, IrOp op, IrType t, IrInst *a, IrInst *b) {
+    IrInst *v = ir_emit(L, op, t, 2);
+    v->args[0] = a;
+    v->args[1] = b;
+    return v;
+}
+
+static IrInst *ir_conv(IrLower *L, IrInst *v, IrType t) {
+    if (t == IRT_NONE || v->type == IRT_NONE) {
+        ir_fail(L, "value of unsupported type");
+        return v;
+    }
+    if (v->type == t || t == IRT_VOID) return v;
+    if (v->type == IRT_VOID) {
+        ir_fail(L, "void value used");
+        return ir_const(L, t, 0);
+    }
+    if (v->op == IR_CONST && !ir_is_float(t)) {
+        return ir_const(L, t, v->ival);
+    }
+    if (v->op == IR_CONST && ir_is_float(t)) {
+        bool u = v->type == IRT_U32 || v->type == IRT_PTR;
+        return ir_fconst(L, t, u ? (double)(unsigned)v->ival : (double)v->ival);
+    }
+    return ir_op1(L, IR_CONV, t, v);
+}
+
+static void ir_add_pred(IrLower *L, IrBlock *b, IrBlock *pred) {
+    /* Edges out of unreachable code are not control flow */
+    if (pred->npreds == 0 && pred != L->f->entry) return;
+    if (b->npreds == b->pred_cap) {
+        int cap = b->pred_cap ? b->pred_cap * 2 : 4;
+        IrBlock **p = arena_alloc(L->arena, sizeof(IrBlock *) * cap);
+        if (b->npreds) memcpy(p, b->preds, sizeof(IrBlock *) * b->npreds);
+        b->preds = p;
+        b->pred_cap = cap;
+    }
+    b->preds[b->npreds++] = pred;
+}
+
+static void ir_jump(IrLower *L, IrBlock *to) {
+    IrBlock *from = ir_cur(L);
+    ir_emit(L, IR_JUMP, IRT_VOID, 0);
+    from->succ[0] = to;
+    from->nsucc = 1;
+    ir_add_pred(L, to, from);
+    L->cur = NULL;
+}
+
+static void ir_branch(IrLower *L, IrInst *cond, IrBlock *t, IrBlock *f) {
+    IrBlock *from = ir_cur(L);
+    IrInst *br = ir_emit(L, IR_BRANCH, IRT_VOID, 1);
+    br->args[0] = cond;
+    from->succ[0] = t;
+    from->succ[1] = f;
+    from->nsucc = 2;
+    ir_add_pred(L, t, from);
+    ir_add_pred(L, f, from);
+    L->cur = NULL;
+}
+
+/* ---- SSA construction ----
+ * Variables are read and written per block; a read in a block without a
+ * definition looks through its predecessors, placing a phi where they
+ * meet.  Blocks whose predecessors are not all known yet (loop headers)
+ * get operand-less phis that are filled in when the block is sealed
+ * (Braun et al., "Simple and Efficient Construction of SSA Form"). */
+
+static IrInst *ir_read(IrLower *L, IrBlock *b, int var, IrType t);
+
+static IrInst *ir_phi(IrLower *L, IrBlock *b, IrType t, int var) {
+    IrInst *phi = ir_new(L, IR_PHI, t, 0);
+    phi->block = b;
+    phi->ival = var;
+    phi->nargs = -1;
+    IrInst **tail = &b->phis;
+    while (*tail) tail = &(*tail)->next;
+    *tail = phi;
+    return phi;
+}
+
+static void ir_phi_fill(IrLower *L, IrInst *phi) {
+    IrBlock *b = phi->block;
+    phi->args = arena_calloc(L->arena, sizeof(IrInst *) * (b->npreds > 0 ? b->npreds : 1));
+    phi->nargs = b->npreds;
+    for (int i = 0; i < b->npreds; i++)
+        phi->args[i] = ir_read(L, b->preds[i], phi->ival, phi->type);
+}
+
+static IrInst *ir_read(IrLower *L, IrBlock *b, int var, IrType t) {
+    if (b->defs[var]) return ir_value(b->defs[var]);
+    IrInst *v;
+    if (!b->sealed) {
+        v = ir_phi(L, b, t, var);
+    } else if (b->npreds == 0) {
+        v = ir_const(L, t, 0);      /* read before any assignment */
+    } else if (b->npreds == 1) {
+        v = ir_read(L, b->preds[0], var, t);
+    } else {
+        v = ir_phi(L, b, t, var);
+        b->defs[var] = v;           /* breaks cycles through loops */
+        ir_phi_fill(L, v);
+    }
+    b->defs[var] = v;
+    return v;
+}
+
+static void ir_seal(IrLower *L, IrBlock *b) {
+    for (IrInst *phi = b->phis; phi; phi = phi->next)
+        if (phi->nargs < 0) ir_phi_fill(L, phi);
+    b->sealed = true;
+}
+
+/* Phis whose operands are all one value (or the phi itself) are replaced
+ * by that value, until none is left */
+static void ir_remove_trivial_phis(IrLower *L) {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (IrBlock *b = L->f->entry; b; b = b->next) {
+            for (IrInst *phi = b->phis; phi; phi = phi->next) {
+                if (phi->forward) continue;
+                IrInst *same = NULL;
+                bool trivial = true;
+                for (int i = 0; i < phi->nargs && trivial; i++) {
+                    IrInst *a = ir_value(phi->args[i]);
+                    if (a == phi || a == same) continue;
+                    if (same) trivial = false;
+                    same = a;
+                }
+                if (!trivial) continue;
+                phi->forward = same ? same : ir_const(L, phi->type, 0);
+                changed = true;
+            }
+        }
+    }
+    for (IrBlock *b = L->f->entry; b; b = b->next) {
+        IrInst **link = &b->phis;
+        while (*link) {
+            if ((*link)->forward) *link = (*link)->next;
+            else link = &(*link)->next;
+        }
+        for (IrInst *phi = b->phis; phi; phi = phi->next)
+            for (int i = 0; i < phi->nargs; i++) phi->args[i] = ir_value(phi->args[i]);
+        for (IrInst *v = b->first; v; v = v->next)
+            for (int i = 0; i < v->nargs; i++) v->args[i] = ir_value(v->args[i]);
+    }
+}
+
+/* ---- Variables ---- */
+
+static IrVar *ir_var_find(IrLower *L, const char *name) {
+    for (IrVar *v = L->vars; v; v = v->next)
+        if (strcmp(v->name, name) == 0) return v;
+    return NULL;
+}
+
+static bool ir_addr_taken(IrLower *L, const char *name) {
+    for (IrName *n = L->addr_taken; n; n = n->next)
+        if (strcmp(n->name, name) == 0) return true;
+    return false;
+}
+
+static void ir_scan_addr(Node *n, void *ctx) {
+    if (!n) return;
+    IrLower *L = ctx;
+    if (n->kind == ND_ADDR && n->lhs && n->lhs->kind == ND_IDENT && !ir_addr_taken(L, n->lhs->name)) {
+        IrName *a = arena_calloc(L->arena, sizeof(IrName));
+        a->name = n->lhs->name;
+        a->next = L->addr_taken;
+        L->addr_taken = a;
+    }
+    if (n->kind == ND_VAR_DECL) L->max_vars++;
+    node_visit_children(n, ir_scan_addr, ctx);
+}
+
+static IrVar *ir_var_push(IrLower *L, const char *name, Type *type) {
+    IrVar *v = arena_calloc(L->arena, sizeof(IrVar));
+    v->name = name;
+    v->type = type;
+    v->index = -1;
+    v->next = L->vars;
+    L->vars = v;
+    return v;
+}
+
+static int ir_alloc(IrLower *L, Type *t) {
+    int size = t->size > 0 ? t->size : 4;
+    int align = t->align > 0 ? t->align : 1;
+    L->stack = (L->stack + size + align - 1) & ~(align - 1);
+    return -L->stack;
+}
+
+/* Declared type of the object an identifier names */
+static Type *ir_ident_type(IrLower *L, Node *n) {
+    IrVar *v = ir_var_find(L, n->name);
+    if (v && !v->global) return v->type;
+    Symbol *sym = symtab_lookup(L->symtab, n->name);
+    return sym ? sym->type : n->type;
+}
+
+/* ---- Addresses ---- */
+
+/* p + i * size (or minus), in pointer arithmetic */
+static IrInst *ir_ptr_add(IrLower *L, IrInst *p, IrInst *i, int size, bool sub) {
+    IrInst *off = ir_conv(L, i, IRT_I32);
+    if (off->op == IR_CONST) {
+        off = ir_const(L, IRT_I32, (int)((unsigned)off->ival * (unsigned)size));
+        if (off->ival == 0) return ir_conv(L, p, IRT_PTR);
+    } else if (size != 1) {
+        off = ir_op2(L, IR_MUL, IRT_I32, off, ir_const(L, IRT_I32, size));
+    }
+    return ir_op2(L, sub ? IR_SUB : IR_ADD, IRT_PTR, ir_conv(L, p, IRT_PTR), off);
+}
+
+static int ir_elem_size(Type *ptr) {
+    Type *b = ptr ? ptr->base : NULL;
+    return b && b->size > 0 ? b->size : 1;
+}
+
+static IrInst *ir_addr(IrLower *L, Node *n);
+
+static Member *ir_member(IrLower *L, Node *n) {
+    Type *st = NULL;
+    if (n->kind == ND_MEMBER) st = n->lhs->type;
+    else if (n->lhs->type && (type_is_ptr(n->lhs->type) || type_is_array(n->lhs->type)))
+        st = n->lhs->type->base;
+    if (!st || (st->kind != TY_STRUCT && st->kind != TY_UNION)) {
+        ir_fail(L, "member of a non-struct");
+        return NULL;
+    }
+    Member *m = type_find_member(st, n->name);
+    if (!m) {
+        ir_fail(L, "unknown member");
+        return NULL;
+    }
+    if (m->bit_width >= 0) {
+        ir_fail(L, "bit-field member");
+        return NULL;
+    }
+    return m;
+}
+
+static IrInst *ir_member_addr(IrLower *L, Node *n, Member **mem) {
+    Member *m = ir_member(L, n);
+    *mem = m;
+    IrInst *base = n->kind == ND_MEMBER ? ir_addr(L, n->lhs) : ir_expr(L, n->lhs);
+    if (!m) return base;
+    return ir_ptr_add(L, base, ir_const(L, IRT_I32, m->offset), 1, false);
+}
+
+/* Address of element n (an ND_SUBSCRIPT) */
+static IrInst *ir_index(IrLower *L, Node *n) {
+    Node *base = n->lhs, *idx = n->rhs;
+    if (!(base->type && (type_is_ptr(base->type) || type_is_array(base->type)))) {
+        base = n->rhs;
+        idx = n->lhs;
+    }
+    int size = n->type && n->type->size > 0 ? n->type->size : 1;
+    IrInst *p = ir_expr(L, base);
+    return ir_ptr_add(L, p, ir_expr(L, idx), size, false);
+}
+
+static IrInst *ir_addr(IrLower *L, Node *n) {
+    switch (n->kind) {
+    case ND_IDENT: {
+        IrVar *v = ir_var_find(L, n->name);
+        if (v && !v->global) {
+            if (v->index >= 0) ir_fail(L, "address of a register variable");
+            return ir_operand(L, IR_SLOT, v->name, v->slot);
+        }
+        Symbol *sym = symtab_lookup(L->symtab, n->name);
+        if (sym && sym->kind == SYM_FUNC) return ir_operand(L, IR_FUNC, n->name, 0);
+        if (!sym || sym->kind != SYM_VAR) ir_fail(L, "unknown identifier");
+        return ir_operand(L, IR_GLOBAL, n->name, 0);
+    }
+    case ND_DEREF:
+        return ir_expr(L, n->lhs);
+    case ND_SUBSCRIPT:
+        return ir_index(L, n);
+    case ND_MEMBER: case ND_MEMBER_PTR: {
+        Member *m;
+        return ir_member_addr(L, n, &m);
+    }
+    case ND_STRING_LIT: {
+        IrInst *s = ir_operand(L, IR_STR, NULL, n->slen);
+        s->str = n->sval;
+        return s;
+    }
+    default:
+        ir_fail(L, "address of an unsupported expression");
+        return ir_const(L, IRT_PTR, 0);
+    }
+}
+
+static bool ir_lval(IrLower *L, Node *n, IrLval *lv) {
+    memset(lv, 0, sizeof(*lv));
+    lv->var = -1;
+    if (n->kind == ND_IDENT) {
+        IrVar *v = ir_var_find(L, n->name);
+        if (v && !v->global && v->index >= 0) {
+            lv->var = v->index;
+            lv->ctype = v->type;
+            lv->type = ir_type(v->type);
+            return true;
+        }
+        lv->ctype = ir_ident_type(L, n);
+    } else if (n->kind == ND_MEMBER || n->kind == ND_MEMBER_PTR) {
+        Member *m = NULL;
+        lv->addr = ir_member_addr(L, n, &m);
+        lv->ctype = m ? m->type : n->type;
+        lv->type = ir_type(lv->ctype);
+        return lv->type != IRT_NONE;
+    } else {
+        lv->ctype = n->type;
+    }
+    lv->addr = ir_addr(L, n);
+    lv->type = ir_type(lv->ctype);
+    if (lv->ctype && (lv->ctype->kind == TY_ARRAY || lv->ctype->kind == TY_FUNC))
+        lv->type = IRT_NONE;
+    return lv->type != IRT_NONE;
+}
+
+static IrInst *ir_load(IrLower *L, IrLval *lv) {
+    if (lv->var >= 0) return ir_read(L, ir_cur(L), lv->var, lv->type);
+    return ir_op1(L, IR_LOAD, lv->type, lv->addr);
+}
+
+static void ir_store(IrLower *L, IrLval *lv, IrInst *val) {
+    if (lv->var >= 0) {
+        ir_cur(L)->defs[lv->var] = val;
+        return;
+    }
+    ir_op2(L, IR_STORE, lv->type, lv->addr, val);
+}
+
+/* Value of an object whose type is ty at address addr: arrays and
+ * functions are their address, scalars are loaded */
+static IrInst *ir_object(IrLower *L, Type *ty, IrInst *addr) {
+    if (ty && (ty->kind == TY_ARRAY || ty->kind == TY_FUNC)) return addr;
+    IrType t = ir_type(ty);
+    if (t == IRT_NONE || t == IRT_VOID) {
+        ir_fail(L, ty && (ty->kind == TY_STRUCT || ty->kind == TY_UNION)
+                   ? "struct value" : "value of unsupported type");
+        return ir_const(L, IRT_I32, 0);
+    }
+    return ir_op1(L, IR_LOAD, t, addr);
+}
+
+/* ---- Expressions ---- */
+
+static void ir_cond(IrLower *L, Node *n, IrBlock *t, IrBlock *f);
+
+static IrOp ir_binop(NodeKind k) {
+    switch (k) {
+    case ND_ADD: case ND_ADD_ASSIGN: return IR_ADD;
+    case ND_SUB: case ND_SUB_ASSIGN: return IR_SUB;
+    case ND_MUL: case ND_MUL_ASSIGN: return IR_MUL;
+    case ND_DIV: case ND_DIV_ASSIGN: return IR_DIV;
+    case ND_MOD: case ND_MOD_ASSIGN: return IR_MOD;
+    case ND_LSHIFT: case ND_LSHIFT_ASSIGN: return IR_SHL;
+    case ND_RSHIFT: case ND_RSHIFT_ASSIGN: return IR_SHR;
+    case ND_BITAND: case ND_AND_ASSIGN: return IR_AND;
+    case ND_BITOR: case ND_OR_ASSIGN: return IR_OR;
+    case ND_BITXOR: case ND_XOR_ASSIGN: return IR_XOR;
+    case ND_EQ: return IR_EQ;
+    case ND_NE: return IR_NE;
+    case ND_LT: return IR_LT;
+    case ND_LE: return IR_LE;
+    case ND_GT: return IR_GT;
+    default:    return IR_GE;
+    }
+}
+
+static IrInst *ir_zero(IrLower *L, IrType t) {
+    return ir_is_float(t) ? ir_fconst(L, t, 0.0) : ir_const(L, t, 0);
+}
+
+/* a op b for arithmetic (non-pointer) operands in type t */
+static IrInst *ir_arith(IrLower *L, IrOp op, IrType t, IrInst *a, IrInst *b) {
+    a = ir_conv(L, a, t);
+    b = ir_conv(L, b, op == IR_SHL || op == IR_SHR ? IRT_I32 : t);
+    return ir_op2(L, op, t, a, b);
+}
+
+/* Type of the operation between values of C types a and b */
+static IrType ir_common(IrLower *L, Type *a, Type *b) {
+    if (!a || !b || !type_is_arithmetic(a) || !type_is_arithmetic(b)) return IRT_PTR;
+    return ir_type(type_usual_arith(L->arena, a, b));
+}
+
+static IrInst *ir_compare(IrLower *L, IrOp op, Node *lhs, Node *rhs) {
+    IrInst *a = ir_expr(L, lhs);
+    IrInst *b = ir_expr(L, rhs);
+    IrType t = a->type == IRT_PTR || b->type == IRT_PTR ? IRT_PTR : ir_common(L, lhs->type, rhs->type);
+    a = ir_conv(L, a, t);
+    b = ir_conv(L, b, t);
+    return ir_op2(L, op, IRT_I32, a, b);
+}
+
+static IrInst *ir_additive(IrLower *L, Node *n) {
+    Type *lt = n->lhs->type, *rt = n->rhs->type;
+    bool lp = lt && (type_is_ptr(lt) || type_is_array(lt));
+    bool rp = rt && (type_is_ptr(rt) || type_is_array(rt));
+    IrOp op = ir_binop(n->kind);
+    if (lp && rp && n->kind == ND_SUB) {
+        IrInst *a = ir_conv(L, ir_expr(L, n->lhs), IRT_I32);
+        IrInst *b = ir_conv(L, ir_expr(L, n->rhs), IRT_I32);
+        IrInst *d = ir_op2(L, IR_SUB, IRT_I32, a, b);
+        int size = ir_elem_size(lt);
+        return size == 1 ? d : ir_op2(L, IR_DIV, IRT_I32, d, ir_const(L, IRT_I32, size));
+    }
+    if (lp && !rp) {
+        IrInst *p = ir_expr(L, n->lhs);
+        return ir_ptr_add(L, p, ir_expr(L, n->rhs), ir_elem_size(lt), n->kind == ND_SUB);
+    }
+    if (rp && !lp && n->kind == ND_ADD) {
+        IrInst *i = ir_expr(L, n->lhs);
+        return ir_ptr_add(L, ir_expr(L, n->rhs), i, ir_elem_size(rt), false);
+    }
+    IrInst *a = ir_expr(L, n->lhs);
+    IrInst *b = ir_expr(L, n->rhs);
+    return ir_arith(L, op, ir_type(n->type), a, b);
+}
+
+/* && and || as values: branches to a join with a phi of 1 and 0 */
+static IrInst *ir_logical(IrLower *L, Node *n) {
+    IrBlock *t = ir_block(L), *f = ir_block(L), *join = ir_block(L);
+    ir_cond(L, n, t, f);
+    ir_seal(L, t);
+    ir_seal(L, f);
+    L->cur = t;
+    ir_jump(L, join);
+    L->cur = f;
+    ir_jump(L, join);
+    ir_seal(L, join);
+    L->cur = join;
+    IrInst *phi = ir_phi(L, join, IRT_I32, -1);
+    phi->args = arena_calloc(L->arena, sizeof(IrInst *) * 2);
+    phi->nargs = 2;
+    phi->args[0] = ir_const(L, IRT_I32, 1);
+    phi->args[1] = ir_const(L, IRT_I32, 0);
+    return phi;
+}
+
+static IrInst *ir_ternary(IrLower *L, Node *n) {
+    IrType rt = ir_type(n->type);
+    if (rt == IRT_NONE) {
+        ir_fail(L, "struct value");
+        return ir_const(L, IRT_I32, 0);
+    }
+    IrBlock *t = ir_block(L), *f = ir_block(L), *join = ir_block(L);
+    ir_cond(L, n->lhs, t, f);
+    ir_seal(L, t);
+    ir_seal(L, f);
+    L->cur = t;
+    IrInst *a = ir_conv(L, ir_expr(L, n->rhs), rt);
+    ir_jump(L, join);
+    L->cur = f;
+    IrInst *b = ir_conv(L, ir_expr(L, n->third), rt);
+    ir_jump(L, join);
+    ir_seal(L, join);
+    L->cur = join;
+    if (rt == IRT_VOID) return ir_const(L, IRT_VOID, 0);
+    IrInst *phi = ir_phi(L, join, rt, -1);
+    phi->args = arena_calloc(L->arena, sizeof(IrInst *) * 2);
+    phi->nargs = 2;
+    phi->args[0] = a;
+    phi->args[1] = b;
+    return phi;
+}
+
+static IrInst *ir_assign(IrLower *L, Node *n) {
+    IrLval lv;
+    if (!ir_lval(L, n->lhs, &lv)) {
+        ir_fail(L, "assignment of an aggregate");
+        return ir_const(L, IRT_I32, 0);
+    }
+    IrInst *v;
+    if (n->kind == ND_ASSIGN) {
+        v = ir_conv(L, ir_expr(L, n->rhs), lv.type);
+    } else {
+        IrInst *old = ir_load(L, &lv);
+        IrOp op = ir_binop(n->kind);
+        Type *lt = lv.ctype;
+        if (lv.type == IRT_PTR && (op == IR_ADD || op == IR_SUB)) {
+            /* sema converted the integer operand to the pointer type */
+            Node *r = n->rhs;
+            if (r->kind == ND_CAST && r->cast_expr && type_is_integer(r->cast_expr->type))
+                r = r->cast_expr;
+            v = ir_ptr_add(L, old, ir_expr(L, r), ir_elem_size(lt), op == IR_SUB);
+        } else {
+            IrInst *b = ir_expr(L, n->rhs);
+            IrType t = op == IR_SHL || op == IR_SHR
+                ? ir_type(type_int_promote(L->arena, lt)) : ir_common(L, lt, n->rhs->type);
+            v = ir_conv(L, ir_arith(L, op, t, old, b), lv.type);
+        }
+    }
+    ir_store(L, &lv, v);
+    return v;
+}
+
+static IrInst *ir_incdec(IrLower *L, Node *n) {
+    IrLval lv;
+    if (!ir_lval(L, n->lhs, &lv)) {
+        ir_fail(L, "increment of an unsupported object");
+        return ir_const(L, IRT_I32, 0);
+    }
+    bool dec = n->kind == ND_PRE_DEC || n->kind == ND_POST_DEC;
+    IrInst *old = ir_load(L, &lv), *v;
+    if (lv.type == IRT_PTR) {
+        v = ir_ptr_add(L, old, ir_const(L, IRT_I32, 1), ir_elem_size(lv.ctype), dec);
+    } else if (ir_is_float(lv.type)) {
+        v = ir_op2(L, dec ? IR_SUB : IR_ADD, lv.type, old, ir_fconst(L, lv.type, 1.0));
+    } else {
+        IrType t = lv.type == IRT_U32 ? IRT_U32 : IRT_I32;
+        v = ir_conv(L, ir_arith(L, dec ? IR_SUB : IR_ADD, t, old, ir_const(L, t, 1)), lv.type);
+    }
+    ir_store(L, &lv, v);
+    return n->kind == ND_PRE_INC || n->kind == ND_PRE_DEC ? v : old;
+}
+
+static bool ir_unsupported_call(const char *name) {
+    static const char *names[] = {
+        "va_start", "va_end", "va_copy", "setjmp", "longjmp", "alloca", NULL
+    };
+    for (int i = 0; names[i]; i++)
+        if (strcmp(name, names[i]) == 0) return true;
+    return strncmp(name, "__builtin", 9) == 0;
+}
+
+static IrInst *ir_call(IrLower *L, Node *n) {
+    Node *callee = n->callee;
+    const char *name = NULL;
+    if (callee->kind == ND_IDENT && !ir_var_find(L, callee->name)) {
+        Symbol *sym = symtab_lookup(L->symtab, callee->name);
+        if (sym && sym->kind == SYM_FUNC) name = callee->name;
+    }
+    if (name && ir_unsupported_call(name)) {
+        ir_fail(L, "call to a compiler builtin");
+        return ir_const(L, IRT_I32, 0);
+    }
+    Type *ft = callee->type;
+    if (ft && ft->kind == TY_PTR) ft = ft->base;
+    IrType ret = ir_type(n->type);
+    if (!ft || ft->kind != TY_FUNC || ret == IRT_NONE) {
+        ir_fail(L, "call returning an aggregate");
+        return ir_const(L, IRT_I32, 0);
+    }
+    int argc = 0;
+    for (Node *a = n->args; a; a = a->next) argc++;
+    IrInst *fnval = name ? NULL : ir_expr(L, callee);
+    IrInst **vals = arena_calloc(L->arena, sizeof(IrInst *) * (argc > 0 ? argc : 1));
+    Param *p = ft->params;
+    int k = 0;
+    for (Node *a = n->args; a; a = a->next, k++) {
+        IrInst *v = ir_expr(L, a);
+        if (p) {
+            v = ir_conv(L, v, ir_type(p->type));
+            p = p->next;
+        } else if (v->type == IRT_NONE || v->type == IRT_VOID) {
+            ir_fail(L, "aggregate argument");
+        }
+        vals[k] = v;
+    }
+    int base = name ? 0 : 1;
+    IrInst *call = ir_emit(L, IR_CALL, ret, base + argc);
+    call->name = name;
+    if (!name) call->args[0] = fnval;
+    for (k = 0; k < argc; k++) call->args[base + k] = vals[k];
+    return call;
+}
+
+static IrInst *ir_expr(IrLower *L, Node *n) {
+    switch (n->kind) {
+    case ND_INT_LIT: {
+        IrType t = ir_type(n->type);
+        if (t == IRT_NONE) {
+            ir_fail(L, "long long value");
+            t = IRT_I32;
+        }
+        return ir_const(L, t, (int)(unsigned)n->ival);
+    }
+    case ND_CHAR_LIT:
+        return ir_const(L, IRT_I32, n->cval);
+    case ND_FLOAT_LIT:
+        return ir_fconst(L, n->type && n->type->kind == TY_FLOAT ? IRT_F32 : IRT_F64, n->fval);
+    case ND_STRING_LIT:
+        return ir_addr(L, n);
+
+    case ND_IDENT: {
+        IrVar *v = ir_var_find(L, n->name);
+        if (v && !v->global && v->index >= 0)
+            return ir_read(L, ir_cur(L), v->index, ir_type(v->type));
+        if (!v) {
+            Symbol *sym = symtab_lookup(L->symtab, n->name);
+            if (sym && sym->kind == SYM_FUNC) return ir_operand(L, IR_FUNC, n->name, 0);
+            if (sym && sym->kind == SYM_ENUM_CONST) return ir_const(L, IRT_I32, (int)sym->enum_val);
+        }
+        return ir_object(L, ir_ident_type(L, n), ir_addr(L, n));
+    }
+
+    case ND_NEG: case ND_POS: case ND_BITNOT: {
+        IrType t = ir_type(n->type);
+        IrInst *a = ir_conv(L, ir_expr(L, n->lhs), t);
+        if (n->kind == ND_POS) return a;
+        return ir_op1(L, n->kind == ND_NEG ? IR_NEG : IR_BITNOT, t, a);
+    }
+    case ND_NOT: {
+        IrInst *a = ir_expr(L, n->lhs);
+        return ir_op2(L, IR_EQ, IRT_I32, a, ir_zero(L, a->type));
+    }
+
+    case ND_ADD: case ND_SUB:
+        return ir_additive(L, n);
+    case ND_MUL: case ND_DIV: case ND_MOD:
+    case ND_LSHIFT: case ND_RSHIFT:
+    case ND_BITAND: case ND_BITOR: case ND_BITXOR: {
+        IrInst *a = ir_expr(L, n->lhs);
+        IrInst *b = ir_expr(L, n->rhs);
+        return ir_arith(L, ir_binop(n->kind), ir_type(n->type), a, b);
+    }
+    case ND_EQ: case ND_NE: case ND_LT: case ND_LE: case ND_GT: case ND_GE:
+        return ir_compare(L, ir_binop(n->kind), n->lhs, n->rhs);
+    case ND_AND: case ND_OR:
+        return ir_logical(L, n);
+    case ND_TERNARY:
+        return ir_ternary(L, n);
+
+    case ND_ASSIGN:
+    case ND_ADD_ASSIGN: case ND_SUB_ASSIGN: case ND_MUL_ASSIGN:
+    case ND_DIV_ASSIGN: case ND_MOD_ASSIGN:
+    case ND_LSHIFT_ASSIGN: case ND_RSHIFT_ASSIGN:
+    case ND_AND_ASSIGN: case ND_OR_ASSIGN: case ND_XOR_ASSIGN:
+        return ir_assign(L, n);
+    case ND_PRE_INC: case ND_PRE_DEC: case ND_POST_INC: case ND_POST_DEC:
+        return ir_incdec(L, n);
+
+    case ND_DEREF:
+        return ir_object(L, n->type, ir_expr(L, n->lhs));
+    case ND_ADDR:
+        return ir_addr(L, n->lhs);
+    case ND_SUBSCRIPT:
+        return ir_object(L, n->type, ir_index(L, n));
+    case ND_MEMBER: case ND_MEMBER_PTR: {
+        Member *m = NULL;
+        IrInst *addr = ir_member_addr(L, n, &m);
+        return ir_object(L, m ? m->type : n->type, addr);
+    }
+
+    case ND_CAST: {
+        IrInst *v = ir_expr(L, n->cast_expr);
+        if (n->cast_type && n->cast_type->kind == TY_VOID) return ir_const(L, IRT_VOID, 0);
+        return ir_conv(L, v, ir_type(n->cast_type));
+    }
+    case ND_COMMA:
+        ir_expr(L, n->lhs);
+        return ir_expr(L, n->rhs);
+    case ND_CALL:
+        return ir_call(L, n);
+
+    case ND_SIZEOF_TYPE:
+    case ND_SIZEOF: {
+        Type *t = n->kind == ND_SIZEOF_TYPE ? n->cast_type
+                : n->lhs->kind == ND_IDENT ? ir_ident_type(L, n->lhs) : n->lhs->type;
+        if (!t || t->kind == TY_VLA || t->size < 0) ir_fail(L, "sizeof of a variable-length array");
+        return ir_const(L, IRT_U32, t ? t->size : 0);
+    }
+
+    default:
+        ir_fail(L, "unsupported expression");
+        return ir_const(L, IRT_I32, 0);
+    }
+}
+
+/* Branch to t when n is true, to f otherwise */
+static void ir_cond(IrLower *L, Node *n, IrBlock *t, IrBlock *f) {
+    if (n->kind == ND_AND || n->kind == ND_OR) {
+        IrBlock *mid = ir_block(L);
+        if (n->kind == ND_AND) ir_cond(L, n->lhs, mid, f);
+        else ir_cond(L, n->lhs, t, mid);
+        ir_seal(L, mid);
+        L->cur = mid;
+        ir_cond(L, n->rhs, t, f);
+        return;
+    }
+    if (n->kind == ND_NOT) {
+        ir_cond(L, n->lhs, f, t);
+        return;
+    }
+    IrInst *v = ir_expr(L, n);
+    if (ir_is_float(v->type)) v = ir_op2(L, IR_NE, IRT_I32, v, ir_zero(L, v->type));
+    if (v->type == IRT_VOID || v->type == IRT_NONE) ir_fail(L, "condition of unsupported type");
+    ir_branch(L, v, t, f);
+}
+
+/* ---- Statements ---- */
+
+static void ir_call_lib(IrLower *L, const char *name, IrInst *a, IrInst *b, IrInst *c) {
+    IrInst *call = ir_emit(L, IR_CALL, IRT_VOID, 3);
+    call->name = name;
+    call->args[0] = a;
+    call->args[1] = b;
+    call->args[2] = c;
+}
+
+static void ir_memset(IrLower *L, IrInst *addr, int size) {
+    IrInst *zero = ir_const(L, IRT_I32, 0);
+    ir_call_lib(L, "memset", addr, zero, ir_const(L, IRT_U32, size));
+}
+
+/* Initializer of a local in memory: scalars, and arrays of scalars from
+ * a flat list or a string */
+static void ir_init(IrLower *L, IrVar *v, Node *init) {
+    Type *ty = v->type;
+    IrInst *addr = ir_operand(L, IR_SLOT, v->name, v->slot);
+    IrType t = ir_type(ty);
+    if (ty->kind != TY_ARRAY) {
+        if (t == IRT_NONE) {
+            ir_fail(L, "aggregate initializer");
+            return;
+        }
+        if (init->kind == ND_INIT_LIST) init = init->body;
+        IrLval lv = { -1, addr, t, ty };
+        if (init) ir_store(L, &lv, ir_conv(L, ir_expr(L, init), t));
+        return;
+    }
+    Type *elem = ty->base;
+    IrType et = ir_type(elem);
+    if (!elem || et == IRT_NONE || elem->kind == TY_ARRAY || ty->array_len < 0) {
+        ir_fail(L, "aggregate initializer");
+        return;
+    }
+    if (init->kind == ND_STRING_LIT && elem->size == 1) {
+        int n = init->slen + 1 < ty->size ? init->slen + 1 : ty->size;
+        IrInst *s = ir_operand(L, IR_STR, NULL, init->slen);
+        s->str = init->sval;
+        if (n < ty->size)
+            ir_memset(L, addr, ty->size);
+        ir_call_lib(L, "memcpy", addr, s, ir_const(L, IRT_U32, n));
+        return;
+    }
+    if (init->kind != ND_INIT_LIST) {
+        ir_fail(L, "aggregate initializer");
+        return;
+    }
+    int count = 0;
+    for (Node *e = init->body; e; e = e->next) {
+        if (e->kind == ND_DESIGNATOR || e->kind == ND_INIT_LIST || count >= ty->array_len) {
+            ir_fail(L, "aggregate initializer");
+            return;
+        }
+        count++;
+    }
+    if (count < ty->array_len)
+        ir_memset(L, addr, ty->size);
+    int k = 0;
+    for (Node *e = init->body; e; e = e->next, k++) {
+        IrInst *val = ir_conv(L, ir_expr(L, e), et);
+        IrLval lv = { -1, ir_ptr_add(L, addr, ir_const(L, IRT_I32, k), elem->size, false), et, elem };
+        ir_store(L, &lv, val);
+    }
+}
+
+static void ir_decl(IrLower *L, Node *d) {
+    if (d->var_sc == SC_TYPEDEF) return;
+    if (d->var_sc == SC_EXTERN) {
+        ir_var_push(L, d->var_name, d->type)->global = true;
+        return;
+    }
+    if (d->var_sc == SC_STATIC) {
+        ir_fail(L, "static local");
+        return;
+    }
+    Type *ty = d->type;
+    if (!ty || ty->kind == TY_VLA) {
+        ir_fail(L, "variable-length array");
+        return;
+    }
+    IrType t = ir_type(ty);
+    bool scalar = t != IRT_NONE && t != IRT_VOID && ty->kind != TY_ARRAY && ty->kind != TY_FUNC;
+    IrVar *v = ir_var_push(L, d->var_name, ty);
+    if (scalar && !ir_addr_taken(L, d->var_name) && L->nvars < L->max_vars) {
+        v->index = L->nvars++;
+        Node *init = d->var_init;
+        if (init && init->kind == ND_INIT_LIST) init = init->body;
+        if (init) {
+            IrInst *val = ir_conv(L, ir_expr(L, init), t);   /* may end the block */
+            ir_cur(L)->defs[v->index] = val;
+        }
+        return;
+    }
+    if (!scalar && ty->kind != TY_ARRAY && ty->kind != TY_STRUCT && ty->kind != TY_UNION) {
+        ir_fail(L, "local of unsupported type");
+        return;
+    }
+    v->slot = ir_alloc(L, ty);
+    if (d->var_init) ir_init(L, v, d->var_init);
+}
+
+static void ir_loop_body(IrLower *L, Node *body, IrBlock *brk, IrBlock *cont) {
+    IrBlock *saved_brk = L->brk, *saved_cont = L->cont;
+    L->brk = brk;
+    L->cont = cont;
+    ir_stmt(L, body);
+    L->brk = saved_brk;
+    L->cont = saved_cont;
+}
+
+static void ir_stmt(IrLower *L, Node *n) {
+    if (!n) return;
+    switch (n->kind) {
+    case ND_BLOCK: {
+        IrVar *mark = L->vars;
+        for (Node *s = n->body; s; s = s->next) ir_stmt(L, s);
+        L->vars = mark;
+        break;
+    }
+    case ND_EXPR_STMT:
+        if (n->lhs) ir_expr(L, n->lhs);
+        break;
+    case ND_VAR_DECL:
+        ir_decl(L, n);
+        break;
+    case ND_NULL_STMT:
+    case ND_TYPEDEF:
+        break;
+
+    case ND_IF: {
+        IrBlock *t = ir_block(L), *f = ir_block(L);
+        IrBlock *join = n->third ? ir_block(L) : f;
+        ir_cond(L, n->lhs, t, f);
+        ir_seal(L, t);
+        L->cur = t;
+        ir_stmt(L, n->rhs);
+        ir_jump(L, join);
+        if (n->third) {
+            ir_seal(L, f);
+            L->cur = f;
+            ir_stmt(L, n->third);
+            ir_jump(L, join);
+        }
+        ir_seal(L, join);
+        L->cur = join;
+        break;
+    }
+    case ND_WHILE: {
+        IrBlock *head = ir_block(L), *body = ir_block(L), *exit = ir_block(L);
+        ir_jump(L, head);
+        L->cur = head;
+        ir_cond(L, n->lhs, body, exit);
+        ir_seal(L, body);
+        L->cur = body;
+        ir_loop_body(L, n->rhs, exit, head);
+        ir_jump(L, head);
+        ir_seal(L, head);
+        ir_seal(L, exit);
+        L->cur = exit;
+        break;
+    }
+    case ND_DO_WHILE: {
+        IrBlock *body = ir_block(L), *latch = ir_block(L), *exit = ir_block(L);
+        ir_jump(L, body);
+        L->cur = body;
+        ir_loop_body(L, n->rhs, exit, latch);
+        ir_jump(L, latch);
+        ir_seal(L, latch);
+        L->cur = latch;
+        ir_cond(L, n->lhs, body, exit);
+        ir_seal(L, body);
+        ir_seal(L, exit);
+        L->cur = exit;
+        break;
+    }
+    case ND_FOR: {
+        IrVar *mark = L->vars;
+        if (n->for_init) {
+            if (n->for_init->kind == ND_VAR_DECL) {
+                for (Node *d = n->for_init; d; d = d->next) ir_decl(L, d);
+            } else {
+                ir_expr(L, n->for_init);
+            }
+        }
+        IrBlock *head = ir_block(L), *body = ir_block(L), *latch = ir_block(L), *exit = ir_block(L);
+        ir_jump(L, head);
+        L->cur = head;
+        if (n->for_cond) ir_cond(L, n->for_cond, body, exit);
+        else ir_jump(L, body);
+        ir_seal(L, body);
+        L->cur = body;
+        ir_loop_body(L, n->for_body, exit, latch);
+        ir_jump(L, latch);
+        ir_seal(L, latch);
+        L->cur = latch;
+        if (n->for_inc) ir_expr(L, n->for_inc);
+        ir_jump(L, head);
+        ir_seal(L, head);
+        ir_seal(L, exit);
+        L->cur = exit;
+        L->vars = mark;
+        break;
+    }
+    case ND_BREAK:
+    case ND_CONTINUE: {
+        IrBlock *to = n->kind == ND_BREAK ? L->brk : L->cont;
+        if (!to) {
+            ir_fail(L, "break out of a switch");
+            break;
+        }
+        ir_jump(L, to);
+        break;
+    }
+    case ND_RETURN: {
+        IrInst *v = n->lhs ? ir_conv(L, ir_expr(L, n->lhs), L->f->ret) : NULL;
+        IrInst *ret = ir_emit(L, IR_RET, IRT_VOID, v && L->f->ret != IRT_VOID ? 1 : 0);
+        if (ret->nargs) ret->args[0] = v;
+        L->cur = NULL;
+        break;
+    }
+
+    case ND_SWITCH: case ND_CASE: case ND_DEFAULT:
+        ir_fail(L, "switch statement");
+        break;
+    case ND_GOTO: case ND_LABEL:
+        ir_fail(L, "goto");
+        break;
+    default:
+        ir_expr(L, n);
+        break;
+    }
+}
+
+IrFunc *ir_lower(Arena *a, SymTab *st, Node *fn) {
+    IrLower L;
+    memset(&L, 0, sizeof(L));
+    L.arena = a;
+    L.symtab = st;
+    L.f = arena_calloc(a, sizeof(IrFunc));
+    IrFunc *f = L.f;
+    f->name = fn->func_name;
+    f->def = fn;
+    f->ret = ir_type(fn->type->return_type);
+    if (f->ret == IRT_NONE) ir_fail(&L, "aggregate or long long return");
+    if (fn->type->is_variadic) ir_fail(&L, "variadic function");
+
+    for (Param *p = fn->type->params; p; p = p->next) L.max_vars++;
+    ir_scan_addr(fn->func_body, &L);
+
+    IrBlock *entry = ir_block(&L);
+    entry->sealed = true;
+    L.cur = entry;
+    int k = 0;
+    for (Param *p = fn->type->params; p; p = p->next, k++) {
+        IrType t = ir_type(p->type);
+        if (t == IRT_NONE || t == IRT_VOID) {
+            ir_fail(&L, "aggregate or long long parameter");
+            continue;
+        }
+        if (!p->name) continue;
+        IrInst *arg = ir_new(&L, IR_PARAM, t, 0);
+        arg->ival = k;
+        arg->name = p->name;
+        IrVar *v = ir_var_push(&L, p->name, p->type);
+        if (ir_addr_taken(&L, p->name)) {
+            v->slot = ir_alloc(&L, p->type);
+            IrLval lv = { -1, ir_operand(&L, IR_SLOT, p->name, v->slot), t, p->type };
+            ir_store(&L, &lv, arg);
+        } else {
+            v->index = L.nvars++;
+            entry->defs[v->index] = arg;
+        }
+    }
+
+    ir_stmt(&L, fn->func_body);
+    if (L.cur) {
+        /* Falling off the end: main returns 0 */
+        bool is_main = strcmp(fn->func_name, "main") == 0 && f->ret == IRT_I32;
+        IrInst *ret = ir_emit(&L, IR_RET, IRT_VOID, is_main ? 1 : 0);
+        if (is_main) ret->args[0] = ir_const(&L, IRT_I32, 0);
+    }
+    ir_remove_trivial_phis(&L);
+    f->frame = (L.stack + 15) & ~15;
+    return f;
+}
+
+/* ---- Printing (--dump-ir) ---- */
+
+static const char *ir_type_name(IrType t) {
+    static const char *names[] = {
+        "?", "void", "bool", "i8", "u8", "i16", "u16", "i32", "u32", "ptr", "f32", "f64"
+    };
+    return names[t];
+}
+
+static const char *ir_op_name(IrOp op) {
+    static const char *names[] = {
+        "const", "fconst", "param", "phi", "global", "func", "str", "slot",
+        "add", "sub", "mul", "div", "mod", "shl", "shr", "and", "or", "xor",
+        "neg", "not",
+        "eq", "ne", "lt", "le", "gt", "ge",
+        "conv", "load", "store", "call",
+        "jump", "branch", "ret"
+    };
+    return names[op];
+}
+
+static void ir_dump_operand(IrInst *v, Buf *out) {
+    switch (v->op) {
+    case IR_CONST:
+        if (v->type == IRT_U32 || v->type == IRT_PTR) buf_printf(out, "%u", (unsigned)v->ival);
+        else buf_printf(out, "%d", v->ival);
+        break;
+    case IR_FCONST:
+        buf_printf(out, "%.17g", v->fval);
+        break;
+    case IR_PARAM:
+        buf_printf(out, "%%%s", v->name);
+        break;
+    case IR_GLOBAL: case IR_FUNC:
+        buf_printf(out, "@%s", v->name);
+        break;
+    case IR_SLOT:
+        buf_printf(out, "slot[%d]", v->ival);
+        break;
+    case IR_STR:
+        buf_push(out, '"');
+        for (int i = 0; i < v->ival; i++) {
+            unsigned char c = (unsigned char)v->str[i];
+            if (c == '"' || c == '\\') buf_printf(out, "\\%c", c);
+            else if (c >= 32 && c < 127) buf_push(out, (char)c);
+            else buf_printf(out, "\\x%02x", c);
+        }
+        buf_push(out, '"');
+        break;
+    default:
+        buf_printf(out, "%%%d", v->id);
+        break;
+    }
+}
+
+void ir_dump(IrFunc *f, Buf *out) {
+    buf_printf(out, "function %s(", f->name);
+    int k = 0;
+    for (Param *p = f->def->type->params; p; p = p->next, k++)
+        buf_printf(out, "%s%s %%%s", k ? ", " : "", ir_type_name(ir_type(p->type)),
+                   p->name ? p->name : "?");
+    buf_printf(out, ") -> %s", ir_type_name(f->ret));
+    if (f->error) {
+        buf_printf(out, "\n  ; not lowered: %s\n\n", f->error);
+        return;
+    }
+    if (f->frame) buf_printf(out, ", frame %d", f->frame);
+    buf_printf(out, "\n");
+    for (IrBlock *b = f->entry; b; b = b->next) {
+        buf_printf(out, "b%d:", b->id);
+        if (b->npreds) {
+            buf_printf(out, "  ; preds");
+            for (int i = 0; i < b->npreds; i++) buf_printf(out, " b%d", b->preds[i]->id);
+        } else if (b != f->entry) {
+            buf_printf(out, "  ; unreachable");
+        }
+        buf_printf(out, "\n");
+        for (IrInst *phi = b->phis; phi; phi = phi->next) {
+            buf_printf(out, "  %%%d = phi %s", phi->id, ir_type_name(phi->type));
+            for (int i = 0; i < phi->nargs; i++) {
+                buf_printf(out, "%s [b%d: ", i ? "," : "", b->preds[i]->id);
+                ir_dump_operand(phi->args[i], out);
+                buf_printf(out, "]");
+            }
+            buf_printf(out, "\n");
+        }
+        for (IrInst *v = b->first; v; v = v->next) {
+            buf_printf(out, "  ");
+            if (v->op == IR_STORE || v->op >= IR_JUMP) {
+                buf_printf(out, "%s", ir_op_name(v->op));
+                if (v->op == IR_STORE) buf_printf(out, " %s", ir_type_name(v->type));
+            } else if (v->type == IRT_VOID) {
+                buf_printf(out, "%s void", ir_op_name(v->op));
+            } else {
+                buf_printf(out, "%%%d = %s %s", v->id, ir_op_name(v->op), ir_type_name(v->type));
+            }
+            if (v->op == IR_CALL && v->name) buf_printf(out, " @%s", v->name);
+            for (int i = 0; i < v->nargs; i++) {
+                buf_printf(out, i || (v->op == IR_CALL && v->name) ? ", " : " ");
+                if (v->op == IR_CONV && i == 0) buf_printf(out, "%s ", ir_type_name(v->args[0]->type));
+                ir_dump_operand(v->args[i], out);
+            }
+            if (v->op == IR_JUMP) buf_printf(out, " b%d", b->succ[0]->id);
+            if (v->op == IR_BRANCH) buf_printf(out, ", b%d, b%d", b->succ[0]->id, b->succ[1]->id);
+            buf_printf(out, "\n");
+        }
+    }
+    buf_printf(out, "\n");
+}
@@ -0,0 +1,101 @@
+#ifndef C99JS_IR_H
+#define C99JS_IR_H
+
+#include "ast.h"
+#include "symtab.h"
+
+/* SSA intermediate representation, for debugging only: --dump-ir prints
+ * it and nothing in code generation reads it.  ir_lower turns one
+ * sema-checked function into basic blocks of typed instructions.  Scalar
+ * locals whose address is never taken become SSA values, with phis where
+ * control flow joins; arrays, structs and address-taken scalars live in
+ * frame slots reached by load and store.  Value types mirror TypeKind and
+ * signedness.  Functions that need anything outside this subset
+ * (aggregates by value, long long, bit-fields, switch, goto, static
+ * locals, varargs, setjmp, ...) are not lowered, and the dump says why. */
+
+typedef enum {
+    IRT_NONE,       /* not representable */
+    IRT_VOID,
+    IRT_BOOL,
+    IRT_I8, IRT_U8,
+    IRT_I16, IRT_U16,
+    IRT_I32, IRT_U32,     /* int, long, enum */
+    IRT_PTR,
+    IRT_F32, IRT_F64,
+} IrType;
+
+typedef enum {
+    /* Operands */
+    IR_CONST,       /* integer constant ival (32-bit pattern) */
+    IR_FCONST,      /* floating constant fval */
+    IR_PARAM,       /* parameter number ival, called name */
+    IR_PHI,         /* one argument per predecessor of the block */
+    IR_GLOBAL,      /* address of the global object name */
+    IR_FUNC,        /* function name as a value */
+    IR_STR,         /* address of the string literal str (ival bytes) */
+    IR_SLOT,        /* address of the frame slot at bp + ival */
+    /* Arithmetic in the instruction's type */
+    IR_ADD, IR_SUB, IR_MUL, IR_DIV, IR_MOD,
+    IR_SHL, IR_SHR, IR_AND, IR_OR, IR_XOR,
+    IR_NEG, IR_BITNOT,
+    /* Comparisons of two operands of one type, giving int 0 or 1 */
+    IR_EQ, IR_NE, IR_LT, IR_LE, IR_GT, IR_GE,
+    IR_CONV,        /* args[0] converted to the instruction's type */
+    /* Memory and calls */
+    IR_LOAD,        /* value at address args[0] */
+    IR_STORE,       /* store args[1] at address args[0] */
+    IR_CALL,        /* call name, or args[0] when name is NULL; then the arguments */
+    /* Terminators */
+    IR_JUMP,        /* to succ[0] */
+    IR_BRANCH,      /* args[0] != 0 ? succ[0] : succ[1] */
+    IR_RET,         /* return args[0], if any */
+} IrOp;
+
+typedef struct IrBlock IrBlock;
+typedef struct IrInst IrInst;
+
+struct IrInst {
+    IrOp        op;
+    IrType      type;       /* result type; stored type for IR_STORE */
+    int         id;         /* value number */
+    IrInst    **args;
+    int         nargs;      /* -1: phi of an unsealed block, not filled in yet */
+    int         ival;
+    double      fval;
+    const char *name;
+    const char *str;
+    IrBlock    *block;
+    IrInst     *forward;    /* removed phi: the value that replaces it */
+    IrInst     *next;
+};
+
+struct IrBlock {
+    int         id;
+    IrInst     *phis;
+    IrInst     *first, *last;   /* last is the terminator once the block ends */
+    IrBlock   **preds;
+    int         npreds;
+    int         pred_cap;
+    IrBlock    *succ[2];
+    int         nsucc;
+    bool        sealed;         /* all predecessors known */
+    IrInst    **defs;           /* current value of each SSA variable */
+    IrBlock    *next;
+};
+
+typedef struct {
+    const char *name;
+    Node       *def;            /* its ND_FUNC_DEF */
+    IrType      ret;
+    IrBlock    *entry;          /* blocks in creation order, via next */
+    int         nblocks;
+    int         nvalues;
+    int         frame;          /* bytes of frame slots below bp */
+    const char *error;          /* why the function was not lowered */
+} IrFunc;
+
+IrFunc *ir_lower(Arena *a, SymTab *st, Node *fn);
+void ir_dump(IrFunc *f, Buf *out);
+
+#endif /* C99JS_IR_H */
@@ -0,0 +1,628 @@
+#include "licm.h"
+#include <stdio.h>
+#include <string.h>
+
+/* A variable of the function being rewritten */
+struct LicmName {
+    const char *name;
+    int         decls;       /* declarations in the function */
+    bool        memory;      /* may be reached through a pointer */
+    int         written;     /* serial of the last loop found assigning it */
+    LicmName   *next;
+};
+
+/* What a loop does */
+typedef struct {
+    Licm *lm;
+    bool  clobber;   /* may store to memory reachable through pointers */
+    bool  bad;       /* contains a label: can be entered from outside */
+    int   switches;  /* switch nesting inside the loop */
+} LicmLoop;
+
+/* Library functions without side effects.  The first group reads the
+ * memory its arguments point to. */
+static const char *licm_pure_mem[] = {
+    "strlen", "strcmp", "strncmp", "memcmp", "strchr", "strrchr", "strstr",
+    "memchr", "atoi", "atof",
+    NULL
+};
+static const char *licm_pure[] = {
+    "abs", "labs", "isalpha", "isdigit", "isalnum", "isspace", "isupper",
+    "islower", "ispunct", "isprint", "iscntrl", "isxdigit", "toupper", "tolower",
+    "sin", "cos", "tan", "asin", "acos", "atan", "atan2", "sqrt", "pow", "fabs",
+    "ceil", "floor", "fmod", "log", "log10", "exp", "tanh", "fmin", "fmax", "round",
+    "sinf", "cosf", "tanf", "sqrtf", "powf", "fabsf", "ceilf", "floorf", "fmodf",
+    "logf", "expf",
+    NULL
+};
+/* ... and functions that write output but no program memory */
+static const char *licm_no_store[] = {
+    "printf", "fprintf", "puts", "putchar", "fputs", "fputc", "putc", "fwrite",
+    "fflush",
+    NULL
+};
+
+void licm_init(Licm *lm, Arena *a) {
+    memset(lm, 0, sizeof(*lm));
+    lm->arena = a;
+}
+
+static unsigned int licm_hash(const char *name) {
+    unsigned int h = 0;
+    for (const char *p = name; *p; p++)
+        h = h * 31 + (unsigned char)*p;
+    return h % LICM_TABLE_SIZE;
+}
+
+static LicmName *licm_name(Licm *lm, const char *name, bool create) {
+    unsigned int h = licm_hash(name);
+    for (LicmName *v = lm->names[h]; v; v = v->next)
+        if (strcmp(v->name, name) == 0) return v;
+    if (!create) return NULL;
+    LicmName *v = arena_calloc(lm->arena, sizeof(LicmName));
+    v->name = name;
+    v->memory = true;
+    v->next = lm->names[h];
+    lm->names[h] = v;
+    return v;
+}
+
+static bool licm_in_list(const char **list, const char *name) {
+    for (int i = 0; list[i]; i++)
+        if (strcmp(list[i], name) == 0) return true;
+    return false;
+}
+
+static bool licm_defined(Licm *lm, const char *name) {
+    for (Node *n = lm->program->body; n; n = n->next)
+        if (n->kind == ND_FUNC_DEF && strcmp(n->func_name, name) == 0) return true;
+    return false;
+}
+
+static bool licm_is_global(Licm *lm, const char *name) {
+    for (Node *n = lm->program->body; n; n = n->next)
+        if (n->kind == ND_VAR_DECL && n->var_name && strcmp(n->var_name, name) == 0)
+            return true;
+    return false;
+}
+
+/* Library function called by n, from list; NULL for other calls */
+static const char *licm_callee(Licm *lm, Node *n) {
+    Node *f = n->callee;
+    if (f->kind != ND_IDENT || !f->type || f->type->kind != TY_FUNC) return NULL;
+    if (licm_defined(lm, f->name)) return NULL;
+    return f->name;
+}
+
+/* ---- Variables ---- */
+
+static bool licm_is_array(Node *n) {
+    return n->type && n->type->kind == TY_ARRAY;
+}
+
+/* Array inside a variable (x, s.a, m[i] of a 2-D array): used as a value
+ * it decays to a pointer into the variable */
+static bool licm_array_lvalue(Node *n) {
+    return licm_is_array(n) &&
+           (n->kind == ND_IDENT || n->kind == ND_MEMBER ||
+            (n->kind == ND_SUBSCRIPT && licm_is_array(n->lhs)));
+}
+
+static void licm_scan_decls(Node *n, void *ctx) {
+    Licm *lm = ctx;
+    if (!n) return;
+    if (n->kind == ND_VAR_DECL && n->var_name) {
+        LicmName *v = licm_name(lm, n->var_name, true);
+        v->decls++;
+        if (n->var_sc == SC_STATIC || n->var_sc == SC_EXTERN || !n->type ||
+            n->type->kind == TY_ARRAY || n->type->kind == TY_VLA ||
+            (n->type->qual & QUAL_VOLATILE))
+            v->decls++; /* never a register */
+    } else if (n->kind == ND_ADDR || licm_array_lvalue(n)) {
+        /* &x, or an array of x decaying to a pointer */
+        Node *r = node_lvalue_root(n->kind == ND_ADDR ? n->lhs : n);
+        if (r) licm_name(lm, r->name, true)->decls += 2;
+    } else if (n->kind == ND_SUBSCRIPT && licm_is_array(n->lhs)) {
+        /* Indexing an array in place takes no address */
+        node_visit_children(n->lhs, licm_scan_decls, lm);
+        licm_scan_decls(n->rhs, lm);
+        return;
+    } else if (n->kind == ND_SIZEOF) {
+        return;
+    }
+    node_visit_children(n, licm_scan_decls, lm);
+}
+
+/* Classify the variables of function f: a register is declared once, is
+ * not a global's name and never has its address taken */
+static void licm_scan_func(Licm *lm, Node *f) {
+    memset(lm->names, 0, sizeof(lm->names));
+    for (Param *p = f->type->params; p; p = p->next)
+        if (p->name) licm_name(lm, p->name, true)->decls++;
+    licm_scan_decls(f->func_body, lm);
+    for (int i = 0; i < LICM_TABLE_SIZE; i++)
+        for (LicmName *v = lm->names[i]; v; v = v->next)
+            v->memory = v->decls != 1 || licm_is_global(lm, v->name);
+}
+
+/* ---- Loop effects ---- */
+
+static void licm_write(LicmLoop *L, Node *lv) {
+    Node *r = node_lvalue_root(lv);
+    if (!r) {
+        L->clobber = true;
+        return;
+    }
+    LicmName *v = licm_name(L->lm, r->name, true);
+    v->written = L->lm->loop;
+    if (v->memory) L->clobber = true;
+}
+
+static void licm_scan_loop(Node *n, void *ctx) {
+    LicmLoop *L = ctx;
+    if (!n) return;
+    switch (n->kind) {
+    case ND_LABEL:
+        L->bad = true;
+        return;
+    case ND_CASE: case ND_DEFAULT:
+        if (L->switches == 0) L->bad = true;
+        break;
+    case ND_SWITCH:
+        L->switches++;
+        node_visit_children(n, licm_scan_loop, L);
+        L->switches--;
+        return;
+    case ND_SIZEOF: case ND_SIZEOF_TYPE:
+        return;
+    case ND_ASSIGN: case ND_ADD_ASSIGN: case ND_SUB_ASSIGN: case ND_MUL_ASSIGN:
+    case ND_DIV_ASSIGN: case ND_MOD_ASSIGN: case ND_LSHIFT_ASSIGN: case ND_RSHIFT_ASSIGN:
+    case ND_AND_ASSIGN: case ND_OR_ASSIGN: case ND_XOR_ASSIGN:
+    case ND_PRE_INC: case ND_PRE_DEC: case ND_POST_INC: case ND_POST_DEC:
+        licm_write(L, n->lhs);
+        break;
+    case ND_VAR_DECL:
+        if (n->var_name) {
+            LicmName *v = licm_name(L->lm, n->var_name, true);
+            v->written = L->lm->loop;
+            if (v->memory) L->clobber = true;
+        }
+        break;
+    case ND_CALL: {
+        const char *f = licm_callee(L->lm, n);
+        if (!f || !(licm_in_list(licm_pure_mem, f) || licm_in_list(licm_pure, f) ||
+                    licm_in_list(licm_no_store, f)))
+            L->clobber = true;
+        break;
+    }
+    case ND_VA_ARG: case ND_COMPOUND_LIT:
+        L->clobber = true;
+        break;
+    default:
+        break;
+    }
+    node_visit_children(n, licm_scan_loop, L);
+}
+
+/* ---- Invariance ---- */
+
+static bool licm_inv(LicmLoop *L, Node *n);
+
+/* Is the address of lvalue n the same on every iteration? */
+static bool licm_addr_inv(LicmLoop *L, Node *n) {
+    switch (n->kind) {
+    case ND_IDENT:
+        return n->type && n->type->kind != TY_VLA;
+    case ND_DEREF: case ND_MEMBER_PTR:
+        return licm_inv(L, n->lhs);
+    case ND_MEMBER:
+        return licm_addr_inv(L, n->lhs);
+    case ND_SUBSCRIPT:
+        return licm_inv(L, n->lhs) && licm_inv(L, n->rhs);
+    default:
+        return false;
+    }
+}
+
+/* Does lvalue n, whose address is invariant, keep its value during the
+ * loop? */
+static bool licm_load_inv(LicmLoop *L, Node *n) {
+    Node *r = node_lvalue_root(n);
+    LicmName *v = r ? licm_name(L->lm, r->name, false) : NULL;
+    if (v && v->written == L->lm->loop) return false;
+    return (v && !v->memory) || !L->clobber;
+}
+
+/* Does n evaluate to the same value on every iteration, without side
+ * effects? */
+static bool licm_inv(LicmLoop *L, Node *n) {
+    if (!n) return true;
+    if (n->type && (n->type->qual & QUAL_VOLATILE)) return false;
+    switch (n->kind) {
+    case ND_INT_LIT: case ND_FLOAT_LIT: case ND_CHAR_LIT: case ND_STRING_LIT:
+        return true;
+    case ND_SIZEOF:
+        return n->lhs && n->lhs->type && n->lhs->type->kind != TY_VLA;
+    case ND_SIZEOF_TYPE:
+        return n->cast_type && n->cast_type->kind != TY_VLA;
+    case ND_IDENT:
+        if (!n->type || n->type->kind == TY_FUNC) return true;
+        if (n->type->kind == TY_ARRAY || n->type->kind == TY_VLA)
+            return licm_addr_inv(L, n);
+        return licm_load_inv(L, n);
+    case ND_ADDR:
+        return licm_addr_inv(L, n->lhs);
+    case ND_DEREF: case ND_MEMBER: case ND_MEMBER_PTR: case ND_SUBSCRIPT:
+        if (!licm_addr_inv(L, n)) return false;
+        return (n->type && n->type->kind == TY_ARRAY) || licm_load_inv(L, n);
+    case ND_CALL: {
+        const char *f = licm_callee(L->lm, n);
+        if (!f) return false;
+        bool reads = licm_in_list(licm_pure_mem, f);
+        if (!reads && !licm_in_list(licm_pure, f)) return false;
+        if (reads && L->clobber) return false;
+        for (Node *a = n->args; a; a = a->next)
+            if (!licm_inv(L, a)) return false;
+        return true;
+    }
+    case ND_CAST:
+        return licm_inv(L, n->cast_expr);
+    case ND_NEG: case ND_POS: case ND_NOT: case ND_BITNOT:
+    case ND_ADD: case ND_SUB: case ND_MUL: case ND_DIV: case ND_MOD:
+    case ND_LSHIFT: case ND_RSHIFT: case ND_LT: case ND_LE: case ND_GT: case ND_GE:
+    case ND_EQ: case ND_NE: case ND_BITAND: case ND_BITOR: case ND_BITXOR:
+    case ND_AND: case ND_OR: case ND_TERNARY: case ND_COMMA:
+        return licm_inv(L, n->lhs) && licm_inv(L, n->rhs) && licm_inv(L, n->third);
+    default:
+        return false;
+    }
+}
+
+static bool licm_costly(LicmLoop *L, Node *n);
+
+/* Does computing the address of lvalue n load memory? */
+static bool licm_costly_addr(LicmLoop *L, Node *n) {
+    switch (n->kind) {
+    case ND_IDENT:
+        return false;
+    case ND_MEMBER:
+        return licm_costly_addr(L, n->lhs);
+    case ND_SUBSCRIPT:
+        return (n->lhs->type && n->lhs->type->kind == TY_ARRAY ? licm_costly_addr(L, n->lhs)
+                                                               : licm_costly(L, n->lhs)) ||
+               licm_costly(L, n->rhs);
+    default:
+        return licm_costly(L, n->lhs);
+    }
+}
+
+/* Is n worth a local: does it load memory or call a function? */
+static bool licm_costly(LicmLoop *L, Node *n) {
+    if (!n) return false;
+    switch (n->kind) {
+    case ND_SIZEOF: case ND_SIZEOF_TYPE:
+        return false;
+    case ND_ADDR:
+        return licm_costly_addr(L, n->lhs);
+    case ND_CALL: case ND_DEREF: case ND_MEMBER_PTR: case ND_SUBSCRIPT:
+        return true;
+    case ND_IDENT: case ND_MEMBER: {
+        if (n->type && n->type->kind == TY_ARRAY) return false;
+        Node *r = node_lvalue_root(n);
+        LicmName *v = r ? licm_name(L->lm, r->name, false) : NULL;
+        if (!v || v->memory) return true;
+        break;
+    }
+    case ND_CAST:
+        return licm_costly(L, n->cast_expr);
+    default:
+        break;
+    }
+    return licm_costly(L, n->lhs) || licm_costly(L, n->rhs) || licm_costly(L, n->third);
+}
+
+/* Free of side effects, so evaluating it once more is harmless */
+static bool licm_no_effects(Licm *lm, Node *n) {
+    if (!n) return true;
+    if (n->type && (n->type->qual & QUAL_VOLATILE)) return false;
+    switch (n->kind) {
+    case ND_ASSIGN: case ND_ADD_ASSIGN: case ND_SUB_ASSIGN: case ND_MUL_ASSIGN:
+    case ND_DIV_ASSIGN: case ND_MOD_ASSIGN: case ND_LSHIFT_ASSIGN: case ND_RSHIFT_ASSIGN:
+    case ND_AND_ASSIGN: case ND_OR_ASSIGN: case ND_XOR_ASSIGN:
+    case ND_PRE_INC: case ND_PRE_DEC: case ND_POST_INC: case ND_POST_DEC:
+    case ND_VA_ARG: case ND_COMPOUND_LIT:
+        return false;
+    case ND_CALL: {
+        const char *f = licm_callee(lm, n);
+        if (!f || !(licm_in_list(licm_pure_mem, f) || licm_in_list(licm_pure, f)))
+            return false;
+        for (Node *a = n->args; a; a = a->next)
+            if (!licm_no_effects(lm, a)) return false;
+        return true;
+    }
+    case ND_CAST:
+        return licm_no_effects(lm, n->cast_expr);
+    default:
+        return licm_no_effects(lm, n->lhs) && licm_no_effects(lm, n->rhs) &&
+               licm_no_effects(lm, n->third);
+    }
+}
+
+/* ---- Hoisting ---- */
+
+static Node *licm_stmt(Arena *a, Node *e) {
+    Node *s = node_new(a, ND_EXPR_STMT, e->loc);
+    s->lhs = e;
+    return s;
+}
+
+/* Replace n by a fresh local and append its computation to *tail */
+static void licm_hoist(LicmLoop *L, Node *n, Node ***tail) {
+    Licm *lm = L->lm;
+    Arena *a = lm->arena;
+    char buf[32];
+    snprintf(buf, sizeof(buf), "__licm%d", lm->counter++);
+    Node *decl = node_new(a, ND_VAR_DECL, n->loc);
+    decl->var_name = arena_strdup(a, buf);
+    decl->type = n->type;
+    decl->var_sc = SC_NONE;
+    decl->next = lm->func->func_body->body;
+    lm->func->func_body->body = decl;
+    LicmName *v = licm_name(lm, decl->var_name, true);
+    v->decls = 1;
+    v->memory = false;
+
+    Node *e = arena_alloc(a, sizeof(Node));
+    *e = *n;
+    e->next = NULL;
+    Node *lhs = node_ident(a, decl->var_name, n->loc);
+    lhs->type = n->type;
+    Node *assign = node_binary(a, ND_ASSIGN, lhs, e, n->loc);
+    assign->type = n->type;
+    **tail = licm_stmt(a, assign);
+    *tail = &(**tail)->next;
+
+    Node *next = n->next;
+    *n = *node_clone(a, lhs, NULL, NULL);
+    n->next = next;
+}
+
+static void licm_expr(LicmLoop *L, Node *n, Node ***tail);
+
+/* Hoist from the address computation of lvalue n */
+static void licm_lvalue(LicmLoop *L, Node *n, Node ***tail) {
+    switch (n->kind) {
+    case ND_IDENT:
+        return;
+    case ND_MEMBER:
+        licm_lvalue(L, n->lhs, tail);
+        return;
+    case ND_SUBSCRIPT:
+        if (n->lhs->type && n->lhs->type->kind == TY_ARRAY) licm_lvalue(L, n->lhs, tail);
+        else licm_expr(L, n->lhs, tail);
+        licm_expr(L, n->rhs, tail);
+        return;
+    case ND_DEREF: case ND_MEMBER_PTR:
+        licm_expr(L, n->lhs, tail);
+        return;
+    default:
+        licm_expr(L, n, tail);
+        return;
+    }
+}
+
+/* Hoist the largest invariant parts of n that are evaluated whenever n is */
+static void licm_expr(LicmLoop *L, Node *n, Node ***tail) {
+    if (!n) return;
+    if (n->type && type_is_scalar(n->type) && n->type->kind != TY_COMPLEX &&
+        licm_costly(L, n) && licm_inv(L, n)) {
+        licm_hoist(L, n, tail);
+        return;
+    }
+    switch (n->kind) {
+    case ND_AND: case ND_OR: case ND_TERNARY:
+        licm_expr(L, n->lhs, tail);
+        return;
+    case ND_SIZEOF: case ND_SIZEOF_TYPE: case ND_COMPOUND_LIT: case ND_VA_ARG:
+    case ND_INIT_LIST:
+        return;
+    case ND_CALL:
+        for (Node *a = n->args; a; a = a->next)
+            licm_expr(L, a, tail);
+        return;
+    case ND_CAST:
+        licm_expr(L, n->cast_expr, tail);
+        return;
+    case ND_ASSIGN: case ND_ADD_ASSIGN: case ND_SUB_ASSIGN: case ND_MUL_ASSIGN:
+    case ND_DIV_ASSIGN: case ND_MOD_ASSIGN: case ND_LSHIFT_ASSIGN: case ND_RSHIFT_ASSIGN:
+    case ND_AND_ASSIGN: case ND_OR_ASSIGN: case ND_XOR_ASSIGN:
+        licm_lvalue(L, n->lhs, tail);
+        licm_expr(L, n->rhs, tail);
+        return;
+    case ND_PRE_INC: case ND_PRE_DEC: case ND_POST_INC: case ND_POST_DEC: case ND_ADDR:
+        licm_lvalue(L, n->lhs, tail);
+        return;
+    default:
+        licm_expr(L, n->lhs, tail);
+        licm_expr(L, n->rhs, tail);
+        licm_expr(L, n->third, tail);
+        return;
+    }
+}
+
+/* Can n leave the enclosing statement list other than by falling off its
+ * end?  loops/switches count the constructs of n that catch break */
+static bool licm_jumps(Licm *lm, Node *n, int loops, int switches) {
+    if (!n) return false;
+    switch (n->kind) {
+    case ND_RETURN: case ND_GOTO: case ND_LABEL:
+        return true;
+    case ND_BREAK:
+        return loops == 0 && switches == 0;
+    case ND_CONTINUE:
+        return loops == 0;
+    case ND_CALL: {
+        const char *f = licm_callee(lm, n);
+        if (f && (strcmp(f, "exit") == 0 || strcmp(f, "abort") == 0 ||
+                  strcmp(f, "longjmp") == 0))
+            return true;
+        break;
+    }
+    case ND_FOR: case ND_WHILE: case ND_DO_WHILE:
+        loops++;
+        break;
+    case ND_SWITCH:
+        switches++;
+        break;
+    default:
+        break;
+    }
+    switch (n->kind) {
+    case ND_CALL:
+        for (Node *a = n->args; a; a = a->next)
+            if (licm_jumps(lm, a, loops, switches)) return true;
+        return false;
+    case ND_FOR:
+        for (Node *s = n->for_init; s; s = s->next)
+            if (licm_jumps(lm, s, loops, switches)) return true;
+        return licm_jumps(lm, n->for_cond, loops, switches) ||
+               licm_jumps(lm, n->for_inc, loops, switches) ||
+               licm_jumps(lm, n->for_body, loops, switches);
+    case ND_SWITCH:
+        return licm_jumps(lm, n->switch_expr, loops, switches) ||
+               licm_jumps(lm, n->switch_body, loops, switches);
+    case ND_CASE:
+        return licm_jumps(lm, n->case_body, loops, switches);
+    case ND_BLOCK:
+        for (Node *s = n->body; s; s = s->next)
+            if (licm_jumps(lm, s, loops, switches)) return true;
+        return false;
+    case ND_VAR_DECL:
+        return licm_jumps(lm, n->var_init, loops, switches);
+    case ND_CAST:
+        return licm_jumps(lm, n->cast_expr, loops, switches);
+    case ND_SIZEOF_TYPE: case ND_COMPOUND_LIT: case ND_INIT_LIST:
+        return false;
+    default:
+        return licm_jumps(lm, n->lhs, loops, switches) ||
+               licm_jumps(lm, n->rhs, loops, switches) ||
+               licm_jumps(lm, n->third, loops, switches);
+    }
+}
+
+/* Hoist from the statements of list s that run, in order, whenever the
+ * list is entered; true if control always reaches the end of the list */
+static bool licm_stmts(LicmLoop *L, Node *s, Node ***tail) {
+    for (; s; s = s->next) {
+        switch (s->kind) {
+        case ND_NULL_STMT:
+            break;
+        case ND_EXPR_STMT: case ND_IF: case ND_WHILE:
+            licm_expr(L, s->lhs, tail);
+            break;
+        case ND_VAR_DECL:
+            if (s->var_sc != SC_STATIC && s->var_sc != SC_EXTERN)
+                licm_expr(L, s->var_init, tail);
+            break;
+        case ND_SWITCH:
+            licm_expr(L, s->switch_expr, tail);
+            break;
+        case ND_BLOCK:
+            if (!licm_stmts(L, s->body, tail)) return false;
+            break;
+        default:
+            return false;
+        }
+        if (licm_jumps(L->lm, s, 0, 0)) return false;
+    }
+    return true;
+}
+
+/* Hoist the invariant expressions of loop n in front of it */
+static void licm_loop(Licm *lm, Node *n) {
+    Arena *a = lm->arena;
+    LicmLoop L;
+    L.lm = lm;
+    L.clobber = false;
+    L.bad = false;
+    L.switches = 0;
+    lm->loop++;
+    bool is_for = n->kind == ND_FOR;
+    Node *cond = is_for ? n->for_cond : n->lhs;
+    Node *body = is_for ? n->for_body : n->rhs;
+    licm_scan_loop(cond, &L);
+    licm_scan_loop(body, &L);
+    if (is_for) licm_scan_loop(n->for_inc, &L);
+    if (L.bad) return;
+
+    Node *pre = NULL, **pre_tail = &pre;          /* run before the loop */
+    Node *guarded = NULL, **guard_tail = &guarded; /* ... if it iterates */
+    if (n->kind == ND_DO_WHILE) {
+        if (licm_stmts(&L, body, &pre_tail))
+            licm_expr(&L, cond, &pre_tail);
+    } else if (!cond) {
+        licm_stmts(&L, body, &pre_tail);
+    } else {
+        licm_expr(&L, cond, &pre_tail);
+        if (licm_no_effects(lm, cond))
+            licm_stmts(&L, body, &guard_tail);
+    }
+    if (!pre && !guarded) return;
+
+    /* n becomes { for-init; pre; if (cond) { guarded; loop } } */
+    Node *loop = arena_alloc(a, sizeof(Node));
+    *loop = *n;
+    loop->next = NULL;
+    Node *head = NULL, **tail = &head;
+    if (is_for && loop->for_init) {
+        if (loop->for_init->kind == ND_VAR_DECL) {
+            *tail = loop->for_init;
+            while (*tail) tail = &(*tail)->next;
+        } else {
+            *tail = licm_stmt(a, loop->for_init);
+            tail = &(*tail)->next;
+        }
+        loop->for_init = NULL;
+    }
+    *tail = pre;
+    tail = pre ? pre_tail : tail;
+    if (guarded) {
+        *guard_tail = loop;
+        Node *block = node_new(a, ND_BLOCK, n->loc);
+        block->body = guarded;
+        Node *iff = node_new(a, ND_IF, n->loc);
+        iff->lhs = node_clone(a, cond, NULL, NULL);
+        iff->rhs = block;
+        *tail = iff;
+    } else {
+        *tail = loop;
+    }
+    Node *next = n->next;
+    memset(n, 0, sizeof(*n));
+    n->kind = ND_BLOCK;
+    n->loc = loop->loc;
+    n->body = head;
+    n->next = next;
+}
+
+/* ---- Traversal ---- */
+
+static void licm_node(Node *n, void *ctx) {
+    Licm *lm = ctx;
+    if (!n) return;
+    node_visit_children(n, licm_node, lm);
+    if (n->kind == ND_FOR || n->kind == ND_WHILE || n->kind == ND_DO_WHILE)
+        licm_loop(lm, n);
+}
+
+void licm_program(Licm *lm, Node *program) {
+    lm->program = program;
+    for (Node *n = program->body; n; n = n->next) {
+        if (n->kind != ND_FUNC_DEF || !n->func_body) continue;
+        if (node_contains_setjmp(n->func_body)) continue;
+        lm->func = n;
+        licm_scan_func(lm, n);
+        licm_node(n->func_body, lm);
+    }
+    lm->func = NULL;
+}
@@ -0,0 +1,31 @@
+#ifndef C99JS_LICM_H
+#define C99JS_LICM_H
+
+#include "ast.h"
+
+/* Loop-invariant code motion.  Runs on the typed AST after fold: in each
+ * for/while/do-while loop, expressions that load memory or call a pure
+ * library function (strlen, memcmp, sqrt, ...) and whose operands the loop
+ * never changes are computed once into a fresh local before the loop.
+ * Only expressions evaluated on every entry to the loop are hoisted, so no
+ * load or call runs that the original program would have skipped; when
+ * they come from the loop body, the hoisted code is guarded by the loop
+ * condition. */
+
+#define LICM_TABLE_SIZE 256
+
+typedef struct LicmName LicmName;
+
+typedef struct {
+    Arena    *arena;
+    Node     *program;
+    Node     *func;                      /* function being rewritten */
+    LicmName *names[LICM_TABLE_SIZE];    /* its variables, by name */
+    int       loop;                      /* serial number of the current loop */
+    int       counter;                   /* suffix for fresh local names */
+} Licm;
+
+void licm_init(Licm *lm, Arena *a);
+void licm_program(Licm *lm, Node *program);
+
+#endif /* C99JS_LICM_H */
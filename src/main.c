@@ -9,6 +9,10 @@
 #include "symtab.h"
 #include "parser.h"
 #include "sema.h"
+#include "fold.h"
+#include "inline.h"
+#include "licm.h"
+#include "ir.h"
 #include "codegen.h"
 
 static void usage(const char *prog) {
@@ -19,6 +23,11 @@ static void usage(const char *prog) {
     fprintf(stderr, "  -D <name>=<val>  Define preprocessor macro\n");
     fprintf(stderr, "  -E           Preprocess only\n");
     fprintf(stderr, "  --dump-ast   Print AST (for debugging)\n");
+    fprintf(stderr, "  --dump-ir    Print the SSA IR of each function (for debugging)\n");
+    fprintf(stderr, "  --nan-boxing Keep doubles as raw 64-bit patterns (preserves NaN payloads)\n");
+    fprintf(stderr, "  --no-inline  Do not inline small static functions\n");
+    fprintf(stderr, "  --no-licm    Do not hoist loop-invariant expressions\n");
+    fprintf(stderr, "  --switch=<auto|js|table|tree>  Lowering of switch statements\n");
     fprintf(stderr, "  -h, --help   Show this help\n");
 }
 
@@ -112,6 +121,7 @@ static void register_builtins(SymTab *st, Arena *a) {
     s = symtab_define(st, "exit", SYM_FUNC, type_func(a, ty_void), loc); s->sc = SC_EXTERN;
     s = symtab_define(st, "abort", SYM_FUNC, type_func(a, ty_void), loc); s->sc = SC_EXTERN;
     s = symtab_define(st, "qsort", SYM_FUNC, type_func(a, ty_void), loc); s->sc = SC_EXTERN;
+    s = symtab_define(st, "bsearch", SYM_FUNC, memfn_ty, loc); s->sc = SC_EXTERN;
 
     /* strtol(const char*, char**, int) -> long */
     Type *strtol_ty = type_func(a, ty_long);
@@ -246,6 +256,10 @@ static void register_builtins(SymTab *st, Arena *a) {
     vfprintf_ty->is_variadic = true;
     s = symtab_define(st, "vfprintf", SYM_FUNC, vfprintf_ty, loc); s->sc = SC_EXTERN;
 
+    /* vprintf(const char*, va_list), vsprintf(char*, const char*, va_list) -> int */
+    s = symtab_define(st, "vprintf", SYM_FUNC, vfprintf_ty, loc); s->sc = SC_EXTERN;
+    s = symtab_define(st, "vsprintf", SYM_FUNC, vfprintf_ty, loc); s->sc = SC_EXTERN;
+
     /* va_start, va_end, va_copy (built-in, special codegen) */
     Type *va_builtin_ty = type_func(a, ty_void);
     va_builtin_ty->is_variadic = true;
@@ -298,6 +312,11 @@ int main(int argc, char **argv) {
     int include_count = 0;
     bool preprocess_only = false;
     bool dump_ast = false;
+    bool dump_ir = false;
+    bool nan_boxing = false;
+    bool no_inline = false;
+    bool no_licm = false;
+    SwitchMode switch_mode = SWITCH_AUTO;
 
     /* Initialize include paths with NULL terminator */
     include_paths[0] = NULL;
@@ -326,6 +345,24 @@ int main(int argc, char **argv) {
             preprocess_only = true;
         } else if (strcmp(argv[i], "--dump-ast") == 0) {
             dump_ast = true;
+        } else if (strcmp(argv[i], "--dump-ir") == 0) {
+            dump_ir = true;
+        } else if (strcmp(argv[i], "--nan-boxing") == 0) {
+            nan_boxing = true;
+        } else if (strcmp(argv[i], "--no-inline") == 0) {
+            no_inline = true;
+        } else if (strcmp(argv[i], "--no-licm") == 0) {
+            no_licm = true;
+        } else if (strncmp(argv[i], "--switch=", 9) == 0) {
+            const char *m = argv[i] + 9;
+            if (strcmp(m, "auto") == 0) switch_mode = SWITCH_AUTO;
+            else if (strcmp(m, "js") == 0) switch_mode = SWITCH_JS;
+            else if (strcmp(m, "table") == 0) switch_mode = SWITCH_TABLE;
+            else if (strcmp(m, "tree") == 0) switch_mode = SWITCH_TREE;
+            else {
+                fprintf(stderr, "unknown switch lowering: %s\n", m);
+                return 1;
+            }
         } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
             usage(argv[0]);
             return 0;
@@ -407,11 +444,51 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    /* Function inlining */
+    if (!no_inline) {
+        Inliner inliner;
+        inline_init(&inliner, &arena);
+        inline_program(&inliner, program);
+    }
+
+    /* Constant folding */
+    Fold fold;
+    fold_init(&fold, &arena, &symtab);
+    fold_program(&fold, program);
+
+    /* Loop-invariant code motion */
+    if (!no_licm) {
+        Licm licm;
+        licm_init(&licm, &arena);
+        licm_program(&licm, program);
+    }
+
     (void)dump_ast; /* TODO: implement AST dump */
 
+    if (dump_ir) {
+        Buf ir;
+        buf_init(&ir);
+        for (Node *n = program->body; n; n = n->next)
+            if (n->kind == ND_FUNC_DEF) ir_dump(ir_lower(&arena, &symtab, n), &ir);
+        buf_push(&ir, '\0');
+        FILE *out = output_file ? fopen(output_file, "w") : stdout;
+        if (!out) {
+            fprintf(stderr, "error: cannot open output file '%s'\n", output_file);
+            return 1;
+        }
+        fputs(ir.data, out);
+        if (output_file) fclose(out);
+        buf_free(&ir);
+        free(src);
+        arena_free(&arena);
+        return 0;
+    }
+
     /* Code generation */
     CodeGen codegen;
     codegen_init(&codegen, &arena, &symtab);
+    codegen.nan_boxing = nan_boxing;
+    codegen.switch_mode = switch_mode;
     codegen_generate(&codegen, program);
     char *output = codegen_get_output(&codegen);
 
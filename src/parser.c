@@ -1,4 +1,5 @@
 #include "parser.h"
+#include "fold.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -26,53 +27,13 @@ static bool  is_type_name(Parser *p);
 #define EXPECT(k) lexer_expect(p->lexer, (k))
 #define LOC (p->lexer->cur.loc)
 
-/* Try to evaluate a constant expression at compile time.
- * Returns true and sets *result if the expression is a compile-time constant. */
-static bool try_eval_const(Node *n, long long *result) {
-    if (!n) return false;
-    if (n->kind == ND_INT_LIT) { *result = (long long)n->ival; return true; }
-    if (n->kind == ND_CHAR_LIT) { *result = n->cval; return true; }
-    long long l, r;
-    switch (n->kind) {
-    case ND_NEG: return try_eval_const(n->lhs, &l) ? (*result = -l, true) : false;
-    case ND_NOT: return try_eval_const(n->lhs, &l) ? (*result = !l, true) : false;
-    case ND_BITNOT: return try_eval_const(n->lhs, &l) ? (*result = ~l, true) : false;
-    case ND_ADD: return (try_eval_const(n->lhs, &l) && try_eval_const(n->rhs, &r)) ? (*result = l + r, true) : false;
-    case ND_SUB: return (try_eval_const(n->lhs, &l) && try_eval_const(n->rhs, &r)) ? (*result = l - r, true) : false;
-    case ND_MUL: return (try_eval_const(n->lhs, &l) && try_eval_const(n->rhs, &r)) ? (*result = l * r, true) : false;
-    case ND_DIV: return (try_eval_const(n->lhs, &l) && try_eval_const(n->rhs, &r) && r != 0) ? (*result = l / r, true) : false;
-    case ND_MOD: return (try_eval_const(n->lhs, &l) && try_eval_const(n->rhs, &r) && r != 0) ? (*result = l % r, true) : false;
-    case ND_LSHIFT: return (try_eval_const(n->lhs, &l) && try_eval_const(n->rhs, &r)) ? (*result = l << r, true) : false;
-    case ND_RSHIFT: return (try_eval_const(n->lhs, &l) && try_eval_const(n->rhs, &r)) ? (*result = l >> r, true) : false;
-    case ND_LT: return (try_eval_const(n->lhs, &l) && try_eval_const(n->rhs, &r)) ? (*result = l < r, true) : false;
-    case ND_LE: return (try_eval_const(n->lhs, &l) && try_eval_const(n->rhs, &r)) ? (*result = l <= r, true) : false;
-    case ND_GT: return (try_eval_const(n->lhs, &l) && try_eval_const(n->rhs, &r)) ? (*result = l > r, true) : false;
-    case ND_GE: return (try_eval_const(n->lhs, &l) && try_eval_const(n->rhs, &r)) ? (*result = l >= r, true) : false;
-    case ND_EQ: return (try_eval_const(n->lhs, &l) && try_eval_const(n->rhs, &r)) ? (*result = l == r, true) : false;
-    case ND_NE: return (try_eval_const(n->lhs, &l) && try_eval_const(n->rhs, &r)) ? (*result = l != r, true) : false;
-    case ND_BITAND: return (try_eval_const(n->lhs, &l) && try_eval_const(n->rhs, &r)) ? (*result = l & r, true) : false;
-    case ND_BITOR: return (try_eval_const(n->lhs, &l) && try_eval_const(n->rhs, &r)) ? (*result = l | r, true) : false;
-    case ND_BITXOR: return (try_eval_const(n->lhs, &l) && try_eval_const(n->rhs, &r)) ? (*result = l ^ r, true) : false;
-    case ND_AND: return (try_eval_const(n->lhs, &l) && try_eval_const(n->rhs, &r)) ? (*result = l && r, true) : false;
-    case ND_OR: return (try_eval_const(n->lhs, &l) && try_eval_const(n->rhs, &r)) ? (*result = l || r, true) : false;
-    case ND_TERNARY: {
-        long long c, t, e;
-        if (try_eval_const(n->lhs, &c) && try_eval_const(n->rhs, &t) && try_eval_const(n->third, &e))
-            return *result = c ? t : e, true;
-        return false;
-    }
-    case ND_CAST:
-        return try_eval_const(n->cast_expr, result);
-    default: return false;
-    }
-}
-
 void parser_init(Parser *p, Lexer *l, Arena *a, SymTab *st) {
     p->lexer = l;
     p->arena = a;
     p->symtab = st;
     p->loop_depth = 0;
     p->switch_depth = 0;
+    p->cur_switch = NULL;
     NEXT(); /* prime the first token */
 }
 
@@ -215,10 +176,8 @@ static Type *parse_type_specifier(Parser *p, StorageClass *sc) {
                             NEXT();
                             /* Parse constant expression for bitfield width */
                             Node *bw = parse_cond_expr(p);
-                            if (bw->kind == ND_INT_LIT)
-                                bit_width = (int)bw->ival;
-                            else
-                                bit_width = 1;
+                            long long w;
+                            bit_width = fold_eval_int(bw, &w) ? (int)w : 1;
                         }
 
                         Member *m = arena_calloc(p->arena, sizeof(Member));
@@ -338,8 +297,9 @@ static Type *parse_type_specifier(Parser *p, StorageClass *sc) {
                     NEXT();
                     if (MATCH(TK_ASSIGN)) {
                         Node *e = parse_cond_expr(p);
-                        if (e->kind == ND_INT_LIT)
-                            val = (long long)e->ival;
+                        long long v;
+                        if (fold_eval_int(e, &v))
+                            val = v;
                     }
                     Symbol *es = symtab_define(p->symtab, ename, SYM_ENUM_CONST, ty_int, eloc);
                     es->enum_val = val;
@@ -425,6 +385,23 @@ static Type *parse_type_specifier(Parser *p, StorageClass *sc) {
     return result;
 }
 
+#define MAX_ARRAY_DIMS 16
+
+/* One [n] suffix of a declarator */
+typedef struct {
+    int   len;   /* -1: incomplete or VLA */
+    bool  vla;
+    Node *size;  /* VLA length expression (NULL for [*]) */
+} ArrayDim;
+
+/* Wrap base in the array suffixes dims[0..n), the last one innermost */
+static Type *apply_array_dims(Parser *p, Type *base, ArrayDim *dims, int n) {
+    for (int i = n - 1; i >= 0; i--)
+        base = dims[i].vla ? type_vla(p->arena, base, dims[i].size)
+                           : type_array(p->arena, base, dims[i].len);
+    return base;
+}
+
 /* Parse declarator: pointers, arrays, function params
  * Returns the final type. If name is non-NULL, stores the declared name. */
 static Type *parse_declarator(Parser *p, Type *base, const char **name) {
@@ -479,47 +456,48 @@ static Type *parse_declarator(Parser *p, Type *base, const char **name) {
     }
 
     /* parse suffix: */
-    /* Array / Function suffixes */
+    /* Array / Function suffixes.  The dimensions of a run of array
+     * suffixes apply innermost last: a[2][4] is 2 arrays of 4 elements. */
+    ArrayDim dims[MAX_ARRAY_DIMS];
+    int ndims = 0;
     for (;;) {
         if (TOK.kind == TK_LBRACKET) {
             NEXT();
+            ArrayDim *d = &dims[ndims < MAX_ARRAY_DIMS ? ndims++ : MAX_ARRAY_DIMS - 1];
+            d->len = -1;
+            d->vla = false;
+            d->size = NULL;
             if (TOK.kind == TK_RBRACKET) {
                 /* Incomplete array */
                 NEXT();
-                base = type_array(p->arena, base, -1);
             } else if (TOK.kind == TK_STAR && PEEK().kind == TK_RBRACKET) {
                 /* VLA with * */
                 NEXT(); NEXT();
-                base = type_vla(p->arena, base, NULL);
-            } else if (TOK.kind == TK_STATIC || is_type_spec_qual(p)) {
+                d->vla = true;
+            } else {
                 /* static or qualifiers in array declarator (C99) - skip them */
                 while (TOK.kind == TK_STATIC || TOK.kind == TK_CONST ||
                        TOK.kind == TK_VOLATILE || TOK.kind == TK_RESTRICT)
                     NEXT();
                 if (TOK.kind == TK_RBRACKET) {
                     NEXT();
-                    base = type_array(p->arena, base, -1);
                 } else {
                     Node *size = parse_assign_expr(p);
                     EXPECT(TK_RBRACKET);
                     long long cv;
-                    if (try_eval_const(size, &cv)) {
-                        base = type_array(p->arena, base, (int)cv);
+                    if (fold_eval_int(size, &cv)) {
+                        d->len = (int)cv;
                     } else {
-                        base = type_vla(p->arena, base, size);
+                        d->vla = true;
+                        d->size = size;
                     }
                 }
-            } else {
-                Node *size = parse_assign_expr(p);
-                EXPECT(TK_RBRACKET);
-                long long cv;
-                if (try_eval_const(size, &cv)) {
-                    base = type_array(p->arena, base, (int)cv);
-                } else {
-                    base = type_vla(p->arena, base, size);
-                }
             }
-        } else if (TOK.kind == TK_LPAREN) {
+            continue;
+        }
+        base = apply_array_dims(p, base, dims, ndims);
+        ndims = 0;
+        if (TOK.kind == TK_LPAREN) {
             NEXT();
             Type *func = type_func(p->arena, base);
 
@@ -643,6 +621,18 @@ static Node *parse_primary_expr(Parser *p) {
     case TK_IDENT: {
         const char *name = TOK.str;
         NEXT();
+        if (TOK.kind == TK_LPAREN && (strcmp(name, "va_arg") == 0 ||
+                                      strcmp(name, "__builtin_va_arg") == 0)) {
+            /* va_arg(ap, type): the second operand is a type name */
+            NEXT();
+            Node *n = node_new(p->arena, ND_VA_ARG, loc);
+            n->lhs = parse_assign_expr(p);
+            EXPECT(TK_COMMA);
+            n->cast_type = parse_type_name(p);
+            EXPECT(TK_RPAREN);
+            n->type = n->cast_type;
+            return n;
+        }
         Node *n = node_ident(p->arena, name, loc);
         /* Look up symbol for type info */
         Symbol *sym = symtab_lookup(p->symtab, name);
@@ -771,6 +761,15 @@ static Node *parse_unary_expr(Parser *p) {
         n->type = n->lhs->type;
         return n;
     }
+    if (TOK.kind == TK_AND && PEEK().kind == TK_IDENT) {
+        /* GNU labels as values: &&label */
+        NEXT();
+        Node *n = node_new(p->arena, ND_LABEL_ADDR, loc);
+        n->name = TOK.str;
+        n->type = type_ptr(p->arena, ty_void);
+        NEXT();
+        return n;
+    }
     if (MATCH(TK_AMP)) {
         Node *operand = parse_cast_expr(p);
         Node *n = node_unary(p->arena, ND_ADDR, operand, loc);
@@ -1126,9 +1125,12 @@ static Node *parse_stmt(Parser *p) {
         EXPECT(TK_RPAREN);
         Node *n = node_new(p->arena, ND_SWITCH, loc);
         n->switch_expr = expr;
+        Node *outer = p->cur_switch;
+        p->cur_switch = n;
         p->switch_depth++;
         n->switch_body = parse_stmt(p);
         p->switch_depth--;
+        p->cur_switch = outer;
         return n;
     }
 
@@ -1138,8 +1140,13 @@ static Node *parse_stmt(Parser *p) {
         EXPECT(TK_COLON);
         Node *n = node_new(p->arena, ND_CASE, loc);
         n->case_expr = expr;
-        if (expr->kind == ND_INT_LIT)
-            n->case_val = (long long)expr->ival;
+        fold_eval_int(expr, &n->case_val);
+        if (p->cur_switch) {
+            /* Append to the switch's case list, in source order */
+            Node **tail = &p->cur_switch->switch_cases;
+            while (*tail) tail = &(*tail)->case_next;
+            *tail = n;
+        }
         n->case_body = parse_stmt(p);
         return n;
     }
@@ -1148,6 +1155,7 @@ static Node *parse_stmt(Parser *p) {
         NEXT();
         EXPECT(TK_COLON);
         Node *n = node_new(p->arena, ND_DEFAULT, loc);
+        if (p->cur_switch) p->cur_switch->switch_default = n;
         n->lhs = parse_stmt(p);
         return n;
     }
@@ -1174,8 +1182,13 @@ static Node *parse_stmt(Parser *p) {
     if (TOK.kind == TK_GOTO) {
         NEXT();
         Node *n = node_new(p->arena, ND_GOTO, loc);
-        n->name = TOK.str;
-        EXPECT(TK_IDENT);
+        if (MATCH(TK_STAR)) {
+            /* GNU computed goto: goto *expr; */
+            n->lhs = parse_expr(p);
+        } else {
+            n->name = TOK.str;
+            EXPECT(TK_IDENT);
+        }
         EXPECT(TK_SEMICOLON);
         return n;
     }
@@ -1324,6 +1337,7 @@ static Node *parse_declaration(Parser *p) {
                                             decl->var_init->slen + 1);
                     ty = decl->type;
                 }
+                sym->type = ty;  /* sizeof sees the completed array */
             }
 
             cur->next = decl;
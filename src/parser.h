@@ -11,6 +11,7 @@ typedef struct {
     SymTab *symtab;
     int     loop_depth;    /* nesting level for break/continue */
     int     switch_depth;  /* nesting level for switch */
+    Node   *cur_switch;    /* innermost switch: collects its case labels */
 } Parser;
 
 void  parser_init(Parser *p, Lexer *l, Arena *a, SymTab *st);
@@ -9,8 +9,8 @@
 /* Portable strdup (not available in strict C99) */
 static char *pp_strdup(const char *s) {
     size_t len = strlen(s) + 1;
-    char *p = malloc(len);
-    if (p) memcpy(p, s, len);
+    char *p = xmalloc(len);
+    memcpy(p, s, len);
     return p;
 }
 
@@ -62,7 +62,7 @@ static void define_macro(const char *name, const char *body, bool is_func,
             return;
         }
     }
-    Macro *m = calloc(1, sizeof(Macro));
+    Macro *m = xcalloc(1, sizeof(Macro));
     m->name = pp_strdup(name);
     m->body = body ? pp_strdup(body) : "";
     m->is_func = is_func;
@@ -139,7 +139,7 @@ static const char *pp_read_ident(PPState *pp) {
     while (isalnum((unsigned char)*pp->p) || *pp->p == '_') pp->p++;
     if (pp->p == start) return NULL;
     size_t len = (size_t)(pp->p - start);
-    char *s = malloc(len + 1);
+    char *s = xmalloc(len + 1);
     memcpy(s, start, len);
     s[len] = '\0';
     return s;
@@ -818,7 +818,7 @@ char *preprocess(const char *src, const char *filename,
                         }
                         const char *pname = pp_read_ident(&pp);
                         if (pname) {
-                            MacroParam *mp = calloc(1, sizeof(MacroParam));
+                            MacroParam *mp = xcalloc(1, sizeof(MacroParam));
                             mp->name = pname;
                             cur->next = mp;
                             cur = mp;
@@ -0,0 +1,346 @@
+#include "range.h"
+#include <string.h>
+
+/* A loop counter and the values it holds in the loop body */
+struct RangeBound {
+    const char *name;
+    long long   lo, hi;
+    RangeBound *next;
+};
+
+#define RANGE_LIMIT (1LL << 53)
+
+void range_init(Ranges *rs, Arena *a) {
+    rs->arena = a;
+    rs->bounds = NULL;
+}
+
+/* Values of integer type t; false for long long (wider than RANGE_LIMIT)
+ * and _Bool */
+static bool type_range(Type *t, long long *lo, long long *hi) {
+    if (!t || !type_is_integer(t) || t->kind == TY_BOOL || t->kind == TY_LLONG) return false;
+    int bits = t->size * 8;
+    if (t->is_unsigned) {
+        *lo = 0;
+        *hi = (1LL << bits) - 1;
+    } else {
+        *lo = -(1LL << (bits - 1));
+        *hi = (1LL << (bits - 1)) - 1;
+    }
+    return true;
+}
+
+bool range_fits(Type *t, long long lo, long long hi) {
+    long long tlo, thi;
+    if (t->kind == TY_LLONG) return !t->is_unsigned || lo >= 0;
+    return type_range(t, &tlo, &thi) && tlo <= lo && hi <= thi;
+}
+
+/* floor(x / 2^k) */
+static long long range_shr(long long x, int k) {
+    return x >= 0 ? x >> k : -((-x - 1) >> k) - 1;
+}
+
+/* Exact value of a op b for a in [alo, ahi] and b in [blo, bhi], before
+ * any wraparound; uns: the operation is unsigned.  False if unknown or
+ * beyond RANGE_LIMIT. */
+static bool binop_range(NodeKind k, bool uns, long long alo, long long ahi,
+                        long long blo, long long bhi, long long *lo, long long *hi) {
+    long long p[4], m;
+    switch (k) {
+    case ND_ADD:
+        *lo = alo + blo; *hi = ahi + bhi;
+        break;
+    case ND_SUB:
+        *lo = alo - bhi; *hi = ahi - blo;
+        break;
+    case ND_MUL:
+        m = 1LL << 31;
+        if (alo < -m || ahi > m || blo < -m || bhi > m) return false;
+        p[0] = alo * blo; p[1] = alo * bhi; p[2] = ahi * blo; p[3] = ahi * bhi;
+        *lo = *hi = p[0];
+        for (int i = 1; i < 4; i++) {
+            if (p[i] < *lo) *lo = p[i];
+            if (p[i] > *hi) *hi = p[i];
+        }
+        break;
+    case ND_DIV:
+        /* Truncating division by a positive divisor */
+        if (blo < 1 || (uns && alo < 0)) return false;
+        *lo = alo >= 0 ? alo / bhi : alo / blo;
+        *hi = ahi >= 0 ? ahi / blo : ahi / bhi;
+        break;
+    case ND_MOD:
+        /* The remainder takes the dividend's sign and is below the divisor */
+        if (blo < 1 || (uns && alo < 0)) return false;
+        m = bhi - 1;
+        *lo = alo >= 0 ? 0 : (alo > -m ? alo : -m);
+        *hi = ahi <= 0 ? 0 : (ahi < m ? ahi : m);
+        break;
+    case ND_LSHIFT:
+        if (blo != bhi || blo < 0 || blo > 31 || alo < 0 || ahi > (RANGE_LIMIT >> blo))
+            return false;
+        *lo = alo << blo; *hi = ahi << blo;
+        break;
+    case ND_RSHIFT:
+        if (blo != bhi || blo < 0 || blo > 31 || (uns && alo < 0)) return false;
+        *lo = range_shr(alo, (int)blo); *hi = range_shr(ahi, (int)blo);
+        break;
+    case ND_BITAND:
+        /* A non-negative operand masks the result */
+        if (alo < 0 && blo < 0) return false;
+        *lo = 0;
+        *hi = alo < 0 ? bhi : blo < 0 ? ahi : (ahi < bhi ? ahi : bhi);
+        break;
+    case ND_BITOR: case ND_BITXOR:
+        if (alo < 0 || blo < 0) return false;
+        m = ahi > bhi ? ahi : bhi;
+        *lo = 0;
+        for (*hi = 1; *hi <= m; *hi <<= 1) {}
+        *hi -= 1;
+        break;
+    default:
+        return false;
+    }
+    return *lo >= -RANGE_LIMIT && *hi <= RANGE_LIMIT;
+}
+
+/* Operators whose result is re-wrapped to their type at least give that
+ * type's range */
+bool range_of(Ranges *rs, Node *n, long long *lo, long long *hi) {
+    long long alo, ahi, blo, bhi;
+    Type *t = n ? n->type : NULL;
+    if (!t || !type_is_integer(t)) return false;
+
+    switch (n->kind) {
+    case ND_INT_LIT:
+        if (t->kind != TY_LLONG)
+            *lo = t->is_unsigned ? (long long)(unsigned)n->ival : (long long)(int)n->ival;
+        else if (t->is_unsigned && n->ival > (unsigned long long)RANGE_LIMIT)
+            return false;
+        else
+            *lo = (long long)n->ival;
+        *hi = *lo;
+        return *lo >= -RANGE_LIMIT && *lo <= RANGE_LIMIT;
+    case ND_CHAR_LIT:
+        *lo = *hi = n->cval;
+        return true;
+
+    case ND_IDENT:
+        for (RangeBound *b = rs->bounds; b; b = b->next) {
+            if (strcmp(b->name, n->name) == 0) {
+                *lo = b->lo; *hi = b->hi;
+                return true;
+            }
+        }
+        return type_range(t, lo, hi);
+
+    case ND_CAST: {
+        Type *from = n->cast_expr->type;
+        if (t->kind != TY_BOOL && from && type_is_integer(from) &&
+            range_of(rs, n->cast_expr, lo, hi) && range_fits(t, *lo, *hi))
+            return true;
+        return type_range(t, lo, hi);
+    }
+
+    case ND_ADD: case ND_SUB: case ND_MUL: case ND_DIV: case ND_MOD:
+    case ND_LSHIFT: case ND_RSHIFT:
+    case ND_BITAND: case ND_BITOR: case ND_BITXOR:
+        if (range_of(rs, n->lhs, &alo, &ahi) && range_of(rs, n->rhs, &blo, &bhi) &&
+            binop_range(n->kind, t->is_unsigned, alo, ahi, blo, bhi, lo, hi) &&
+            range_fits(t, *lo, *hi))
+            return true;
+        return type_range(t, lo, hi);
+
+    case ND_NEG:
+        if (range_of(rs, n->lhs, &alo, &ahi) && range_fits(t, -ahi, -alo)) {
+            *lo = -ahi; *hi = -alo;
+            return true;
+        }
+        return type_range(t, lo, hi);
+
+    case ND_LT: case ND_LE: case ND_GT: case ND_GE:
+    case ND_EQ: case ND_NE:
+    case ND_AND: case ND_OR: case ND_NOT:
+        *lo = 0; *hi = 1;
+        return true;
+
+    case ND_TERNARY:
+        /* Arms are not converted to the result type: both must fit it */
+        if (!range_of(rs, n->rhs, lo, hi) || !range_of(rs, n->third, &blo, &bhi))
+            return false;
+        if (blo < *lo) *lo = blo;
+        if (bhi > *hi) *hi = bhi;
+        return range_fits(t, *lo, *hi);
+    case ND_COMMA:
+        return range_of(rs, n->rhs, lo, hi) && range_fits(t, *lo, *hi);
+
+    case ND_ASSIGN:
+    case ND_ADD_ASSIGN: case ND_SUB_ASSIGN: case ND_MUL_ASSIGN:
+    case ND_DIV_ASSIGN: case ND_MOD_ASSIGN:
+    case ND_LSHIFT_ASSIGN: case ND_RSHIFT_ASSIGN:
+    case ND_AND_ASSIGN: case ND_OR_ASSIGN: case ND_XOR_ASSIGN:
+    case ND_PRE_INC: case ND_PRE_DEC: case ND_POST_INC: case ND_POST_DEC:
+    case ND_DEREF: case ND_MEMBER: case ND_MEMBER_PTR: case ND_SUBSCRIPT:
+    case ND_BITNOT: case ND_SIZEOF: case ND_SIZEOF_TYPE:
+        return type_range(t, lo, hi);
+
+    default:
+        /* Calls and va_arg: the callee is not trusted to narrow */
+        return false;
+    }
+}
+
+/* True if JS evaluates a op b exactly (before any |0 or >>>0) for a lower
+ * bound alo and a result of at most hi: Math.imul and bitwise operators
+ * return int32, / is a float division, and % of a negative dividend may
+ * give -0 */
+static bool js_op_exact(NodeKind k, long long alo, long long hi) {
+    switch (k) {
+    case ND_ADD: case ND_SUB: case ND_RSHIFT:
+        return true;
+    case ND_MOD:
+        return alo >= 0;
+    case ND_MUL: case ND_LSHIFT: case ND_BITAND: case ND_BITOR: case ND_BITXOR:
+        return hi <= 2147483647LL;
+    default:
+        return false;
+    }
+}
+
+bool range_binop_exact(Ranges *rs, Node *n) {
+    long long alo, ahi, blo, bhi, lo, hi;
+    return range_of(rs, n->lhs, &alo, &ahi) && range_of(rs, n->rhs, &blo, &bhi) &&
+           binop_range(n->kind, n->type->is_unsigned, alo, ahi, blo, bhi, &lo, &hi) &&
+           range_fits(n->type, lo, hi) && js_op_exact(n->kind, alo, hi);
+}
+
+/* A long long operand contributes its low word, which is the value when it
+ * is a non-negative int32 */
+bool range_cast_exact(Ranges *rs, Node *n) {
+    long long lo, hi;
+    Type *from = n->cast_expr->type;
+    return n->cast_type->kind != TY_BOOL && from && type_is_integer(from) &&
+           range_of(rs, n->cast_expr, &lo, &hi) && range_fits(n->cast_type, lo, hi) &&
+           (from->kind != TY_LLONG || (lo >= 0 && hi <= 2147483647LL));
+}
+
+/* Follows the JS that codegen emits for the update: an ++, --, op= or =
+ * whose right operand is a 32-bit integer */
+bool range_update(Ranges *rs, Node *n, Type *lt, long long *lo, long long *hi) {
+    long long alo, ahi, blo = 1, bhi = 1;
+    NodeKind k;
+    if (!type_is_integer(lt)) return false;
+    if (n->kind != ND_PRE_INC && n->kind != ND_PRE_DEC &&
+        n->kind != ND_POST_INC && n->kind != ND_POST_DEC &&
+        (!n->rhs->type || !type_is_integer(n->rhs->type) || n->rhs->type->kind == TY_LLONG ||
+         !range_of(rs, n->rhs, &blo, &bhi)))
+        return false;
+    if (n->kind == ND_ASSIGN) {
+        *lo = blo; *hi = bhi;
+        return true;
+    }
+    switch (n->kind) {
+    case ND_PRE_INC: case ND_POST_INC: case ND_ADD_ASSIGN: k = ND_ADD; break;
+    case ND_PRE_DEC: case ND_POST_DEC: case ND_SUB_ASSIGN: k = ND_SUB; break;
+    case ND_MUL_ASSIGN: k = ND_MUL; break;
+    case ND_MOD_ASSIGN: k = ND_MOD; break;
+    case ND_LSHIFT_ASSIGN: k = ND_LSHIFT; break;
+    case ND_RSHIFT_ASSIGN: k = ND_RSHIFT; break;
+    case ND_AND_ASSIGN: k = ND_BITAND; break;
+    case ND_OR_ASSIGN: k = ND_BITOR; break;
+    case ND_XOR_ASSIGN: k = ND_BITXOR; break;
+    default: return false;
+    }
+    if (!range_of(rs, n->lhs, &alo, &ahi) ||
+        !binop_range(k, lt->is_unsigned, alo, ahi, blo, bhi, lo, hi))
+        return false;
+    return js_op_exact(k, alo, *hi);
+}
+
+const char *range_counter(Node *n) {
+    Node *init = n->for_init;
+    if (!init) return NULL;
+    if (init->kind == ND_VAR_DECL && !init->next && init->var_init &&
+        init->var_init->kind != ND_INIT_LIST)
+        return init->var_name;
+    if (init->kind == ND_ASSIGN && init->lhs->kind == ND_IDENT)
+        return init->lhs->name;
+    return NULL;
+}
+
+/* Matches "i = a; i < e; i += s" with a constant step (also <=, and > / >=
+ * counting down), where the loop assigns i nowhere else.  The last
+ * increment must stay within i's type, so i never wraps and lies between a
+ * and the bound whenever the body runs. */
+bool range_loop(Ranges *rs, Node *n, Type *ty) {
+    Node *init = n->for_init, *cond = n->for_cond, *inc = n->for_inc;
+    const char *name = range_counter(n);
+    Node *start, *ctr;
+    long long alo, ahi, elo, ehi, slo, shi, tlo, thi, step, lo, hi;
+
+    if (!name || !cond || !inc || !type_is_integer(ty) || ty->kind == TY_BOOL) return false;
+    start = init->kind == ND_VAR_DECL ? init->var_init : init->rhs;
+    if (!type_range(ty, &tlo, &thi)) {
+        tlo = ty->is_unsigned ? 0 : -RANGE_LIMIT;
+        thi = RANGE_LIMIT;
+    }
+    if (!range_of(rs, start, &alo, &ahi) || alo < tlo || ahi > thi) return false;
+
+    if (!inc->lhs || inc->lhs->kind != ND_IDENT || strcmp(inc->lhs->name, name) != 0)
+        return false;
+    if (inc->kind == ND_PRE_INC || inc->kind == ND_POST_INC) {
+        step = 1;
+    } else if (inc->kind == ND_PRE_DEC || inc->kind == ND_POST_DEC) {
+        step = -1;
+    } else if ((inc->kind == ND_ADD_ASSIGN || inc->kind == ND_SUB_ASSIGN) &&
+               range_of(rs, inc->rhs, &slo, &shi) && slo == shi &&
+               slo >= 1 && slo <= (1LL << 31)) {
+        step = inc->kind == ND_ADD_ASSIGN ? slo : -slo;
+    } else {
+        return false;
+    }
+
+    /* The counter, possibly widened, against the bound */
+    ctr = cond->lhs;
+    if (ctr && ctr->kind == ND_CAST && range_fits(ctr->cast_type, tlo, thi))
+        ctr = ctr->cast_expr;
+    if (!ctr || ctr->kind != ND_IDENT || strcmp(ctr->name, name) != 0) return false;
+    if (!range_of(rs, cond->rhs, &elo, &ehi)) return false;
+    if (type_usual_arith(rs->arena, cond->lhs->type, cond->rhs->type)->is_unsigned &&
+        (alo < 0 || elo < 0))
+        return false;
+
+    if (step > 0) {
+        if (cond->kind == ND_LT) hi = ehi - 1;
+        else if (cond->kind == ND_LE) hi = ehi;
+        else return false;
+        if (hi + step > thi) return false;
+        lo = alo;
+    } else {
+        if (cond->kind == ND_GT) lo = elo + 1;
+        else if (cond->kind == ND_GE) lo = elo;
+        else return false;
+        if (lo + step < tlo) return false;
+        hi = ahi;
+    }
+    if (hi < lo) hi = lo; /* the body never runs */
+
+    if (node_writes_name(cond, name) || node_writes_name(n->for_body, name)) return false;
+
+    RangeBound *b = arena_alloc(rs->arena, sizeof(RangeBound));
+    b->name = name;
+    b->lo = lo;
+    b->hi = hi;
+    b->next = rs->bounds;
+    rs->bounds = b;
+    return true;
+}
+
+RangeBound *range_mark(Ranges *rs) {
+    return rs->bounds;
+}
+
+void range_drop(Ranges *rs, RangeBound *mark) {
+    rs->bounds = mark;
+}
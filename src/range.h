@@ -0,0 +1,42 @@
+#ifndef C99JS_RANGE_H
+#define C99JS_RANGE_H
+
+#include "ast.h"
+
+/* Value ranges.  A conservative interval [lo, hi] of the C value of an
+ * integer expression, which codegen consults to drop a |0, >>>0 or
+ * narrowing mask whose operand is already in range, and to pass a long
+ * long to printf-style varargs as a Number when it stays within 2^53.
+ * Locals and loads are known only by their type, except for the counters
+ * of the for loops being emitted (range_loop).  Intervals never leave
+ * +-2^53, so they are exact as JS numbers. */
+
+typedef struct RangeBound RangeBound;
+
+typedef struct {
+    Arena      *arena;
+    RangeBound *bounds;     /* counters of the enclosing loops */
+} Ranges;
+
+void range_init(Ranges *rs, Arena *a);
+/* Interval of the C value of integer expression n; false if unknown */
+bool range_of(Ranges *rs, Node *n, long long *lo, long long *hi);
+/* True if every value in [lo, hi] is representable in integer type t */
+bool range_fits(Type *t, long long lo, long long hi);
+/* True if the 32-bit integer operation n needs no wrap to its type */
+bool range_binop_exact(Ranges *rs, Node *n);
+/* True if integer cast n leaves its operand's value unchanged */
+bool range_cast_exact(Ranges *rs, Node *n);
+/* Range of the integer value assignment or update n computes for lvalue
+ * type lt; false if unknown or if JS may compute it inexactly */
+bool range_update(Ranges *rs, Node *n, Type *lt, long long *lo, long long *hi);
+
+/* Name of the variable the init clause of for loop n assigns, or NULL */
+const char *range_counter(Node *n);
+/* Bound the counter of for loop n, a JS local of integer type ty, inside
+ * its body and increment; false if the loop does not bound it */
+bool range_loop(Ranges *rs, Node *n, Type *ty);
+RangeBound *range_mark(Ranges *rs);
+void range_drop(Ranges *rs, RangeBound *mark);   /* leave loops entered since mark */
+
+#endif /* C99JS_RANGE_H */
@@ -17,10 +17,28 @@ static void ensure_type(Sema *s, Node *n) {
     n->type = ty_int; /* fallback */
 }
 
-/* Array-to-pointer decay: char[] -> char*, etc. */
+/* Array-to-pointer decay: char[] -> char*, etc.  Names and literals are
+ * retyped in place; an array reached through an lvalue (m[i], s.a, p->a)
+ * becomes the address of its first element, so it is not loaded as a
+ * pointer. */
 static void decay_array(Sema *s, Node *n) {
-    if (n && n->type && n->type->kind == TY_ARRAY)
-        n->type = type_ptr(s->arena, n->type->base);
+    if (!n || !n->type || n->type->kind != TY_ARRAY) return;
+    Type *ptr = type_ptr(s->arena, n->type->base);
+    if (n->kind != ND_SUBSCRIPT && n->kind != ND_MEMBER && n->kind != ND_MEMBER_PTR &&
+        n->kind != ND_DEREF) {
+        n->type = ptr;
+        return;
+    }
+    Node *arr = node_new(s->arena, n->kind, n->loc);
+    *arr = *n;
+    arr->next = NULL;
+    Node *next = n->next;
+    memset(n, 0, sizeof(*n));
+    n->kind = ND_ADDR;
+    n->loc = arr->loc;
+    n->lhs = arr;
+    n->type = ptr;
+    n->next = next;
 }
 
 /* Insert implicit cast if types differ */
@@ -86,7 +104,9 @@ static void check_expr(Sema *s, Node *n) {
     case ND_DEREF:
         check_expr(s, n->lhs);
         ensure_type(s, n->lhs);
-        if (!type_is_ptr(n->lhs->type) && !type_is_array(n->lhs->type))
+        if (n->lhs->type->kind == TY_FUNC)
+            n->type = n->lhs->type; /* *f is f for a function designator */
+        else if (!type_is_ptr(n->lhs->type) && !type_is_array(n->lhs->type))
             error_at(n->loc, "cannot dereference non-pointer type");
         else
             n->type = n->lhs->type->base;
@@ -98,6 +118,10 @@ static void check_expr(Sema *s, Node *n) {
         n->type = type_ptr(s->arena, n->lhs->type);
         break;
 
+    case ND_LABEL_ADDR:
+        n->type = type_ptr(s->arena, ty_void);
+        break;
+
     case ND_PRE_INC: case ND_PRE_DEC:
     case ND_POST_INC: case ND_POST_DEC:
         check_expr(s, n->lhs);
@@ -276,6 +300,12 @@ static void check_expr(Sema *s, Node *n) {
         n->type = n->cast_type;
         break;
 
+    case ND_VA_ARG:
+        check_expr(s, n->lhs);
+        ensure_type(s, n->lhs);
+        n->type = n->cast_type;
+        break;
+
     default:
         break;
     }
@@ -391,7 +421,15 @@ static void check_node(Sema *s, Node *n) {
     case ND_NULL_STMT:
     case ND_BREAK:
     case ND_CONTINUE:
+        break;
+
     case ND_GOTO:
+        if (n->lhs) {
+            check_expr(s, n->lhs);
+            ensure_type(s, n->lhs);
+            if (!type_is_ptr(n->lhs->type))
+                error_at(n->loc, "computed goto needs a pointer operand");
+        }
         break;
 
     default:
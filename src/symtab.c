@@ -8,8 +8,15 @@ static unsigned int sym_hash(const char *name) {
     return h % SCOPE_HASH_SIZE;
 }
 
-static Scope *new_scope(Arena *a, Scope *parent) {
-    Scope *s = arena_calloc(a, sizeof(Scope));
+static Scope *new_scope(SymTab *st, Scope *parent) {
+    /* Nothing refers to a scope once it is left, so its table is reused */
+    Scope *s = st->free_scopes;
+    if (s) {
+        st->free_scopes = s->parent;
+        memset(s, 0, sizeof(Scope));
+    } else {
+        s = arena_calloc(st->arena, sizeof(Scope));
+    }
     s->parent = parent;
     s->depth = parent ? parent->depth + 1 : 0;
     return s;
@@ -17,17 +24,21 @@ static Scope *new_scope(Arena *a, Scope *parent) {
 
 void symtab_init(SymTab *st, Arena *a) {
     st->arena = a;
-    st->file_scope = new_scope(a, NULL);
+    st->free_scopes = NULL;
+    st->file_scope = new_scope(st, NULL);
     st->current = st->file_scope;
 }
 
 void symtab_enter_scope(SymTab *st) {
-    st->current = new_scope(st->arena, st->current);
+    st->current = new_scope(st, st->current);
 }
 
 void symtab_leave_scope(SymTab *st) {
-    if (st->current->parent)
-        st->current = st->current->parent;
+    Scope *s = st->current;
+    if (!s->parent) return;
+    st->current = s->parent;
+    s->parent = st->free_scopes;
+    st->free_scopes = s;
 }
 
 void symtab_enter_func_scope(SymTab *st) {
@@ -59,6 +59,7 @@ typedef struct {
     Arena *arena;
     Scope *current;
     Scope *file_scope;       /* global scope */
+    Scope *free_scopes;      /* left scopes, reused by the next enter */
 } SymTab;
 
 void    symtab_init(SymTab *st, Arena *a);
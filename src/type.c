@@ -219,8 +219,8 @@ static int type_rank(Type *t) {
 
 Type *type_int_promote(Arena *a, Type *t) {
     (void)a;
-    if (type_rank(t) < type_rank(ty_int)) {
-        /* Everything smaller than int promotes to int */
+    if (type_is_integer(t) && type_rank(t) < type_rank(ty_int)) {
+        /* Integer types smaller than int promote to int */
         return ty_int;
     }
     return t;
@@ -6,9 +6,33 @@
 int error_count = 0;
 int warn_count = 0;
 
+/* ---- Checked allocation ---- */
+static void out_of_memory(size_t size) {
+    fprintf(stderr, "error: out of memory (allocating %lu bytes)\n", (unsigned long)size);
+    exit(1);
+}
+
+void *xmalloc(size_t size) {
+    void *p = malloc(size);
+    if (!p && size) out_of_memory(size);
+    return p;
+}
+
+void *xcalloc(size_t count, size_t size) {
+    void *p = calloc(count, size);
+    if (!p && count && size) out_of_memory(count * size);
+    return p;
+}
+
+void *xrealloc(void *p, size_t size) {
+    void *q = realloc(p, size);
+    if (!q && size) out_of_memory(size);
+    return q;
+}
+
 /* ---- Arena allocator ---- */
 static ArenaBlock *arena_new_block(size_t size) {
-    ArenaBlock *b = malloc(sizeof(ArenaBlock) + size);
+    ArenaBlock *b = xmalloc(sizeof(ArenaBlock) + size);
     b->next = NULL;
     b->size = size;
     b->used = 0;
@@ -76,7 +100,7 @@ static void buf_grow(Buf *b, size_t need) {
     if (b->len + need <= b->cap) return;
     size_t ncap = b->cap ? b->cap * 2 : 64;
     while (ncap < b->len + need) ncap *= 2;
-    b->data = realloc(b->data, ncap);
+    b->data = xrealloc(b->data, ncap);
     b->cap = ncap;
 }
 
@@ -163,7 +187,7 @@ char *read_file(const char *path, size_t *out_len) {
     fseek(f, 0, SEEK_END);
     long sz = ftell(f);
     fseek(f, 0, SEEK_SET);
-    char *buf = malloc((size_t)sz + 1);
+    char *buf = xmalloc((size_t)sz + 1);
     size_t rd = fread(buf, 1, (size_t)sz, f);
     buf[rd] = '\0';
     fclose(f);
@@ -197,7 +221,7 @@ const char *str_intern_range(const char *start, const char *end) {
         if (e->len == len && memcmp(e->str, start, len) == 0)
             return e->str;
     }
-    InternEntry *e = malloc(sizeof(InternEntry) + len + 1);
+    InternEntry *e = xmalloc(sizeof(InternEntry) + len + 1);
     e->len = len;
     memcpy(e->str, start, len);
     e->str[len] = '\0';
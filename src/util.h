@@ -13,6 +13,13 @@ typedef struct {
     int col;
 } SrcLoc;
 
+/* ---- Checked allocation ---- */
+/* malloc/calloc/realloc that report running out of memory and exit instead of
+ * returning NULL */
+void *xmalloc(size_t size);
+void *xcalloc(size_t count, size_t size);
+void *xrealloc(void *p, size_t size);
+
 /* ---- Arena allocator ---- */
 typedef struct ArenaBlock {
     struct ArenaBlock *next;
@@ -57,7 +64,7 @@ void buf_free(Buf *b);
 #define vec_push(v, item) do { \
     if ((v).len >= (v).cap) { \
         (v).cap = (v).cap ? (v).cap * 2 : 8; \
-        (v).data = realloc((v).data, sizeof(*(v).data) * (v).cap); \
+        (v).data = xrealloc((v).data, sizeof(*(v).data) * (v).cap); \
     } \
     (v).data[(v).len++] = (item); \
 } while(0)
@@ -88,6 +88,33 @@ run_test() {
     PASS=$((PASS + 1))
 }
 
+# Compare the --dump-ir output of a source file with the expected text
+run_dump_test() {
+    local src="$1"
+    local expect_file="$2"
+    local name
+    name=$(basename "$expect_file")
+
+    printf "  %-25s " "$name"
+
+    local actual_out
+    if ! actual_out=$($C99JS --dump-ir "$src" 2>&1); then
+        echo "FAIL (compile error)"
+        FAIL=$((FAIL + 1))
+        return
+    fi
+    actual_out=$(printf '%s' "$actual_out" | tr -d '\r')
+    if [ "$actual_out" != "$(tr -d '\r' < "$expect_file")" ]; then
+        echo "FAIL (output mismatch)"
+        diff <(tr -d '\r' < "$expect_file") <(printf '%s\n' "$actual_out") | head -5 | sed 's/^/    /'
+        FAIL=$((FAIL + 1))
+        return
+    fi
+
+    echo "PASS"
+    PASS=$((PASS + 1))
+}
+
 echo "c99js test suite"
 echo "  compiler: $C99JS"
 echo "  node:     $("$NODE" --version 2>/dev/null || echo "$NODE")"
@@ -115,6 +142,33 @@ run_test test/test_basic.c           0 "test/expected/test_basic.txt"
 run_test test/test_string.c          0 "test/expected/test_string.txt"
 run_test test/test_struct.c          0 "test/expected/test_struct.txt"
 run_test test/test_funcptr.c         0 "test/expected/test_funcptr.txt"
+run_test test/test_locals.c          0 "test/expected/test_locals.txt"
+run_test test/test_double.c          0 "test/expected/test_double.txt"
+run_test test/test_heap.c            0 "test/expected/test_heap.txt"
+run_test test/test_assign.c          0 "test/expected/test_assign.txt"
+run_test test/test_fold.c            0 "test/expected/test_fold.txt"
+run_test test/test_cond.c            0 "test/expected/test_cond.txt"
+run_test test/test_intmath.c         0 "test/expected/test_intmath.txt"
+run_test test/test_int64.c           0 "test/expected/test_int64.txt"
+run_test test/test_varargs.c         0 "test/expected/test_varargs.txt"
+run_test test/test_sroa.c            0 "test/expected/test_sroa.txt"
+run_test test/test_struct_pass.c     0 "test/expected/test_struct_pass.txt"
+run_test test/test_inline.c          0 "test/expected/test_inline.txt"
+run_test test/test_switch.c          0 "test/expected/test_switch.txt"
+run_test test/test_licm.c            0 "test/expected/test_licm.txt"
+run_test test/test_reach.c           0 "test/expected/test_reach.txt"
+run_test test/test_data.c            0 "test/expected/test_data.txt"
+run_test test/test_localinit.c       0 "test/expected/test_localinit.txt"
+run_test test/test_goto.c            0 "test/expected/test_goto.txt"
+run_test test/test_labelvalues.c     0 "test/expected/test_labelvalues.txt"
+run_test test/test_ir.c              0 "test/expected/test_ir.txt"
+run_test test/test_cse.c             0 "test/expected/test_cse.txt"
+run_test test/test_range.c           0 "test/expected/test_range.txt"
+run_test test/test_alias.c           0 "test/expected/test_alias.txt"
+run_test test/test_dse.c             0 "test/expected/test_dse.txt"
+
+# IR dumps: run_dump_test <source> <expected_dump_file>
+run_dump_test test/test_ir.c "test/expected/test_ir.ir"
 
 echo ""
 echo "Results: $PASS passed, $FAIL failed, $SKIP skipped (total $((PASS + FAIL + SKIP)))"
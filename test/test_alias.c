@@ -0,0 +1,94 @@
+/* Test: loads kept across stores that cannot alias them */
+#include <stdio.h>
+
+struct vec { int n; double *data; };
+union pun { int i; float f; unsigned char b[4]; };
+
+static int gtab[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+static int gout[8];
+static const int weights[4] = { 3, 5, 7, 11 };
+
+static void axpy(int n, double *restrict y, const double *restrict x, double a) {
+    for (int i = 0; i < n; i++) {
+        y[i] = y[i] + a * x[i];
+        y[i] += x[i] * x[i];
+    }
+}
+
+static void add_rows(int *restrict dst, const int *restrict src, int n) {
+    for (int i = 0; i < n; i++) {
+        dst[i] += src[i];
+        dst[i] += src[i] * 2;
+    }
+}
+
+static void scale(struct vec *v, double k) {
+    /* double stores leave v->data and v->n in place */
+    for (int i = 0; i < v->n; i++) {
+        v->data[i] = v->data[i] * k;
+        v->data[i] += 1.0;
+    }
+}
+
+static int globals(int k) {
+    /* distinct named arrays */
+    gout[k] = gtab[k] * 2;
+    gout[k + 1] = gtab[k] + gtab[k + 1];
+    return gout[k] + gout[k + 1] + gtab[k];
+}
+
+static int overlap(int *a, int *b) {
+    /* plain pointers of one type may alias */
+    int s = a[0];
+    b[0] = 100;
+    return s + a[0];
+}
+
+static int bytes(int *p, unsigned char *c) {
+    /* character stores may change any object */
+    int s = *p;
+    c[0] = 0x7F;
+    return s - *p;
+}
+
+static float punned(union pun *u) {
+    u->i = 0x3F800000;
+    float f = u->f;
+    u->b[3] = 0x40;
+    return f + u->f;
+}
+
+static int consts(int *p, int i) {
+    int s = weights[i] * 10;
+    *p = 5;
+    return s + weights[i] + *p;
+}
+
+int main(void) {
+    double y[4] = { 1, 2, 3, 4 }, x[4] = { 0.5, 1, 1.5, 2 };
+    axpy(4, y, x, 2.0);
+    printf("axpy %.2f %.2f %.2f %.2f\n", y[0], y[1], y[2], y[3]);
+
+    int d[3] = { 1, 2, 3 }, s[3] = { 10, 20, 30 };
+    add_rows(d, s, 3);
+    printf("rows %d %d %d\n", d[0], d[1], d[2]);
+
+    double buf[3] = { 1, 2, 3 };
+    struct vec v = { 3, buf };
+    scale(&v, 2.0);
+    printf("scale %.1f %.1f %.1f\n", buf[0], buf[1], buf[2]);
+
+    printf("globals %d %d\n", globals(1), globals(4));
+
+    int one[1] = { 7 };
+    printf("overlap %d\n", overlap(one, one));
+    int word = 0x01020304;
+    printf("bytes %d\n", bytes(&word, (unsigned char *)&word));
+
+    union pun u;
+    printf("punned %.1f\n", punned(&u));
+
+    int out;
+    printf("consts %d %d\n", consts(&out, 2), consts(&out, 3));
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include <stdio.h>
+
+/* Assignment, compound assignment and ++/-- in value and statement
+ * contexts, on JS locals and on memory (typed-array and DataView paths). */
+
+struct pt { int x, y; };
+
+static int counter;
+static int next(void) { return counter++; }
+
+int main(void) {
+    int arr[6] = { 1, 2, 3, 4, 5, 6 };
+    int *p = arr;
+    p += 2;
+    printf("p+=2 -> %d\n", *p);
+    p -= 1;
+    printf("p-=1 -> %d\n", *p);
+
+    int i = 0;
+    arr[i++] += 10;
+    arr[next()] *= 3;
+    printf("arr: %d %d %d i=%d counter=%d\n", arr[0], arr[1], arr[2], i, counter);
+
+    int a, b, c;
+    a = b = c = 7;
+    printf("chain: %d %d %d\n", a, b, c);
+
+    signed char sc[2] = { 0, 0 };
+    int v = (sc[0] = 300);
+    int w = ++sc[1];
+    sc[1] = 127;
+    int x = sc[1]++;
+    printf("char: %d %d %d %d\n", v, w, x, sc[1]);
+
+    unsigned char uc = 250;
+    int y = (uc += 10);
+    printf("uchar: %d %d\n", y, uc);
+
+    int *q = &arr[3];
+    int old = (*q)++;
+    int nw = --*q;
+    printf("ptr inc: %d %d %d\n", old, nw, *q);
+
+    struct pt pts[3] = { { 1, 2 }, { 3, 4 }, { 5, 6 } };
+    int k = 0;
+    pts[k++] = pts[2];
+    printf("struct: %d %d k=%d\n", pts[0].x, pts[0].y, k);
+
+    unsigned u = 1;
+    u <<= 31;
+    u += u;
+    printf("unsigned: %u\n", u);
+
+    int s = 0;
+    for (int m = 0, n = 10; m < n; m++, n--) s += m * n;
+    printf("loop: %d\n", s);
+
+    long long big = 1;
+    big <<= 40;
+    big += 5;
+    printf("llong: %d\n", (int)(big & 0xffff));
+    return 0;
+}
@@ -0,0 +1,38 @@
+#include <stdio.h>
+
+static int calls = 0;
+static int tick(int v) { calls++; return v; }
+
+int main(void) {
+    int a = 3, b = 5;
+    double nan = 0.0 / 0.0, zero = 0.0, neg_zero = -0.0;
+    unsigned long long big = 1ULL << 40;
+    char *p = 0;
+
+    /* Conditions consumed by control flow */
+    if (a < b && b < 10) printf("and\n");
+    if (a > b || !(b > 10)) printf("or/not\n");
+    if (nan) printf("nan is true\n");
+    if (!zero && !neg_zero) printf("zeros are false\n");
+    if (big > 1000) printf("big\n");
+    if (!p) printf("null\n");
+
+    int n = 0;
+    while (n < 4 && tick(1)) n++;
+    do n--; while (n > 2);
+    for (int i = 0; i != 3 && n; i++) n += 2;
+    printf("n=%d calls=%d\n", n, calls);
+
+    /* Short-circuiting */
+    calls = 0;
+    if (a > b && tick(1)) printf("unreachable\n");
+    if (a < b || tick(1)) printf("short calls=%d\n", calls);
+
+    /* Conditions used as values */
+    int lt = a < b, eq = a == b, both = a && b, either = 0 || zero, inv = !a;
+    int sum = (a < b) + (b < a) + (a != b) * 2;
+    printf("lt=%d eq=%d both=%d either=%d inv=%d sum=%d\n", lt, eq, both, either, inv, sum);
+    printf("ternary=%d %d\n", a < b ? 10 : 20, nan ? 1 : 2);
+    printf("notnan=%d dcmp=%d\n", !nan, nan == nan);
+    return 0;
+}
@@ -0,0 +1,140 @@
+/* Test: reuse of pointer loads within a basic block */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct node {
+    int nkeys;
+    int keys[4];
+    struct node *child[5];
+    struct node *parent;
+};
+
+struct tree { struct node *root; int height; };
+
+struct pair { int a, b; };
+struct rec { struct pair p; struct pair *pp; long long big; };
+struct holder { struct rec *r; struct holder *next; };
+
+static struct node *mknode(int base) {
+    struct node *n = calloc(1, sizeof(struct node));
+    n->nkeys = 3;
+    for (int i = 0; i < 3; i++) n->keys[i] = base + i;
+    return n;
+}
+
+static int chase(struct tree *t, int i) {
+    /* t->root and t->root->child[1] are loaded once */
+    int s = t->root->keys[i] + t->root->child[1]->keys[i];
+    s += t->root->child[1]->nkeys + t->root->nkeys;
+    return s;
+}
+
+static int aliased(struct tree *t, struct node **slot, struct node *other) {
+    /* the store through slot may replace t->root: reload after it */
+    int a = t->root->keys[0];
+    *slot = other;
+    int b = t->root->keys[0];
+    return a * 1000 + b;
+}
+
+static struct node *relink(struct node *n) {
+    n->child[0]->parent = n;
+    n->child[0] = n->child[0]->child[0];
+    return n->child[0];
+}
+
+static int conditional(struct node *n, int k) {
+    /* a load made on one arm is not available after the branch */
+    int s = 0;
+    if (k > 0 && n->child[0]->nkeys > 2)
+        s += n->child[0]->keys[0];
+    s += k ? n->child[1]->keys[1] : n->child[2]->keys[2];
+    s += n->child[1]->keys[0] + n->child[2]->keys[0];
+    if (n->child[1]) {
+        s += n->child[1]->nkeys;
+    } else {
+        s -= 1;
+    }
+    s += n->child[1]->keys[2];
+    return s;
+}
+
+static int bump(struct node *n) {
+    n->keys[0]++;
+    return n->keys[0];
+}
+
+static int across_calls(struct node *n) {
+    int a = n->child[0]->keys[0];
+    int b = bump(n->child[0]);
+    int c = n->child[0]->keys[0];
+    return a * 100 + b * 10 + c;
+}
+
+static int walk(struct node *n) {
+    int s = 0;
+    while (n->parent) {
+        s += n->parent->keys[0];
+        n = n->parent;
+        s += n->keys[1];
+    }
+    return s;
+}
+
+static void copy_struct(struct holder *h, struct pair v) {
+    /* the address of h->r->pp[1] is computed once for both stores */
+    struct pair w = h->r->pp[1] = v;
+    h->next->r->p = h->r->pp[0];
+    h->r->pp[0].a += w.b;
+    h->r->big += 5;
+}
+
+static int switched(struct node *n, int k) {
+    int s = n->child[0]->keys[0];
+    switch (k) {
+    case 0: s += n->child[0]->keys[1]; break;
+    case 1: n->child[0] = n->child[1];
+    /* fall through */
+    default: s += n->child[0]->keys[2]; break;
+    }
+    return s + n->child[0]->nkeys;
+}
+
+int main(void) {
+    struct node *root = mknode(10);
+    for (int i = 0; i < 3; i++) {
+        root->child[i] = mknode(100 * (i + 1));
+        root->child[i]->parent = root;
+    }
+    root->child[0]->child[0] = mknode(900);
+    struct tree t = { root, 2 };
+
+    printf("chase %d %d\n", chase(&t, 0), chase(&t, 2));
+
+    struct node *other = mknode(50);
+    printf("aliased %d\n", aliased(&t, &t.root, other));
+    t.root = root;
+
+    struct node *g = relink(root);
+    printf("relink %d %d\n", g->keys[1], root->child[0]->keys[0]);
+    root->child[0] = mknode(100);
+    root->child[0]->parent = root;
+
+    printf("conditional %d %d\n", conditional(root, 1), conditional(root, 0));
+    printf("calls %d\n", across_calls(root));
+    printf("walk %d\n", walk(root->child[2]));
+
+    struct pair arr[2] = { { 1, 2 }, { 3, 4 } };
+    struct rec r1 = { { 0, 0 }, arr, 40 }, r2 = { { 7, 8 }, NULL, 0 };
+    struct holder h2 = { &r2, NULL };
+    struct holder h1 = { &r1, &h2 };
+    struct pair v = { 5, 6 };
+    copy_struct(&h1, v);
+    printf("copy %d %d %d %d %d %lld\n", arr[0].a, arr[1].a, arr[1].b, r2.p.a, r2.p.b, r1.big);
+
+    printf("switch %d", switched(root, 0));
+    printf(" %d", switched(root, 2));
+    printf(" %d\n", switched(root, 1));
+    return 0;
+}
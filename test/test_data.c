@@ -0,0 +1,122 @@
+/* Test: static data laid out at compile time */
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+enum color { RED = 1, GREEN = 5, BLUE = -3 };
+
+static const unsigned char sbox[16] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5,
+    0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+};
+static const short shorts[] = { -1, 32767, -32768, 1000 };
+static const unsigned int big[] = { 0xffffffffu, 0x80000000u, 123456789u };
+static const long long wide[] = { -5LL, 1LL << 40, 0x7fffffffffffffffLL };
+static const double dbl[] = { 1.5, -0.25, 1e300, 3 };
+static const float flt[] = { 0.1f, -2.5f, 7 };
+static const char *names[] = { "alpha", "beta", "gamma", "beta", NULL };
+static char buf[16] = "hello";
+static char exact[5] = "abcde";
+static bool flags[3] = { 1, 0, 2 };
+static enum color colors[] = { RED, GREEN, BLUE };
+static signed char neg = (signed char)200;
+static unsigned char wrap = (unsigned char)300;
+static int from_double = (int)3.99;
+static double from_int = 7;
+/* Enum values and array sizes narrow at casts like any constant */
+enum narrowed { N_BYTE = (unsigned char)300, N_SHORT = (short)70000, N_NEXT,
+                N_MIXED = (signed char)200 + (unsigned short)-2 };
+static int narrowed[] = { N_BYTE, N_SHORT, N_NEXT, N_MIXED, (int)(unsigned char)511 * 2 };
+static char small_dim[(unsigned char)258];
+
+struct op { const char *name; int (*fn)(int); char tag[6]; double w; };
+static int twice(int x) { return 2 * x; }
+static int square(int x) { return x * x; }
+static struct op ops[] = {
+    { "twice", twice, "tw", 0.5 },
+    { .fn = square, .name = "square", .tag = "sq", .w = 2 },
+};
+
+static int table[8];
+static int *ptr_to = &table[3];
+static int *decay = table;
+static int *plus = table + 5;
+static char *mid = &buf[2];
+static int counter = 10;
+static int *pcount = &counter;
+
+static unsigned crc_table[256];
+
+/* Nested arrays: each string fills its own row */
+static char grid[2][4] = { "ab", "cde" };
+static const char *in_row = grid[1] + 1;
+static int matrix[3][5] = { { 1, 2 }, { 3 }, { 4, 5, 6, 7, 8 } };
+struct menu { int id; char items[3][6]; };
+static struct menu menu = { 7, { "tea", "", "juice" } };
+
+/* Zero-filled storage between initialized data is not in the image */
+static int before[4] = { 7, 0, 0, 9 };
+static char scratch[1 << 20];
+static int after[3] = { 11, 0, 13 };
+
+static void make_crc(void) {
+    for (unsigned n = 0; n < 256; n++) {
+        unsigned c = n;
+        for (int k = 0; k < 8; k++)
+            c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        crc_table[n] = c;
+    }
+}
+
+static int next_id(void) {
+    static int id = 100;
+    static const char *prefix = "id";
+    printf("%s%d ", prefix, id);
+    return id++;
+}
+
+int main(void) {
+    int sum = 0;
+    for (int i = 0; i < 16; i++) sum += sbox[i];
+    printf("sbox: %d %02x\n", sum, sbox[15]);
+    printf("shorts: %d %d %d %d\n", shorts[0], shorts[1], shorts[2], shorts[3]);
+    printf("big: %u %u %u\n", big[0], big[1], big[2]);
+    printf("wide: %lld %lld %lld\n", wide[0], wide[1], wide[2]);
+    printf("dbl: %g %g %g %g\n", dbl[0], dbl[1], dbl[2], dbl[3]);
+    printf("flt: %.7g %g %g\n", flt[0], flt[1], flt[2]);
+    for (int i = 0; names[i]; i++) printf("%s%c", names[i], names[i + 1] ? ' ' : '\n');
+    printf("buf: %s %d\n", buf, (int)sizeof(buf));
+    strcat(buf, " world");
+    printf("buf: %s\n", buf);
+    printf("exact: %.5s\n", exact);
+    printf("flags: %d %d %d\n", flags[0], flags[1], flags[2]);
+    printf("colors: %d %d %d\n", colors[0], colors[1], colors[2]);
+    printf("casts: %d %d %d %g\n", neg, wrap, from_double, from_int);
+    printf("narrowed: %d %d %d %d %d %d\n", narrowed[0], narrowed[1], narrowed[2],
+           narrowed[3], narrowed[4], (int)sizeof(small_dim));
+    for (int i = 0; i < 2; i++)
+        printf("op %s/%s: %d %g\n", ops[i].name, ops[i].tag, ops[i].fn(7), ops[i].w);
+    table[3] = 42;
+    printf("ptrs: %d %d %d %d %s\n", *ptr_to, decay == table, *pcount,
+           (int)(plus - table), mid);
+    make_crc();
+    printf("crc: %08x %08x\n", crc_table[1], crc_table[255]);
+    printf("grid: %s %s %s %d %d\n", grid[0], grid[1], in_row, (int)sizeof(grid[0]),
+           (int)(grid[1] - grid[0]));
+    printf("matrix: %d %d %d %d %d\n", matrix[0][1], matrix[1][0], matrix[1][4], matrix[2][4],
+           (int)sizeof(matrix[0]));
+    printf("menu: %d %s [%s] %s\n", menu.id, menu.items[0], menu.items[1], menu.items[2]);
+    char rows[4][4] = { "a", "bb", "ccc", "dddd" };
+    char mixed[2][6] = { "x", "yz" };
+    mixed[0][1] = (char)('0' + counter % 10);
+    printf("rows: %s %s %s %.4s %s %s\n", rows[0], rows[1], rows[2], rows[3], mixed[0], mixed[1]);
+    long zeros = 0;
+    for (int i = 0; i < (int)sizeof(scratch); i++) zeros += scratch[i] == 0;
+    scratch[sizeof(scratch) - 1] = 5;
+    printf("zero-filled: %ld %d %d %d %d %d\n", zeros, before[0], before[3], after[0], after[2],
+           scratch[sizeof(scratch) - 1]);
+    next_id();
+    next_id();
+    printf("\n");
+    return 0;
+}
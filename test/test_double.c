@@ -0,0 +1,56 @@
+#include <stdio.h>
+
+/* Doubles are plain JS numbers by default and BigInt raw bits under
+ * --nan-boxing; both representations must give the same results. */
+
+static double poly(double x) {
+    return 3.0 * x * x - 2.0 * x + 0.5;
+}
+
+static float to_float(float f) {
+    return f * 2;
+}
+
+static double dot(const double *a, const double *b, int n) {
+    double s = 0;
+    for (int i = 0; i < n; i++)
+        s += a[i] * b[i];
+    return s;
+}
+
+struct vec { double x, y; };
+
+int main(void) {
+    double a[4] = { 1.5, -2.25, 3.0, 0.125 };
+    double b[4] = { 2.0, 4.0, -1.0, 8.0 };
+    printf("poly = %.4f\n", poly(1.25));
+    printf("float = %.2f\n", (double)to_float(5.25));
+    printf("dot = %g\n", dot(a, b, 4));
+
+    double d = 7.9;
+    int i = (int)d;
+    long long ll = (long long)(d * 1000);
+    unsigned u = (unsigned)(d * 2);
+    printf("conv = %d %d %u\n", i, (int)ll, u);
+
+    double acc = 1;
+    acc *= 1.5;
+    acc += 2;
+    acc -= 0.25;
+    acc /= 2;
+    acc++;
+    printf("acc = %.5f\n", acc);
+
+    struct vec v = { 0.5, -0.75 };
+    v.x += v.y * 2;
+    printf("vec = %.3f %.3f\n", v.x, v.y);
+
+    double neg = -d;
+    double mid = d > 5 ? d : 0;
+    printf("neg = %.1f mid = %.1f\n", neg, mid);
+
+    double big = 1e300;
+    double inf = big * big;
+    printf("inf > big: %d, nan self-eq: %d\n", inf > big, (inf - inf) == (inf - inf));
+    return 0;
+}
@@ -0,0 +1,108 @@
+/* Test: zeroing and copies that an initializer makes redundant */
+#include <stdio.h>
+#include <string.h>
+
+struct big { int a[6]; double d; char tag[8]; };
+struct small { int x, y; };
+struct mixed { char c; int n; short s[5]; struct small p; };
+struct wide { struct small a, b, c, d, e, f, g, h, i; };
+
+static struct big make(int k) {
+    struct big b;
+    for (int i = 0; i < 6; i++) b.a[i] = k * 10 + i;
+    b.d = k / 4.0;
+    strcpy(b.tag, "big");
+    return b;
+}
+
+static struct big make_twice(int k) {
+    /* returns through the caller's own return pointer */
+    return make(k + 1);
+}
+
+static struct big shift(struct big b, int k) {
+    for (int i = 0; i < 6; i++) b.a[i] += k;
+    return b;
+}
+
+static struct small pair(int x) {
+    struct small s = { x, x * 2 };
+    return s;
+}
+
+static struct wide spread(int k) {
+    struct wide w;
+    w.a.x = k; w.a.y = k + 1; w.b.x = k * 2; w.b.y = 0;
+    w.c = w.a; w.d = w.b; w.e = w.a; w.f = w.b; w.g = w.a; w.h = w.b;
+    w.i.x = -k; w.i.y = k * k;
+    return w;
+}
+
+static int sum(const struct big *b) {
+    int s = 0;
+    for (int i = 0; i < 6; i++) s += b->a[i];
+    return s;
+}
+
+static void show(const char *what, const struct big *b) {
+    printf("%s %d %d %.2f %s\n", what, b->a[0], sum(b), b->d, b->tag);
+}
+
+static int partial(int k) {
+    /* only the bytes the initializer leaves unset are zeroed */
+    int a[8] = { k, k + 1, k + 2 };
+    struct mixed m = { 'm', k, { k + 3 } };
+    struct mixed d = { .n = k, .p = { k + 4 } };
+    int s = 0;
+    for (int i = 0; i < 8; i++) s = s * 3 + a[i];
+    for (int i = 0; i < 5; i++) s += m.s[i] * (i + 1);
+    return s + m.c + m.n + m.p.x + m.p.y + d.c + d.n + d.s[4] + d.p.x + d.p.y;
+}
+
+static int strings(int k) {
+    char s[12] = "ab";
+    char t[4] = "xyz";
+    s[2 + k] = 'c';
+    return (int)strlen(s) * 100 + s[11] + (int)strlen(t);
+}
+
+int main(void) {
+    struct big b = make(1);
+    show("init", &b);
+    struct big c = make_twice(2);
+    show("tail", &c);
+
+    /* the arguments read the destination: goes through a temporary */
+    b = shift(b, 100);
+    show("self", &b);
+    struct big *p = &c;
+    c = shift(*p, 1000);
+    show("alias", &c);
+
+    struct big e;
+    e = make(5);
+    show("assign", &e);
+    e = make_twice(e.a[0]);
+    show("reassign", &e);
+
+    /* a local whose address is never taken is a call's destination */
+    struct wide w;
+    w = spread(4);
+    printf("wide %d %d %d", w.a.y, w.h.x, w.i.y);
+    w = spread(w.b.x + w.i.y);
+    printf(" %d %d %d\n", w.a.y, w.h.x, w.i.x);
+
+    struct small s = pair(7);
+    struct big f = e;
+    printf("copy %d %d %d\n", s.x + s.y, sum(&f), f.a[5]);
+
+    for (int i = 0; i < 3; i++) {
+        struct big g = make(i);
+        struct big h = shift(g, i);
+        printf("loop %d %d\n", sum(&g), sum(&h));
+    }
+
+    printf("partial %d %d\n", partial(3), partial(-2));
+    printf("strings %d %d\n", strings(0), strings(1));
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include <stdio.h>
+
+enum color { RED, GREEN = 5, BLUE };
+
+struct point { int x; int y; };
+struct shape { char tag; struct point pts[3]; short w[4]; };
+
+static int counter = 0;
+static int bump(void) { return ++counter; }
+
+int main(void) {
+    /* Integer wraparound per type */
+    unsigned char uc = (unsigned char)(250 + 10);
+    signed char sc = (signed char)(127 + 1);
+    unsigned short us = (unsigned short)(0 - 1);
+    short ss = (short)(32767 + 2);
+    unsigned u = 0u - 1u;
+    int shl = (int)(1u << 31);
+    printf("uc=%d sc=%d us=%d ss=%d u=%u shl=%d\n", uc, sc, us, ss, u, shl);
+
+    /* Signed division, modulo and shifts */
+    printf("div=%d mod=%d neg_mod=%d sar=%d shr=%u\n",
+           -7 / 2, -7 % 2, 7 % -2, -16 >> 2, 0xF0000000u >> 4);
+
+    /* Comparisons use the usual arithmetic conversions */
+    printf("cmp=%d %d %d %d\n", -1 < 1u, -1 < 1, (unsigned char)255 == -1, 'a' < 'b');
+
+    /* Floating point and conversions */
+    double d = 1.5 * 4.0 - 0.25;
+    float f = 1.0f / 3.0f;
+    int trunc = (int)-3.99;
+    unsigned big = (unsigned)3000000000.0;
+    printf("d=%g f=%.9g trunc=%d big=%u half=%g\n", d, f, trunc, big, 1 / 2 + 1.0 / 2);
+
+    /* sizeof, enum constants and ternaries */
+    struct shape s;
+    printf("sizeof=%u %u %u enum=%d %d\n", (unsigned)sizeof(struct shape),
+           (unsigned)sizeof s.pts, (unsigned)sizeof(int[5]), BLUE * 2, GREEN > RED ? GREEN : RED);
+
+    /* Constant conditions still keep side effects of live code */
+    int x = 3;
+    int a = 1 && x;
+    int b = 0 || bump();
+    int c = 0 && bump();
+    if (0) printf("dead\n");
+    else printf("live a=%d b=%d c=%d counter=%d\n", a, b, c, counter);
+    while (0) bump();
+    if (sizeof(int) == 4 ? 1 : 0) printf("int is 32-bit\n");
+
+    /* Case labels with constant expressions */
+    for (int i = 0; i < 3; i++) {
+        switch (i * 2) {
+        case 1 + 1: printf("case two\n"); break;
+        case BLUE - GREEN - 1: printf("case zero\n"); break;
+        default: printf("default\n"); break;
+        }
+    }
+
+    /* Constant member/element offsets */
+    s.tag = 'q';
+    s.pts[0].x = 1; s.pts[2].y = 7; s.w[3] = -2;
+    struct shape *p = &s;
+    printf("offsets=%c %d %d %d %d\n", s.tag, s.pts[0].x, p->pts[2].y, s.w[3], *(&s.w[0] + 3));
+
+    /* long long literals */
+    long long ll = 5LL;
+    ll = ll + 3LL;
+    unsigned long long ull = ~0ULL;
+    printf("ll=%d eq=%d hi=%d\n", (int)ll, ll == 8LL, (int)(ull >> 40));
+    return 0;
+}
@@ -1,4 +1,6 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 int add(int a, int b) { return a + b; }
 int sub(int a, int b) { return a - b; }
@@ -21,6 +23,34 @@ void print_int(int x) {
     printf("%d ", x);
 }
 
+/* Comparators for qsort/bsearch */
+int cmp_int(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+int cmp_desc(const void *a, const void *b) {
+    return cmp_int(b, a);
+}
+
+/* Dispatch table inside a struct */
+struct vm_op {
+    const char *name;
+    int (*fn)(int, int);
+};
+
+static struct vm_op vm_ops[] = { {"add", add}, {"sub", sub}, {"mul", mul} };
+
+/* Pointer bound once at file scope */
+static binop fixed_op = mul;
+
+/* Reassigned pointer: must stay an indirect call */
+static binop current_op = add;
+
+binop pick(int i) {
+    return i ? sub : add;
+}
+
 int main(void) {
     /* Function pointers */
     apply(add, 10, 20);
@@ -39,5 +69,46 @@ int main(void) {
     for_each(arr, 5, print_int);
     printf("\n");
 
+    /* Pointers the compiler can resolve to one function */
+    binop local_op = add;
+    int (*deref_op)(int, int) = &sub;
+    printf("local_op = %d\n", local_op(7, 2));
+    printf("deref_op = %d\n", (*deref_op)(7, 2));
+    printf("fixed_op = %d\n", fixed_op(7, 2));
+    printf("(*add) = %d\n", (*add)(7, 2));
+
+    /* Reassigned and computed pointers */
+    printf("current_op = %d\n", current_op(7, 2));
+    current_op = mul;
+    printf("current_op = %d\n", current_op(7, 2));
+    binop loop_op = add;
+    for (int i = 0; i < 2; i++) {
+        printf("loop_op = %d\n", loop_op(7, 2));
+        loop_op = sub;
+    }
+    printf("pick(1) = %d\n", pick(1)(7, 2));
+    for (int i = 0; i < 3; i++)
+        printf("vm %s = %d\n", vm_ops[i].name, vm_ops[i].fn(6, 3));
+
+    /* Function pointer identity */
+    binop p = add, q = add;
+    printf("p == q: %d, p == sub: %d, null: %d\n", p == q, p == sub, (binop)0 == 0);
+
+    /* Library callbacks */
+    int v[] = {5, 3, 9, 1, 7, 2};
+    qsort(v, 6, sizeof(int), cmp_int);
+    for (int i = 0; i < 6; i++) printf("%d ", v[i]);
+    printf("\n");
+    int key = 7;
+    int *hit = bsearch(&key, v, 6, sizeof(int), cmp_int);
+    printf("bsearch 7 -> index %d\n", hit ? (int)(hit - v) : -1);
+    qsort(v, 6, sizeof(int), cmp_desc);
+    for (int i = 0; i < 6; i++) printf("%d ", v[i]);
+    printf("\n");
+
+    /* A library function used as a value */
+    int (*scmp)(const char *, const char *) = strcmp;
+    printf("strcmp via pointer: %d\n", scmp("abc", "abc"));
+
     return 0;
 }
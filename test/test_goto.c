@@ -0,0 +1,176 @@
+/* Test: goto lowering */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Cleanup ladder: forward gotos out of nested statements */
+static int setup(int fail_at) {
+    int *a = NULL, *b = NULL, *c = NULL;
+    int rc = -1;
+    a = malloc(16);
+    if (fail_at == 1) goto out;
+    b = malloc(16);
+    for (int i = 0; i < 4; i++) {
+        if (fail_at == 2 && i == 2) goto free_a;
+    }
+    c = malloc(16);
+    if (fail_at == 3) goto free_b;
+    rc = 0;
+    free(c);
+free_b:
+    free(b);
+free_a:
+    free(a);
+out:
+    return rc * 10 + fail_at;
+}
+
+/* Backward goto: retry loop, with C continue/break inside the region */
+static int retry(int n) {
+    int tries = 0, sum = 0;
+    for (int i = 0; i < n; i++) {
+again:
+        tries++;
+        if (i == 1) continue;      /* continues the for loop */
+        if (i == 5) break;         /* breaks the for loop */
+        if (tries % 3 != 0) goto again;
+        sum += i;
+    }
+    return sum * 100 + tries;
+}
+
+/* Lexer-style state machine: crossing forward and backward jumps */
+static int count_tokens(const char *s) {
+    int tokens = 0;
+    const char *p = s;
+space:
+    if (*p == '\0') goto done;
+    if (*p == ' ') { p++; goto space; }
+    tokens++;
+word:
+    p++;
+    if (*p == ' ') goto space;
+    if (*p == '\0') goto done;
+    goto word;
+done:
+    return tokens;
+}
+
+/* goto out of a switch and a nested loop */
+static int find(int (*grid)[4], int want) {
+    int r = -1;
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            switch (grid[i][j] - want) {
+            case 0:
+                r = i * 4 + j;
+                goto found;
+            default:
+                break;
+            }
+    return -1;
+found:
+    return r;
+}
+
+/* Label on a statement that is not in a block */
+static int lone(int n) {
+    int k = 0;
+    if (n > 0)
+    top:
+        if (++k < n) goto top;
+    return k;
+}
+
+/* Backward goto with a switch whose break must not leave the region */
+static int gcd(int a, int b) {
+    int steps = 0;
+loop:
+    steps++;
+    switch (b) {
+    case 0:
+        return a * 100 + steps;
+    default:
+        break;
+    }
+    {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    goto loop;
+}
+
+/* goto across a loop body into its own statement list */
+static int collatz(int n) {
+    int steps = 0;
+    while (1) {
+        if (n == 1) goto stop;
+        if (n % 2) goto odd;
+        n /= 2;
+        goto next;
+    odd:
+        n = 3 * n + 1;
+    next:
+        steps++;
+    }
+stop:
+    return steps;
+}
+
+/* Irreducible: a loop entered both at its top and in its middle */
+static int twoway(int n) {
+    int steps = 0;
+    if (n & 1) goto mid;
+top:
+    n += 3;
+    steps++;
+mid:
+    n -= 1;
+    if (n > 0 && n % 5) goto top;
+    return steps * 1000 + n;
+}
+
+/* Jumps into loop and branch bodies from outside */
+static int into(int n, int start) {
+    int s = 0, i;
+    if (start) {
+        i = start;
+        goto body;
+    }
+    for (i = 0; i < n; i++) {
+        if (i == 7) break;
+    body:
+        if (i % 3 == 0) continue;
+        s += i;
+    }
+    if (n > 4) goto other;
+    if (s > 10) {
+        s *= 2;
+    } else {
+    other:
+        s += 1000;
+    }
+    do {
+    again:
+        s -= 1;
+    } while (s % 4);
+    if (s < 0) goto again;
+    return s;
+}
+
+int main(void) {
+    printf("setup: %d %d %d %d\n", setup(0), setup(1), setup(2), setup(3));
+    printf("retry: %d %d\n", retry(4), retry(8));
+    printf("tokens: %d %d %d\n", count_tokens("hello big  world"),
+           count_tokens("  "), count_tokens("one"));
+    int grid[4][4];
+    for (int i = 0; i < 16; i++) grid[i / 4][i % 4] = i * 3;
+    printf("find: %d %d\n", find(grid, 27), find(grid, 28));
+    printf("lone: %d %d\n", lone(5), lone(0));
+    printf("gcd: %d\n", gcd(1071, 462));
+    printf("collatz: %d %d\n", collatz(27), collatz(1));
+    printf("twoway: %d %d\n", twoway(7), twoway(8));
+    printf("into: %d %d %d %d\n", into(3, 0), into(6, 0), into(10, 5), into(2, 1));
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include <stdio.h>
+#include <string.h>
+
+/* Loads and stores of every scalar width, through aligned typed-array
+ * views and through the DataView fallback for unaligned casts. */
+
+struct rec {
+    char tag;
+    short s;
+    int i;
+    float f;
+    double d;
+    unsigned char bytes[3];
+    unsigned u;
+};
+
+static unsigned read_u32_at(const unsigned char *p) {
+    return *(const unsigned *)p;
+}
+
+int main(void) {
+    struct rec r;
+    r.tag = -5;
+    r.s = -1234;
+    r.i = 0x12345678;
+    r.f = 1.5f;
+    r.d = -2.75;
+    r.bytes[0] = 200;
+    r.bytes[2] = 7;
+    r.u = 4000000000u;
+    printf("%d %d %x %.1f %.2f %d %d %u\n",
+           r.tag, r.s, r.i, (double)r.f, r.d, r.bytes[0], r.bytes[2], r.u);
+
+    short sa[4] = { -1, 2, -3, 4 };
+    float fa[3] = { 0.5f, 0.25f, 0.125f };
+    double da[2] = { 1e10, -1e-10 };
+    int sum = 0;
+    for (int k = 0; k < 4; k++) sum += sa[k];
+    printf("%d %.3f %g %g\n", sum, (double)(fa[0] + fa[1] + fa[2]), da[0], da[1]);
+
+    unsigned char buf[12];
+    for (int k = 0; k < 12; k++) buf[k] = (unsigned char)(k + 1);
+    printf("%08x %08x\n", read_u32_at(buf + 1), *(unsigned *)(buf + 3));
+    *(unsigned short *)(buf + 5) = 0xBEEF;
+    printf("%02x %02x\n", buf[5], buf[6]);
+
+    struct rec *rp = &r;
+    rp->i += 1;
+    rp->bytes[1] = rp->bytes[0] + 50;
+    printf("%x %d\n", rp->i, rp->bytes[1]);
+
+    /* pointer locals keep the misalignment of what they were assigned */
+    unsigned char raw[16];
+    memset(raw, 0, sizeof(raw));
+    int *q = (int *)(raw + 6);
+    *q = -2;
+    void *v = raw + 1;
+    short *h = v;
+    h[0] = 0x1234;
+    unsigned *w = 0;
+    w = (unsigned *)(raw + 11);
+    *w = 0xA1B2C3D4u;
+    int *q2 = q;
+    q2[0] += 1;
+    for (int k = 0; k < 16; k++) printf("%d%c", raw[k], k == 15 ? '\n' : ' ');
+    printf("%d %x %x\n", *q, h[0], *w);
+
+    char *p = (char *)&r.i;
+    memset(p, 0xff, 4);
+    printf("%d\n", r.i);
+    return 0;
+}
@@ -0,0 +1,84 @@
+/* Test: inlining of small static functions */
+#include <stdio.h>
+
+struct point { int x, y; };
+
+static int counter;
+static int limit = 10;
+
+static int get_x(const struct point *p) { return p->x; }
+static int max(int a, int b) { return a > b ? a : b; }
+static inline int min(int a, int b) { if (a < b) return a; return b; }
+static int next(void) { return ++counter; }
+static void bump(int by) { counter += by; }
+static int clamp(int v, int lo, int hi) {
+    if (v < lo) return lo;
+    else if (v > hi) return hi;
+    return v;
+}
+static int sum3(int a, int b, int c) {
+    int t = a + b;
+    t += c;
+    return t * 2;
+}
+static int sign(int v) {
+    if (v < 0) return -1;
+    if (v > 0) return 1;
+    return 0;
+}
+static int manhattan(struct point p) { return (p.x < 0 ? -p.x : p.x) + (p.y < 0 ? -p.y : p.y); }
+static void swap(int *a, int *b) { int t = *a; *a = *b; *b = t; }
+static int fact(int n) { return n <= 1 ? 1 : n * fact(n - 1); }
+static int is_odd(int n);
+static int is_even(int n) { return n == 0 ? 1 : is_odd(n - 1); }
+static int is_odd(int n) { return n == 0 ? 0 : is_even(n - 1); }
+static int over_limit(int v) { return v > limit; }
+static int add_limit(int a, int b, int c) { return a + b + c + limit; }
+static int twice(int v) { v *= 2; return v; }
+static double half(double d) { return d / 2; }
+static long long widen(int v) { return (long long)v * 1000000; }
+static float to_float(int v) { return v; }
+static unsigned char low_byte(int v) { return v; }
+static int quad(int v) { return twice(twice(v)); }
+static int ignore(int v) { (void)0; return 7; }
+
+int main(void) {
+    struct point pt = { 3, -4 };
+    printf("get_x: %d\n", get_x(&pt));
+    printf("max: %d %d\n", max(3, 9), max(-2, -7));
+    int i = 5;
+    int m = max(i++, 2);
+    printf("max side effects: %d %d\n", m, i);
+    printf("min: %d %d\n", min(4, 1), min(next(), next()));
+    printf("counter: %d\n", counter);
+    bump(5);
+    bump(counter);
+    printf("bump: %d\n", counter);
+    printf("clamp: %d %d %d\n", clamp(-5, 0, 10), clamp(50, 0, 10), clamp(7, 0, 10));
+    printf("sum3: %d\n", sum3(1, 2, 3));
+    printf("sign: %d %d %d\n", sign(-8), sign(0), sign(12));
+    printf("manhattan: %d\n", manhattan(pt));
+    int a = 1, b = 2;
+    swap(&a, &b);
+    printf("swap: %d %d\n", a, b);
+    printf("fact: %d\n", fact(6));
+    printf("even/odd: %d %d\n", is_even(10), is_odd(7));
+    int limit = 3;
+    printf("shadowed global: %d %d\n", over_limit(limit), over_limit(11));
+    printf("shadowed args: %d\n", add_limit(limit, a, b));
+    int v = 4;
+    printf("twice: %d %d\n", twice(v), v);
+    printf("half: %.2f\n", half(7));
+    printf("widen: %lld\n", widen(123456));
+    printf("to_float: %.1f\n", to_float(3));
+    printf("low_byte: %d\n", low_byte(0x1ff));
+    printf("quad: %d\n", quad(3));
+    int total = 0;
+    for (int k = 0; k < 5; k++)
+        total += max(k, 2) + min(k, 3);
+    printf("loop: %d\n", total);
+    int ig = ignore(next());
+    printf("ignore: %d %d\n", ig, counter);
+    printf("nested: %d\n", max(min(8, 5), clamp(sign(-3), 0, 4)));
+    return 0;
+}
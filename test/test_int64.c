@@ -0,0 +1,127 @@
+/* 64-bit integer lowering: long long values as pairs of int32 words */
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef unsigned long long u64;
+typedef long long i64;
+
+struct Acc {
+    int tag;
+    i64 sum;
+    u64 bits[3];
+};
+
+static i64 g_total = -1234567890123LL;
+static u64 g_table[4] = { 1, 0xFFFFFFFFULL, 0x100000000ULL, ~0ULL };
+
+static u64 fnv1a(const char *s) {
+    u64 h = 14695981039346656037ULL;
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static u64 xorshift64(u64 *state) {
+    u64 x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+static i64 add3(i64 a, int b, u64 c) {
+    return a + b + (i64)c;
+}
+
+static u64 rotl(u64 x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static i64 (*op_ptr)(i64, int, u64) = add3;
+
+static int classify(i64 v) {
+    switch (v) {
+    case -1: return 1;
+    case 0: return 2;
+    case 4294967296LL: return 3;
+    default: return 4;
+    }
+}
+
+int main(void) {
+    i64 a = 4000000000LL, b = -3, c;
+    u64 u = 0xFFFFFFFFULL, w;
+    int i;
+
+    /* carries and borrows across the word boundary */
+    printf("add %lld %llu\n", a + a, u + 1);
+    printf("sub %lld %lld\n", b - a, (i64)0 - 1);
+    c = a;
+    c++;
+    i64 d = c--;
+    printf("inc %lld %lld", c, d);
+    printf(" %lld\n", ++d);
+    printf("neg %lld %lld\n", -a, -(i64)-2147483648LL);
+
+    /* multiplication, division and remainder */
+    printf("mul %lld %lld\n", a * b, a * a);
+    printf("mulu %llu\n", u * u);
+    printf("div %lld %lld %lld\n", a / b, (a * 1000) / 7, -a / 7);
+    printf("mod %lld %lld\n", a % b, -(a * 1000) % 7);
+    printf("divu %llu %llu\n", ~0ULL / 3, ~0ULL % 1000);
+
+    /* shifts */
+    printf("shl %lld %llx\n", 1LL << 40, u << 4);
+    printf("shr %lld %llx\n", (a * a) >> 33, ~0ULL >> 60);
+    printf("sar %lld %lld\n", -a >> 1, (i64)-1 >> 63);
+    for (i = 0; i < 64; i += 21)
+        printf("var %d %llx %llx %lld\n", i, 1ULL << i, ~0ULL >> i, (-a) >> i);
+    printf("rotl %llx\n", rotl(0x0123456789ABCDEFULL, 8));
+
+    /* bitwise */
+    printf("bits %llx %llx %llx %llx\n", a & u, a | ~u, a ^ ~0ULL, ~a);
+
+    /* comparisons */
+    printf("cmp %d %d %d %d\n", a > b, b < 0, (u64)b > u, a == 4000000000LL);
+    printf("cmp %d %d %d\n", (i64)u != (i64)0xFFFFFFFF, a <= a, -a >= b);
+    if (a) printf("truthy\n");
+    if (!(a - a)) printf("falsy\n");
+
+    /* conversions */
+    printf("conv %d %u %d %d\n", (int)a, (unsigned)a, (char)(a + 1), (short)-a);
+    printf("conv %lld %llu %lld\n", (i64)-5, (u64)-5, (i64)4294967295U);
+    printf("conv %.1f %.1f %lld %llu\n", (double)a, (double)~0ULL, (i64)-1e15, (u64)1e19);
+    printf("conv %d\n", (_Bool)(a << 31));
+
+    /* globals, arrays and struct members */
+    struct Acc acc = { 7, 0, { 0 } };
+    for (i = 0; i < 4; i++) {
+        acc.sum += g_table[i];
+        acc.bits[i % 3] ^= g_table[i] << i;
+    }
+    g_total += acc.sum;
+    printf("mem %lld %llx %llx %llx %lld\n", acc.sum, acc.bits[0], acc.bits[1],
+           acc.bits[2], g_total);
+    i64 *p = &acc.sum;
+    *p *= 3;
+    p[0] -= 1;
+    printf("ptr %lld %d\n", *p, acc.tag);
+
+    /* calls */
+    printf("call %lld %lld\n", add3(a, -1, u), op_ptr(-a, 7, 1ULL << 40));
+    printf("ternary %lld\n", b < 0 ? a : b);
+    printf("switch %d %d %d %d\n", classify(-1), classify(0), classify(1LL << 32),
+           classify(a));
+
+    /* hashing */
+    printf("fnv %llx %llx\n", fnv1a(""), fnv1a("hello world"));
+    w = 88172645463325252ULL;
+    for (i = 0; i < 3; i++) printf("xs %llu\n", xorshift64(&w));
+
+    printf("strtoll %lld %llu\n", strtoll("-9000000000000000000", NULL, 10),
+           strtoull("ffffffffffffffff", NULL, 16));
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include <stdio.h>
+
+static unsigned fnv1a(const char *s) {
+    unsigned h = 2166136261u;
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static unsigned mix(unsigned x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+int main(void) {
+    int a = 123456789, b = 987654321;
+    unsigned ua = 4000000000u, ub = 3;
+    int neg = -7, m = -1;
+    unsigned ptrs[8];
+
+    /* Products past 2^53 keep their low 32 bits */
+    printf("imul=%d umul=%u\n", a * b, ua * ua);
+    printf("fnv=%u mix=%u\n", fnv1a("hello, world"), mix(12345u));
+
+    /* Division and modulo, including powers of two */
+    printf("sdiv=%d %d %d %d\n", neg / 2, neg / 4, neg % 4, a / 1000);
+    printf("udiv=%u %u %u %u\n", ua / 8, ua % 8, ua / ub, ua % ub);
+    printf("mixed=%u %u\n", ua / (unsigned)m, 10u / 3);
+    int q = -1000;
+    q /= 8;
+    printf("sdiv_assign=%d\n", q);
+
+    /* Unsigned results stay in uint32 range */
+    unsigned one = 1;
+    printf("shl=%u not=%u neg=%u and=%u\n", one << 31, ~one, -one, ua & 0xF0000000u);
+    printf("cmp=%d %d\n", (one << 31) > one, m < (int)one);
+
+    /* Signed/unsigned comparison follows the usual arithmetic conversions */
+    printf("sucmp=%d %d\n", m < one, m == 0xFFFFFFFFu);
+
+    /* Compound multiply and wraparound */
+    int w = 0x7FFFFFFF;
+    w *= 3;
+    unsigned uw = 0xFFFFFFFFu;
+    uw *= uw;
+    printf("wrap=%d %u %d\n", w, uw, a + b + b);
+
+    /* Pointer difference */
+    printf("ptrdiff=%d\n", (int)(&ptrs[7] - &ptrs[1]));
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <string.h>
+
+/* Functions within the scalar subset that lowers to the SSA IR (--dump-ir) */
+
+int g_counter;
+int g_table[4] = {3, 1, 4, 1};
+
+static int sum(const int *a, int n) {
+    int s = 0;
+    for (int i = 0; i < n; i++) s += a[i];
+    return s;
+}
+
+/* Loop-carried swap: the phi copies must be parallel */
+static unsigned fib(unsigned n) {
+    unsigned a = 0, b = 1;
+    while (n--) {
+        unsigned t = a + b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static int swap_steps(int n) {
+    int x = 1, y = 2;
+    for (int i = 0; i < n; i++) {
+        int t = x;
+        x = y;
+        y = t;
+    }
+    return x * 10 + y;
+}
+
+/* break, continue and early return in nested loops */
+static int find_pair(const int *a, int n, int target) {
+    for (int i = 0; i < n; i++) {
+        if (a[i] < 0) continue;
+        for (int j = i + 1; j < n; j++) {
+            if (a[j] < 0) break;
+            if (a[i] + a[j] == target) return i * 100 + j;
+        }
+    }
+    return -1;
+}
+
+static int collatz(int n) {
+    int steps = 0;
+    do {
+        n = n % 2 ? 3 * n + 1 : n / 2;
+        steps++;
+    } while (n != 1);
+    return steps;
+}
+
+static int logic(int a, int b) {
+    int r = 0;
+    if (a > 0 && b > 0) r |= 1;
+    if (a > 0 || b > 0) r |= 2;
+    if (!(a == b)) r |= 4;
+    return r + (a < b) * 8;
+}
+
+static int narrow(int x) {
+    signed char c = (signed char)x;
+    unsigned char u = (unsigned char)x;
+    short s = (short)(x * 300);
+    unsigned short us = (unsigned short)(x * 300);
+    c += 100;
+    u++;
+    return c + u + s + us;
+}
+
+static unsigned mix(unsigned h, const char *s) {
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+        h = (h << 5) | (h >> 27);
+    }
+    return h;
+}
+
+static double poly(double x) {
+    double r = 0.0;
+    for (int i = 5; i > 0; i--) r = r * x + i;
+    return r;
+}
+
+static float fsum(int n) {
+    float f = 0.0f;
+    for (int i = 1; i <= n; i++) f += 1.0f / (float)i;
+    return f;
+}
+
+/* Address-taken scalar and a local array live in the frame */
+static void bump(int *p) { *p += 5; g_counter++; }
+
+static int frame_user(int k) {
+    int v = k;
+    int arr[6] = {1, 2};
+    char name[8] = "ir";
+    bump(&v);
+    bump(&arr[1]);
+    arr[5] = v;
+    return v + arr[1] + arr[5] + (int)strlen(name) + (int)sizeof(arr);
+}
+
+static int apply(int (*f)(int), int x) { return f(x); }
+static int twice(int x) { return x * 2; }
+
+static int ptr_diff(void) {
+    int a[10];
+    int *p = a + 7, *q = &a[2];
+    return (int)(p - q);
+}
+
+/* Outside the subset: the dump gives the reason instead */
+static long long widen(int x) { return (long long)x << 33; }
+
+int main(void) {
+    int data[6] = {5, -1, 7, 2, 9, 4};
+    printf("sum %d\n", sum(g_table, 4));
+    printf("fib %u %u\n", fib(10), fib(47));
+    printf("swap %d %d\n", swap_steps(3), swap_steps(4));
+    printf("pair %d %d\n", find_pair(data, 6, 11), find_pair(data, 6, 100));
+    printf("collatz %d\n", collatz(27));
+    printf("logic %d %d %d\n", logic(1, 2), logic(-1, 2), logic(-3, -3));
+    printf("narrow %d %d\n", narrow(200), narrow(-7));
+    printf("mix %u\n", mix(2166136261u, "hello, ir"));
+    printf("poly %.6f\n", poly(0.5));
+    printf("fsum %.5f\n", fsum(10));
+    printf("frame %d\n", frame_user(3));
+    printf("counter %d\n", g_counter);
+    printf("apply %d\n", apply(twice, 21));
+    printf("diff %d\n", ptr_diff());
+    printf("widen %lld\n", widen(3));
+    return 0;
+}
@@ -0,0 +1,98 @@
+/* GNU labels as values: &&label and goto *ptr */
+#include <stdio.h>
+
+enum { OP_PUSH, OP_ADD, OP_MUL, OP_DUP, OP_DEC, OP_SWAP, OP_JNZ, OP_DROP, OP_HALT };
+
+/* Threaded stack machine */
+static int run(const int *code) {
+    static void *ops[] = { &&push, &&add, &&mul, &&dup, &&dec, &&swap, &&jnz, &&drop, &&halt };
+    int stack[16], sp = 0;
+    const int *pc = code;
+#define DISPATCH goto *ops[*pc++]
+    DISPATCH;
+push:
+    stack[sp++] = *pc++;
+    DISPATCH;
+add:
+    sp--;
+    stack[sp - 1] += stack[sp];
+    DISPATCH;
+mul:
+    sp--;
+    stack[sp - 1] *= stack[sp];
+    DISPATCH;
+dup:
+    stack[sp] = stack[sp - 1];
+    sp++;
+    DISPATCH;
+dec:
+    stack[sp - 1]--;
+    DISPATCH;
+swap: {
+        int t = stack[sp - 1];
+        stack[sp - 1] = stack[sp - 2];
+        stack[sp - 2] = t;
+    }
+    DISPATCH;
+jnz:
+    if (stack[--sp]) {
+        pc = code + *pc;
+        DISPATCH;
+    }
+    pc++;
+    DISPATCH;
+drop:
+    sp--;
+    DISPATCH;
+halt:
+    return stack[sp - 1];
+}
+
+/* Targets inside a loop body, a table in a local array */
+static int classify(const char *s) {
+    void *kind[3];
+    kind[0] = &&other;
+    kind[1] = &&digit;
+    kind[2] = &&space;
+    int digits = 0, spaces = 0, others = 0;
+    for (int i = 0; s[i]; i++) {
+        int k = s[i] >= '0' && s[i] <= '9' ? 1 : s[i] == ' ' ? 2 : 0;
+        goto *kind[k];
+    digit:
+        digits++;
+        continue;
+    space:
+        spaces++;
+        if (spaces > 3) break;
+        continue;
+    other:
+        others++;
+    }
+    return digits * 10000 + spaces * 100 + others;
+}
+
+/* Label values compare and survive a round trip through memory */
+static int same(void) {
+    void *a = &&one, *b = &&two;
+    void *saved[2] = { a, b };
+    int r = (a == saved[0]) + 2 * (a != b) + 4 * (saved[1] == &&two);
+    goto *saved[r & 1];
+one:
+    return r * 10 + 1;
+two:
+    return r * 10 + 2;
+}
+
+int main(void) {
+    int sum[] = { OP_PUSH, 2, OP_PUSH, 40, OP_ADD, OP_HALT };
+    int product[] = { OP_PUSH, 6, OP_PUSH, 7, OP_MUL, OP_HALT };
+    /* acc = 0, n = 4; while (n) { acc++; n--; } */
+    int countdown[] = { OP_PUSH, 0, OP_PUSH, 4,
+                        /* 4 */ OP_DUP, OP_JNZ, 9, OP_DROP, OP_HALT,
+                        /* 9 */ OP_SWAP, OP_PUSH, 1, OP_ADD, OP_SWAP,
+                        OP_DEC, OP_PUSH, 1, OP_JNZ, 4 };
+    printf("run: %d %d %d\n", run(sum), run(product), run(countdown));
+    printf("classify: %d %d\n", classify("a1 b22 c333"), classify("x     y"));
+    printf("same: %d\n", same());
+    return 0;
+}
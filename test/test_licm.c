@@ -0,0 +1,175 @@
+/* Test: loop-invariant code motion */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+struct buf { int len; int scale; char *data; };
+struct ctx { struct buf *base; int bias; };
+
+static int total;
+
+static int count_spaces(const char *s) {
+    int n = 0;
+    for (int i = 0; i < (int)strlen(s); i++)
+        if (s[i] == ' ') n++;
+    return n;
+}
+
+static void upcase(char *s) {
+    /* stores through s: strlen(s) must be re-evaluated */
+    for (size_t i = 0; i < strlen(s); i++)
+        if (s[i] >= 'a' && s[i] <= 'z') s[i] -= 32;
+}
+
+static int sum_scaled(struct ctx *c, const int *v, int n) {
+    int sum = 0;
+    for (int i = 0; i < n; i++)
+        sum += v[i] * c->base->scale + c->bias;
+    return sum;
+}
+
+static void fill(struct buf *b, int *out, int n) {
+    /* out may alias b: b->scale is reloaded after every store */
+    for (int i = 0; i < n; i++)
+        out[i] = b->scale + i;
+}
+
+static int guarded(struct buf *b, int n) {
+    int s = 0;
+    while (n > 0) {
+        s += b->len;
+        n--;
+    }
+    return s;
+}
+
+static int with_global(int n) {
+    int s = 0;
+    for (int i = 0; i < n; i++) {
+        s += total;
+        total++;
+    }
+    return s;
+}
+
+static int reads_global(int n) {
+    int s = 0;
+    for (int i = 0; i < n; i++)
+        s += total * 2;
+    return s;
+}
+
+static double norms(const double *x, int n, double k) {
+    double s = 0;
+    int i = 0;
+    do {
+        s += x[i] / sqrt(k);
+        i++;
+    } while (i < n);
+    return s;
+}
+
+static int forever(const char *s) {
+    int i = 0;
+    for (;;) {
+        int len = (int)strlen(s);
+        if (i >= len) break;
+        i += 2;
+    }
+    return i;
+}
+
+static int nested(const char *a, const char *b) {
+    int hits = 0;
+    for (int i = 0; a[i]; i++)
+        for (int j = 0; j < (int)strlen(b); j++)
+            if (a[i] == b[j]) hits++;
+    return hits;
+}
+
+static int early_exit(struct buf *b, int n) {
+    int s = 0;
+    for (int i = 0; i < n; i++) {
+        if (!b) return -1;
+        s += b->len;
+    }
+    return s;
+}
+
+static int modified_by_call(struct buf *b) {
+    int s = 0;
+    for (int i = 0; i < 3; i++) {
+        s += b->len;
+        b->len = b->len * 2;
+    }
+    return s;
+}
+
+static int skip_label(int n, int *p) {
+    int s = 0, i = 0;
+    if (n > 100) goto inside;
+    while (i < n) {
+    inside:
+        s += *p;
+        i++;
+    }
+    return s;
+}
+
+struct acc { int arr[3]; int n; };
+
+static void put_at(int *a, int i, int v) {
+    if (v >= 0) a[i] = v;
+}
+
+static int decayed(int v) {
+    /* s.arr passed as a pointer: s is written through it */
+    struct acc s = { { 0, 0, 0 }, 0 };
+    int t = 0;
+    for (int i = 0; i < 3; i++) {
+        put_at(s.arr, i, v + i);
+        t += s.arr[0];
+    }
+    int *p = s.arr;
+    for (int i = 0; i < 3; i++) {
+        *p = i * 10 + v;
+        t += s.arr[0] * 100;
+    }
+    return t;
+}
+
+int main(void) {
+    char text[] = "the quick brown fox jumps over the lazy dog";
+    printf("spaces: %d\n", count_spaces(text));
+    upcase(text);
+    printf("upcase: %s\n", text);
+
+    char data[4] = "abc";
+    struct buf b = { 7, 3, data };
+    struct ctx c = { &b, 1 };
+    int v[5] = { 1, 2, 3, 4, 5 };
+    printf("sum_scaled: %d\n", sum_scaled(&c, v, 5));
+
+    int out[4];
+    fill(&b, out, 4);
+    printf("fill: %d %d %d %d\n", out[0], out[1], out[2], out[3]);
+    fill(&b, &b.len, 2);
+    printf("fill alias: %d %d\n", b.len, b.scale);
+
+    printf("guarded: %d %d\n", guarded(&b, 3), guarded(NULL, 0));
+    total = 5;
+    int wg = with_global(4);
+    printf("with_global: %d %d\n", wg, total);
+    printf("reads_global: %d\n", reads_global(3));
+    double x[3] = { 2, 4, 6 };
+    printf("norms: %.3f\n", norms(x, 3, 4.0));
+    printf("forever: %d\n", forever("abcdefg"));
+    printf("nested: %d\n", nested("hello", "world"));
+    printf("early_exit: %d %d\n", early_exit(&b, 2), early_exit(NULL, 2));
+    b.len = 1;
+    printf("modified: %d\n", modified_by_call(&b));
+    int k = 4;
+    printf("skip_label: %d %d\n", skip_label(3, &k), skip_label(0, &k));
+    printf("decayed: %d\n", decayed(2));
+    return 0;
+}
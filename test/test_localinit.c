@@ -0,0 +1,76 @@
+/* Test: local aggregates initialized from constant templates */
+#include <stdio.h>
+#include <string.h>
+
+struct config { int width, height; double scale; const char *name; char mode[4]; };
+
+static int lookup(int i) {
+    int table[10] = { 3, 1, 4, 1, 5, 9, 2, 6, 5, 3 };
+    int r = table[i];
+    table[i] = -1;  /* must not leak into the next call */
+    return r;
+}
+
+static void show_config(int w) {
+    struct config c = { 640, 480, 1.5, "default", "rgb" };
+    if (w) c.width = w;
+    printf("config: %dx%d %.1f %s %s\n", c.width, c.height, c.scale, c.name, c.mode);
+}
+
+static void strings(void) {
+    char exact[] = "exact";
+    char padded[12] = "pad";
+    char clipped[3] = "abc";
+    printf("strings: %s %d %s %d %c%c%c\n", exact, (int)sizeof(exact), padded,
+           padded[11], clipped[0], clipped[1], clipped[2]);
+    exact[0] = 'E';
+    padded[3] = '!';
+    printf("modified: %s %s\n", exact, padded);
+}
+
+static int partial(int x) {
+    int a[6] = { 1, 2, x, 4, 5, 6 };      /* covers the array, not constant */
+    int b[6] = { x, x };                  /* rest must be zero */
+    int c[8] = { [2] = 7, [6] = 9 };      /* designated: gaps are zero */
+    int s = 0;
+    for (int i = 0; i < 6; i++) s += a[i] * 100 + b[i];
+    for (int i = 0; i < 8; i++) s += c[i] * 1000 * (i + 1);
+    return s;
+}
+
+struct point { int x, y; };
+struct shape { const char *name; struct point pts[3]; int n; };
+
+static int perimeter_like(int scale) {
+    struct shape tri = { "tri", { { 0, 0 }, { 4, 0 }, { 0, 3 } }, 3 };
+    int s = 0;
+    for (int i = 0; i < tri.n; i++) s += (tri.pts[i].x + tri.pts[i].y) * scale;
+    tri.pts[0].x = 100;
+    return s + (int)strlen(tri.name);
+}
+
+static int depth(int n) {
+    int digits[5] = { 10, 20, 30, 40, 50 };
+    if (n == 0) return digits[4];
+    digits[4] = n;
+    return digits[4] + depth(n - 1);
+}
+
+static double weights(void) {
+    double w[4] = { 0.5, 0.25, 0.125, 0.0625 };
+    float f[4] = { 1.5f, 2.5f, -1, 0 };
+    return w[0] + w[1] + w[2] + w[3] + f[0] + f[1] + f[2] + f[3];
+}
+
+int main(void) {
+    printf("lookup: %d %d %d\n", lookup(2), lookup(2), lookup(5));
+    show_config(0);
+    show_config(800);
+    strings();
+    strings();
+    printf("partial: %d %d\n", partial(3), partial(7));
+    printf("shape: %d %d\n", perimeter_like(1), perimeter_like(2));
+    printf("depth: %d\n", depth(3));
+    printf("weights: %g\n", weights());
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include <stdio.h>
+
+/* Locals whose address is never taken live in JS variables; these checks
+ * make sure they keep C storage semantics (width, signedness). */
+
+static int fib(int n) {
+    int a = 0, b = 1;
+    for (int i = 0; i < n; i++) {
+        int t = a + b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static int wrap_char(void) {
+    signed char c = 127;
+    c++;
+    unsigned char u = 250;
+    u += 10;
+    short s = 32767;
+    s = s + 1;
+    return c + u + s;
+}
+
+static unsigned mix(unsigned x) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+static int through_ptr(int v) {
+    int x = v;
+    int *p = &x;
+    *p += 5;
+    return x;
+}
+
+static int narrow(char c) {
+    return c;
+}
+
+int main(void) {
+    printf("fib(20) = %d\n", fib(20));
+    printf("wrap = %d\n", wrap_char());
+    printf("mix = %u\n", mix(2463534242u));
+    printf("through_ptr = %d\n", through_ptr(10));
+    printf("narrow = %d\n", narrow(300));
+    long long big = 1;
+    for (int k = 0; k < 40; k++) big *= 2;
+    printf("big = %d\n", (int)(big >> 20));
+    return 0;
+}
@@ -0,0 +1,92 @@
+/* Test: value ranges that let coercions and BigInt conversions be dropped */
+#include <stdio.h>
+#include <limits.h>
+
+static unsigned char bytes[16];
+
+static int near_max(void) {
+    /* the increment after the last iteration still fits in int */
+    int n = 0;
+    for (int i = INT_MAX - 3; i < INT_MAX; i++) n += i & 7;
+    return n;
+}
+
+static unsigned countdown(unsigned from) {
+    unsigned s = 0;
+    for (unsigned u = from; u > 0; u--) s = s * 3 + u;
+    for (unsigned char c = 250; c < 255; c++) s += c;
+    return s;
+}
+
+static int narrow(int x) {
+    char lo = x & 0x7F;          /* fits: no sign extension needed */
+    char wrapped = x & 0xFF;     /* may need it */
+    unsigned short hw = (x & 0xFFFF) >> 4;
+    signed char sc = (signed char)(x % 100);
+    return lo * 1000000 + wrapped * 1000 + hw + sc;
+}
+
+static unsigned mix(unsigned u, int k) {
+    unsigned a = (u & 0xFF) << 8;
+    unsigned b = (u & 0xFFFF) * 3u;
+    unsigned c = u - 1;          /* wraps at 0 */
+    unsigned d = (unsigned)k % 10;
+    int e = k % 7;               /* sign of the dividend */
+    return a + b + c + d + (unsigned)e;
+}
+
+static void remainder_zero(int a) {
+    double d = (double)(a % 3);
+    printf("rem %f %d\n", d, a % 4);
+}
+
+static void bytes_loop(void) {
+    for (int i = 0; i < 16; i++) bytes[i] = (unsigned char)(i * 17);
+    unsigned sum = 0;
+    for (int i = 0; i < 16; i++) sum += bytes[i] ^ 0x55;
+    printf("bytes %u %d\n", sum, (int)bytes[15]);
+}
+
+static void shadowed(void) {
+    int total = 0;
+    for (int i = 0; i < 3; i++) {
+        total += i;
+        for (int i = -5; i < -2; i++) total += i;
+    }
+    int j;
+    for (j = 0; j < 10; j++) {
+        if (j == 2) j = 2000000000;
+        total += j > 100;
+    }
+    printf("shadowed %d %d\n", total, j);
+}
+
+static void wide(int n) {
+    for (long long q = 0; q < 3; q++) printf("q%lld ", q);
+    long long s = 0;
+    for (int i = 0; i < n; i++) s += i;
+    printf("%lld %lld %llu\n", (long long)n * 3, (long long)(n - 20) * 1000000000, (unsigned long long)(n & 0xFF));
+    printf("%lld %llu %lld %llx\n", s, (unsigned long long)n * 4000000000u, (long long)-n, (unsigned long long)(unsigned)n);
+    int low = (int)((long long)n * 2);
+    printf("low %d\n", low);
+}
+
+static int pick(int c, int x) {
+    short s = c ? (x & 0x3FF) : -(x & 0xFF);
+    unsigned char b = (c, x & 0x7F);
+    return s * 1000 + b;
+}
+
+int main(void) {
+    printf("near_max %d\n", near_max());
+    printf("countdown %u %u\n", countdown(5), countdown(0));
+    printf("narrow %d %d\n", narrow(0x1234), narrow(-77));
+    printf("mix %u %u\n", mix(0, -13), mix(0xABCDEF12u, 123456));
+    remainder_zero(-6);
+    remainder_zero(7);
+    bytes_loop();
+    shadowed();
+    wide(10);
+    printf("pick %d %d\n", pick(1, 0x7FF), pick(0, 0x1FF));
+    return 0;
+}
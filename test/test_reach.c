@@ -0,0 +1,59 @@
+/* Test: unreachable function removal and function-pointer IDs */
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef int (*binop)(int, int);
+
+static int add(int a, int b) { return a + b; }
+static int sub(int a, int b) { return a - b; }
+static int mul(int a, int b) { return a * b; }
+
+/* Reached only through a global table */
+static const struct { const char *name; binop fn; } ops[] = {
+    { "add", add }, { "sub", sub },
+};
+
+/* Unreachable: mutually recursive, never referenced from main */
+static int ping(int n);
+static int pong(int n) { return n ? ping(n - 1) : 0; }
+static int ping(int n) { return n ? pong(n - 1) : 1; }
+int unused_extern(void) { return ping(4); }
+
+/* Reached only through an unreachable function: dropped too */
+static int helper(int x) { return x * 3; }
+static int dead(int x) { return helper(x) + (int)(long)&helper; }
+
+static int cmp_int(const void *a, const void *b) {
+    return *(const int *)a - *(const int *)b;
+}
+
+static int fact(int n) { return n <= 1 ? 1 : n * fact(n - 1); }
+static int even(int n);
+static int odd(int n) { return n == 0 ? 0 : even(n - 1); }
+static int even(int n) { return n == 0 ? 1 : odd(n - 1); }
+
+static binop pick(int i) { return i ? mul : NULL; }
+
+static int counter;
+static void bump(void) { counter++; }
+
+int main(void) {
+    for (int i = 0; i < 2; i++)
+        printf("%s: %d\n", ops[i].name, ops[i].fn(7, 3));
+
+    int v[5] = { 4, 1, 5, 2, 3 };
+    qsort(v, 5, sizeof(int), cmp_int);
+    printf("sorted: %d %d %d %d %d\n", v[0], v[1], v[2], v[3], v[4]);
+
+    printf("fact: %d\n", fact(6));
+    printf("even: %d %d\n", even(10), even(7));
+
+    binop f = pick(1);
+    printf("pick: %d %d\n", f(6, 7), pick(0) == NULL);
+    printf("same: %d %d\n", ops[0].fn == add, ops[0].fn == ops[1].fn);
+
+    void (*g)(void) = bump;
+    g(); g();
+    printf("counter: %d\n", counter);
+    return 0;
+}
@@ -67,7 +67,7 @@ elif command -v clang >/dev/null 2>&1; then
     echo "  Using: clang"
     clang -std=c99 -O2 -D_CRT_SECURE_NO_WARNINGS -o c99js \
         src/util.c src/type.c src/lexer.c src/ast.c src/symtab.c \
-        src/preprocess.c src/parser.c src/sema.c src/codegen.c src/main.c 2>&1
+        src/preprocess.c src/parser.c src/sema.c src/inline.c src/fold.c src/licm.c src/cse.c src/range.c src/dse.c src/ir.c src/codegen.c src/main.c 2>&1
     rc=$?
     check "clang build" $rc
     if [ $rc -ne 0 ]; then echo "Cannot continue without compiler."; exit 1; fi
@@ -77,7 +77,7 @@ elif command -v gcc >/dev/null 2>&1; then
     echo "  Using: gcc"
     gcc -std=c99 -O2 -D_CRT_SECURE_NO_WARNINGS -o c99js \
         src/util.c src/type.c src/lexer.c src/ast.c src/symtab.c \
-        src/preprocess.c src/parser.c src/sema.c src/codegen.c src/main.c 2>&1
+        src/preprocess.c src/parser.c src/sema.c src/inline.c src/fold.c src/licm.c src/cse.c src/range.c src/dse.c src/ir.c src/codegen.c src/main.c 2>&1
     rc=$?
     check "gcc build" $rc
     if [ $rc -ne 0 ]; then echo "Cannot continue without compiler."; exit 1; fi
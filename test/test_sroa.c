@@ -0,0 +1,83 @@
+#include <stdio.h>
+
+/* Struct locals that are only accessed field-by-field and copied whole */
+
+typedef struct { double x, y; } Vec2;
+typedef struct { float re, im; } Complex;
+typedef struct { Vec2 min, max; } Box;
+typedef struct { long long id; int tag; char flag; } Rec;
+
+static Vec2 vec_add(Vec2 a, Vec2 b) {
+    Vec2 r;
+    r.x = a.x + b.x;
+    r.y = a.y + b.y;
+    return r;
+}
+
+static Complex cmul(Complex a, Complex b) {
+    Complex r = { a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re };
+    return r;
+}
+
+static Box box_grow(Box b, double d) {
+    Box r = b;
+    r.min.x -= d; r.min.y -= d;
+    r.max.x += d; r.max.y += d;
+    return r;
+}
+
+static Rec rec_next(Rec in) {
+    Rec r = { .tag = 7 };
+    r.id = in.id * 3 + 1;
+    r.flag = (char)(in.flag + 1);
+    return r;
+}
+
+static double sum_loop(int n) {
+    Vec2 acc = { 0, 0 };
+    for (int i = 0; i < n; i++) {
+        Vec2 step = { i, i * 0.5 };
+        acc = vec_add(acc, step);
+    }
+    return acc.x + acc.y;
+}
+
+int main(void) {
+    Vec2 a = { 1.5, 2.5 }, b = { .y = 4 };
+    Vec2 c = vec_add(a, b);
+    printf("c = (%.2f, %.2f)\n", c.x, c.y);
+
+    Vec2 d = c;
+    d.x *= 2;
+    c = d;
+    c.y++;
+    printf("c = (%.2f, %.2f), d = (%.2f, %.2f)\n", c.x, c.y, d.x, d.y);
+
+    Complex z = { 1.0f, 2.0f }, w = z;
+    for (int i = 0; i < 3; i++) w = cmul(w, z);
+    printf("z^4 = %.1f%+.1fi\n", w.re, w.im);
+
+    Box bx = { { 0, 0 }, { 1, 2 } };
+    Box g = box_grow(bx, 0.5);
+    printf("box (%.1f,%.1f)-(%.1f,%.1f)\n", g.min.x, g.min.y, g.max.x, g.max.y);
+    Box h;
+    h.min = g.max;
+    h.max = bx.min;
+    printf("h (%.1f,%.1f)-(%.1f,%.1f)\n", h.min.x, h.min.y, h.max.x, h.max.y);
+
+    Rec r = { 5000000000LL, 1, 'a' };
+    for (int i = 0; i < 2; i++) r = rec_next(r);
+    printf("rec %lld %d %c\n", r.id, r.tag, r.flag);
+    r.id <<= 2;
+    r.id++;
+    printf("rec %lld\n", r.id);
+
+    printf("sum %.2f\n", sum_loop(10));
+
+    /* Address taken: stays in memory */
+    Vec2 m = a;
+    Vec2 *pm = &m;
+    pm->x = 9;
+    printf("m = (%.2f, %.2f)\n", m.x, m.y);
+    return 0;
+}
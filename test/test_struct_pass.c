@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdarg.h>
+
+/* Small structs passed and returned by value */
+
+typedef struct { int x, y; } Point;
+typedef struct { unsigned char r, g, b, a; } Color;
+typedef struct { long long value; int ok; } Result;
+typedef struct { float m[2]; } Pair;              /* array member: memory */
+typedef struct { double a, b, c; } Triple;        /* 24 bytes: memory */
+typedef struct { Point p; short w, h; } Rect;
+typedef union { int i; float f; } Bits;
+
+static Point pt(int x, int y) { Point p = { x, y }; return p; }
+static Point pt_add(Point a, Point b) { return pt(a.x + b.x, a.y + b.y); }
+static int pt_dot(Point a, Point b) { return a.x * b.x + a.y * b.y; }
+
+/* Parameter whose address is taken stays in the frame */
+static void pt_scale(Point *p, int k) { p->x *= k; p->y *= k; }
+static Point pt_scaled(Point p, int k) { pt_scale(&p, k); return p; }
+
+static Point pt_from(const Point *p) { return *p; }
+
+static Color blend(Color a, Color b) {
+    Color c;
+    c.r = (unsigned char)((a.r + b.r) / 2);
+    c.g = (unsigned char)((a.g + b.g) / 2);
+    c.b = (unsigned char)((a.b + b.b) / 2);
+    c.a = 255;
+    return c;
+}
+
+static Result checked_mul(long long a, long long b) {
+    Result r = { 0, 0 };
+    if (b != 0 && a > 9000000000000000000LL / b) return r;
+    r.value = a * b;
+    r.ok = 1;
+    return r;
+}
+
+static Pair pair_swap(Pair p) {
+    Pair q;
+    q.m[0] = p.m[1];
+    q.m[1] = p.m[0];
+    return q;
+}
+static Triple triple_sum(Triple t) { Triple r = { t.a + t.b + t.c, t.a, t.b }; return r; }
+
+static Rect rect_move(Rect r, Point d) {
+    r.p = pt_add(r.p, d);
+    return r;
+}
+
+static Bits bits_of(float f) { Bits b; b.f = f; return b; }
+
+static int count_calls;
+static Point counted(int v) { count_calls++; return pt(v, -v); }
+
+static Point sum_points(int n, ...) {
+    va_list ap;
+    Point s = { 0, 0 };
+    va_start(ap, n);
+    for (int i = 0; i < n; i++) {
+        Point p = va_arg(ap, Point);
+        s.x += p.x;
+        s.y += p.y;
+    }
+    va_end(ap);
+    return s;
+}
+
+static Point apply(Point (*fn)(Point, Point), Point a, Point b) { return fn(a, b); }
+
+Point g_origin;
+
+int main(void) {
+    Point a = pt(1, 2), b = pt(3, 4);
+    Point c = pt_add(a, b);
+    printf("c = (%d, %d), dot = %d\n", c.x, c.y, pt_dot(a, b));
+    printf("nested = %d\n", pt_add(pt_add(a, b), pt(10, 20)).y);
+    printf("dot call = %d\n", pt_dot(pt(2, 3), pt_add(a, pt(1, 1))));
+
+    Point s = pt_scaled(c, 3);
+    printf("scaled = (%d, %d), c = (%d, %d)\n", s.x, s.y, c.x, c.y);
+
+    Point arr[3] = { { 1, 1 }, { 2, 4 }, { 3, 9 } };
+    Point *pp = &arr[1];
+    Point t = pt_add(arr[0], *pp);
+    arr[2] = pt_add(arr[2], pp[1]);
+    printf("t = (%d, %d), arr[2] = (%d, %d)\n", t.x, t.y, arr[2].x, arr[2].y);
+    Point f = pt_from(&arr[2]);
+    printf("from = (%d, %d)\n", f.x, f.y);
+
+    Color red = { 255, 0, 0, 255 }, blue = { 0, 0, 255, 255 };
+    Color m = blend(red, blue);
+    printf("blend = %d %d %d %d\n", m.r, m.g, m.b, m.a);
+
+    Result r1 = checked_mul(123456789LL, 1000LL);
+    Result r2 = checked_mul(4000000000000LL, 4000000000000LL);
+    printf("mul = %lld ok=%d, overflow ok=%d\n", r1.value, r1.ok, r2.ok);
+
+    Pair pr = { { 1.5f, 2.5f } };
+    pr = pair_swap(pr);
+    printf("pair = %.1f %.1f\n", pr.m[0], pr.m[1]);
+    Triple tr = { 1, 2, 3 };
+    tr = triple_sum(tr);
+    printf("triple = %.1f %.1f %.1f\n", tr.a, tr.b, tr.c);
+
+    Rect rc = { { 5, 6 }, 7, 8 };
+    rc = rect_move(rc, pt(-5, 4));
+    printf("rect = (%d, %d) %dx%d\n", rc.p.x, rc.p.y, rc.w, rc.h);
+
+    printf("bits = 0x%08x\n", (unsigned)bits_of(1.0f).i);
+
+    counted(1);
+    (void)counted(2);
+    int k = 1;
+    Point q = k ? counted(3) : counted(4);
+    printf("calls = %d, q = (%d, %d)\n", count_calls, q.x, q.y);
+
+    Point v = sum_points(3, a, b, pt(100, 200));
+    printf("varargs = (%d, %d)\n", v.x, v.y);
+
+    Point w = apply(pt_add, a, c);
+    printf("apply = (%d, %d)\n", w.x, w.y);
+
+    g_origin = pt(-1, -2);
+    Point o = g_origin;
+    printf("global = (%d, %d)\n", o.x, o.y);
+    return 0;
+}
@@ -0,0 +1,158 @@
+/* Test: switch lowering (dispatch tables and compare trees) */
+#include <stdio.h>
+
+enum op { OP_PUSH, OP_POP, OP_ADD, OP_SUB, OP_MUL, OP_JMP, OP_HALT };
+
+static int dense(int x) {
+    int r = 0;
+    switch (x) {
+    case 0: r += 1;
+    case 1: r += 10; break;
+    case 2:
+    case 3: r = 30; break;
+    default: r = -1; break;
+    case 5: r = 50;
+    case 6: r += 6; break;
+    case 7: return 700;
+    }
+    return r;
+}
+
+static const char *sparse(int x) {
+    switch (x) {
+    case -100000: return "minus big";
+    case -7: return "minus seven";
+    case 1: return "one";
+    case 2: return "two";
+    case 3: return "three";
+    case 1000: return "thousand";
+    case 65536: return "64k";
+    case 2147483647: return "int max";
+    }
+    return "none";
+}
+
+static int unsigned_switch(unsigned u) {
+    switch (u) {
+    case 0: return 0;
+    case 1: return 1;
+    case 0x7fffffffu: return 2;
+    case 0x80000000u: return 3;
+    case 0xfffffffeu: return 4;
+    case 0xffffffffu: return 5;
+    default: return -1;
+    }
+}
+
+static int chars(const char *s) {
+    int score = 0;
+    for (; *s; s++) {
+        switch (*s) {
+        case 'a': case 'e': case 'i': case 'o': case 'u':
+            score += 1;
+            break;
+        case ' ':
+            continue;
+        case '!':
+            score *= 2;
+            break;
+        default:
+            score += 100;
+        }
+        score += 1000;
+    }
+    return score;
+}
+
+static int run(const int *code) {
+    int stack[16], sp = 0, pc = 0;
+    for (;;) {
+        switch ((enum op)code[pc++]) {
+        case OP_PUSH: stack[sp++] = code[pc++]; break;
+        case OP_POP: sp--; break;
+        case OP_ADD: sp--; stack[sp - 1] += stack[sp]; break;
+        case OP_SUB: sp--; stack[sp - 1] -= stack[sp]; break;
+        case OP_MUL: sp--; stack[sp - 1] *= stack[sp]; break;
+        case OP_JMP: pc = code[pc]; break;
+        case OP_HALT: return stack[sp - 1];
+        }
+    }
+}
+
+static int nested(int a, int b) {
+    switch (a) {
+    case 1:
+        switch (b) {
+        case 1: return 11;
+        case 2: return 12;
+        case 3: break;
+        case 4: return 14;
+        }
+        return 10;
+    case 2: {
+        int i, t = 0;
+        for (i = 0; i < 10; i++) {
+            if (i == b) break;
+            t += i;
+        }
+        return t;
+    }
+    case 3:
+        while (b > 0) {
+            b--;
+            switch (b) { case 0: case 1: case 2: case 3: continue; default: break; }
+            b--;
+        }
+        return b;
+    case 4: break;
+    }
+    return -1;
+}
+
+static int pre_decl(int x) {
+    switch (x) {
+        int y;
+    case 1: y = 5; return y;
+    case 2: y = 7; return y * 2;
+    case 3: case 4: case 5: return 3;
+    }
+    return 0;
+}
+
+static int wide(long long v) {
+    switch (v) {
+    case 1: return 1;
+    case 4294967296LL: return 2;
+    case -1: return 3;
+    case 12345678901LL: return 4;
+    default: return 0;
+    }
+}
+
+static int small(int x) {
+    switch (x) { case 1: return 5; default: return 6; }
+}
+
+static int only_default(int x) {
+    switch (x) { default: x += 3; }
+    return x;
+}
+
+int main(void) {
+    for (int i = -1; i <= 8; i++) printf("dense(%d) = %d\n", i, dense(i));
+    int sv[] = { -100000, -7, -6, 1, 2, 3, 4, 1000, 65536, 2147483647, 0 };
+    for (int i = 0; i < 11; i++) printf("sparse(%d) = %s\n", sv[i], sparse(sv[i]));
+    unsigned uv[] = { 0, 1, 2, 0x7fffffffu, 0x80000000u, 0xfffffffeu, 0xffffffffu };
+    for (int i = 0; i < 7; i++) printf("unsigned(%u) = %d\n", uv[i], unsigned_switch(uv[i]));
+    printf("chars = %d\n", chars("hello world!"));
+    int prog[] = { OP_PUSH, 6, OP_PUSH, 7, OP_MUL, OP_JMP, 9, OP_PUSH, 99, OP_PUSH, 2, OP_SUB, OP_HALT };
+    printf("run = %d\n", run(prog));
+    for (int a = 1; a <= 5; a++)
+        for (int b = 1; b <= 4; b++) printf("nested(%d,%d) = %d\n", a, b, nested(a, b));
+    for (int i = 0; i <= 6; i++) printf("pre_decl(%d) = %d\n", i, pre_decl(i));
+    long long wv[] = { 1, 4294967296LL, -1, 12345678901LL, 7 };
+    for (int i = 0; i < 5; i++) printf("wide(%d) = %d\n", i, wide(wv[i]));
+    printf("small = %d %d\n", small(1), small(2));
+    printf("only_default = %d\n", only_default(4));
+    return 0;
+}
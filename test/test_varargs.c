@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <stdarg.h>
+
+/* Sum of n ints */
+int sum_ints(int n, ...) {
+    va_list ap;
+    va_start(ap, n);
+    int total = 0;
+    for (int i = 0; i < n; i++)
+        total += va_arg(ap, int);
+    va_end(ap);
+    return total;
+}
+
+/* Mixed argument kinds described by a type string */
+void show(const char *types, ...) {
+    va_list ap;
+    va_start(ap, types);
+    for (const char *t = types; *t; t++) {
+        switch (*t) {
+        case 'i': printf("int %d\n", va_arg(ap, int)); break;
+        case 'u': printf("uint %u\n", va_arg(ap, unsigned int)); break;
+        case 'c': printf("char %c\n", (char)va_arg(ap, int)); break;
+        case 'd': printf("double %.3f\n", va_arg(ap, double)); break;
+        case 'L': printf("llong %lld\n", va_arg(ap, long long)); break;
+        case 's': printf("str %s\n", va_arg(ap, const char *)); break;
+        case 'p': printf("ptr deref %d\n", *va_arg(ap, int *)); break;
+        }
+    }
+    va_end(ap);
+}
+
+struct pair { int a, b; };
+
+int pair_sum(int n, ...) {
+    va_list ap;
+    va_start(ap, n);
+    int total = 0;
+    for (int i = 0; i < n; i++) {
+        struct pair p = va_arg(ap, struct pair);
+        total += p.a * p.b;
+    }
+    va_end(ap);
+    return total;
+}
+
+/* va_copy walks the same arguments twice */
+double mean_and_max(int n, ...) {
+    va_list ap, ap2;
+    va_start(ap, n);
+    va_copy(ap2, ap);
+    double sum = 0, max = -1e300;
+    for (int i = 0; i < n; i++) sum += va_arg(ap, double);
+    for (int i = 0; i < n; i++) {
+        double d = va_arg(ap2, double);
+        if (d > max) max = d;
+    }
+    va_end(ap2);
+    va_end(ap);
+    printf("max %.2f\n", max);
+    return sum / n;
+}
+
+/* Logging wrappers forwarding their va_list to the v*printf family */
+static int log_count;
+
+void log_msg(const char *level, const char *fmt, ...) {
+    char buf[128];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    log_count++;
+    printf("[%s] %s\n", level, buf);
+}
+
+void log_direct(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+}
+
+/* A va_list passed down to a helper */
+int vsum(int n, va_list ap) {
+    int total = 0;
+    while (n-- > 0) total += va_arg(ap, int);
+    return total;
+}
+
+int sum_via(int n, ...) {
+    va_list ap;
+    va_start(ap, n);
+    int r = vsum(n, ap);
+    va_end(ap);
+    return r;
+}
+
+int main(void) {
+    printf("sum = %d\n", sum_ints(4, 1, 2, 3, 4));
+    printf("sum = %d\n", sum_ints(0));
+    show("iucdLsp", -7, 4000000000u, 'x', 2.5f, -1234567890123LL, "hello", &log_count);
+    struct pair p1 = {2, 3}, p2 = {4, 5};
+    printf("pair_sum = %d\n", pair_sum(2, p1, p2));
+    printf("mean %.2f\n", mean_and_max(3, 1.5, 4.25, 2.0));
+    for (int i = 0; i < 3; i++)
+        log_msg("info", "step %d of %d: %s %.1f", i + 1, 3, i ? "ok" : "start", i * 0.5);
+    log_msg("warn", "%5s|%-4d|%x|%llu", "ab", 7, 255, 18446744073709551615ULL);
+    log_direct("direct %c%c %05.1f\n", 'o', 'k', 3.14159);
+    printf("logged %d\n", log_count);
+    printf("sum_via = %d\n", sum_via(3, 10, 20, 30));
+    printf("nested = %d\n", sum_ints(2, sum_ints(2, 1, 2), sum_ints(3, 3, 4, 5)));
+    return 0;
+}